@@ -3,9 +3,12 @@
 
 #include "bsp_sys.h"
 #include "bsp_key.h"
+#include "bsp_msg.h"
+#include "bsp_sched.h"
 #include "bsp_dac.h"
 #include "bsp_fmrx.h"
 #include "bsp_param.h"
+#include "bsp_kv.h"
 #include "bsp_ir.h"
 #include "bsp_audio.h"
 #include "bsp_music.h"
@@ -14,12 +17,17 @@
 #include "bsp_bt.h"
 #include "bsp_eq.h"
 #include "bsp_charge.h"
+#include "bsp_fuel.h"
+#include "bsp_alarm.h"
 #include "bsp_piano.h"
+#include "bsp_synth.h"
+#include "bsp_spectrum.h"
 #include "bsp_id3_tag.h"
 #include "bsp_record.h"
 #include "bsp_aux.h"
 #include "bsp_i2c.h"
 #include "bsp_karaok.h"
 #include "bsp_ble.h"
+#include "bsp_app_link.h"
 
 #endif
@@ -0,0 +1,345 @@
+#include "include.h"
+
+#if FUNC_CLOCK_EN
+#define ALARM_DAY_SEC               86400UL
+#define ALARM_EPOCH_WDAY            4           //RTC计数0(1970.1.1)是周四
+#define ALARM_PROGRAM_MIN           2           //闹钟寄存器至少设在当前时间2秒后, 避免写的时候刚好跨秒错过比较
+
+typedef struct {
+    u32 due;                    //到期时间(RTC秒计数)
+    u8 type;
+    u8 id;
+} alarm_node_t;
+
+typedef struct {
+    alarm_node_t heap[ALARM_HEAP_MAX];
+    u8 num;
+    u8 ring;                    //正在响的闹钟id
+    u32 alm;                    //已写入RTCALM的值
+    alarm_cfg_t cfg[ALARM_NUM];
+    alarm_stat_t stat;
+} alarm_cb_t;
+
+static alarm_cb_t alarm_cb AT(.buf.bsp.alarm);
+
+//同一秒到期时按类型排: 闹钟, 贪睡, 定时关机
+AT(.text.bsp.alarm)
+static bool alarm_node_before(const alarm_node_t *a, const alarm_node_t *b)
+{
+    if (a->due != b->due) {
+        return (a->due < b->due);
+    }
+    return (a->type < b->type);
+}
+
+AT(.text.bsp.alarm)
+static void alarm_node_swap(u8 i, u8 j)
+{
+    alarm_node_t tmp = alarm_cb.heap[i];
+    alarm_cb.heap[i] = alarm_cb.heap[j];
+    alarm_cb.heap[j] = tmp;
+}
+
+AT(.text.bsp.alarm)
+static void alarm_sift_up(u8 i)
+{
+    while (i > 0) {
+        u8 parent = (i - 1) >> 1;
+        if (!alarm_node_before(&alarm_cb.heap[i], &alarm_cb.heap[parent])) {
+            break;
+        }
+        alarm_node_swap(i, parent);
+        i = parent;
+    }
+}
+
+AT(.text.bsp.alarm)
+static void alarm_sift_down(u8 i)
+{
+    while (1) {
+        u8 child = 2 * i + 1;
+        if (child >= alarm_cb.num) {
+            break;
+        }
+        if ((child + 1 < alarm_cb.num) && alarm_node_before(&alarm_cb.heap[child + 1], &alarm_cb.heap[child])) {
+            child++;
+        }
+        if (!alarm_node_before(&alarm_cb.heap[child], &alarm_cb.heap[i])) {
+            break;
+        }
+        alarm_node_swap(i, child);
+        i = child;
+    }
+}
+
+AT(.text.bsp.alarm)
+static void alarm_heap_delete(u8 i)
+{
+    alarm_cb.num--;
+    if (i != alarm_cb.num) {
+        alarm_cb.heap[i] = alarm_cb.heap[alarm_cb.num];
+        alarm_sift_up(i);
+        alarm_sift_down(i);
+    }
+}
+
+//每个(type, id)在堆里最多一个, 先删掉旧的
+AT(.text.bsp.alarm)
+static void alarm_heap_remove(u8 type, u8 id)
+{
+    for (u8 i = 0; i < alarm_cb.num; i++) {
+        if (alarm_cb.heap[i].type == type && alarm_cb.heap[i].id == id) {
+            alarm_heap_delete(i);
+            return;
+        }
+    }
+}
+
+AT(.text.bsp.alarm)
+static void alarm_heap_push(u32 due, u8 type, u8 id)
+{
+    alarm_heap_remove(type, id);
+    if (alarm_cb.num >= ALARM_HEAP_MAX) {
+        return;
+    }
+    alarm_node_t *n = &alarm_cb.heap[alarm_cb.num];
+    n->due = due;
+    n->type = type;
+    n->id = id;
+    alarm_sift_up(alarm_cb.num++);
+    if (alarm_cb.num > alarm_cb.stat.hwm) {
+        alarm_cb.stat.hwm = alarm_cb.num;
+    }
+}
+
+//闹钟在now之后(不含now)下一次响的时间
+AT(.text.bsp.alarm)
+static u32 alarm_next_due(u32 now, const alarm_cfg_t *cfg)
+{
+    u32 day = now / ALARM_DAY_SEC;
+    u32 tod = (u32)cfg->hour * 3600 + (u32)cfg->min * 60;
+    if (tod <= now % ALARM_DAY_SEC) {
+        day++;
+    }
+    if (cfg->wday) {
+        while (!(cfg->wday & BIT((day + ALARM_EPOCH_WDAY) % 7))) {
+            day++;
+        }
+    }
+    return day * ALARM_DAY_SEC + tod;
+}
+
+AT(.text.bsp.alarm)
+static void alarm_pending_clear(void)
+{
+    RTCCPND = BIT(17);                          //clear RTC alarm pending
+    irtc_sfr_write(RTCCON8_CMD, 0x02);          //clear alarm pending
+}
+
+//RTC闹钟只设堆顶, 堆空时关掉闹钟唤醒
+AT(.text.bsp.alarm)
+static void alarm_program(void)
+{
+    uint rtccon3 = irtc_sfr_read(RTCCON3_CMD);
+    if (alarm_cb.num) {
+        u32 due = alarm_cb.heap[0].due;
+        u32 now = irtc_time_read(RTCCNT_CMD);
+        if (due < now + ALARM_PROGRAM_MIN) {
+            due = now + ALARM_PROGRAM_MIN;      //已经过期的, 到时统一在alarm_expire处理
+        }
+        if (due != alarm_cb.alm) {
+            irtc_time_write(RTCALM_CMD, due);
+            alarm_cb.alm = due;
+            alarm_cb.stat.program++;
+        }
+        rtccon3 |= BIT(6);                      //RTC alarm wakeup enable
+    } else {
+        rtccon3 &= ~BIT(6);
+    }
+    irtc_sfr_write(RTCCON3_CMD, rtccon3);
+}
+
+AT(.text.bsp.alarm)
+static void alarm_cfg_save(void)
+{
+    param_alarm_write((u8 *)alarm_cb.cfg);
+    param_sync();
+}
+
+//取出所有到期的项, 重复闹钟按now排下一次, 单次闹钟到期后关掉
+AT(.text.bsp.alarm)
+static void alarm_expire(u32 now)
+{
+    bool ring = false, sleep = false, save = false;
+
+    while (alarm_cb.num && alarm_cb.heap[0].due <= now) {
+        alarm_node_t n = alarm_cb.heap[0];
+        alarm_heap_delete(0);
+        alarm_cb.stat.fire++;
+        if (n.type == ALARM_TYPE_SLEEP) {
+            sleep = true;
+            continue;
+        }
+        if (n.type == ALARM_TYPE_ALARM) {
+            alarm_cfg_t *cfg = &alarm_cb.cfg[n.id];
+            if (cfg->wday) {
+                alarm_heap_push(alarm_next_due(now, cfg), ALARM_TYPE_ALARM, n.id);
+            } else {
+                cfg->en = 0;
+                save = true;
+            }
+        }
+        alarm_cb.ring = n.id;
+        ring = true;
+    }
+
+    if (save) {
+        alarm_cfg_save();
+    }
+    if (ring) {
+        msg_enqueue(EVT_ALARM_RING);
+    }
+    if (sleep) {
+        msg_enqueue(EVT_ALARM_SLEEP);
+    }
+}
+
+//主循环里调用, 没有闹钟pending时只读一次寄存器
+AT(.text.bsp.alarm)
+void alarm_process(void)
+{
+    if (!alarm_is_pending()) {
+        return;
+    }
+    alarm_pending_clear();
+    alarm_expire(irtc_time_read(RTCCNT_CMD));
+    alarm_program();
+}
+
+AT(.text.bsp.alarm)
+bool alarm_set(u8 id, const alarm_cfg_t *cfg)
+{
+    if (id >= ALARM_NUM || cfg->hour > 23 || cfg->min > 59) {
+        return false;
+    }
+    alarm_cfg_t *c = &alarm_cb.cfg[id];
+    c->hour = cfg->hour;
+    c->min = cfg->min;
+    c->wday = cfg->wday & 0x7f;
+    c->en = (cfg->en) ? 1 : 0;
+    alarm_cfg_save();
+
+    if (c->en) {
+        alarm_heap_push(alarm_next_due(irtc_time_read(RTCCNT_CMD), c), ALARM_TYPE_ALARM, id);
+    } else {
+        alarm_heap_remove(ALARM_TYPE_ALARM, id);
+    }
+    alarm_program();
+    return true;
+}
+
+AT(.text.bsp.alarm)
+const alarm_cfg_t *alarm_get(u8 id)
+{
+    if (id >= ALARM_NUM) {
+        return NULL;
+    }
+    return &alarm_cb.cfg[id];
+}
+
+//调整RTC时间: 闹钟按新时间重新排, 贪睡和定时关机保持剩余时间不变
+AT(.text.bsp.alarm)
+void alarm_time_set(u32 time)
+{
+    u32 delta = time - irtc_time_read(RTCCNT_CMD);
+    irtc_time_write(RTCCNT_CMD, time);
+
+    for (u8 i = 0; i < alarm_cb.num; i++) {
+        alarm_cb.heap[i].due += delta;          //同时平移, 堆序不变
+    }
+    for (u8 id = 0; id < ALARM_NUM; id++) {
+        if (alarm_cb.cfg[id].en) {
+            alarm_heap_push(alarm_next_due(time, &alarm_cb.cfg[id]), ALARM_TYPE_ALARM, id);
+        }
+    }
+    alarm_program();
+}
+
+//响铃中按键贪睡, ALARM_SNOOZE_TIME后再响
+AT(.text.bsp.alarm)
+void alarm_snooze(void)
+{
+    if (alarm_cb.ring == ALARM_NONE) {
+        return;
+    }
+    alarm_heap_push(irtc_time_read(RTCCNT_CMD) + ALARM_SNOOZE_TIME, ALARM_TYPE_SNOOZE, alarm_cb.ring);
+    alarm_cb.ring = ALARM_NONE;
+    alarm_program();
+}
+
+//关掉响铃和还没到的贪睡
+AT(.text.bsp.alarm)
+void alarm_stop(void)
+{
+    for (u8 id = 0; id < ALARM_NUM; id++) {
+        alarm_heap_remove(ALARM_TYPE_SNOOZE, id);
+    }
+    alarm_cb.ring = ALARM_NONE;
+    alarm_program();
+}
+
+AT(.text.bsp.alarm)
+u8 alarm_get_ringing(void)
+{
+    return alarm_cb.ring;
+}
+
+//定时关机, nsec = 0取消
+AT(.text.bsp.alarm)
+void alarm_sleep_timer_set(u32 nsec)
+{
+    if (nsec) {
+        alarm_heap_push(irtc_time_read(RTCCNT_CMD) + nsec, ALARM_TYPE_SLEEP, 0);
+    } else {
+        alarm_heap_remove(ALARM_TYPE_SLEEP, 0);
+    }
+    alarm_program();
+}
+
+AT(.text.bsp.alarm)
+u32 alarm_sleep_timer_left(void)
+{
+    for (u8 i = 0; i < alarm_cb.num; i++) {
+        if (alarm_cb.heap[i].type == ALARM_TYPE_SLEEP) {
+            u32 now = irtc_time_read(RTCCNT_CMD);
+            return (alarm_cb.heap[i].due > now) ? (alarm_cb.heap[i].due - now) : 0;
+        }
+    }
+    return 0;
+}
+
+AT(.text.bsp.alarm)
+void alarm_init(void)
+{
+    u32 now = irtc_time_read(RTCCNT_CMD);
+
+    memset(&alarm_cb, 0, sizeof(alarm_cb));
+    alarm_cb.ring = ALARM_NONE;
+    param_alarm_read((u8 *)alarm_cb.cfg);
+    for (u8 id = 0; id < ALARM_NUM; id++) {
+        alarm_cfg_t *cfg = &alarm_cb.cfg[id];
+        if (cfg->hour > 23 || cfg->min > 59 || cfg->wday > 0x7f || cfg->en > 1) {
+            memset(cfg, 0, sizeof(alarm_cfg_t));        //参数区没写过
+        } else if (cfg->en) {
+            alarm_heap_push(alarm_next_due(now, cfg), ALARM_TYPE_ALARM, id);
+        }
+    }
+    alarm_pending_clear();
+    alarm_program();
+}
+
+const alarm_stat_t *alarm_get_stat(void)
+{
+    return &alarm_cb.stat;
+}
+#endif // FUNC_CLOCK_EN
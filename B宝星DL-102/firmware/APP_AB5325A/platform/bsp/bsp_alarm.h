@@ -0,0 +1,44 @@
+#ifndef _BSP_ALARM_H
+#define _BSP_ALARM_H
+
+//RTC闹钟调度: 闹钟, 贪睡, 定时关机都放在按到期时间排序的小根堆里, RTC闹钟只设堆顶(最近的一个)
+#define ALARM_NUM                   4           //可设置的闹钟个数, 掉电保存
+#define ALARM_HEAP_MAX              (ALARM_NUM + 2)     //每个闹钟 + 1个贪睡 + 1个定时关机
+#define ALARM_SNOOZE_TIME           (9*60)      //贪睡时间(秒)
+#define ALARM_NONE                  0xff
+
+enum {
+    ALARM_TYPE_ALARM = 0,       //闹钟, 到期发EVT_ALARM_RING
+    ALARM_TYPE_SNOOZE,          //贪睡, 到期发EVT_ALARM_RING
+    ALARM_TYPE_SLEEP,           //定时关机, 到期发EVT_ALARM_SLEEP
+};
+
+typedef struct {
+    u8 hour;
+    u8 min;
+    u8 wday;                    //重复: BIT(0)~BIT(6)对应周日~周六, 0表示只响一次
+    u8 en;
+} alarm_cfg_t;
+
+typedef struct {
+    u16 fire;                   //到期次数
+    u16 program;                //写RTC闹钟寄存器的次数
+    u8 hwm;                     //堆的最高水位
+} alarm_stat_t;
+
+//RTC闹钟pending, 休眠时sleep_timer()里查询
+#define alarm_is_pending()          (RTCCON & BIT(17))
+
+void alarm_init(void);
+void alarm_process(void);
+bool alarm_set(u8 id, const alarm_cfg_t *cfg);
+void alarm_time_set(u32 time);
+const alarm_cfg_t *alarm_get(u8 id);
+void alarm_snooze(void);
+void alarm_stop(void);
+u8 alarm_get_ringing(void);
+void alarm_sleep_timer_set(u32 nsec);
+u32 alarm_sleep_timer_left(void);
+const alarm_stat_t *alarm_get_stat(void);
+
+#endif // _BSP_ALARM_H
@@ -0,0 +1,263 @@
+#include "include.h"
+#include "bsp_app_link.h"
+
+#if BT_APP_LINK_EN
+
+#define APP_LINK_RING_MASK          (APP_LINK_RING_SIZE - 1)
+#define APP_LINK_FRAME_MAX          (APP_LINK_HEAD_LEN + APP_LINK_PAYLOAD_MAX + 2)
+
+uint calc_crc(void *buf, uint len, uint seed);
+int eq_huart_putcs(uint8_t *packet, uint16_t len);
+
+typedef struct {
+    u8 ring[APP_LINK_RING_SIZE];        //收到的字节流, 不管SPP/BLE怎么拆包合包都先放进来
+    u16 rptr;
+    u16 wptr;
+    u8 link;                            //当前链路
+    u32 rx_tick;
+
+    u8 frame[APP_LINK_FRAME_MAX];       //从ring里取出的一整帧
+    u8 xfer[APP_LINK_XFER_SIZE];        //多帧拼成的一次传输
+    u16 xfer_len;
+    u8 xfer_seq;                        //最后收到的帧序号
+    u8 xfer_err;
+
+    app_link_stat_t stat;
+} app_link_cb_t;
+
+static app_link_cb_t app_link_cb;
+
+void app_link_init(void)
+{
+    memset(&app_link_cb, 0, sizeof(app_link_cb));
+}
+
+const app_link_stat_t *app_link_get_stat(void)
+{
+    return &app_link_cb.stat;
+}
+
+static inline u16 app_link_ring_len(void)
+{
+    return (u16)(app_link_cb.wptr - app_link_cb.rptr);
+}
+
+static inline u8 app_link_ring_peek(u16 ofs)
+{
+    return app_link_cb.ring[(app_link_cb.rptr + ofs) & APP_LINK_RING_MASK];
+}
+
+static void app_link_ring_read(u8 *buf, u16 len)
+{
+    u16 pos = app_link_cb.rptr & APP_LINK_RING_MASK;
+    u16 n = APP_LINK_RING_SIZE - pos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buf, &app_link_cb.ring[pos], n);
+    memcpy(buf + n, app_link_cb.ring, len - n);
+}
+
+static void app_link_ring_write(u8 *ptr, u16 size)
+{
+    u16 space = APP_LINK_RING_SIZE - app_link_ring_len();
+    if (size > space) {
+        app_link_cb.stat.overflow++;
+        if (size > APP_LINK_RING_SIZE) {
+            //比整个ring还大, 只留最后APP_LINK_RING_SIZE个字节
+            ptr += size - APP_LINK_RING_SIZE;
+            size = APP_LINK_RING_SIZE;
+        }
+        //放不下, 丢掉最老的数据, 后面重新找sync
+        app_link_cb.rptr += size - space;
+    }
+    u16 pos = app_link_cb.wptr & APP_LINK_RING_MASK;
+    u16 n = APP_LINK_RING_SIZE - pos;
+    if (n > size) {
+        n = size;
+    }
+    memcpy(&app_link_cb.ring[pos], ptr, n);
+    memcpy(app_link_cb.ring, ptr + n, size - n);
+    app_link_cb.wptr += size;
+}
+
+static void app_link_tx(u8 *buf, u16 len)
+{
+    switch (app_link_cb.link) {
+#if BT_SPP_EN
+    case APP_LINK_SPP:
+        if (bt_get_status() >= BT_STA_CONNECTED) {
+            bt_spp_tx(buf, len);
+        }
+        break;
+#endif // BT_SPP_EN
+
+#if LE_EN
+    case APP_LINK_BLE:
+        ble_send_packet(buf, len);
+        break;
+#endif // LE_EN
+
+#if EQ_DBG_IN_UART
+    case APP_LINK_UART:
+        eq_huart_putcs(buf, len);
+        break;
+#endif // EQ_DBG_IN_UART
+    }
+}
+
+static void app_link_tx_ack(u8 seq, u8 status)
+{
+    u8 ack[APP_LINK_HEAD_LEN + 2 + 2];
+    ack[0] = APP_LINK_SYNC0;
+    ack[1] = APP_LINK_SYNC1;
+    ack[2] = 2;
+    ack[3] = 0;
+    ack[4] = seq;
+    ack[5] = APP_FRM_ACK | APP_FRM_NOACK;
+    ack[6] = seq;
+    ack[7] = status;
+    u16 crc = calc_crc(&ack[2], 6, APP_LINK_CRC_SEED);
+    ack[8] = crc;
+    ack[9] = crc >> 8;
+    app_link_tx(ack, sizeof(ack));
+}
+
+//执行一次传输里的所有命令, 有命令被拒绝时ACK回APP_ACK_CMD_ERR, 后面的命令照常执行
+static u8 app_link_xfer_exec(u8 *buf, u16 len)
+{
+    u16 pos = 0;
+    u8 status = APP_ACK_OK;
+    while (pos + 3 <= len) {
+        u8 cmd = buf[pos];
+        u16 size = buf[pos + 1] | ((u16)buf[pos + 2] << 8);
+        pos += 3;
+        if (pos + size > len) {
+            app_link_cb.stat.cmd_err++;
+            return APP_ACK_CMD_ERR;
+        }
+        if (!bt_app_cmd_exec(cmd, &buf[pos], size)) {
+            app_link_cb.stat.cmd_err++;
+            status = APP_ACK_CMD_ERR;
+        }
+        pos += size;
+    }
+    return (pos == len) ? status : APP_ACK_CMD_ERR;
+}
+
+static void app_link_frame_done(u8 *frm)
+{
+    app_link_cb_t *p = &app_link_cb;
+    u16 len = frm[2] | ((u16)frm[3] << 8);
+    u8 seq = frm[4];
+    u8 flag = frm[5];
+
+    if (flag & APP_FRM_ACK) {
+        return;                                 //对方的ACK, 不处理
+    }
+    if (p->xfer_len || p->xfer_err) {
+        if (seq != (u8)(p->xfer_seq + 1)) {     //中间丢帧, 之前拼的数据作废, 当前帧作为新传输的开始
+            p->stat.seq_err++;
+            p->xfer_len = 0;
+            p->xfer_err = 0;
+        }
+    }
+    p->xfer_seq = seq;
+
+    if (!p->xfer_err) {
+        if (p->xfer_len + len > APP_LINK_XFER_SIZE) {
+            p->stat.overflow++;
+            p->xfer_err = APP_ACK_OVERFLOW;
+            p->xfer_len = 0;
+        } else {
+            memcpy(&p->xfer[p->xfer_len], &frm[APP_LINK_HEAD_LEN], len);
+            p->xfer_len += len;
+        }
+    }
+    if (flag & APP_FRM_MORE) {
+        return;
+    }
+
+    u8 status = p->xfer_err;
+    if (!status) {
+        status = app_link_xfer_exec(p->xfer, p->xfer_len);
+        p->stat.rx_xfers++;
+    }
+    p->xfer_len = 0;
+    p->xfer_err = 0;
+    if (!(flag & APP_FRM_NOACK)) {
+        app_link_tx_ack(seq, status);
+    }
+}
+
+//从ring里解析出完整帧, 支持一包多帧及一帧多包
+static void app_link_parse(void)
+{
+    app_link_cb_t *p = &app_link_cb;
+    u16 avail;
+
+    while ((avail = app_link_ring_len()) >= APP_LINK_HEAD_LEN) {
+        if (app_link_ring_peek(0) != APP_LINK_SYNC0 || app_link_ring_peek(1) != APP_LINK_SYNC1) {
+            p->rptr++;
+            continue;
+        }
+        u16 len = app_link_ring_peek(2) | ((u16)app_link_ring_peek(3) << 8);
+        if (len > APP_LINK_PAYLOAD_MAX) {
+            p->rptr++;                          //假的sync, 跳过继续找
+            continue;
+        }
+        u16 frm_len = APP_LINK_HEAD_LEN + len + 2;
+        if (avail < frm_len) {
+            break;                              //等后面的包
+        }
+        app_link_ring_read(p->frame, frm_len);
+        u16 crc = calc_crc(&p->frame[2], APP_LINK_HEAD_LEN - 2 + len, APP_LINK_CRC_SEED);
+        if (crc != (p->frame[frm_len - 2] | ((u16)p->frame[frm_len - 1] << 8))) {
+            p->stat.crc_err++;
+            p->rptr++;
+            continue;
+        }
+        p->rptr += frm_len;
+        p->stat.rx_frames++;
+        app_link_frame_done(p->frame);
+    }
+}
+
+//ring里有未收完的帧时, 后续包都要进ring
+bool app_link_is_frame(u8 link, u8 *ptr, u16 size)
+{
+    app_link_cb_t *p = &app_link_cb;
+    if (app_link_ring_len() || p->xfer_len) {
+        if (p->link == link && !tick_check_expire(p->rx_tick, APP_LINK_RX_TIMEOUT)) {
+            return true;
+        }
+        p->rptr = p->wptr;                      //超时或换链路, 丢掉半包
+        p->xfer_len = 0;
+        p->xfer_err = 0;
+    }
+    return (size >= 2 && ptr[0] == APP_LINK_SYNC0 && ptr[1] == APP_LINK_SYNC1);
+}
+
+void app_link_rx(u8 link, u8 *ptr, u16 size)
+{
+    app_link_cb_t *p = &app_link_cb;
+    if (p->link != link) {
+        p->rptr = p->wptr;
+        p->xfer_len = 0;
+        p->xfer_err = 0;
+        p->link = link;
+    }
+    p->rx_tick = tick_get();
+    //大包分段写入, 每段写完就解析, 解析后ring里最多剩一个没收完的帧, 不会溢出
+    while (size) {
+        u16 n = APP_LINK_RING_SIZE - app_link_ring_len();
+        if (n > size) {
+            n = size;
+        }
+        app_link_ring_write(ptr, n);
+        app_link_parse();
+        ptr += n;
+        size -= n;
+    }
+}
+#endif // BT_APP_LINK_EN
@@ -0,0 +1,63 @@
+#ifndef _BSP_APP_LINK_H
+#define _BSP_APP_LINK_H
+
+//APP通信帧格式(小端):
+//sync0(0xA5) | sync1(0x5A) | len(2byte, payload长度) | seq(1byte) | flag(1byte) | payload[len] | crc16(2byte)
+//crc16 = calc_crc(&len, len + 4, 0xffff), 即从len到payload结束
+//payload由一条或多条命令组成(批量): type(1byte) | size(2byte) | data[size]
+//一次传输可以拆成多帧(flag带APP_FRM_MORE), seq连续递增, 收齐后统一执行
+
+#define APP_LINK_SYNC0              0xA5
+#define APP_LINK_SYNC1              0x5A
+#define APP_LINK_HEAD_LEN           6
+#define APP_LINK_CRC_SEED           0xffff
+#define APP_LINK_PAYLOAD_MAX        240                         //单帧最大payload
+#define APP_LINK_RING_SIZE          512                         //拼包环形缓存(2的幂)
+#define APP_LINK_XFER_SIZE          (EQ_BUFFER_LEN + 3 * 4)     //一次传输最大长度, 能放下完整12段EQ加几条控制命令
+#define APP_LINK_RX_TIMEOUT         500                         //半包超时丢弃(ms)
+
+//flag
+#define APP_FRM_MORE                BIT(0)      //后面还有属于同一次传输的帧
+#define APP_FRM_NOACK               BIT(1)      //不需要回复ACK
+#define APP_FRM_ACK                 BIT(7)      //ACK帧
+
+//命令类型
+enum {
+    APP_CMD_SYS         = 0x01,     //system control, data: key index
+    APP_CMD_RGB         = 0x02,     //rgb leds control, data: on, r, g, b
+    APP_CMD_OTA         = 0x03,
+    APP_CMD_EQ          = 0x10,     //data: 完整的EQ包("EQ"开头, 同EQ工具格式)
+};
+
+//ACK状态
+enum {
+    APP_ACK_OK = 0,
+    APP_ACK_CRC_ERR,
+    APP_ACK_SEQ_ERR,
+    APP_ACK_OVERFLOW,
+    APP_ACK_CMD_ERR,
+};
+
+//通信链路
+enum {
+    APP_LINK_SPP = 0,
+    APP_LINK_BLE,
+    APP_LINK_UART,
+};
+
+typedef struct {
+    u32 rx_frames;          //正确帧数
+    u32 rx_xfers;           //完整传输次数
+    u16 crc_err;
+    u16 seq_err;
+    u16 overflow;           //ring或传输缓存溢出次数
+    u16 cmd_err;
+} app_link_stat_t;
+
+void app_link_init(void);
+bool app_link_is_frame(u8 link, u8 *ptr, u16 size);
+void app_link_rx(u8 link, u8 *ptr, u16 size);
+const app_link_stat_t *app_link_get_stat(void);
+
+bool bt_app_cmd_exec(u8 cmd, u8 *data, u16 size);
+#endif // _BSP_APP_LINK_H
@@ -61,63 +61,154 @@ const sdadc_cfg_t rec_cfg_tbl[] = {
 
 const u8 btmic_ch_tbl[] = {CH_MIC_PF2, CH_MIC_PF5};
 
-void audio_path_init(u8 path_idx)
+#define AUDIO_PATH_BTMIC_KARAOK     AUDIO_PATH_NUM          //通话KARAOK, 只在缓存里使用
+
+//生成通路配置用到的xcfg_cb设置
+typedef struct {
+    u8 aux_ch;
+    u8 aux_gain[2];
+    u8 mic_ch;
+    u8 mic_gain[2];
+    u8 mic_proc;                            //通话AEC/ALC
+} audio_path_src_t;
+
+typedef struct {
+    sdadc_cfg_t cfg[AUDIO_PATH_NUM + 1];    //按xcfg_cb解析好的通路配置
+    audio_path_src_t src;                   //生成cfg时的设置
+    u8 valid;
+    u8 next;                                //audio_path_exit之后马上要打开的通路
+} audio_path_cb_t;
+
+static audio_path_cb_t audio_path_cb = {.next = AUDIO_PATH_NONE};
+
+static void audio_path_get_src(audio_path_src_t *src)
 {
-    sdadc_cfg_t cfg;
-    memcpy(&cfg, &rec_cfg_tbl[path_idx], sizeof(sdadc_cfg_t));
+    memset(src, 0, sizeof(audio_path_src_t));
+#if FUNC_AUX_EN
+    src->aux_ch = get_aux_channel_cfg();
+    src->aux_gain[0] = xcfg_cb.aux_anl_gain;
+    src->aux_gain[1] = xcfg_cb.aux_dig_gain;
+#endif // FUNC_AUX_EN
+    src->mic_ch = xcfg_cb.bt_ch_mic;
+    src->mic_gain[0] = BT_ANL_GAIN;
+    src->mic_gain[1] = BT_DIG_GAIN;
+#if BT_AEC_EN || BT_ALC_EN
+    src->mic_proc = ((u8)xcfg_cb.bt_aec_en << 1) | xcfg_cb.bt_alc_en;
+#endif
+}
+
+//根据xcfg_cb生成所有通路的配置, 开机调用一次. 之后相关设置有修改时, audio_path_get_cfg发现和生成时不同会重新生成
+void audio_path_cfg_build(void)
+{
+    const u8 mic_path_tbl[] = {AUDIO_PATH_BTMIC, AUDIO_PATH_KARAOK, AUDIO_PATH_BTMIC_KARAOK};
+    sdadc_cfg_t *cfg;
+
+    audio_path_get_src(&audio_path_cb.src);
+    memcpy(audio_path_cb.cfg, rec_cfg_tbl, sizeof(rec_cfg_tbl));
+    memcpy(&audio_path_cb.cfg[AUDIO_PATH_BTMIC_KARAOK], &rec_cfg_tbl[AUDIO_PATH_KARAOK], sizeof(sdadc_cfg_t));
+    audio_path_cb.cfg[AUDIO_PATH_BTMIC_KARAOK].sample_rate = SPR_48000;
 
 #if FUNC_AUX_EN
-    if (path_idx == AUDIO_PATH_AUX) {
-        cfg.channel = (xcfg_cb.auxr_sel << 4) | xcfg_cb.auxl_sel;
-        cfg.gain = ((u16)xcfg_cb.aux_anl_gain << 5) | xcfg_cb.aux_dig_gain;
-    }
+    cfg = &audio_path_cb.cfg[AUDIO_PATH_AUX];
+    cfg->channel = get_aux_channel_cfg();
+    cfg->gain = ((u16)xcfg_cb.aux_anl_gain << 5) | xcfg_cb.aux_dig_gain;
 #endif // FUNC_AUX_EN
 
 #if FUNC_FMRX_EN
-    if (path_idx == AUDIO_PATH_FM) {
-        cfg.gain = ((u16)FMRX_AUX_ANL_GAIN << 5);
-    }
+    audio_path_cb.cfg[AUDIO_PATH_FM].gain = ((u16)FMRX_AUX_ANL_GAIN << 5);
 #endif // FUNC_FMRX_EN
 
-    if (path_idx == AUDIO_PATH_BTMIC || path_idx == AUDIO_PATH_KARAOK) {
-        if (path_idx == AUDIO_PATH_BTMIC) {
-            if (sys_cb.hfp_karaok_en) {
-                memcpy(&cfg, &rec_cfg_tbl[AUDIO_PATH_KARAOK], sizeof(sdadc_cfg_t));
-                cfg.sample_rate = SPR_48000;
-            } else {
-        #if BT_AEC_EN || BT_ALC_EN
-                if (xcfg_cb.bt_aec_en) {
-                    cfg.callback = bt_aec_process;
-                } else if (xcfg_cb.bt_alc_en) {
-                    cfg.callback = bt_alc_process;
-                } else {
-                    cfg.callback = bt_sco_process;
-                }
-        #endif
-            }
-        }
-        cfg.channel = btmic_ch_tbl[xcfg_cb.bt_ch_mic];
-        cfg.gain = ((u16)BT_ANL_GAIN << 5) | BT_DIG_GAIN;
+    cfg = &audio_path_cb.cfg[AUDIO_PATH_BTMIC];
+#if BT_AEC_EN || BT_ALC_EN
+    if (xcfg_cb.bt_aec_en) {
+        cfg->callback = bt_aec_process;
+    } else if (xcfg_cb.bt_alc_en) {
+        cfg->callback = bt_alc_process;
+    } else {
+        cfg->callback = bt_sco_process;
     }
+#endif
+    for (u8 i = 0; i < sizeof(mic_path_tbl); i++) {
+        cfg = &audio_path_cb.cfg[mic_path_tbl[i]];
+        cfg->channel = btmic_ch_tbl[xcfg_cb.bt_ch_mic];
+        cfg->gain = ((u16)BT_ANL_GAIN << 5) | BT_DIG_GAIN;
+    }
+    audio_path_cb.valid = 1;
+}
 
-    sdadc_init(&cfg);
+static const sdadc_cfg_t *audio_path_get_cfg(u8 path_idx)
+{
+    audio_path_src_t src;
+    audio_path_get_src(&src);
+    if (!audio_path_cb.valid || memcmp(&src, &audio_path_cb.src, sizeof(src))) {
+        audio_path_cfg_build();
+    }
+    if (path_idx == AUDIO_PATH_BTMIC && sys_cb.hfp_karaok_en) {
+        path_idx = AUDIO_PATH_BTMIC_KARAOK;
+    }
+    return &audio_path_cb.cfg[path_idx];
 }
 
-void audio_path_start(u8 path_idx)
+#if MICL_MUX_DETECT_LINEIN
+static bool audio_path_is_micl(const sdadc_cfg_t *cfg)
 {
-    sdadc_cfg_t cfg;
-    memcpy(&cfg, &rec_cfg_tbl[path_idx], sizeof(sdadc_cfg_t));
-#if FUNC_AUX_EN
-    if (path_idx == AUDIO_PATH_AUX) {
-        cfg.channel = (xcfg_cb.auxr_sel << 4) | xcfg_cb.auxl_sel;
+    return (((cfg->channel & CHANNEL_L) == CH_MIC_PF2) && (is_linein_det_mux_micl()));
+}
+#endif // MICL_MUX_DETECT_LINEIN
+
+//计算从from通路切换到to通路需要的操作, to为AUDIO_PATH_NONE表示关闭后不再打开其它通路
+u8 audio_path_plan(u8 from, u8 to)
+{
+    u8 ops = 0;
+    const sdadc_cfg_t *cfg_to = NULL;
+
+    if (to != AUDIO_PATH_NONE) {
+        cfg_to = audio_path_get_cfg(to);
+        ops |= AUDIO_OP_SDADC_INIT | AUDIO_OP_SDADC_START;
     }
-#endif // FUNC_AUX_EN
-    if (path_idx == AUDIO_PATH_BTMIC || path_idx == AUDIO_PATH_KARAOK) {
-        cfg.channel = btmic_ch_tbl[xcfg_cb.bt_ch_mic];
+    if (from != AUDIO_PATH_NONE) {
+        ops |= AUDIO_OP_SDADC_EXIT;
+        if (cfg_to == NULL) {
+            ops |= AUDIO_OP_ADPLL_RESTORE;          //后面的通路初始化时会重新设置adpll, 不用先切回DAC_OUT_SPR
+        }
+#if MICL_MUX_DETECT_LINEIN
+        if (audio_path_is_micl(audio_path_get_cfg(from)) && (cfg_to == NULL || !audio_path_is_micl(cfg_to))) {
+            ops |= AUDIO_OP_MICL_RELEASE;
+        }
+#endif // MICL_MUX_DETECT_LINEIN
+    }
+#if MICL_MUX_DETECT_LINEIN
+    if (cfg_to != NULL && audio_path_is_micl(cfg_to) && !sys_cb.micl_en) {
+        ops |= AUDIO_OP_MICL_CLAIM;
     }
+#endif // MICL_MUX_DETECT_LINEIN
+    return ops;
+}
+
+//通路实际配置的采样率, ADC回调里用, 通路打开时配置已经生成
+AT(.com_text.audio)
+u8 audio_path_get_spr(u8 path_idx)
+{
+    return audio_path_cb.cfg[path_idx].sample_rate;
+}
+
+//告诉下一次audio_path_exit马上会打开哪个通路, 只对下一次audio_path_exit有效
+void audio_path_set_next(u8 path_idx)
+{
+    audio_path_cb.next = path_idx;
+}
+
+void audio_path_init(u8 path_idx)
+{
+    sdadc_init(audio_path_get_cfg(path_idx));
+}
+
+void audio_path_start(u8 path_idx)
+{
+    const sdadc_cfg_t *cfg = audio_path_get_cfg(path_idx);
 
 #if MICL_MUX_DETECT_LINEIN
-    if (((cfg.channel & CHANNEL_L) == CH_MIC_PF2) && (is_linein_det_mux_micl())) {
+    if (audio_path_plan(AUDIO_PATH_NONE, path_idx) & AUDIO_OP_MICL_CLAIM) {
         sys_cb.micl_en = 1;
         micl2gnd_flag = 0;
         GPIOFDIR |= BIT(2);
@@ -125,28 +216,19 @@ void audio_path_start(u8 path_idx)
         GPIOFPU &= ~BIT(2);
     }
 #endif // MICL_MUX_DETECT_LINEIN
-    sdadc_start(cfg.channel);
+    sdadc_start(cfg->channel);
 }
 
 void audio_path_exit(u8 path_idx)
 {
-    sdadc_cfg_t cfg;
-    memcpy(&cfg, &rec_cfg_tbl[path_idx], sizeof(sdadc_cfg_t));
+    const sdadc_cfg_t *cfg = audio_path_get_cfg(path_idx);
+    u8 ops = audio_path_plan(path_idx, audio_path_cb.next);
+    audio_path_cb.next = AUDIO_PATH_NONE;
 
-#if FUNC_AUX_EN
-    if (path_idx == AUDIO_PATH_AUX) {
-        cfg.channel = (xcfg_cb.auxr_sel << 4) | xcfg_cb.auxl_sel;
-    }
-#endif // FUNC_AUX_EN
-
-    if (path_idx == AUDIO_PATH_BTMIC || path_idx == AUDIO_PATH_KARAOK) {
-        cfg.channel = btmic_ch_tbl[xcfg_cb.bt_ch_mic];
-    }
-
-    sdadc_exit(cfg.channel);
+    sdadc_exit(cfg->channel);
 
 #if MICL_MUX_DETECT_LINEIN
-    if (((cfg.channel & CHANNEL_L) == CH_MIC_PF2) && (is_linein_det_mux_micl())) {
+    if (ops & AUDIO_OP_MICL_RELEASE) {
         GPIOFDIR |= BIT(2);
         GPIOFDE |= BIT(2);
         GPIOFPU |= BIT(2);
@@ -156,7 +238,9 @@ void audio_path_exit(u8 path_idx)
     }
 #endif // MICL_MUX_DETECT_LINEIN
 
-    adpll_spr_set(DAC_OUT_SPR);
+    if (ops & AUDIO_OP_ADPLL_RESTORE) {
+        adpll_spr_set(DAC_OUT_SPR);
+    }
 }
 
 u8 get_aux_channel_cfg(void)
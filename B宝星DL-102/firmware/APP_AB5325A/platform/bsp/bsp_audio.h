@@ -7,7 +7,21 @@
 #define AUDIO_PATH_BTMIC           3
 #define AUDIO_PATH_USBMIC          4
 #define AUDIO_PATH_KARAOK          5
+#define AUDIO_PATH_NUM             6
+#define AUDIO_PATH_NONE            0xff
 
+//通路切换操作
+#define AUDIO_OP_SDADC_EXIT        BIT(0)
+#define AUDIO_OP_MICL_RELEASE      BIT(1)      //MICL切回LINEIN检测
+#define AUDIO_OP_ADPLL_RESTORE     BIT(2)      //adpll切回DAC_OUT_SPR
+#define AUDIO_OP_SDADC_INIT        BIT(3)
+#define AUDIO_OP_MICL_CLAIM        BIT(4)      //MICL从LINEIN检测切到MIC
+#define AUDIO_OP_SDADC_START       BIT(5)
+
+void audio_path_cfg_build(void);
+u8 audio_path_plan(u8 from, u8 to);
+u8 audio_path_get_spr(u8 path_idx);
+void audio_path_set_next(u8 path_idx);
 void audio_path_init(u8 path_idx);
 void audio_path_exit(u8 path_idx);
 void audio_path_start(u8 path_idx);
@@ -3,19 +3,59 @@
 
 #if LE_EN
 
-#define BLE_CMD_BUF_LEN     4
+#define BLE_MTU_DEF         23                      //默认ATT MTU, 没有交换MTU时用这个
+#define BLE_MTU_MAX         247
+
+#define BLE_CMD_BUF_LEN     8                       //接收队列(2的幂)
 #define BLE_CMD_BUF_MASK    (BLE_CMD_BUF_LEN - 1)
+#define BLE_CMD_DATA_MAX    (BLE_MTU_DEF - 3)
+
+#define BLE_TX_RING_SIZE    512                     //发送数据环形缓存(2的幂), 能放下两个最大的APP帧
+#define BLE_TX_RING_MASK    (BLE_TX_RING_SIZE - 1)
+#define BLE_TX_DESC_NUM     8                       //发送队列里最多几个包(2的幂)
+#define BLE_TX_DESC_MASK    (BLE_TX_DESC_NUM - 1)
+#define BLE_TX_INTERVAL     15                      //发送节拍(ms), 跟连接间隔一致
+#define BLE_TX_CREDITS      2                       //每个节拍最多交给协议栈几包
+
+#define BLE_TX_COALESCE     BIT(0)                  //状态包: 还没发出去时, 新的同类包直接覆盖
+
+#define BLE_IDX_BAT         0                       //att_hdl_tbl里电量通道的序号
+#define BLE_IDX_APP         1                       //att_hdl_tbl里APP通道的序号
+#define BLE_BAT_INTERVAL    1000                    //电量变化检查周期(ms)
 
 struct ble_cmd_t{
     u8 len;
     u16 handle;
-    u8 buf[20];
+    u8 buf[BLE_CMD_DATA_MAX];
+};
+
+struct ble_tx_t {
+    u16 pos;                                        //数据在ring里的起始位置(未取模)
+    u16 len;
+    u16 sent;                                       //已经发出去的字节数
+    u8 index;                                       //att_hdl_tbl序号
+    u8 flag;
 };
 
 struct ble_cb_t {
     struct ble_cmd_t cmd[BLE_CMD_BUF_LEN];
     u8 cmd_rptr;
     u8 cmd_wptr;
+
+    struct ble_tx_t tx[BLE_TX_DESC_NUM];
+    u8 tx_rptr;
+    u8 tx_wptr;
+    u16 ring_rptr;
+    u16 ring_wptr;
+    u8 ring[BLE_TX_RING_SIZE];
+    u8 seg[BLE_MTU_MAX - 3];                        //跨ring边界的分包拷到这里再发
+    u16 mtu;
+    u8 credit;
+    u32 tick;
+    u8 bat_notify;                                  //手机打开了电量通知
+    u8 bat_level;                                   //最后发出的电量, 0xff表示要重新发
+    u32 bat_tick;
+    ble_stat_t stat;
 }ble_cb;
 
 const uint8_t adv_data_const[] = {
@@ -108,12 +148,8 @@ u32 ble_get_adv_data(u8 *adv_buf, u32 buf_size)
 uint ble_get_bat_level(void)
 {
 #if VBAT_DETECT_EN
-    //计算方法：level = (实测电压 - 关机电压) / ((满电电压 - 关机电压) / 100)
-    u16 bat_off = LPWR_OFF_VBAT * 100 + 2700;
-    if (bat_off > sys_cb.vbat) {
-        return 0;
-    }
-    uint bat_level = (sys_cb.vbat - bat_off) / ((4200 - bat_off) / 100);
+    //按开路电压曲线计算, 0对应关机电压
+    uint bat_level = fuel_get_level();
 //    printf("bat level: %d %d\n", sys_cb.vbat, bat_level);
     return bat_level;
 #else
@@ -127,8 +163,9 @@ void ble_init_att(void)
 //    buffer[0] = ble_get_bat_level();
 //    ble_init_att_do(BLE_IDX_BATTERY, att_hdl_tbl[BLE_IDX_BATTERY].hdl, att_hdl_tbl[BLE_IDX_BATTERY].cfg, buffer, 1);   //初始化电量
     memset(&ble_cb, 0, sizeof(struct ble_cb_t));
+    ble_cb.mtu = BLE_MTU_DEF;
     memset(buffer, 0, 4);
-    for (int i = 0; i < (sizeof(att_hdl_tbl) / sizeof(struct att_hdl_t)); i++) {
+    for (uint i = 0; i < (sizeof(att_hdl_tbl) / sizeof(struct att_hdl_t)); i++) {
         ble_init_att_do(i, att_hdl_tbl[i].hdl, att_hdl_tbl[i].cfg, buffer, 4);
     }
 }
@@ -143,36 +180,195 @@ void ble_get_local_bd_addr(u8 *addr)
     memset(addr, 0xaa, 6);
 }
 
+//协议栈里调用, 主循环在bsp_ble_process里取. 满了丢新包, 不覆盖还没处理的命令
 u8 ble_att_write_callback(u16 handle, u8 *ptr, u8 len)
 {
     printf("BLE RX:");
     print_r(ptr, len);
 
+    if (len > BLE_CMD_DATA_MAX) {
+        ble_cb.stat.rx_oversize++;
+        return false;
+    }
+    if ((u8)(ble_cb.cmd_wptr - ble_cb.cmd_rptr) >= BLE_CMD_BUF_LEN) {
+        ble_cb.stat.rx_drop++;
+        return false;
+    }
     u8 wptr = ble_cb.cmd_wptr & BLE_CMD_BUF_MASK;
-    ble_cb.cmd_wptr++;
     memcpy(ble_cb.cmd[wptr].buf, ptr, len);
     ble_cb.cmd[wptr].len = len;
     ble_cb.cmd[wptr].handle = handle;
+    ble_cb.cmd_wptr++;                              //数据写完再移指针
     return true;
 }
 
-bool ble_send_packet(u8 *buf, u8 len)
+static void ble_tx_ring_write(u16 pos, u8 *buf, u16 len)
+{
+    u16 ofs = pos & BLE_TX_RING_MASK;
+    u16 n = BLE_TX_RING_SIZE - ofs;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(&ble_cb.ring[ofs], buf, n);
+    memcpy(ble_cb.ring, buf + n, len - n);
+}
+
+//返回分包数据的地址, 跨边界时拷到seg里
+static u8 *ble_tx_ring_read(u16 pos, u16 len)
 {
-    if (buf == NULL || len > 20) {
+    u16 ofs = pos & BLE_TX_RING_MASK;
+    u16 n = BLE_TX_RING_SIZE - ofs;
+    if (n >= len) {
+        return &ble_cb.ring[ofs];
+    }
+    memcpy(ble_cb.seg, &ble_cb.ring[ofs], n);
+    memcpy(ble_cb.seg + n, ble_cb.ring, len - n);
+    return ble_cb.seg;
+}
+
+static void ble_tx_flush(void)
+{
+    ble_cb.tx_rptr = ble_cb.tx_wptr;
+    ble_cb.ring_rptr = ble_cb.ring_wptr;
+}
+
+//放进发送队列, 不等待. 整包放不下时返回false, 不会只放一半
+static bool ble_tx_queue(u8 index, u8 *buf, u16 len, u8 flag)
+{
+    struct ble_tx_t *tx;
+    if (buf == NULL || len == 0 || len > BLE_TX_RING_SIZE) {
         return false;
     }
-    static u32 ble_tick = 0;
-    while (!tick_check_expire(ble_tick, 30)) {     //延时30ms再发
-        delay_5ms(2);
+    if (flag & BLE_TX_COALESCE) {
+        //同一通道还没开始发的状态包, 长度一样就直接覆盖内容
+        for (u8 i = ble_cb.tx_rptr; i != ble_cb.tx_wptr; i++) {
+            tx = &ble_cb.tx[i & BLE_TX_DESC_MASK];
+            if (tx->index == index && (tx->flag & BLE_TX_COALESCE) && tx->sent == 0 && tx->len == len) {
+                ble_tx_ring_write(tx->pos, buf, len);
+                ble_cb.stat.tx_coalesce++;
+                return true;
+            }
+        }
+    }
+    if ((u8)(ble_cb.tx_wptr - ble_cb.tx_rptr) >= BLE_TX_DESC_NUM
+        || (u16)(ble_cb.ring_wptr - ble_cb.ring_rptr) + len > BLE_TX_RING_SIZE) {
+        ble_cb.stat.tx_drop++;
+        return false;
+    }
+    tx = &ble_cb.tx[ble_cb.tx_wptr & BLE_TX_DESC_MASK];
+    tx->pos = ble_cb.ring_wptr;
+    tx->len = len;
+    tx->sent = 0;
+    tx->index = index;
+    tx->flag = flag;
+    ble_tx_ring_write(tx->pos, buf, len);
+    ble_cb.ring_wptr += len;
+    ble_cb.tx_wptr++;
+    return true;
+}
+
+//按MTU分包, 每个节拍最多发BLE_TX_CREDITS包, 协议栈忙就等下个节拍
+static void ble_tx_process(void)
+{
+    if (ble_cb.tx_rptr == ble_cb.tx_wptr) {
+        return;
+    }
+    if (!le_is_connect()) {
+        ble_tx_flush();
+        return;
+    }
+    if (tick_check_expire(ble_cb.tick, BLE_TX_INTERVAL)) {
+        ble_cb.tick = tick_get();
+        ble_cb.credit = BLE_TX_CREDITS;
+        ble_set_mtu(le_get_gatt_mtu() + 3);         //手机随时可能交换MTU, 每个节拍取一次
+    }
+    while (ble_cb.credit > 0 && ble_cb.tx_rptr != ble_cb.tx_wptr) {
+        struct ble_tx_t *tx = &ble_cb.tx[ble_cb.tx_rptr & BLE_TX_DESC_MASK];
+        u16 len = tx->len - tx->sent;
+        if (len > ble_cb.mtu - 3) {
+            len = ble_cb.mtu - 3;
+        }
+        u8 *buf = ble_tx_ring_read(tx->pos + tx->sent, len);
+        if (!le_tx_notify(tx->index, buf, len)) {
+            ble_cb.stat.tx_busy++;
+            ble_cb.credit = 0;
+            break;
+        }
+        printf("BLE TX:");
+        print_r(buf, len);
+        ble_cb.credit--;
+        ble_cb.stat.tx_pkts++;
+        ble_cb.stat.tx_bytes += len;
+        tx->sent += len;
+        if (tx->sent >= tx->len) {
+            ble_cb.ring_rptr = tx->pos + tx->len;
+            ble_cb.tx_rptr++;
+        }
+    }
+}
+
+//APP数据, 长度不限于一包, 发送时按MTU分包
+bool ble_send_packet(u8 *buf, u16 len)
+{
+    return ble_tx_queue(BLE_IDX_APP, buf, len, 0);
+}
+
+//状态同步, 还没发出去的旧状态会被覆盖, 不会排队
+bool ble_send_status(u8 index, u8 *buf, u16 len)
+{
+    return ble_tx_queue(index, buf, len, BLE_TX_COALESCE);
+}
+
+//库里没有MTU交换的回调, 在CCCD回调和每个发送节拍里按le_get_gatt_mtu()更新
+void ble_set_mtu(u16 mtu)
+{
+    if (mtu < BLE_MTU_DEF) {
+        mtu = BLE_MTU_DEF;
+    } else if (mtu > BLE_MTU_MAX) {
+        mtu = BLE_MTU_MAX;
+    }
+    ble_cb.mtu = mtu;
+}
+
+const ble_stat_t *ble_get_stat(void)
+{
+    return &ble_cb.stat;
+}
+
+//协议栈里调用: 手机写CCCD(打开/关闭通知), 一般在交换MTU之后
+void ble_client_cfg_callback(u16 handle, u8 cfg)
+{
+    ble_set_mtu(le_get_gatt_mtu() + 3);
+    if (handle == att_hdl_tbl[BLE_IDX_BAT].hdl + 1) {
+        ble_cb.bat_notify = cfg & BIT(0);
+        ble_cb.bat_level = 0xff;                    //打开通知后马上发一次当前电量
+    }
+}
+
+//电量变化时发通知. 走状态包, 还没发出去的旧电量直接被覆盖
+static void ble_bat_process(void)
+{
+    if (!le_is_connect()) {
+        ble_cb.bat_notify = 0;                      //断开后等手机重新打开通知
+        return;
+    }
+    if (!ble_cb.bat_notify) {
+        return;
+    }
+    if (ble_cb.bat_level != 0xff && !tick_check_expire(ble_cb.bat_tick, BLE_BAT_INTERVAL)) {
+        return;
+    }
+    ble_cb.bat_tick = tick_get();
+    u8 level = ble_get_bat_level();
+    if (level != ble_cb.bat_level && ble_send_status(BLE_IDX_BAT, &level, 1)) {
+        ble_cb.bat_level = level;
     }
-    ble_tick = tick_get();
-    printf("BLE TX:");
-    print_r(buf, len);
-    return le_tx_notify(1, buf, len);
 }
 
 void bsp_ble_process(void)
 {
+    ble_bat_process();
+    ble_tx_process();
     if (ble_cb.cmd_rptr == ble_cb.cmd_wptr) {
         return;
     }
@@ -182,6 +378,12 @@ void bsp_ble_process(void)
     u8 len = ble_cb.cmd[rptr].len;
     u16 handle = ble_cb.cmd[rptr].handle;
     if (handle == 0x0009) {             //兼容旧版APP
+#if BT_APP_LINK_EN
+        if (app_link_is_frame(APP_LINK_BLE, ptr, len)) {
+            app_link_rx(APP_LINK_BLE, ptr, len);
+            return;
+        }
+#endif // BT_APP_LINK_EN
         bt_app_cmd_process(ptr, len);
     }
 }
@@ -7,6 +7,16 @@ struct att_hdl_t {
     u8 res;
 };
 
+typedef struct {
+    u32 tx_bytes;
+    u32 tx_pkts;
+    u16 tx_drop;            //发送队列满丢掉的包
+    u16 tx_coalesce;        //被新状态覆盖的状态包
+    u16 tx_busy;            //协议栈忙, 推迟到下个节拍
+    u16 rx_drop;            //接收队列满丢掉的命令
+    u16 rx_oversize;        //超过缓存长度丢掉的命令
+} ble_stat_t;
+
 //enum {
 //    BLE_IDX_BATTERY,
 //    BLE_IDX_OLD_APP,
@@ -18,5 +28,8 @@ struct att_hdl_t {
 void bsp_ble_process(void);
 void ble_init_att_do(u8 index, u16 handle, u8 config , u8* buf, u8 len);
 void bt_app_cmd_process(u8 *ptr, u16 size);
-bool ble_send_packet(u8 *buf, u8 len);
+bool ble_send_packet(u8 *buf, u16 len);
+bool ble_send_status(u8 index, u8 *buf, u16 len);
+void ble_set_mtu(u16 mtu);
+const ble_stat_t *ble_get_stat(void);
 #endif
@@ -311,12 +311,8 @@ uint hfp_get_spk_gain(void)
 uint hfp_get_bat_level(void)
 {
 #if VBAT_DETECT_EN
-    //计算方法：level = (实测电压 - 关机电压) / ((满电电压 - 关机电压) / 10)
-    u16 bat_off = LPWR_OFF_VBAT * 100 + 2700;
-    if (bat_off > sys_cb.vbat) {
-        return 0;
-    }
-    uint bat_level = (sys_cb.vbat - bat_off) / ((4200 - bat_off) / 10);
+    //计算方法：level = 电量计百分比 / 10
+    uint bat_level = fuel_get_level() / 10;
     if (bat_level) {
         bat_level--;
     }
@@ -138,6 +138,21 @@ bool bsp_set_volume(u8 vol)
     return true;
 }
 
+//dac_pcm_pow_calc()读完会重新开始硬件统计(DNR库里也在用), 多处调用会互相缩短统计时间.
+//应用层(频谱VU, 电量计)统一从这里读, DAC_POW_INTERVAL内重复读返回上次的值
+static u16 dac_pow_last;
+static u32 dac_pow_tick;
+
+AT(.com_text.dac)
+u16 dac_pcm_pow_get(void)
+{
+    if (tick_check_expire(dac_pow_tick, DAC_POW_INTERVAL)) {
+        dac_pow_tick = tick_get();
+        dac_pow_last = dac_pcm_pow_calc();
+    }
+    return dac_pow_last;
+}
+
 //开机控制DAC电容放电等待时间
 AT(.text.dac)
 void dac_pull_down_delay(void)
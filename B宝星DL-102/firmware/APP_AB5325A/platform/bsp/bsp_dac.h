@@ -65,6 +65,8 @@
 #define DIG_N59DB           (MAX_DIG_VAL / 891.250938)
 #define DIG_N60DB           0
 
+#define DAC_POW_INTERVAL    20          //dac_pcm_pow_get()多久(ms)读一次硬件
+
 extern const uint16_t tbl_sample_rate[10];
 
 u8 bsp_volume_inc(u8 vol);
@@ -76,4 +78,5 @@ void dac_set_anl_offset(u8 bt_call_flag);
 void dac_dnr_init(u8 voice_cnt, u16 voice_pow, u8 silence_cnt, u16 silence_pow);
 void dac_dnr_set_sta(u8 sta);
 u8 dac_dnr_get_sta(void);
+u16 dac_pcm_pow_get(void);
 #endif // _BSP_DAC_H
@@ -24,6 +24,7 @@ typedef struct  {
 
 typedef struct {
     u8 rx_type;
+    u8 rx_busy;             //APP_LINK的EQ包已放进eq_rx_buf, 等EVT_ONLINE_SET_EQ处理
     eq_spp_cb_t eq_spp_cb;
 }eq_dbg_cb_t;
 
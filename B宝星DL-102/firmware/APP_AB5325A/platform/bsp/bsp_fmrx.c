@@ -188,6 +188,38 @@ u8 bsp_fmrx_check_freq(u16 freq)
     return ret;
 }
 
+//判台并返回电台质量, 0:不是电台, 值越大信号越好, 用于搜台细扫排序
+AT(.text.bsp.fmrx)
+u8 bsp_fmrx_seek_quality(u16 freq)
+{
+    u8 ret = 0;
+#if FMRX_INSIDE_EN
+    if (sys_cb.fmrx_type == FMRX_INSIDE) {
+        ret = fmrx_check_freq(freq) ? 1 : 0;    //内置收音只有判台结果
+    }
+#endif
+
+#if FMRX_QN8035_EN
+    if (sys_cb.fmrx_type == FMRX_QN8035) {
+        ret = qn8035_seek_quality(freq);
+    }
+#endif
+
+    return ret;
+}
+
+//bsp_fmrx_seek_quality是否有质量高低, 内置收音只有0/1
+AT(.text.bsp.fmrx)
+bool bsp_fmrx_quality_graded(void)
+{
+#if FMRX_QN8035_EN
+    if (sys_cb.fmrx_type == FMRX_QN8035) {
+        return true;
+    }
+#endif
+    return false;
+}
+
 //AT(.text.bsp.fmrx)
 //void bsp_fmrx_logger_out(void)
 //{
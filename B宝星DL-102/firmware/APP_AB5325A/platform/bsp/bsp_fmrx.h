@@ -24,6 +24,8 @@ void bsp_fmrx_exit(void);
 void bsp_fmrx_get_type(void);
 void bsp_fmrx_set_volume(u8 vol);
 u8 bsp_fmrx_check_freq(u16 freq);
+u8 bsp_fmrx_seek_quality(u16 freq);
+bool bsp_fmrx_quality_graded(void);
 void bsp_fmrx_set_freq(u16 freq);
 void bsp_fmrx_set_loc_dx(u8 loc_flag);
 void bsp_fmrx_logger_out(void);
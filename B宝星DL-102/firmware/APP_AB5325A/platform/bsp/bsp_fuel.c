@@ -0,0 +1,125 @@
+#include "include.h"
+#include "bsp_fuel.h"
+
+#if VBAT_DETECT_EN
+
+#define FUEL_TBL_NUM                (sizeof(fuel_ocv_mv) / sizeof(fuel_ocv_mv[0]))
+
+typedef struct {
+    s32 ema;                    //开路电压估计, mV << FUEL_EMA_FRAC, 0表示还没有采样
+    u8 level;                   //上报的电量(%)
+    u8 level_valid;
+    u8 charge;                  //上次计算电量时的充电状态
+} fuel_cb_t;
+
+static fuel_cb_t fuel_cb;
+
+//单节锂电开路电压-电量曲线(静置后测得)
+static const u16 fuel_ocv_mv[] = {
+    3300, 3500, 3600, 3680, 3730, 3770, 3800, 3840, 3890, 3950, 4020, 4100, 4180,
+};
+static const u8 fuel_ocv_soc[] = {
+       0,    3,    6,   12,   20,   32,   44,   55,   65,   75,   85,   94,  100,
+};
+
+//播放时的电流跟输出能量和音量的平方成正比, 压降按满幅满音量时的FUEL_LOAD_DROP_MAX折算
+AT(.com_text.fuel)
+static u16 fuel_load_drop(void)
+{
+    u32 pow = dac_pcm_pow_get();          //和频谱VU共用一次硬件统计
+    u32 vol_max = VOL_MAX;
+    if (pow == 0 || vol_max == 0) {
+        return 0;
+    }
+    if (pow > FUEL_LOAD_POW_FULL) {
+        pow = FUEL_LOAD_POW_FULL;
+    }
+    u32 drop = (u32)FUEL_LOAD_DROP_MAX * pow / FUEL_LOAD_POW_FULL;
+    return drop * sys_cb.vol * sys_cb.vol / (vol_max * vol_max);
+}
+
+//每次电压采样调用, 返回补偿并滤波后的开路电压估计
+AT(.com_text.fuel)
+u16 fuel_filter(u16 vbat)
+{
+    s32 ocv = vbat;
+    if (CHARGE_DC_IN()) {
+        ocv -= FUEL_CHARGE_RISE;
+    } else {
+        ocv += fuel_load_drop();
+    }
+    if (fuel_cb.ema == 0) {
+        fuel_cb.ema = ocv << FUEL_EMA_FRAC;
+    } else {
+        fuel_cb.ema += ((ocv << FUEL_EMA_FRAC) - fuel_cb.ema) >> FUEL_EMA_SHIFT;
+    }
+    return fuel_cb.ema >> FUEL_EMA_FRAC;
+}
+
+AT(.com_text.fuel)
+u16 fuel_get_ocv(void)
+{
+    if (fuel_cb.ema == 0) {
+        return sys_cb.vbat;                 //没打开VBAT_FUEL_GAUGE_EN时, 直接用采样电压
+    }
+    return fuel_cb.ema >> FUEL_EMA_FRAC;
+}
+
+//低电提醒按补偿后的开路电压判断, 大音量播放时端电压的瞬时下跌不会提前报低电.
+//没打开VBAT_FUEL_GAUGE_EN时fuel_get_ocv()就是sys_cb.vbat, 和原来一样
+AT(.text.bsp.fuel)
+bool fuel_lowbat_warning(void)
+{
+    return fuel_get_ocv() < ((u16)LPWR_WARNING_VBAT * 100 + 2800);
+}
+
+//查表线性插值, 返回0~100
+AT(.text.bsp.fuel)
+static uint fuel_ocv_to_soc(u16 mv)
+{
+    uint i;
+    if (mv <= fuel_ocv_mv[0]) {
+        return 0;
+    }
+    for (i = 1; i < FUEL_TBL_NUM; i++) {
+        if (mv < fuel_ocv_mv[i]) {
+            return fuel_ocv_soc[i - 1] + (uint)(fuel_ocv_soc[i] - fuel_ocv_soc[i - 1]) * (mv - fuel_ocv_mv[i - 1])
+                                         / (fuel_ocv_mv[i] - fuel_ocv_mv[i - 1]);
+        }
+    }
+    return 100;
+}
+
+//level:0~100, 0对应低电关机电压
+AT(.text.bsp.fuel)
+uint fuel_get_level(void)
+{
+    uint soc_off = fuel_ocv_to_soc(LPWR_OFF_VBAT * 100 + 2700);
+    uint soc = fuel_ocv_to_soc(fuel_get_ocv());
+    u8 charge = CHARGE_DC_IN() ? 1 : 0;
+    uint level;
+
+    if (soc_off >= 100) {
+        return 0;
+    }
+    level = (soc > soc_off) ? (soc - soc_off) * 100 / (100 - soc_off) : 0;
+    if (!fuel_cb.level_valid || charge != fuel_cb.charge) {
+        //开机或插拔充电器后, 直接采用新值
+        fuel_cb.level = level;
+        fuel_cb.level_valid = 1;
+        fuel_cb.charge = charge;
+    } else if (charge) {
+        //充电时只升不降, 回落超过回差才跟随
+        if (level > fuel_cb.level || level + FUEL_HYST <= fuel_cb.level) {
+            fuel_cb.level = level;
+        }
+    } else {
+        //放电时只降不升, 静置回升超过回差才跟随
+        if (level < fuel_cb.level || level >= (uint)fuel_cb.level + FUEL_HYST) {
+            fuel_cb.level = level;
+        }
+    }
+    return fuel_cb.level;
+}
+
+#endif // VBAT_DETECT_EN
@@ -0,0 +1,17 @@
+#ifndef _BSP_FUEL_H
+#define _BSP_FUEL_H
+
+//电量计: 采样电压 -> 补偿内阻压降/充电抬升 -> EMA -> 查OCV曲线得到电量
+#define FUEL_EMA_SHIFT              9           //EMA系数1/512, 5ms采样时时间常数约2.5s
+#define FUEL_EMA_FRAC               8           //EMA内部保留的小数位
+#define FUEL_LOAD_DROP_MAX          250         //最大音量满幅输出时电池内阻上的压降(mV), 按方案实测调整
+#define FUEL_LOAD_POW_FULL          45000       //满幅输出时dac_pcm_pow_get()的值
+#define FUEL_CHARGE_RISE            120         //充电时端电压比开路电压高出的值(mV)
+#define FUEL_HYST                   3           //电量反向变化的回差(%), 放电时不回升, 充电时不回落
+
+u16 fuel_filter(u16 vbat);
+u16 fuel_get_ocv(void);
+uint fuel_get_level(void);
+bool fuel_lowbat_warning(void);
+
+#endif // _BSP_FUEL_H
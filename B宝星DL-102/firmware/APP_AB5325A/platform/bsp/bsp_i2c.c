@@ -9,7 +9,8 @@
 //        asm("nop");
 //    }
 //}
-#define bsp_i2c_delay() delay_us(5)
+static u8 i2c_delay = I2C_DELAY_STD;
+#define bsp_i2c_delay() delay_us(i2c_delay)
 
 //ACK: The transmitter releases the SDA line (HIGH->LOW) during the acknowledge clock pulse
 AT(.text.bsp.i2c)
@@ -130,4 +131,220 @@ void bsp_i2c_init(void)
     I2C_SDA_H();
     delay_5ms(2);
 }
+
+/*****************************************************************************
+ * I2C设备层
+ *****************************************************************************/
+AT(.text.bsp.i2c)
+static bool i2c_dev_is_valid(i2c_dev_t *dev, u8 reg)
+{
+    return (dev->valid[reg >> 5] & BIT(reg & 0x1f)) != 0;
+}
+
+AT(.text.bsp.i2c)
+static bool i2c_dev_is_nocache(i2c_dev_t *dev, u8 reg)
+{
+    return (dev->nocache != NULL) && (dev->nocache[reg >> 5] & BIT(reg & 0x1f));
+}
+
+AT(.text.bsp.i2c)
+static u16 i2c_dev_get_shadow(i2c_dev_t *dev, u8 reg)
+{
+    if (dev->flag & I2C_DEV_REG9) {
+        return ((u16 *)dev->shadow)[reg];
+    }
+    return ((u8 *)dev->shadow)[reg];
+}
+
+AT(.text.bsp.i2c)
+static void i2c_dev_set_shadow(i2c_dev_t *dev, u8 reg, u16 val)
+{
+    if (reg >= dev->reg_num) {
+        return;
+    }
+    if (dev->flag & I2C_DEV_REG9) {
+        ((u16 *)dev->shadow)[reg] = val;
+    } else {
+        ((u8 *)dev->shadow)[reg] = (u8)val;
+    }
+    dev->valid[reg >> 5] |= BIT(reg & 0x1f);
+}
+
+//影子里已经是这个值, 不需要再写
+AT(.text.bsp.i2c)
+static bool i2c_dev_is_clean(i2c_dev_t *dev, u8 reg, u16 val)
+{
+    if (reg >= dev->reg_num || i2c_dev_is_nocache(dev, reg) || !i2c_dev_is_valid(dev, reg)) {
+        return false;
+    }
+    return (i2c_dev_get_shadow(dev, reg) == val);
+}
+
+AT(.text.bsp.i2c)
+static void i2c_dev_tx(i2c_dev_t *dev, u8 dat)
+{
+    bsp_i2c_tx_byte(dat);
+    bsp_i2c_rx_ack();
+    dev->stat.bytes++;
+}
+
+//批量写中已经START过, 再次调用就是重复START, 不用STOP
+AT(.text.bsp.i2c)
+static void i2c_dev_bus_start(i2c_dev_t *dev, u8 addr)
+{
+    if (!dev->open) {
+#if I2C_FAST_MODE_EN
+        i2c_delay = (dev->flag & I2C_DEV_FAST) ? I2C_DELAY_FAST : I2C_DELAY_STD;
+#endif
+        dev->open = 1;
+        dev->stat.trans++;
+    } else {
+        bsp_i2c_delay();                //重复START之前SCL已经是低, 保持够半个时钟再拉高
+    }
+    dev->stat.start++;
+    bsp_i2c_start();
+    i2c_dev_tx(dev, addr);
+}
+
+AT(.text.bsp.i2c)
+static void i2c_dev_bus_stop(i2c_dev_t *dev)
+{
+    bsp_i2c_stop();
+    if (dev->gap_us) {
+        delay_us(dev->gap_us);
+    }
+    i2c_delay = I2C_DELAY_STD;          //直接调用bsp_i2c_xxx的驱动还用标准时序
+    dev->open = 0;
+}
+
+AT(.text.bsp.i2c)
+static void i2c_dev_bus_write(i2c_dev_t *dev, u8 reg, u16 val)
+{
+    i2c_dev_bus_start(dev, dev->addr);
+    if (dev->flag & I2C_DEV_REG9) {
+        i2c_dev_tx(dev, (reg << 1) | ((val >> 8) & 0x01));
+    } else {
+        i2c_dev_tx(dev, reg);
+    }
+    i2c_dev_tx(dev, (u8)val);
+    i2c_dev_set_shadow(dev, reg, val);
+    if (!dev->batch) {
+        i2c_dev_bus_stop(dev);
+    }
+}
+
+//芯片复位或掉电后调用, 之后的写都会重新访问总线
+AT(.text.bsp.i2c)
+void i2c_dev_invalidate(i2c_dev_t *dev)
+{
+    memset(dev->valid, 0, ((dev->reg_num + 31) >> 5) * sizeof(u32));
+}
+
+//芯片复位后寄存器为已知默认值, 直接装入影子
+AT(.text.bsp.i2c)
+void i2c_dev_sync(i2c_dev_t *dev, const void *val)
+{
+    memcpy(dev->shadow, val, dev->reg_num * ((dev->flag & I2C_DEV_REG9) ? sizeof(u16) : sizeof(u8)));
+    memset(dev->valid, 0xff, ((dev->reg_num + 31) >> 5) * sizeof(u32));
+}
+
+//begin/end之间的寄存器写合并成一次传输(重复START), 可以嵌套
+AT(.text.bsp.i2c)
+void i2c_dev_batch_begin(i2c_dev_t *dev)
+{
+    dev->batch++;
+}
+
+AT(.text.bsp.i2c)
+void i2c_dev_batch_end(i2c_dev_t *dev)
+{
+    if (dev->batch && --dev->batch == 0 && dev->open) {
+        i2c_dev_bus_stop(dev);
+    }
+}
+
+//返回true表示访问了总线, false表示和影子相同被跳过
+AT(.text.bsp.i2c)
+bool i2c_dev_write(i2c_dev_t *dev, u8 reg, u16 val)
+{
+    if (i2c_dev_is_clean(dev, reg, val)) {
+        dev->stat.skip++;
+        return false;
+    }
+    i2c_dev_bus_write(dev, reg, val);
+    return true;
+}
+
+//音量更新位之类的寄存器, 值相同也要写
+AT(.text.bsp.i2c)
+void i2c_dev_write_force(i2c_dev_t *dev, u8 reg, u16 val)
+{
+    i2c_dev_bus_write(dev, reg, val);
+}
+
+//连续寄存器写, 去掉首尾没有变化的寄存器, 支持地址自增的设备一次传输写完
+AT(.text.bsp.i2c)
+void i2c_dev_write_burst(i2c_dev_t *dev, u8 reg, const u8 *buf, u8 cnt)
+{
+    while (cnt && i2c_dev_is_clean(dev, reg, buf[0])) {
+        reg++;
+        buf++;
+        cnt--;
+        dev->stat.skip++;
+    }
+    while (cnt && i2c_dev_is_clean(dev, reg + cnt - 1, buf[cnt - 1])) {
+        cnt--;
+        dev->stat.skip++;
+    }
+    if (cnt == 0) {
+        return;
+    }
+
+    if ((dev->flag & (I2C_DEV_AUTO_INC | I2C_DEV_REG9)) != I2C_DEV_AUTO_INC) {
+        i2c_dev_batch_begin(dev);
+        for (u8 i = 0; i < cnt; i++) {
+            i2c_dev_write(dev, reg + i, buf[i]);
+        }
+        i2c_dev_batch_end(dev);
+        return;
+    }
+
+    i2c_dev_bus_start(dev, dev->addr);
+    i2c_dev_tx(dev, reg);
+    for (u8 i = 0; i < cnt; i++) {
+        i2c_dev_tx(dev, buf[i]);
+        i2c_dev_set_shadow(dev, reg + i, buf[i]);
+    }
+    if (!dev->batch) {
+        i2c_dev_bus_stop(dev);
+    }
+}
+
+//普通寄存器影子有效时不访问总线, I2C_DEV_REG9设备只能读影子
+AT(.text.bsp.i2c)
+u16 i2c_dev_read(i2c_dev_t *dev, u8 reg)
+{
+    u8 dat;
+    if (reg < dev->reg_num) {
+        if ((dev->flag & I2C_DEV_REG9) || (!i2c_dev_is_nocache(dev, reg) && i2c_dev_is_valid(dev, reg))) {
+            return i2c_dev_get_shadow(dev, reg);
+        }
+    }
+    if (dev->open) {
+        i2c_dev_bus_stop(dev);          //批量写中间读, 先结束前面的写
+    }
+
+    i2c_dev_bus_start(dev, dev->addr);
+    i2c_dev_tx(dev, reg);
+    i2c_dev_bus_stop(dev);
+
+    i2c_dev_bus_start(dev, dev->addr | 0x01);
+    dat = bsp_i2c_rx_byte();
+    bsp_i2c_tx_nack();
+    dev->stat.bytes++;
+    i2c_dev_bus_stop(dev);
+
+    i2c_dev_set_shadow(dev, reg, dat);
+    return dat;
+}
 #endif
@@ -10,4 +10,44 @@ bool bsp_i2c_rx_ack(void);
 void bsp_i2c_tx_ack(void);
 void bsp_i2c_tx_nack(void);
 
+/*****************************************************************************
+ * I2C设备层: 寄存器影子, 跳过重复写, 批量写合并成一次总线传输
+ *****************************************************************************/
+#define I2C_DELAY_STD               5           //标准时序半个时钟延时(us)
+#define I2C_DELAY_FAST              2           //快速时序半个时钟延时(us), 加上IO翻转开销SCL低于250KHz, QN8035/WM8978最高400KHz
+
+//设备标志
+#define I2C_DEV_FAST                BIT(0)      //使用快速时序
+#define I2C_DEV_AUTO_INC            BIT(1)      //支持寄存器地址自增的连续写
+#define I2C_DEV_REG9                BIT(2)      //7bit寄存器地址+9bit数据(WM8978), 数据bit8放在地址字节里, 只能写不能读
+
+typedef struct {
+    u32 trans;                  //总线传输次数(START到STOP)
+    u32 start;                  //START次数, 包括批量写里的重复START
+    u32 bytes;                  //总线上发送和接收的字节数
+    u32 skip;                   //影子命中跳过的寄存器写
+} i2c_dev_stat_t;
+
+typedef struct {
+    u8 addr;                    //设备写地址(8bit)
+    u8 flag;
+    u8 reg_num;                 //影子寄存器个数
+    u8 gap_us;                  //STOP之后需要的间隔
+    void *shadow;               //寄存器影子, I2C_DEV_REG9为u16[reg_num], 否则为u8[reg_num]
+    u32 *valid;                 //影子有效位, (reg_num + 31) / 32个u32
+    const u32 *nocache;         //状态类寄存器位图, 每次都访问总线, 可以为NULL
+    u8 batch;                   //批量写嵌套层数
+    u8 open;                    //批量写已经发过START
+    i2c_dev_stat_t stat;
+} i2c_dev_t;
+
+void i2c_dev_invalidate(i2c_dev_t *dev);
+void i2c_dev_sync(i2c_dev_t *dev, const void *val);
+void i2c_dev_batch_begin(i2c_dev_t *dev);
+void i2c_dev_batch_end(i2c_dev_t *dev);
+bool i2c_dev_write(i2c_dev_t *dev, u8 reg, u16 val);
+void i2c_dev_write_force(i2c_dev_t *dev, u8 reg, u16 val);
+void i2c_dev_write_burst(i2c_dev_t *dev, u8 reg, const u8 *buf, u8 cnt);
+u16 i2c_dev_read(i2c_dev_t *dev, u8 reg);
+
 #endif
@@ -24,37 +24,50 @@ static const u16 tbl_wm8978_reg[58] = {
 	0x0001,0x0001
 };
 
+//R0写任何值都是软件复位
+static const u32 wm8978_nocache[2] = {BIT(0), 0};
+
+static u32 wm8978_valid[2];
+
+static i2c_dev_t wm8978_dev = {
+    .addr = 0x34,
+    .flag = I2C_DEV_FAST | I2C_DEV_REG9,
+    .reg_num = 58,
+    .shadow = wm8978_reg,
+    .valid = wm8978_valid,
+    .nocache = wm8978_nocache,
+};
+
 AT(.text.bsp.i2s)
-static void bsp_wm8978_write_one_byte(u8 addr, u8 dat)
+static bool bsp_wm8978_sfr_write(u8 addr, u16 dat)
 {
-	bsp_i2c_start();
-	bsp_i2c_tx_byte(0x34);
-	bsp_i2c_rx_ack();
-	bsp_i2c_tx_byte(addr);
-    bsp_i2c_rx_ack();
-	bsp_i2c_tx_byte(dat);
-    bsp_i2c_rx_ack();
-	bsp_i2c_stop();
+    return i2c_dev_write(&wm8978_dev, addr, dat);
 }
 
 AT(.text.bsp.i2s)
-static void bsp_wm8978_sfr_write(u8 addr, u16 dat)
+static u16 bsp_wm8978_sfr_read(u8 addr)
 {
-    bsp_wm8978_write_one_byte((addr << 1) | ((dat >> 8) & 0x01), (u8)dat);
-    wm8978_reg[addr] = dat;
+    return i2c_dev_read(&wm8978_dev, addr);
 }
 
+//左右声道寄存器对, 右声道带update位, 左声道有改动时右声道必须重写才会生效
 AT(.text.bsp.i2s)
-static u16 bsp_wm8978_sfr_read(u8 addr)
+static void bsp_wm8978_sfr_write_lr(u8 addr, u16 datl, u16 datr)
 {
-    return wm8978_reg[addr];
+    i2c_dev_batch_begin(&wm8978_dev);
+    if (bsp_wm8978_sfr_write(addr, datl)) {
+        i2c_dev_write_force(&wm8978_dev, addr + 1, datr);
+    } else {
+        bsp_wm8978_sfr_write(addr + 1, datr);
+    }
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 AT(.text.bsp.i2s)
 static void bsp_wm8978_reset(void)
 {
     bsp_wm8978_sfr_write(0, 0);
-    memcpy(wm8978_reg, tbl_wm8978_reg, sizeof(tbl_wm8978_reg));
+    i2c_dev_sync(&wm8978_dev, tbl_wm8978_reg);
 }
 
 //设置喇叭音量, voll:左声道音量(0~63)
@@ -64,8 +77,7 @@ void bsp_wm8978_speaker_vol(u8 vol)
 	if (vol ==0) {
             vol |= 1<<6;                    //音量为0时,直接mute
 	}
- 	bsp_wm8978_sfr_write(54, vol);			//R54,喇叭左声道音量设置
-	bsp_wm8978_sfr_write(55, vol | (1<<8));	//R55,喇叭右声道音量设置,同步更新(SPKVU=1)
+	bsp_wm8978_sfr_write_lr(54, vol, vol | (1<<8));    //R54/R55,喇叭左右声道音量设置,同步更新(SPKVU=1)
 }
 
 //设置耳机左右声道音量
@@ -81,8 +93,7 @@ void bsp_wm8978_hp_vol(u8 voll, u8 volr)
 	if (volr == 0) {
         volr |= 1<<6;					    //音量为0时,直接mute
 	}
-	bsp_wm8978_sfr_write(52, voll);		    //R52,耳机左声道音量设置
-	bsp_wm8978_sfr_write(53, volr|(1<<8));  //R53,耳机右声道音量设置,同步更新(HPVU=1)
+	bsp_wm8978_sfr_write_lr(52, voll, volr|(1<<8));    //R52/R53,耳机左右声道音量设置,同步更新(HPVU=1)
 }
 
 //WM8978 MIC增益设置(不包括BOOST的20dB,MIC-->ADC输入部分的增益)
@@ -90,8 +101,7 @@ void bsp_wm8978_hp_vol(u8 voll, u8 volr)
 void bsp_wm8978_mic_gain(u8 gain)
 {
 	gain &= 0x3f;
-	bsp_wm8978_sfr_write(45, gain);		    //R45,左通道PGA设置
-	bsp_wm8978_sfr_write(46, gain|1<<8);    //R46,右通道PGA设置
+	bsp_wm8978_sfr_write_lr(45, gain, gain|1<<8);      //R45/R46,左右通道PGA设置
 }
 
 
@@ -111,6 +121,7 @@ AT(.text.bsp.i2s)
 void bsp_wm8978_audio_cfg(u8 dacen, u8 adcen)
 {
 	uint16_t regval;
+    i2c_dev_batch_begin(&wm8978_dev);
 	regval = bsp_wm8978_sfr_read(3);		//读取R3
 	if (dacen) {
 		regval |= 3 << 0;					//R3最低2个位设置为1,开启DACR&DACL
@@ -127,6 +138,7 @@ void bsp_wm8978_audio_cfg(u8 dacen, u8 adcen)
 		regval &= ~(3 << 0);			    //R2最低2个位清零,关闭ADCR&ADCL.
 	}
 	bsp_wm8978_sfr_write(2, regval);	    //设置R2
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 //WM8978 输出配置
@@ -135,6 +147,7 @@ void bsp_wm8978_audio_cfg(u8 dacen, u8 adcen)
 void bsp_wm8978_output_cfg(u8 dacen, u8 bpsen)
 {
 	u16 regval = 0;
+    i2c_dev_batch_begin(&wm8978_dev);
 	if (dacen) {
 		regval |= 1 << 0;				    //DAC输出使能
 	}
@@ -144,6 +157,7 @@ void bsp_wm8978_output_cfg(u8 dacen, u8 bpsen)
 	}
 	bsp_wm8978_sfr_write(50, regval);	    //R50设置
 	bsp_wm8978_sfr_write(51, regval);       //R51设置
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 //WM8978 L2/R2(也就是Line In)增益设置(L2/R2-->ADC输入部分的增益)
@@ -151,6 +165,7 @@ void bsp_wm8978_output_cfg(u8 dacen, u8 bpsen)
 void bsp_wm8978_linein_gain(u8 gain)
 {
 	u16 regval;
+    i2c_dev_batch_begin(&wm8978_dev);
 	gain &= 0x07;
 	regval = bsp_wm8978_sfr_read(47);		    //读取R47
 	regval &= ~(7<<4);						    //清除原来的设置
@@ -158,6 +173,7 @@ void bsp_wm8978_linein_gain(u8 gain)
 	regval = bsp_wm8978_sfr_read(48);		    //读取R48
 	regval &= ~(7<<4);						    //清除原来的设置
  	bsp_wm8978_sfr_write(48, regval|gain<<4);   //设置R48
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 //WM8978 AUXR,AUXL(PWM音频部分)增益设置(AUXR/L-->ADC输入部分的增益)
@@ -165,6 +181,7 @@ void bsp_wm8978_linein_gain(u8 gain)
 void bsp_wm8978_aux_gain(u8 gain)
 {
 	uint16_t regval;
+    i2c_dev_batch_begin(&wm8978_dev);
 	gain &= 0x07;
 	regval = bsp_wm8978_sfr_read(47);		    //读取R47
 	regval &= ~(7<<0);						    //清除原来的设置
@@ -172,6 +189,7 @@ void bsp_wm8978_aux_gain(u8 gain)
 	regval = bsp_wm8978_sfr_read(48);		    //读取R48
 	regval &= ~(7<<0);						    //清除原来的设置
  	bsp_wm8978_sfr_write(48, regval|gain<<0);   //设置R48
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 
@@ -182,6 +200,7 @@ void bsp_wm8978_aux_gain(u8 gain)
 void bsp_wm8978_input_cfg(u8 micen, u8 lineinen, u8 auxen)
 {
 	uint16_t regval;
+    i2c_dev_batch_begin(&wm8978_dev);
 	regval = bsp_wm8978_sfr_read(2);	    //读取R2
 	if (micen) {
 		regval |= 3 << 2;					//开启INPPGAENR,INPPGAENL(MIC的PGA放大)
@@ -206,6 +225,7 @@ void bsp_wm8978_input_cfg(u8 micen, u8 lineinen, u8 auxen)
 	} else {
 		bsp_wm8978_aux_gain(0);			    //关闭AUX输入
 	}
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 AT(.text.bsp.i2s)
@@ -217,6 +237,7 @@ void bsp_wm8978_init(void)
     delay_5ms(1);
 
     bsp_wm8978_reset();
+    i2c_dev_batch_begin(&wm8978_dev);       //复位之后的配置合并成一次传输
 #if  I2S_MODE_SEL == 0
 	bsp_wm8978_sfr_write(1, 0x1B);		    //R1,MICEN设置为1(MIC使能),BIASEN设置为1(模拟器工作),VMIDSEL[1:0]设置为:11(5K)
 	bsp_wm8978_sfr_write(2, 0x1B0);		    //R2,ROUT1,LOUT1输出使能(耳机可以工作),BOOSTENR,BOOSTENL使能
@@ -258,6 +279,7 @@ void bsp_wm8978_init(void)
     //bsp_wm8978_speaker_vol(30);
 //    bsp_wm8978_mic_gain(6);
 #endif
+    i2c_dev_batch_end(&wm8978_dev);
 }
 
 #endif
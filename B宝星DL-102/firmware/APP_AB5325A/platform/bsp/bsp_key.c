@@ -298,7 +298,7 @@ int is_lowpower_vbat_warning(void)
 #if WARNING_LOW_BATTERY
     else {
         sys_cb.lpwr_cnt = 0;
-        if (sys_cb.vbat < ((u16)LPWR_WARNING_VBAT*100 + 2800)) {
+        if (fuel_lowbat_warning()) {                //开路电压估计, 关机判断仍用实测端电压
     #if LED_LOWBAT_EN
             if (xcfg_cb.rled_lowbat_en) {
                 if ((!CHARGE_DC_IN()) && (!RLED_LOWBAT_FOLLOW_EN)) {
@@ -897,9 +897,11 @@ u8 bsp_key_scan(void)
     key = bsp_key_process(key_val);
     if (key != NO_KEY) {
         //printf("enqueue: %04x\n", key);
+#if !MSG_PRIO_QUEUE_EN
         if ((key & KEY_TYPE_MASK) == KEY_LONG_UP) {
             msg_queue_detach(key | KEY_HOLD);       //长按抬键，先清掉HOLD按键消息
         }
+#endif // MSG_PRIO_QUEUE_EN
         msg_enqueue(key);
     }
     return key_val;
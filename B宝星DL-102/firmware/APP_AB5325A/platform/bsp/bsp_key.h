@@ -47,6 +47,8 @@
 #define EVT_ECHO_LEVEL          0x7e6
 #define EVT_MIC_VOL             0x7e5
 #define EVT_MUSIC_VOL           0x7e4
+#define EVT_ALARM_RING          0x7e3
+#define EVT_ALARM_SLEEP         0x7e2
 
 //普通按键定义，可以支持短按，长按，双击等。范围：0 ~ 0xdf
 #define NO_KEY                  0x00
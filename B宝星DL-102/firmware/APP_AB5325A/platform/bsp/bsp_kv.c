@@ -0,0 +1,386 @@
+#include "include.h"
+
+#if SYS_PARAM_KV_EN
+#define KV_MAGIC                    0x4b565031  //"KVP1"
+#define KV_CRC_SEED                 0xffff
+#define KV_HDR_SIZE                 sizeof(kv_sector_hdr_t)
+#define KV_REC_HDR_SIZE             4
+#define KV_REC_SIZE(len)            ((KV_REC_HDR_SIZE + (len) + 3) & ~3)
+#define KV_NONE                     0xff
+//CM库的flash格式: 每4K扇区16格, 每格256字节 = 250字节数据 + 0xd2c3标记 + 0 + 页号 + crc16
+#define KV_CM_SLOT                  0x100
+#define KV_CM_SECTOR                0x1000
+#define KV_CM_TAG                   0xd2c3
+#define KV_CM_CRC_SEED              0x2018
+
+uint calc_crc(void *buf, uint len, uint seed);
+
+typedef struct {
+    u32 magic;
+    u32 seq;                    //每整理一次加1, 上电用seq最大的扇区
+    u32 erase[KV_SECTOR_NUM];   //所有扇区的擦除次数, 整理到一半掉电的扇区也不会丢计数
+    u16 crc;
+    u16 res;
+} kv_sector_hdr_t;
+
+typedef struct {
+    u8 image[KV_IMAGE_SIZE];
+    u8 dirty[KV_IMAGE_SIZE / 8];
+    u32 erase[KV_SECTOR_NUM];
+    u32 start;
+    u32 seq;
+    u32 tick;                   //最后一次修改的时间
+    u16 wptr;                   //当前扇区的写指针
+    u8 sector;                  //当前扇区, KV_NONE表示还没有
+    u8 sync;                    //param_sync请求写flash
+    kv_stat_t stat;
+} kv_cb_t;
+
+typedef struct {
+    u32 addr[MAX_CM_PAGE];      //每页最新一份的flash地址
+    u32 erase;                  //cm_init会直接擦掉的扇区, 0表示不擦
+    u8 found;                   //找到的页BIT(page)
+} kv_cm_scan_t;
+
+static kv_cb_t kv_cb AT(.buf.bsp.kv);
+static u8 kv_cm_buf[KV_CM_SLOT] AT(.kv_cm_buf);     //只在上电导入时用, 和aram其它缓存复用
+
+AT(.text.bsp.kv)
+static u32 kv_sector_addr(u8 sector)
+{
+    return kv_cb.start + (u32)sector * KV_SECTOR_SIZE;
+}
+
+AT(.text.bsp.kv)
+static u16 kv_rec_crc(u8 *rec)
+{
+    uint crc = calc_crc(rec, 2, KV_CRC_SEED);
+    return calc_crc(rec + KV_REC_HDR_SIZE, rec[1], crc);
+}
+
+AT(.text.bsp.kv)
+static u16 kv_sector_hdr_crc(kv_sector_hdr_t *hdr)
+{
+    return calc_crc(hdr, (u8 *)&hdr->crc - (u8 *)hdr, KV_CRC_SEED);
+}
+
+AT(.text.bsp.kv)
+static bool kv_sector_hdr_read(u8 sector, kv_sector_hdr_t *hdr)
+{
+    os_spiflash_read(hdr, kv_sector_addr(sector), KV_HDR_SIZE);
+    return (hdr->magic == KV_MAGIC && hdr->crc == kv_sector_hdr_crc(hdr));
+}
+
+AT(.text.bsp.kv)
+static bool kv_is_dirty(uint i)
+{
+    return (kv_cb.dirty[i >> 3] & BIT(i & 7));
+}
+
+//从*pos开始找下一段连续的改动(最长KV_REC_MAX), 返回长度, 没有返回0
+AT(.text.bsp.kv)
+static uint kv_dirty_next(uint *pos, uint *key)
+{
+    uint i = *pos;
+    while (i < KV_IMAGE_SIZE && !kv_is_dirty(i)) {
+        i++;
+    }
+    *key = i;
+    while (i < KV_IMAGE_SIZE && kv_is_dirty(i) && i - *key < KV_REC_MAX) {
+        i++;
+    }
+    *pos = i;
+    return i - *key;
+}
+
+//追加一条记录, 头和数据一起写, 写一半掉电时crc对不上
+AT(.text.bsp.kv)
+static void kv_rec_append(u8 key, u8 len)
+{
+    u8 rec[KV_REC_SIZE(KV_REC_MAX)];
+    uint size = KV_REC_SIZE(len);
+    u16 crc;
+
+    memset(rec, 0xff, size);
+    rec[0] = key;
+    rec[1] = len;
+    memcpy(rec + KV_REC_HDR_SIZE, &kv_cb.image[key], len);
+    crc = kv_rec_crc(rec);
+    rec[2] = crc;
+    rec[3] = crc >> 8;
+    os_spiflash_program(rec, kv_sector_addr(kv_cb.sector) + kv_cb.wptr, size);
+    kv_cb.wptr += size;
+    kv_cb.stat.rec++;
+}
+
+//把整个镜像写到下一个扇区, 扇区头最后写: 写完之前掉电, 旧扇区仍然有效
+AT(.text.bsp.kv)
+static void kv_gc(void)
+{
+    kv_sector_hdr_t hdr;
+    u8 sector = (kv_cb.sector == KV_NONE) ? 0 : (kv_cb.sector + 1) % KV_SECTOR_NUM;
+
+#if KV_SECTOR_NUM < 2
+    cm_write(kv_cb.image, PAGE0(0), KV_IMAGE_SIZE);    //擦的就是唯一的扇区, 先备份
+    cm_sync();
+#endif
+    os_spiflash_erase(kv_sector_addr(sector));
+    kv_cb.erase[sector]++;
+    kv_cb.sector = sector;
+    kv_cb.wptr = KV_HDR_SIZE;
+    for (uint key = 0; key < KV_IMAGE_SIZE; key += KV_REC_MAX) {
+        kv_rec_append(key, KV_REC_MAX);
+    }
+
+    hdr.magic = KV_MAGIC;
+    hdr.seq = ++kv_cb.seq;
+    memcpy(hdr.erase, kv_cb.erase, sizeof(hdr.erase));
+    hdr.crc = kv_sector_hdr_crc(&hdr);
+    hdr.res = 0xffff;
+    os_spiflash_program(&hdr, kv_sector_addr(sector), KV_HDR_SIZE);
+    kv_cb.stat.gc++;
+}
+
+//回放当前扇区的记录, 遇到crc错误的记录(断电残留)返回false
+AT(.text.bsp.kv)
+static bool kv_replay(void)
+{
+    u8 rec[KV_REC_SIZE(KV_REC_MAX)];
+    u32 addr = kv_sector_addr(kv_cb.sector);
+
+    kv_cb.wptr = KV_HDR_SIZE;
+    while (kv_cb.wptr + KV_REC_HDR_SIZE <= KV_SECTOR_SIZE) {
+        os_spiflash_read(rec, addr + kv_cb.wptr, KV_REC_HDR_SIZE);
+        if (rec[0] == 0xff && rec[1] == 0xff && rec[2] == 0xff && rec[3] == 0xff) {
+            return true;                                        //日志结尾
+        }
+        u8 key = rec[0], len = rec[1];
+        if (len == 0 || len > KV_REC_MAX || key + len > KV_IMAGE_SIZE || kv_cb.wptr + KV_REC_SIZE(len) > KV_SECTOR_SIZE) {
+            return false;
+        }
+        os_spiflash_read(rec + KV_REC_HDR_SIZE, addr + kv_cb.wptr + KV_REC_HDR_SIZE, len);
+        if (kv_rec_crc(rec) != (rec[2] | (rec[3] << 8))) {
+            return false;
+        }
+        memcpy(&kv_cb.image[key], rec + KV_REC_HDR_SIZE, len);
+        kv_cb.wptr += KV_REC_SIZE(len);
+    }
+    return true;
+}
+
+//返回false表示flash里还没有参数日志
+AT(.text.bsp.kv)
+bool kv_init(u32 start)
+{
+    kv_sector_hdr_t hdr;
+
+    memset(&kv_cb, 0, sizeof(kv_cb));
+    kv_cb.start = start;
+    kv_cb.sector = KV_NONE;
+    for (u8 i = 0; i < KV_SECTOR_NUM; i++) {
+        if (kv_sector_hdr_read(i, &hdr) && (kv_cb.sector == KV_NONE || hdr.seq > kv_cb.seq)) {
+            kv_cb.sector = i;
+            kv_cb.seq = hdr.seq;
+        }
+    }
+    if (kv_cb.sector == KV_NONE) {
+        return false;
+    }
+    kv_sector_hdr_read(kv_cb.sector, &hdr);
+    memcpy(kv_cb.erase, hdr.erase, sizeof(kv_cb.erase));
+
+    if (!kv_replay()) {
+        //日志尾部写了一半, 后面不能再追加, 下次写flash时整理到新扇区(整理要用CM, 这时CM可能还没初始化)
+        kv_cb.stat.recover++;
+        kv_cb.wptr = KV_SECTOR_SIZE;
+    }
+    return true;
+}
+
+//读CM的一格, 返回页号, 空格返回-1, 无效返回-2
+AT(.text.bsp.kv)
+static int kv_cm_slot(u32 addr, u8 *slot)
+{
+    os_spiflash_read(slot, addr, KV_CM_SLOT);
+    if ((slot[250] | (slot[251] << 8)) != KV_CM_TAG) {
+        for (uint i = 0; i < KV_CM_SLOT; i++) {
+            if (slot[i] != 0xff) {
+                return -2;
+            }
+        }
+        return -1;
+    }
+    if ((uint)(slot[254] | (slot[255] << 8)) != calc_crc(slot, 254, KV_CM_CRC_SEED) || slot[253] >= MAX_CM_PAGE) {
+        return -2;
+    }
+    return slot[253];
+}
+
+//不经过CM库, 按cm_init的规则在[start, start+size)里找每页最新的一份, 只读不写.
+//从第一个最后一格是空的扇区往回找, 先找到的是最新的(第一格就无效时从区域末尾往回找).
+//找到的放在addr[page], found为BIT(page); 空格不足16个时cm_init不搬页直接擦下一个扇区, 记在erase
+AT(.text.bsp.kv)
+static void kv_cm_scan(u32 start, uint size, kv_cm_scan_t *scan)
+{
+    u32 end = start + size, addr = end - KV_CM_SLOT;
+    uint free = 0;
+    bool lead = true;
+    int page;
+
+    memset(scan, 0, sizeof(kv_cm_scan_t));
+    scan->erase = start;
+    if (kv_cm_slot(start, kv_cm_buf) >= 0) {
+        for (addr = start + KV_CM_SECTOR - KV_CM_SLOT; addr < end; addr += KV_CM_SECTOR) {
+            if (kv_cm_slot(addr, kv_cm_buf) == -1) {
+                break;
+            }
+        }
+        if (addr >= end) {
+            return;                                     //没有空格, cm_init会当成没格式化, 擦第一个扇区
+        }
+    }
+    scan->erase = (addr + KV_CM_SLOT >= end) ? start : (addr + KV_CM_SLOT);
+    for (uint n = size / KV_CM_SLOT - 1; n != 0 && scan->found != BIT(MAX_CM_PAGE) - 1; n--) {
+        page = kv_cm_slot(addr, kv_cm_buf);
+        if (lead && page == -1) {
+            free++;
+        } else {
+            if (page >= 0 && !(scan->found & BIT(page))) {
+                scan->addr[page] = addr;
+                scan->found |= BIT(page);
+            }
+            lead = false;
+        }
+        addr = (addr == start) ? end - KV_CM_SLOT : addr - KV_CM_SLOT;
+    }
+    if (scan->found == 0) {
+        scan->erase = start;
+    } else if (free >= 16) {
+        scan->erase = 0;
+    }
+}
+
+//按new_size初始化CM能不能找到和按old_size一样的页, 并且不会擦掉其中任何一页
+AT(.text.bsp.kv)
+static bool kv_cm_fit(u32 start, uint old_size, uint new_size)
+{
+    kv_cm_scan_t old, cur;
+
+    kv_cm_scan(start, old_size, &old);
+    kv_cm_scan(start, new_size, &cur);
+    if (old.found != cur.found) {
+        return false;
+    }
+    for (u8 i = 0; i < MAX_CM_PAGE; i++) {
+        if ((cur.found & BIT(i)) && (cur.addr[i] != old.addr[i] || (cur.addr[i] & ~(KV_CM_SECTOR - 1)) == cur.erase)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//CM在[start, start+size), 日志在CM后面. 日志无效时(老固件的CM占整个参数区old_size, 或只有一个扇区时整理到一半掉电),
+//日志扇区里可能还有CM页的最新一份, 直接按新大小cm_init会丢页或写出厂值. cm_init只能调一次(不清页表),
+//所以先按old_size初始化CM, 用库把所有页重写到前面, 直到按新大小也能找到同样的页, 再复位重新上电.
+//之后按新大小初始化, 从PAGE0导入参数建立日志. 中间掉电, 下次上电从头再来
+AT(.text.bsp.kv)
+void kv_cm_init(u32 start, uint size, uint old_size)
+{
+    if (kv_init(start + size)) {
+        cm_init(MAX_CM_PAGE, start, size);
+        return;
+    }
+    if (!kv_cm_fit(start, old_size, size)) {
+        cm_init(MAX_CM_PAGE, start, old_size);
+        for (uint n = old_size / KV_CM_SLOT; n != 0 && !kv_cm_fit(start, old_size, size); n--) {
+            for (u8 i = 0; i < MAX_CM_PAGE; i++) {
+                cm_read(kv_cm_buf, PAGE0(0) + (i << 8), KV_CM_PAGE_SIZE);
+                cm_write(kv_cm_buf, PAGE0(0) + (i << 8), KV_CM_PAGE_SIZE);
+                cm_sync();
+            }
+        }
+        WDT_RST();
+    }
+    cm_init(MAX_CM_PAGE, start, size);
+    cm_read(kv_cb.image, PAGE0(0), KV_IMAGE_SIZE);
+    memset(kv_cb.dirty, 0xff, sizeof(kv_cb.dirty));
+    kv_flush();
+}
+
+AT(.text.bsp.kv)
+void kv_read(void *buf, u32 key, uint len)
+{
+    if (key + len > KV_IMAGE_SIZE) {
+        return;
+    }
+    memcpy(buf, &kv_cb.image[key], len);
+}
+
+//只改RAM镜像, 值没变的不写
+AT(.text.bsp.kv)
+void kv_write(void *buf, u32 key, uint len)
+{
+    u8 *p = buf;
+    if (key + len > KV_IMAGE_SIZE) {
+        return;
+    }
+    for (uint i = 0; i < len; i++, key++) {
+        if (kv_cb.image[key] != p[i]) {
+            kv_cb.image[key] = p[i];
+            kv_cb.dirty[key >> 3] |= BIT(key & 7);
+        }
+    }
+    kv_cb.tick = tick_get();
+    kv_cb.stat.write++;
+}
+
+//请求写flash, 空闲KV_IDLE_TIME后在kv_process里写
+AT(.text.bsp.kv)
+void kv_sync(void)
+{
+    kv_cb.sync = 1;
+}
+
+//马上把改动写到flash, 关机和休眠前调用
+AT(.text.bsp.kv)
+void kv_flush(void)
+{
+    uint pos, key, len, need = 0;
+
+    kv_cb.sync = 0;
+    for (pos = 0; (len = kv_dirty_next(&pos, &key)) != 0; ) {
+        need += KV_REC_SIZE(len);
+    }
+    if (need == 0) {
+        return;
+    }
+
+    if (kv_cb.sector == KV_NONE || kv_cb.wptr + need > KV_SECTOR_SIZE) {
+        kv_gc();                                    //写不下, 整个镜像整理到下一个扇区
+    } else {
+        for (pos = 0; (len = kv_dirty_next(&pos, &key)) != 0; ) {
+            kv_rec_append(key, len);
+        }
+    }
+    memset(kv_cb.dirty, 0, sizeof(kv_cb.dirty));
+    kv_cb.stat.flush++;
+}
+
+AT(.text.bsp.kv)
+void kv_process(void)
+{
+    if (kv_cb.sync && tick_check_expire(kv_cb.tick, KV_IDLE_TIME)) {
+        kv_flush();
+    }
+}
+
+u32 kv_get_erase_cnt(u8 sector)
+{
+    return (sector < KV_SECTOR_NUM) ? kv_cb.erase[sector] : 0;
+}
+
+const kv_stat_t *kv_get_stat(void)
+{
+    return &kv_cb.stat;
+}
+#endif // SYS_PARAM_KV_EN
@@ -0,0 +1,38 @@
+#ifndef _BSP_KV_H
+#define _BSP_KV_H
+
+//系统参数日志: RAM里保存完整参数镜像, 修改只改RAM, param_sync后空闲时把改动追加写到flash
+//扇区头(magic, seq, 擦除次数) + 记录(key, len, crc16, value), 写满后把镜像整理到下一个扇区
+//只有一个扇区时, 整理前先把镜像备份到CM PAGE0, 擦除后到扇区头写完之前掉电, 上电从PAGE0恢复
+#define KV_SECTOR_SIZE              0x1000      //SPI flash扇区大小
+#define KV_SECTOR_NUM               1           //轮流使用的扇区数, 参数区20K里CM要留16K(见bsp_param.c), 只剩一个扇区
+#define KV_SIZE                     (KV_SECTOR_SIZE * KV_SECTOR_NUM)
+#define KV_IMAGE_SIZE               0x80        //参数镜像大小, 要覆盖bsp_param.h里所有PARAM_xxx
+#define KV_REC_MAX                  32          //一条记录最大数据长度
+#define KV_IDLE_TIME                500         //最后一次修改后空闲多久(ms)才写flash, 连续调音量只写一次
+#define KV_CM_PAGE_SIZE             250         //CM每页的数据长度
+
+typedef struct {
+    u16 write;                  //参数写入次数(RAM)
+    u16 flush;                  //写flash次数
+    u16 rec;                    //追加的记录数
+    u16 gc;                     //整理到新扇区的次数
+    u16 recover;                //上电发现断电写了一半的记录
+} kv_stat_t;
+
+bool kv_init(u32 start);
+void kv_cm_init(u32 start, uint size, uint old_size);
+void kv_read(void *buf, u32 key, uint len);
+void kv_write(void *buf, u32 key, uint len);
+void kv_sync(void);
+void kv_flush(void);
+void kv_process(void);
+u32 kv_get_erase_cnt(u8 sector);
+const kv_stat_t *kv_get_stat(void);
+
+//SPI flash接口(库函数)
+void os_spiflash_read(void *buf, u32 addr, uint len);
+void os_spiflash_program(void *buf, u32 addr, uint len);
+void os_spiflash_erase(u32 addr);
+
+#endif // _BSP_KV_H
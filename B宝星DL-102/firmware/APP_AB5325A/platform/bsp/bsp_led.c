@@ -14,12 +14,43 @@ typedef struct {
     u8 space_cnt;
 
     u8 flag;
+
+    //字节码闪灯, pat为NULL时用上面的亮灭控制
+    const u8 *pat;
+    u8 pc;
+    u8 wait;        //当前关键帧剩余的50ms数
+    u8 sp;
+    u8 loop_pc[LED_PAT_LOOP_DEPTH];
+    u8 loop_cnt[LED_PAT_LOOP_DEPTH];
+    u16 lvl[2];     //当前亮度(红, 蓝), Q8
+    u16 tgt[2];
+    s16 step[2];
+    u8 duty[2];     //PWM占空比, 0 ~ LED_PAT_LVL_MAX
+    u8 pwm_cnt;
 } led_cb_t;
 
 led_cb_t led_cb AT(.buf.led);
 led_cb_t led_bak AT(.buf.led);
 volatile int port2led_sta AT(.buf.led);
 
+//蓝牙配对心跳: 1s周期双闪, 每个周期对齐ticks_50ms, TWS两边同步
+AT(.com_rodata.led)
+static const u8 led_pat_bt_pair[] = {
+    LP_LOOP(0), LP_SYNC(20), LP_KEY(0, 8, 2), LP_KEY(0, 0, 2), LP_KEY(0, 8, 2), LP_KEY(0, 0, 14), LP_NEXT(),
+};
+
+//低电提示: 红灯100ms闪2次后恢复之前的闪灯
+AT(.com_rodata.led)
+static const u8 led_pat_lowbat_warn[] = {
+    LP_LOOP(2), LP_KEY(8, 0, 2), LP_KEY(0, 0, 2), LP_NEXT(), LP_RET(),
+};
+
+AT(.com_rodata.led)
+static const u8 * const led_pat_tbl[LED_PAT_NUM] = {
+    [LED_PAT_BT_PAIR]       = led_pat_bt_pair,
+    [LED_PAT_LOWBAT_WARN]   = led_pat_lowbat_warn,
+};
+
 AT(.com_text.led)
 void tmr5ms_set_sync(void)
 {
@@ -59,6 +90,130 @@ static bool led_sync(void)
     return true;
 }
 
+AT(.com_text.led_disp)
+static void led_pat_output(led_cb_t *s)
+{
+    for (u8 i = 0; i < 2; i++) {
+        s->duty[i] = (s->lvl[i] + 0x80) >> 8;
+    }
+    //全亮全灭直接输出, 中间亮度由1ms的led_pat_pwm_isr输出
+    if (s->duty[0] == 0) {
+        rled_set_off();
+    } else if (s->duty[0] >= LED_PAT_LVL_MAX) {
+        rled_set_on();
+    }
+    if (s->duty[1] == 0) {
+        bled_set_off();
+    } else if (s->duty[1] >= LED_PAT_LVL_MAX) {
+        bled_set_on();
+    }
+}
+
+AT(.com_text.led_disp)
+static void led_pat_frame(led_cb_t *s, u8 rb, u8 ticks, bool ramp)
+{
+    u16 tgt[2] = {(rb >> 4) << 8, (rb & 0x0f) << 8};
+    for (u8 i = 0; i < 2; i++) {
+        if (tgt[i] > (LED_PAT_LVL_MAX << 8)) {
+            tgt[i] = LED_PAT_LVL_MAX << 8;
+        }
+        s->tgt[i] = tgt[i];
+        if (ramp && ticks) {
+            s->step[i] = ((s16)tgt[i] - (s16)s->lvl[i]) / ticks;
+        } else {
+            s->lvl[i] = tgt[i];
+            s->step[i] = 0;
+        }
+    }
+    s->wait = ticks;
+}
+
+//字节码解释器, 50ms调用一次. 执行到带时间的指令、SYNC未对齐或END为止
+AT(.com_text.led_disp)
+static void led_pat_run(void)
+{
+    led_cb_t *s = &led_cb;
+    const u8 *p;
+    u8 op, n;
+
+    if (s->wait) {
+        s->wait--;
+        for (u8 i = 0; i < 2; i++) {
+            s->lvl[i] = (s->wait) ? (s->lvl[i] + s->step[i]) : s->tgt[i];
+        }
+        if (s->wait) {
+            led_pat_output(s);
+            return;
+        }
+    }
+
+    p = s->pat;
+    for (n = 0; n < LED_PAT_OPS_MAX; n++) {
+        op = p[s->pc];
+        if (op == LP_OP_KEY || op == LP_OP_RAMP) {
+            led_pat_frame(s, p[s->pc + 1], p[s->pc + 2], (op == LP_OP_RAMP));
+            s->pc += 3;
+            if (s->wait) {
+                break;
+            }
+        } else if (op == LP_OP_LOOP) {
+            if (s->sp < LED_PAT_LOOP_DEPTH) {
+                s->loop_cnt[s->sp] = p[s->pc + 1];
+                s->loop_pc[s->sp] = s->pc + 2;
+                s->sp++;
+            }
+            s->pc += 2;
+        } else if (op == LP_OP_NEXT) {
+            s->pc++;
+            if (s->sp) {
+                u8 *cnt = &s->loop_cnt[s->sp - 1];
+                if (*cnt == 0 || --(*cnt) != 0) {        //0为无限循环
+                    s->pc = s->loop_pc[s->sp - 1];
+                } else {
+                    s->sp--;
+                }
+            }
+        } else if (op == LP_OP_SYNC) {
+            if (p[s->pc + 1] && (ticks_50ms % p[s->pc + 1])) {
+                break;                                  //等同步点
+            }
+            s->pc += 2;
+        } else if (op == LP_OP_RET && (s->flag & LED_TOG_LBAT)) {
+            memcpy(&led_cb, &led_bak, sizeof(led_cb_t));
+            led_cb.flag &= ~LED_TOG_LBAT;
+            return;
+        } else {
+            break;                                      //END: 保持最后的亮度
+        }
+    }
+    led_pat_output(s);
+}
+
+//1ms调用, 中间亮度的软件PWM, 8ms一个周期
+AT(.com_text.led_disp)
+void led_pat_pwm_isr(void)
+{
+    led_cb_t *s = &led_cb;
+    if (s->pat == NULL || !is_led_scan_enable()) {
+        return;
+    }
+    s->pwm_cnt = (s->pwm_cnt + 1) & (LED_PAT_LVL_MAX - 1);
+    if (s->duty[0] && s->duty[0] < LED_PAT_LVL_MAX) {
+        if (s->pwm_cnt < s->duty[0]) {
+            rled_set_on();
+        } else {
+            rled_set_off();
+        }
+    }
+    if (s->duty[1] && s->duty[1] < LED_PAT_LVL_MAX) {
+        if (s->pwm_cnt < s->duty[1]) {
+            bled_set_on();
+        } else {
+            bled_set_off();
+        }
+    }
+}
+
 //50ms调用周期
 AT(.com_text.led_disp)
 void led_scan(void)
@@ -67,6 +222,17 @@ void led_scan(void)
         return;
     }
 
+    if (led_cb.pat != NULL) {
+        if (led_cb.flag & LED_SYNC) {               //TWS同步后从头开始, 由SYNC指令对齐
+            led_cb.flag &= ~LED_SYNC;
+            led_cb.pc = 0;
+            led_cb.sp = 0;
+            led_cb.wait = 0;
+        }
+        led_pat_run();
+        return;
+    }
+
     if(!led_sync()) {
         return;
     }
@@ -109,10 +275,34 @@ void led_scan(void)
     }
 }
 
-//获取LED当前设置的状态
+//字节码闪灯里这个灯(0红, 1蓝)有没有被点亮的关键帧
+AT(.com_text.led_disp)
+static bool led_pat_is_used(const u8 *p, u8 ch)
+{
+    for (u8 pc = 0; ; ) {
+        u8 op = p[pc];
+        if (op == LP_OP_KEY || op == LP_OP_RAMP) {
+            if ((ch ? p[pc + 1] : (p[pc + 1] >> 4)) & 0x0f) {
+                return true;
+            }
+            pc += 3;
+        } else if (op == LP_OP_LOOP || op == LP_OP_SYNC) {
+            pc += 2;
+        } else if (op == LP_OP_NEXT) {
+            pc++;
+        } else {
+            return false;                           //END/RET
+        }
+    }
+}
+
+//获取LED当前设置的状态, type: 1红灯, 0蓝灯
 AT(.com_text.led_disp)
 u8 get_led_sta(u32 type)
 {
+    if (led_cb.pat != NULL) {
+        return (led_pat_is_used(led_cb.pat, !type)) ? 0xff : 0x00;
+    }
     if (type) {
         return led_cb.rled_sta;
     } else {
@@ -456,6 +646,7 @@ void led_set_sta(u8 rled_sta, u8 bled_sta, u8 uint, u8 period)
     rled_set_off();
     bled_set_off();
 
+    s->pat = NULL;
     s->rled_sta = rled_sta;
     s->bled_sta = bled_sta;
     s->uint = uint;
@@ -469,6 +660,36 @@ void led_set_sta(u8 rled_sta, u8 bled_sta, u8 uint, u8 period)
     }
 }
 
+//按ID播放led_pat_tbl里的字节码闪灯
+AT(.com_text.led_disp)
+void led_pat_play(u8 id)
+{
+    led_cb_t *s = &led_cb;
+
+    if (id >= LED_PAT_NUM) {
+        return;
+    }
+    if (s->flag & LED_TOG_LBAT) {                   //低电优先闪灯
+        s = &led_bak;
+    }
+
+    s->pat = NULL;
+    s->space_cnt = 0xff;                            //避免中断同时操作led_cb
+    rled_set_off();
+    bled_set_off();
+
+    s->rled_sta = 0;
+    s->bled_sta = 0;
+    s->pc = 0;
+    s->sp = 0;
+    s->wait = 0;
+    memset(s->lvl, 0, sizeof(s->lvl));
+    memset(s->duty, 0, sizeof(s->duty));
+    s->flag &= ~LED_SYNC;
+    s->space_cnt = 0;
+    s->pat = led_pat_tbl[id];
+}
+
 AT(.com_text.led_disp)
 void led_cfg_set_sta(led_cfg_t *cfg_cb)
 {
@@ -505,7 +726,7 @@ void led_lowbat_follow_warning(void)
 {
     if (!(led_cb.flag & LED_TOG_LBAT)) {
         memcpy(&led_bak, &led_cb, sizeof(led_cb_t));
-        led_set_sta(0x0a, 0x00, 2, 0xff);              //红灯100ms周期闪2次
+        led_pat_play(LED_PAT_LOWBAT_WARN);              //红灯100ms周期闪2次, 闪完自动恢复
         led_cb.flag |= LED_TOG_LBAT;
     }
 }
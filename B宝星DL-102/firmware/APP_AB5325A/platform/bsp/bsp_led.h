@@ -10,6 +10,37 @@ typedef struct {
     u8 cycle;
 } led_cfg_t;
 
+//字节码闪灯: 亮度0 ~ LED_PAT_LVL_MAX, 时间单位50ms
+#define LED_PAT_LVL_MAX     8
+#define LED_PAT_LOOP_DEPTH  2   //LOOP最多嵌套层数
+#define LED_PAT_OPS_MAX     16  //每个50ms最多执行的指令数, 防止空循环
+
+enum {
+    LP_OP_END       = 0x00,     //结束, 保持最后的亮度
+    LP_OP_KEY       = 0x10,     //[op, 红<<4|蓝, t] 设置亮度并保持t
+    LP_OP_RAMP      = 0x20,     //[op, 红<<4|蓝, t] t时间内渐变到目标亮度
+    LP_OP_LOOP      = 0x30,     //[op, n] 循环开始, n为次数, 0为无限
+    LP_OP_NEXT      = 0x40,     //[op] 循环结束
+    LP_OP_SYNC      = 0x50,     //[op, n] 等到ticks_50ms为n的倍数(TWS两边同步)
+    LP_OP_RET       = 0x60,     //结束并恢复低电提示前的闪灯
+};
+
+#define LP_KEY(r, b, t)     LP_OP_KEY, (((r) << 4) | (b)), (t)
+#define LP_RAMP(r, b, t)    LP_OP_RAMP, (((r) << 4) | (b)), (t)
+#define LP_LOOP(n)          LP_OP_LOOP, (n)
+#define LP_NEXT()           LP_OP_NEXT
+#define LP_SYNC(n)          LP_OP_SYNC, (n)
+#define LP_RET()            LP_OP_RET
+#define LP_END()            LP_OP_END
+
+//闪灯ID
+enum {
+    LED_PAT_BT_PAIR = 0,        //蓝牙配对心跳
+    LED_PAT_LOWBAT_WARN,        //低电提示红灯闪2次
+
+    LED_PAT_NUM,
+};
+
 enum
 {
     LED_TOG_LBAT    = 0x03, //低电LED闪烁
@@ -21,6 +52,8 @@ enum
     extern volatile int port2led_sta;
 
     void led_set_sta(u8 rled_sta, u8 bled_sta, u8 uint, u8 period);
+    void led_pat_play(u8 id);
+    void led_pat_pwm_isr(void);
     void led_cfg_set_sta(led_cfg_t *cfg_cb);
     u8 get_led_sta(u32 type);
 
@@ -88,6 +121,8 @@ enum
     void led_record(void);
 #else
     #define led_set_sta(x)
+    #define led_pat_play(x)
+    #define led_pat_pwm_isr()
     #define led_cfg_set_sta(x)
     #define led_cfg_port_init(x)
     #define led_cfg_set_on(x)
@@ -0,0 +1,216 @@
+#include "include.h"
+
+#if MSG_PRIO_QUEUE_EN
+//本文件需要调用库里原来的消息队列
+#undef msg_queue_init
+#undef msg_queue_clear
+#undef msg_enqueue
+#undef msg_dequeue
+#undef msg_queue_detach
+
+#define MSG_PRIO_QUEUE_MASK         (MSG_PRIO_QUEUE_LEN - 1)
+
+typedef struct {
+    u16 buf[MSG_PRIO_QUEUE_LEN];
+    u8 rptr;
+    u8 wptr;
+} msg_prio_queue_t;
+
+static msg_prio_queue_t msg_prio_queue[MSG_PRIO_NUM] AT(.buf.bsp.msg);
+static msg_prio_stat_t msg_prio_stat[MSG_PRIO_NUM] AT(.buf.bsp.msg);
+
+//音频控制类消息
+AT(.com_rodata.msg)
+static const u16 msg_audio_tbl[] = {
+    EVT_HFP_SET_VOL,
+    EVT_A2DP_SET_VOL,
+    EVT_TWS_SET_VOL,
+    EVT_A2DP_MUSIC_PLAY,
+    EVT_A2DP_MUSIC_STOP,
+    EVT_ONLINE_SET_EQ,
+    EVT_BT_SET_EQ,
+    EVT_ECHO_LEVEL,
+    EVT_MIC_VOL,
+    EVT_MUSIC_VOL,
+    EVT_KEY_2_UNMUTE,
+};
+
+//只关心最后一次的消息, 队列里有相同的就合并(去掉旧的, 新的放到队尾)
+//定时/插拔这类消息重复处理没有意义, 主循环忙时合并掉, 免得8深度的队列满了丢掉插拔消息.
+//插拔抖动时INSERT/REMOVE各留最后一条, 顺序和最后的状态一致
+AT(.com_rodata.msg)
+static const u16 msg_coalesce_tbl[] = {
+    MSG_SYS_1S,
+    MSG_SYS_500MS,
+    EVT_SD_INSERT,
+    EVT_SD_REMOVE,
+    EVT_SD1_INSERT,
+    EVT_SD1_REMOVE,
+    EVT_UDISK_INSERT,
+    EVT_UDISK_REMOVE,
+    EVT_PC_INSERT,
+    EVT_PC_REMOVE,
+    EVT_LINEIN_INSERT,
+    EVT_LINEIN_REMOVE,
+    EVT_MIC_INSERT,
+    EVT_MIC_REMOVE,
+    EVT_BT_SCAN_START,
+    EVT_BT_SET_LANG_ID,
+    EVT_ALARM_RING,
+    EVT_ALARM_SLEEP,
+    EVT_HFP_SET_VOL,
+    EVT_A2DP_SET_VOL,
+    EVT_TWS_SET_VOL,
+    EVT_ONLINE_SET_EQ,
+    EVT_BT_SET_EQ,
+    EVT_ECHO_LEVEL,
+    EVT_MIC_VOL,
+    EVT_MUSIC_VOL,
+};
+
+AT(.com_text.msg)
+static bool msg_tbl_find(const u16 *tbl, u8 cnt, u16 msg)
+{
+    for (u8 i = 0; i < cnt; i++) {
+        if (tbl[i] == msg) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AT(.com_text.msg)
+static bool msg_is_event(u16 msg)
+{
+    return ((msg & 0xff00) == 0x0700);              //Event Message范围：0x700 ~ 0x7ff
+}
+
+AT(.com_text.msg)
+static u8 msg_get_prio(u16 msg)
+{
+    if (!msg_is_event(msg)) {
+        return MSG_PRIO_INPUT;
+    }
+    if (msg_tbl_find(msg_audio_tbl, sizeof(msg_audio_tbl) / sizeof(u16), msg)) {
+        return MSG_PRIO_AUDIO;
+    }
+    return MSG_PRIO_HOUSEKEEP;
+}
+
+AT(.com_text.msg)
+static bool msg_can_coalesce(u16 msg)
+{
+    if (!msg_is_event(msg)) {
+        u16 type = msg & KEY_TYPE_MASK;
+        return ((type == KEY_HOLD) || (type == KEY_LHOLD));     //连按只保留最新一次
+    }
+    return msg_tbl_find(msg_coalesce_tbl, sizeof(msg_coalesce_tbl) / sizeof(u16), msg);
+}
+
+//删除队列中所有的msg, 返回删除个数
+AT(.com_text.msg)
+static u8 msg_prio_queue_remove(msg_prio_queue_t *q, u16 msg)
+{
+    u8 wptr = q->rptr;
+    for (u8 rptr = q->rptr; rptr != q->wptr; rptr++) {
+        u16 val = q->buf[rptr & MSG_PRIO_QUEUE_MASK];
+        if (val != msg) {
+            q->buf[wptr & MSG_PRIO_QUEUE_MASK] = val;
+            wptr++;
+        }
+    }
+    u8 cnt = q->wptr - wptr;
+    q->wptr = wptr;
+    return cnt;
+}
+
+AT(.com_text.msg)
+void bsp_msg_enqueue(u16 msg)
+{
+    if (msg == NO_MSG) {
+        return;
+    }
+    u8 prio = msg_get_prio(msg);
+    msg_prio_queue_t *q = &msg_prio_queue[prio];
+    msg_prio_stat_t *s = &msg_prio_stat[prio];
+
+    GLOBAL_INT_DISABLE();
+    if ((msg & KEY_TYPE_MASK) == KEY_LONG_UP) {
+        msg_prio_queue_remove(q, msg | KEY_HOLD);   //长按抬键，先清掉HOLD按键消息
+    } else if (msg_can_coalesce(msg)) {
+        s->coalesce += msg_prio_queue_remove(q, msg);
+    }
+    u8 len = q->wptr - q->rptr;
+    if (len < MSG_PRIO_QUEUE_LEN) {
+        q->buf[q->wptr & MSG_PRIO_QUEUE_MASK] = msg;
+        q->wptr++;
+        len++;
+        if (len > s->hwm) {
+            s->hwm = len;
+        }
+    } else {
+        s->drop++;
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+AT(.com_text.msg)
+u16 bsp_msg_dequeue(void)
+{
+    u16 msg;
+
+    //库里发出的消息先转到优先级队列
+    while ((msg = msg_dequeue()) != NO_MSG) {
+        bsp_msg_enqueue(msg);
+    }
+
+    msg = NO_MSG;
+    GLOBAL_INT_DISABLE();
+    for (u8 prio = 0; prio < MSG_PRIO_NUM; prio++) {
+        msg_prio_queue_t *q = &msg_prio_queue[prio];
+        if (q->rptr != q->wptr) {
+            msg = q->buf[q->rptr & MSG_PRIO_QUEUE_MASK];
+            q->rptr++;
+            break;
+        }
+    }
+    GLOBAL_INT_RESTORE();
+    return msg;
+}
+
+AT(.com_text.msg)
+void bsp_msg_detach(u16 msg)
+{
+    msg_queue_detach(msg);
+    GLOBAL_INT_DISABLE();
+    msg_prio_queue_remove(&msg_prio_queue[msg_get_prio(msg)], msg);
+    GLOBAL_INT_RESTORE();
+}
+
+AT(.text.bsp.msg)
+void bsp_msg_clear(void)
+{
+    msg_queue_clear();
+    GLOBAL_INT_DISABLE();
+    for (u8 prio = 0; prio < MSG_PRIO_NUM; prio++) {
+        msg_prio_queue[prio].rptr = msg_prio_queue[prio].wptr;
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+AT(.text.bsp.msg)
+void bsp_msg_init(void)
+{
+    msg_queue_init();
+    memset(msg_prio_queue, 0, sizeof(msg_prio_queue));
+    memset(msg_prio_stat, 0, sizeof(msg_prio_stat));
+}
+
+const msg_prio_stat_t *bsp_msg_get_stat(u8 prio)
+{
+    if (prio >= MSG_PRIO_NUM) {
+        return NULL;
+    }
+    return &msg_prio_stat[prio];
+}
+#endif // MSG_PRIO_QUEUE_EN
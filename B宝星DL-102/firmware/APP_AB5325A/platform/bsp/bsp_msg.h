@@ -0,0 +1,36 @@
+#ifndef _BSP_MSG_H
+#define _BSP_MSG_H
+
+//消息优先级, 数值越小越先处理
+enum {
+    MSG_PRIO_INPUT = 0,         //按键, 遥控, APP按键
+    MSG_PRIO_AUDIO,             //音量, EQ, 播放状态等音频控制
+    MSG_PRIO_HOUSEKEEP,         //定时消息, 设备插拔等
+    MSG_PRIO_NUM,
+};
+
+#define MSG_PRIO_QUEUE_LEN          8       //每级队列深度(2的幂)
+
+typedef struct {
+    u8 hwm;                     //队列最高水位
+    u8 drop;                    //队列满丢掉的消息数
+    u16 coalesce;               //被合并的重复消息数
+} msg_prio_stat_t;
+
+#if MSG_PRIO_QUEUE_EN
+void bsp_msg_init(void);
+void bsp_msg_clear(void);
+void bsp_msg_enqueue(u16 msg);
+u16 bsp_msg_dequeue(void);
+void bsp_msg_detach(u16 msg);
+const msg_prio_stat_t *bsp_msg_get_stat(u8 prio);
+
+//替换库里的单FIFO消息队列
+#define msg_queue_init()            bsp_msg_init()
+#define msg_queue_clear()           bsp_msg_clear()
+#define msg_enqueue(msg)            bsp_msg_enqueue(msg)
+#define msg_dequeue()               bsp_msg_dequeue()
+#define msg_queue_detach(msg)       bsp_msg_detach(msg)
+#endif // MSG_PRIO_QUEUE_EN
+
+#endif // _BSP_MSG_H
@@ -1,7 +1,18 @@
 #include "include.h"
 
-#define CM_SIZE         0x5000          //参数区至少20k
-#define CM_START        (FLASH_SIZE - CM_SIZE)
+#define PARAM_SIZE      0x5000          //参数区至少20k, prd文件不能用到这里
+#if SYS_PARAM_KV_EN
+#define CM_SIZE         (PARAM_SIZE - KV_SIZE)  //系统参数日志占参数区最后4K, CM只保存蓝牙配对信息
+#else
+#define CM_SIZE         PARAM_SIZE
+#endif
+#define CM_START        (FLASH_SIZE - PARAM_SIZE)
+
+//升级(updatefile_init/updateota_init)时cm_release_all把CM页收到CM最后一个扇区, 升级驱动暂存在CM前面CM_SIZE-4K里,
+//放不下直接返回失败. V1.0的fw5000.upd要暂存9728字节, CM至少16K. 升级不会写CM后面的日志扇区
+#if CM_SIZE < 0x4000
+#error "CM needs at least 16K for the update driver, reduce KV_SECTOR_NUM"
+#endif
 
 
 #if SYS_PARAM_RTCRAM
@@ -14,6 +25,16 @@
     #define param_read(a, b, c)     rtcram_read(a, b, c)
     #define param_write(a, b, c)    rtcram_write(a, b, c)
     #define param_sync_do()
+#elif SYS_PARAM_KV_EN
+    #define param_read8(a, b)       kv_read((u8 *)&b, a, 1)
+    #define param_write8(a, b)      kv_write((u8 *)&b, a, 1)
+    #define param_read16(a, b)      kv_read((u8 *)&b, a, 2)
+    #define param_write16(a, b)     kv_write((u8 *)&b, a, 2)
+    #define param_read32(a, b)      kv_read((u8 *)&b, a, 4)
+    #define param_write332(a, b)    kv_write((u8 *)&b, a, 4)
+    #define param_read(a, b, c)     kv_read(a, b, c)
+    #define param_write(a, b, c)    kv_write(a, b, c)
+    #define param_sync_do()         kv_sync()
 #else
     #define param_read8(a, b)       b = cm_read8(PAGE0(a))
     #define param_write8(a, b)      cm_write8(PAGE0(a), b)
@@ -37,7 +58,11 @@ void param_init(bool reset)
             WDT_CLR();
         }
     }
+#if SYS_PARAM_KV_EN
+    kv_cm_init(CM_START, CM_SIZE, PARAM_SIZE);  //老固件的CM占整个参数区, 第一次上电把CM页挪到前16K(要复位一次), 再导入PAGE0的参数
+#else
     cm_init(MAX_CM_PAGE, CM_START, CM_SIZE);
+#endif // SYS_PARAM_KV_EN
     //printf("CM: %x\n", cm_read8(PAGE0(0)));
     //printf("CM: %x\n", cm_read8(PAGE1(0)));
 
@@ -106,7 +131,11 @@ void bsp_param_read(u8 *buf, u32 addr, uint len)
 AT(.text.bsp.param)
 void bsp_param_sync(void)
 {
+#if SYS_PARAM_KV_EN
+    kv_flush();                     //库里调用完可能马上复位, 不等空闲
+#else
     param_sync_do();
+#endif
 }
 
 #if BT_LOCAL_ADDR
@@ -278,6 +307,20 @@ void param_sys_mode_write(u8 mode)
 }
 #endif
 
+#if FUNC_CLOCK_EN
+AT(.text.bsp.param)
+void param_alarm_write(u8 *buf)
+{
+    param_write(buf, PARAM_ALARM_CFG, sizeof(alarm_cfg_t) * ALARM_NUM);
+}
+
+AT(.text.bsp.param)
+void param_alarm_read(u8 *buf)
+{
+    param_read(buf, PARAM_ALARM_CFG, sizeof(alarm_cfg_t) * ALARM_NUM);
+}
+#endif // FUNC_CLOCK_EN
+
 #if SYS_KARAOK_EN
 AT(.text.bsp.param)
 void param_echo_level_write(void)
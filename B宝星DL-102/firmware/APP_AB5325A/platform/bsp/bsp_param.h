@@ -21,6 +21,7 @@
 #define PARAM_FMTX_FREQ             0x4C        //FM TX freq 2 Byte
 #define PARAM_ECHO_LEVEL            0x4E        //echo level 1 Byte
 #define PARAM_ECHO_DELAY            0x4F        //echo delay 1 Byte
+#define PARAM_ALARM_CFG             0x50        //闹钟设置 4Byte * ALARM_NUM
 
 #define RTCRAM_PWROFF_FLAG          63         //软关机的标识放在RTCRAM的最后一BYTE
 
@@ -46,5 +47,7 @@ void param_random_key_write(void);
 void param_random_key_read(u8 *key);
 u8 param_sys_mode_read(void);
 void param_sys_mode_write(u8 mode);
+void param_alarm_write(u8 *buf);
+void param_alarm_read(u8 *buf);
 #endif // __BSP_PARAM_H
 
@@ -181,6 +181,14 @@ void bsp_piano_warning_play(uint type, uint index)
 {
     void *res;
 
+#if TONE_SYNTH_EN
+    //ADC->DAC通路正在运行, 直接混音播放, 不用停通路
+    if (type == WARNING_TONE && bsp_synth_is_streaming()) {
+        bsp_synth_start(index);
+        return;
+    }
+#endif // TONE_SYNTH_EN
+
     if (type == WARNING_PIANO) {
         res = (void *)&warning_piano_tbl[index];
     } else {
@@ -0,0 +1,174 @@
+#include "include.h"
+
+#define SCHED_WHEEL_MASK            (SCHED_WHEEL_SIZE - 1)
+#define SCHED_NONE                  0xff
+
+typedef struct {
+    sched_func_t func;
+    sched_probe_t probe;        //读输入原始状态, 连续不变时退避, 可以为NULL
+    u32 due;                    //到期tick
+    u8 period;                  //周期, 5ms为单位
+    u8 shift;                   //退避级数, 实际周期 = period << shift
+    u8 stable;                  //输入连续不变的次数
+    u8 last;                    //上次probe结果
+    u8 next;                    //同一个槽里的下一个任务
+} sched_job_t;
+
+typedef struct {
+    sched_job_t job[SCHED_JOB_MAX];
+    u8 slot[SCHED_WHEEL_SIZE];  //每个槽的任务链表头
+    u8 num;
+    u32 ticks;
+    u32 next_due;               //最早到期的tick, 之前的tick不用看时间轮
+    sched_stat_t stat;
+} sched_cb_t;
+
+static sched_cb_t sched_cb AT(.buf.bsp.sched);
+
+AT(.com_text.sched)
+static void sched_job_insert(u8 id)
+{
+    sched_job_t *j = &sched_cb.job[id];
+    u8 *head = &sched_cb.slot[j->due & SCHED_WHEEL_MASK];
+    j->next = *head;
+    *head = id;
+}
+
+AT(.com_text.sched)
+static void sched_next_due_update(void)
+{
+    u32 next = sched_cb.ticks + 0x7fffffff;
+    for (u8 i = 0; i < sched_cb.num; i++) {
+        if ((s32)(sched_cb.job[i].due - next) < 0) {
+            next = sched_cb.job[i].due;
+        }
+    }
+    sched_cb.next_due = next;
+}
+
+AT(.com_text.sched)
+static void sched_job_remove(u8 id)
+{
+    u8 *link = &sched_cb.slot[sched_cb.job[id].due & SCHED_WHEEL_MASK];
+    while (*link != SCHED_NONE) {
+        if (*link == id) {
+            *link = sched_cb.job[id].next;
+            return;
+        }
+        link = &sched_cb.job[*link].next;
+    }
+}
+
+//输入稳定时拉长周期, 有变化马上恢复
+AT(.com_text.sched)
+static void sched_job_backoff(sched_job_t *j)
+{
+    u8 sta = j->probe();
+    if (sta == SCHED_PROBE_BUSY) {
+        return;
+    }
+    if (sta != j->last) {
+        j->last = sta;
+        j->stable = 0;
+        j->shift = 0;
+    } else if (++j->stable >= SCHED_STABLE_CNT && j->shift < SCHED_BACKOFF_MAX) {
+        j->stable = 0;
+        j->shift++;
+        sched_cb.stat.backoff++;
+    }
+}
+
+//5ms定时中断里调用, 只处理当前槽里到期的任务. 没有任务到期的tick直接返回
+AT(.com_text.sched)
+void sched_tick(void)
+{
+    u32 now = ++sched_cb.ticks;
+    if ((s32)(sched_cb.next_due - now) > 0) {
+        sched_cb.stat.idle++;
+        return;
+    }
+    u8 *link = &sched_cb.slot[now & SCHED_WHEEL_MASK];
+    u8 due_head = SCHED_NONE;
+    u8 *due_tail = &due_head;
+    u8 id;
+
+    //先把到期的任务摘出来(保持注册顺序), 没到期的(超过一圈)留在槽里
+    while ((id = *link) != SCHED_NONE) {
+        sched_job_t *j = &sched_cb.job[id];
+        if (j->due == now) {
+            *link = j->next;
+            j->next = SCHED_NONE;
+            *due_tail = id;
+            due_tail = &j->next;
+        } else {
+            link = &j->next;
+        }
+    }
+
+    while ((id = due_head) != SCHED_NONE) {
+        sched_job_t *j = &sched_cb.job[id];
+        due_head = j->next;
+        j->func();
+        sched_cb.stat.run++;
+        if (j->probe != NULL) {
+            sched_job_backoff(j);
+        }
+        j->due = now + ((u32)j->period << j->shift);
+        sched_job_insert(id);
+    }
+    sched_next_due_update();
+}
+
+//period: 周期(5ms为单位); phase: 第一次执行的tick偏移, 用来错开同周期的任务
+AT(.text.bsp.sched)
+u8 sched_job_add(sched_func_t func, u8 period, u8 phase, sched_probe_t probe)
+{
+    u8 id;
+    if (sched_cb.num >= SCHED_JOB_MAX || period == 0) {
+        return SCHED_NONE;
+    }
+    GLOBAL_INT_DISABLE();
+    id = sched_cb.num++;
+    sched_job_t *j = &sched_cb.job[id];
+    memset(j, 0, sizeof(sched_job_t));
+    j->func = func;
+    j->probe = probe;
+    j->period = period;
+    j->last = SCHED_PROBE_BUSY;
+    j->due = sched_cb.ticks + 1 + (phase % period);
+    sched_job_insert(id);
+    sched_next_due_update();
+    GLOBAL_INT_RESTORE();
+    return id;
+}
+
+//外部知道输入可能有变化(比如休眠唤醒), 取消退避, 下一个tick执行
+AT(.com_text.sched)
+void sched_job_kick(u8 id)
+{
+    if (id >= sched_cb.num) {
+        return;
+    }
+    GLOBAL_INT_DISABLE();
+    sched_job_t *j = &sched_cb.job[id];
+    sched_job_remove(id);
+    j->shift = 0;
+    j->stable = 0;
+    j->due = sched_cb.ticks + 1;
+    sched_job_insert(id);
+    sched_cb.next_due = j->due;
+    GLOBAL_INT_RESTORE();
+}
+
+AT(.text.bsp.sched)
+void sched_init(void)
+{
+    memset(&sched_cb, 0, sizeof(sched_cb));
+    memset(sched_cb.slot, SCHED_NONE, sizeof(sched_cb.slot));
+    sched_cb.next_due = 0x7fffffff;
+}
+
+const sched_stat_t *sched_get_stat(void)
+{
+    return &sched_cb.stat;
+}
@@ -0,0 +1,28 @@
+#ifndef _BSP_SCHED_H
+#define _BSP_SCHED_H
+
+//5ms定时任务调度(时间轮): 每个任务注册自己的周期和相位, 每个tick只处理到期的任务.
+//5ms定时器由库控制, 这里做不到真正的tickless, 没有任务到期的tick只是不走时间轮
+#define SCHED_JOB_MAX               16          //最大任务数
+#define SCHED_WHEEL_SIZE            16          //时间轮槽数(2的幂)
+#define SCHED_STABLE_CNT            20          //输入连续不变多少次后退避一级
+#define SCHED_BACKOFF_MAX           3           //最多退避到周期的8倍
+
+#define SCHED_PROBE_BUSY            0xff        //probe返回: IO被复用, 本次结果无效
+
+typedef void (*sched_func_t)(void);
+typedef u8 (*sched_probe_t)(void);
+
+typedef struct {
+    u32 run;                    //任务执行次数
+    u32 idle;                   //没有任务到期的tick数
+    u16 backoff;                //进入退避的次数
+} sched_stat_t;
+
+void sched_init(void);
+u8 sched_job_add(sched_func_t func, u8 period, u8 phase, sched_probe_t probe);
+void sched_job_kick(u8 id);
+void sched_tick(void);
+const sched_stat_t *sched_get_stat(void);
+
+#endif // _BSP_SCHED_H
@@ -0,0 +1,380 @@
+#include "include.h"
+
+#if SPECTRUM_EN
+#if SPECTRUM_FFT_N == 128
+#define SPECTRUM_LOG2_HALF          6           //log2(SPECTRUM_FFT_N / 2)
+#elif SPECTRUM_FFT_N == 64
+#define SPECTRUM_LOG2_HALF          5
+#else
+#error "SPECTRUM_FFT_N must be 64 or 128"
+#endif
+#define SPECTRUM_FRAME_TIME         4           //5ms * 4 = 20ms算一帧
+#define SPECTRUM_NONE               0xff
+
+typedef struct {
+    s16 re;
+    s16 im;
+} spectrum_cpx_t;
+
+typedef struct {
+    s16 level;                  //当前显示级数(Q8)
+    s16 peak;                   //峰值(Q8)
+    u8 hold;                    //峰值还要保持的帧数
+} spectrum_env_t;
+
+typedef struct {
+    s16 buf[2][SPECTRUM_FFT_N]; //抽取后的PCM, 双缓冲
+    s32 acc;                    //抽取累加
+    u8 acc_cnt;
+    u8 wbuf;                    //正在写的缓冲
+    u8 ready;                   //另一个缓冲已写满
+    u8 frame_cnt;
+    u8 shift;                   //当前帧块浮点放大的位数, 能量要减去2*shift个log2
+    u16 wpos;
+    u32 tick;                   //最后一次PCM输入的时间
+    spectrum_cpx_t x[SPECTRUM_FFT_N];
+    s16 win[SPECTRUM_FFT_N / 2 + 1];
+    u8 pos_band[SPECTRUM_FFT_N];    //FFT输出位置(数字反序)对应的频段
+    spectrum_env_t env[SPECTRUM_BAND_NUM];
+    spectrum_stat_t stat;
+} spectrum_cb_t;
+
+static spectrum_cb_t spectrum_cb AT(.buf.bsp.spectrum);
+
+//sin(2*pi*k/128), k = 0~32, Q15
+AT(.com_rodata.spectrum)
+static const s16 spectrum_sin_tbl[33] = {
+    0, 1608, 3212, 4808, 6393, 7962, 9512, 11039, 12539, 14010, 15446, 16846, 18204, 19519, 20787, 22005,
+    23170, 24279, 25329, 26319, 27245, 28105, 28898, 29621, 30273, 30852, 31356, 31785, 32137, 32412, 32609, 32728,
+    32767,
+};
+
+//旋转因子 W = cos - j*sin, 角度为2*pi*t/SPECTRUM_FFT_N
+AT(.com_text.spectrum)
+static void spectrum_twiddle(uint t, s32 *c, s32 *s)
+{
+    uint u = (t * (128 / SPECTRUM_FFT_N)) & 127;
+    uint r = u & 31;
+    s32 a = spectrum_sin_tbl[r], b = spectrum_sin_tbl[32 - r];
+
+    switch (u >> 5) {
+    case 0:
+        *s = a;
+        *c = b;
+        break;
+    case 1:
+        *s = b;
+        *c = -a;
+        break;
+    case 2:
+        *s = -a;
+        *c = -b;
+        break;
+    default:
+        *s = -b;
+        *c = a;
+        break;
+    }
+}
+
+//(re + j*im) * W^t, 结果写回p
+AT(.com_text.spectrum)
+static void spectrum_rotate(spectrum_cpx_t *p, s32 re, s32 im, uint t)
+{
+    s32 c, s;
+    if (t == 0) {
+        p->re = re;
+        p->im = im;
+        return;
+    }
+    spectrum_twiddle(t, &c, &s);
+    p->re = (re * c + im * s) >> 15;
+    p->im = (im * c - re * s) >> 15;
+}
+
+//Q15基4 DIF FFT, 每级缩小4倍(基2级缩小2倍), 输出为X[k]/N, 按数字反序存放
+AT(.com_text.spectrum)
+static void spectrum_fft(spectrum_cpx_t *x)
+{
+    uint len = SPECTRUM_FFT_N;
+
+#if SPECTRUM_FFT_N == 128
+    //先做一级基2, 分成偶数频点和奇数频点两个64点
+    for (uint n = 0; n < 64; n++) {
+        spectrum_cpx_t *p = &x[n];
+        s32 ar = p[0].re, ai = p[0].im, br = p[64].re, bi = p[64].im;
+        p[0].re = (ar + br) >> 1;
+        p[0].im = (ai + bi) >> 1;
+        spectrum_rotate(&p[64], (ar - br) >> 1, (ai - bi) >> 1, n);
+    }
+    len = 64;
+#endif
+
+    for (; len >= 4; len >>= 2) {
+        uint q = len >> 2;
+        uint step = SPECTRUM_FFT_N / len;
+        for (uint j = 0; j < SPECTRUM_FFT_N; j += len) {
+            for (uint n = 0; n < q; n++) {
+                spectrum_cpx_t *p = &x[j + n];
+                s32 t0r = p[0].re + p[2*q].re, t0i = p[0].im + p[2*q].im;
+                s32 t1r = p[0].re - p[2*q].re, t1i = p[0].im - p[2*q].im;
+                s32 t2r = p[q].re + p[3*q].re, t2i = p[q].im + p[3*q].im;
+                s32 t3r = p[q].im - p[3*q].im, t3i = p[3*q].re - p[q].re;   //-j * (b - d)
+
+                p[0].re = (t0r + t2r) >> 2;
+                p[0].im = (t0i + t2i) >> 2;
+                spectrum_rotate(&p[q], (t1r + t3r) >> 2, (t1i + t3i) >> 2, n * step);
+                spectrum_rotate(&p[2*q], (t0r - t2r) >> 2, (t0i - t2i) >> 2, 2 * n * step);
+                spectrum_rotate(&p[3*q], (t1r - t3r) >> 2, (t1i - t3i) >> 2, 3 * n * step);
+            }
+        }
+    }
+}
+
+//log2(x), Q8. 整数部分是最高位的位置, 小数部分用尾数线性近似(误差<0.09, 约0.26dB), 不查表
+AT(.com_text.spectrum)
+static s32 spectrum_log2(uint x)
+{
+    s32 n = 31;
+    if (x == 0) {
+        return 0;
+    }
+    if (!(x & 0xffff0000)) {
+        x <<= 16;
+        n -= 16;
+    }
+    if (!(x & 0xff000000)) {
+        x <<= 8;
+        n -= 8;
+    }
+    if (!(x & 0xf0000000)) {
+        x <<= 4;
+        n -= 4;
+    }
+    if (!(x & 0xc0000000)) {
+        x <<= 2;
+        n -= 2;
+    }
+    if (!(x & 0x80000000)) {
+        x <<= 1;
+        n -= 1;
+    }
+    return (n << 8) | ((x >> 23) & 0xff);
+}
+
+//2^(x/256), log2的反函数, 同样用线性近似
+AT(.text.bsp.spectrum)
+static uint spectrum_exp2(uint x)
+{
+    return (((256 + (x & 0xff)) << (x >> 8)) + 128) >> 8;
+}
+
+//快速上升, 每帧按SPECTRUM_DECAY下降; 峰值保持SPECTRUM_HOLD帧后再下降
+AT(.com_text.spectrum)
+static void spectrum_env_update(spectrum_env_t *env, s32 level)
+{
+    if (level < 0) {
+        level = 0;
+    } else if (level > (SPECTRUM_LEVEL_MAX << 8)) {
+        level = SPECTRUM_LEVEL_MAX << 8;
+    }
+
+    if (level >= env->level) {
+        env->level = level;
+    } else {
+        env->level = (env->level - SPECTRUM_DECAY > level) ? (env->level - SPECTRUM_DECAY) : level;
+    }
+
+    if (level >= env->peak) {
+        env->peak = level;
+        env->hold = SPECTRUM_HOLD;
+    } else if (env->hold) {
+        env->hold--;
+    } else {
+        env->peak = (env->peak - SPECTRUM_DECAY > env->level) ? (env->peak - SPECTRUM_DECAY) : env->level;
+    }
+}
+
+//在sdadc回调里调用(与bsp_synth_mix同一位置), 单声道混合后抽取到约11kHz
+AT(.com_text.spectrum)
+void spectrum_pcm_input(u8 *ptr, u32 samples, int ch_mode, u8 spr)
+{
+    spectrum_cb_t *s = &spectrum_cb;
+    s16 *pcm = (s16 *)ptr;
+    u8 decim = (spr < SPR_24000) ? 4 : (spr < SPR_12000) ? 2 : 1;
+
+    s->tick = tick_get();
+    for (u32 n = 0; n < samples; n++) {
+        s32 val = *pcm++;
+        if (ch_mode) {
+            val = (val + *pcm++) >> 1;
+        }
+        s->acc += val;
+        if (++s->acc_cnt < decim) {
+            continue;
+        }
+        s->buf[s->wbuf][s->wpos] = s->acc >> (decim >> 1);
+        s->acc = 0;
+        s->acc_cnt = 0;
+        if (++s->wpos >= SPECTRUM_FFT_N) {
+            s->wpos = 0;
+            if (s->ready) {
+                s->stat.skip++;             //上一帧还没算, 只算最新的
+            }
+            s->wbuf ^= 1;
+            s->ready = 1;
+        }
+    }
+}
+
+//算一帧FFT, 按频段更新包络. 没有PCM输入时返回false
+AT(.com_text.spectrum)
+static bool spectrum_process(void)
+{
+    spectrum_cb_t *s = &spectrum_cb;
+    u32 pow[SPECTRUM_BAND_NUM];
+    s32 val, max = 0;
+
+    if (!spectrum_is_active()) {
+        return false;
+    }
+    if (!s->ready) {
+        return true;
+    }
+
+    //加Hann窗
+    GLOBAL_INT_DISABLE();
+    s16 *src = s->buf[s->wbuf ^ 1];
+    for (uint n = 0; n < SPECTRUM_FFT_N; n++) {
+        s16 w = s->win[(n <= SPECTRUM_FFT_N / 2) ? n : (SPECTRUM_FFT_N - n)];
+        val = ((s32)src[n] * w) >> 15;
+        s->x[n].re = val;
+        s->x[n].im = 0;
+        max |= (val < 0) ? -val : val;     //只需要最高位
+    }
+    s->ready = 0;
+    GLOBAL_INT_RESTORE();
+
+    //块浮点: 小信号先放大到接近满幅再算FFT, 减少定点误差; 再右移1位留出旋转后的余量
+    for (s->shift = 0; s->shift < 15 && (max << (s->shift + 1)) < 0x8000; s->shift++);
+    for (uint n = 0; n < SPECTRUM_FFT_N; n++) {
+        s->x[n].re = ((s32)s->x[n].re << s->shift) >> 1;
+    }
+
+    spectrum_fft(s->x);
+
+    memset(pow, 0, sizeof(pow));
+    for (uint n = 0; n < SPECTRUM_FFT_N; n++) {
+        u8 band = s->pos_band[n];
+        if (band != SPECTRUM_NONE) {
+            s32 re = s->x[n].re, im = s->x[n].im;
+            pow[band] += re * re + im * im;
+        }
+    }
+    for (u8 i = 0; i < SPECTRUM_BAND_NUM; i++) {
+        s32 level = (spectrum_log2(pow[i]) - (s->shift << 9) - (SPECTRUM_FLOOR << 8)) * SPECTRUM_LEVEL_MAX / SPECTRUM_RANGE;
+        spectrum_env_update(&s->env[i], level);
+    }
+    s->stat.frame++;
+    return true;
+}
+
+//没有PCM的模式(音乐/蓝牙在库里直接送DAC), 用dac_pcm_pow_get()的总能量画单条VU, 从第0段往后点亮
+AT(.com_text.spectrum)
+static void spectrum_vu_process(u16 pow)
+{
+    s32 bar = (spectrum_log2(pow) - (SPECTRUM_VU_FLOOR << 8)) * (SPECTRUM_BAND_NUM * SPECTRUM_LEVEL_MAX) / SPECTRUM_VU_RANGE;
+    for (u8 i = 0; i < SPECTRUM_BAND_NUM; i++) {
+        spectrum_env_update(&spectrum_cb.env[i], bar - ((s32)i * SPECTRUM_LEVEL_MAX << 8));
+    }
+}
+
+//5ms定时器里调用
+AT(.com_text.spectrum)
+void spectrum_5ms_process(void)
+{
+    if (++spectrum_cb.frame_cnt < SPECTRUM_FRAME_TIME) {
+        return;
+    }
+    spectrum_cb.frame_cnt = 0;
+    if (!spectrum_process()) {
+        spectrum_vu_process(dac_pcm_pow_get());
+    }
+}
+
+AT(.com_text.spectrum)
+bool spectrum_is_active(void)
+{
+    return (spectrum_cb.tick != 0 && !tick_check_expire(spectrum_cb.tick, SPECTRUM_TIMEOUT));
+}
+
+AT(.com_text.spectrum)
+u8 spectrum_get_level(u8 band)
+{
+    if (band >= SPECTRUM_BAND_NUM) {
+        return 0;
+    }
+    return (spectrum_cb.env[band].level + 0x80) >> 8;
+}
+
+AT(.com_text.spectrum)
+u8 spectrum_get_peak(u8 band)
+{
+    if (band >= SPECTRUM_BAND_NUM) {
+        return 0;
+    }
+    return (spectrum_cb.env[band].peak + 0x80) >> 8;
+}
+
+//FFT输出位置p对应的频点: 基4数字反序, 128点时最高位是基2级的奇偶
+AT(.text.bsp.spectrum)
+static uint spectrum_pos_to_bin(uint p)
+{
+    uint k = 0, m = p;
+    for (uint i = 0; i < 3; i++) {
+        k = (k << 2) | (m & 3);
+        m >>= 2;
+    }
+#if SPECTRUM_FFT_N == 128
+    k = (k << 1) | (p >> 6);
+#endif
+    return k;
+}
+
+AT(.text.bsp.spectrum)
+void spectrum_init(void)
+{
+    spectrum_cb_t *s = &spectrum_cb;
+    u8 edge[SPECTRUM_BAND_NUM + 1];
+    s32 c, sn;
+
+    memset(s, 0, sizeof(spectrum_cb_t));
+    for (uint n = 0; n <= SPECTRUM_FFT_N / 2; n++) {
+        spectrum_twiddle(n, &c, &sn);
+        s->win[n] = (32767 - c) >> 1;
+    }
+
+    //频段边界按对数均分第1点到第N/2点, 每段至少一个频点
+    for (uint i = 0; i <= SPECTRUM_BAND_NUM; i++) {
+        edge[i] = spectrum_exp2((SPECTRUM_LOG2_HALF << 8) * i / SPECTRUM_BAND_NUM);
+        if (i && edge[i] <= edge[i - 1]) {
+            edge[i] = edge[i - 1] + 1;
+        }
+    }
+    for (uint p = 0; p < SPECTRUM_FFT_N; p++) {
+        uint k = spectrum_pos_to_bin(p);
+        s->pos_band[p] = SPECTRUM_NONE;
+        for (u8 i = 0; i < SPECTRUM_BAND_NUM; i++) {
+            if (k >= edge[i] && k < edge[i + 1]) {
+                s->pos_band[p] = i;
+                break;
+            }
+        }
+    }
+}
+
+const spectrum_stat_t *spectrum_get_stat(void)
+{
+    return &spectrum_cb.stat;
+}
+#endif // SPECTRUM_EN
@@ -0,0 +1,30 @@
+#ifndef _BSP_SPECTRUM_H
+#define _BSP_SPECTRUM_H
+
+//频谱分析: ADC->DAC的PCM抽取到约11kHz, Hann窗 + Q15基4 FFT, 按对数频段累加能量,
+//用log2(不查表)映射成显示级数, 再做峰值保持和衰减. 给能量灯和数码管显示用
+#define SPECTRUM_FFT_N              64          //FFT点数, 64或128
+#define SPECTRUM_BAND_NUM           4           //频段数, 对应能量灯/数码管位数
+#define SPECTRUM_LEVEL_MAX          8           //每个频段的显示级数, 与ENERGY_PWM_MAX_DUTY一致
+#define SPECTRUM_FLOOR              8           //频段能量log2低于这个值显示0级(满幅正弦约为24)
+#define SPECTRUM_RANGE              16          //从0级到满级的能量log2范围(1 = 3dB)
+#define SPECTRUM_VU_FLOOR           10          //没有PCM时, dac_pcm_pow_get()的log2低于这个值全灭
+#define SPECTRUM_VU_RANGE           5           //dac_pcm_pow_get()的log2从全灭到全亮的范围(满幅约45000时全亮)
+#define SPECTRUM_DECAY              48          //每帧衰减(Q8级), 20ms一帧约0.85s从满级落到0
+#define SPECTRUM_HOLD               25          //峰值保持帧数
+#define SPECTRUM_TIMEOUT            100         //多久(ms)没有PCM输入就认为没有频谱
+
+typedef struct {
+    u32 frame;                  //计算的FFT帧数
+    u32 skip;                   //来不及计算被新数据覆盖的帧数
+} spectrum_stat_t;
+
+void spectrum_init(void);
+void spectrum_pcm_input(u8 *ptr, u32 samples, int ch_mode, u8 spr);
+void spectrum_5ms_process(void);
+bool spectrum_is_active(void);
+u8 spectrum_get_level(u8 band);
+u8 spectrum_get_peak(u8 band);
+const spectrum_stat_t *spectrum_get_stat(void);
+
+#endif // _BSP_SPECTRUM_H
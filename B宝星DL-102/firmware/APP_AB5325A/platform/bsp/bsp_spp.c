@@ -11,18 +11,79 @@ static const u16 bt_key_msg_tbl[] = {
     KU_MODE,
 };
 
+//执行一条APP命令, 传统包和APP_LINK帧共用. 返回false表示命令被拒绝
+bool bt_app_cmd_exec(u8 cmd, u8 *data, u16 size)
+{
+    switch (cmd) {
+        case 0x01:
+            //system control
+            if (size < 1) {
+                return false;
+            }
+            if ((data[0] > 0) && (data[0] <= sizeof(bt_key_msg_tbl) / sizeof(bt_key_msg_tbl[0]))) {
+                msg_enqueue(bt_key_msg_tbl[data[0] - 1]);
+            }
+            break;
+
+        case 0x02:
+            //rgb leds control
+            if (size < 4) {
+                return false;
+            }
+#if PWM_RGB_EN
+            if (data[0] > 0) {
+                pwm_rgb_write(data[1], data[2], data[3]);
+            } else {
+                pwm_rgb_close();
+            }
+#endif // PWM_RGB_EN
+            break;
+
+        case 0x03:
+            //ota control
+            break;
+
+#if EQ_DBG_IN_SPP
+        case 0x10:
+            //online eq, 整包一次收齐. 和传统SPP EQ一样要打开eq_dgb_spp_en;
+            //eq_rx_buf只有一份, 上一包还没被EVT_ONLINE_SET_EQ处理完时拒收, 同一批里的第二包EQ也会被拒
+            if (!xcfg_cb.eq_dgb_spp_en || size > EQ_BUFFER_LEN || eq_dbg_cb.rx_busy) {
+                return false;
+            }
+            eq_dbg_cb.rx_busy = 1;
+            memcpy(eq_rx_buf, data, size);
+            msg_enqueue(EVT_ONLINE_SET_EQ);
+            break;
+#endif
+    }
+    return true;
+}
+
 void bt_app_cmd_process(u8 *ptr, u16 size)
 {
+#if BT_APP_LINK_EN
+    if (app_link_is_frame(APP_LINK_SPP, ptr, size)) {
+        app_link_rx(APP_LINK_SPP, ptr, size);
+        return;
+    }
+#endif // BT_APP_LINK_EN
+
 #if EQ_DBG_IN_SPP
     if (xcfg_cb.eq_dgb_spp_en) {
         eq_spp_cb_t *p = &eq_dbg_cb.eq_spp_cb;
         if (ptr[0] == 'E' && ptr[1] == 'Q') {       //EQ消息
+            if (size > EQ_BUFFER_LEN) {
+                return;
+            }
             if (ptr[2] == '?') {
                 memcpy(eq_rx_buf, ptr, size);
                 msg_enqueue(EVT_ONLINE_SET_EQ);
                 return;
             }
             u32 rx_size = little_endian_read_16(ptr, 4) + 6;
+            if (rx_size > EQ_BUFFER_LEN) {
+                return;
+            }
             if (size < rx_size) {
                 memcpy(eq_rx_buf, ptr, size);
                 p->remain = 1;
@@ -32,6 +93,10 @@ void bt_app_cmd_process(u8 *ptr, u16 size)
             return;
         }
         if (p->remain) {
+            if (p->remian_ptr + size > p->rx_size) {   //拼包长度不对, 丢掉
+                memset(p, 0, sizeof(eq_spp_cb_t));
+                return;
+            }
             memcpy(&eq_rx_buf[p->remian_ptr], ptr, size);
             p->remian_ptr += size;
             if (p->rx_size == p->remian_ptr) {
@@ -50,9 +115,7 @@ void bt_app_cmd_process(u8 *ptr, u16 size)
             if (size != 4) {
                 return;     //2byte data + 2byte crc16
             }
-            if ((ptr[1] > 0) && (ptr[1] <= sizeof(bt_key_msg_tbl))) {
-                msg_enqueue(bt_key_msg_tbl[ptr[1] - 1]);
-            }
+            bt_app_cmd_exec(ptr[0], &ptr[1], 1);
             break;
 
         case 0x02:
@@ -60,13 +123,7 @@ void bt_app_cmd_process(u8 *ptr, u16 size)
             if (size != 7) {
                 return;     //5byte data + 2byte crc16
             }
-#if PWM_RGB_EN
-            if (ptr[1] > 0) {
-                pwm_rgb_write(ptr[2], ptr[3], ptr[4]);
-            } else {
-                pwm_rgb_close();
-            }
-#endif // PWM_RGB_EN
+            bt_app_cmd_exec(ptr[0], &ptr[1], 4);
             break;
 
         case 0x03:
@@ -0,0 +1,439 @@
+#include "include.h"
+
+#if TONE_SYNTH_EN
+
+#define SYNTH_ENV_FULL              (32767L << 8)       //包络Q23
+#define SYNTH_STREAM_TIMEOUT        20                  //多久没有混音认为数据流已停止(ms)
+
+u32 get_piano_digvol(void);
+
+//包络阶段
+enum {
+    SYNTH_ENV_ATTACK = 0,
+    SYNTH_ENV_DECAY,
+    SYNTH_ENV_SUSTAIN,
+    SYNTH_ENV_RELEASE,
+    SYNTH_ENV_OFF,
+};
+
+typedef struct {
+    u8 attack;                  //ms
+    u8 decay;                   //ms
+    u8 sustain;                 //sustain电平, 255为满幅
+    u8 release;                 //release占音符时长, 单位1/8
+    u8 lfo;                     //幅度调制频率Hz, 0为不调制
+} synth_env_t;
+
+typedef struct {
+    u32 phase;
+    u32 inc;
+    u32 lfo_phase;
+    u32 lfo_inc;
+    s32 env;
+    s32 env_step;
+    u32 cnt;                    //当前包络阶段剩余样点
+    u32 seg[SYNTH_ENV_OFF];     //各包络阶段的样点数
+    s32 sustain;
+    u8 stage;
+    u8 wave;
+} synth_voice_t;
+
+typedef struct {
+    synth_voice_t voice[SYNTH_VOICE_NUM];
+    const synth_note_t *tbl;
+    u8 len;
+    u8 idx;                     //下一个音符
+    u8 voice_next;              //轮流分配发声单元
+    u8 spr;
+    u32 spr_hz;
+    u32 inc_unit;               //1Hz对应的相位增量
+    u32 wait;                   //多少个样点后开始下一个音符
+    s32 gain;
+    u32 mix_tick;
+} synth_cb_t;
+
+static synth_cb_t synth_cb AT(.buf.bsp.synth);
+
+//1/4周期正弦表, Q15
+AT(.com_rodata.synth)
+static const s16 synth_sine_tbl[65] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+//与SPR_xxx对应
+AT(.com_rodata.synth)
+static const u16 synth_spr_tbl[] = {
+    48000, 44100, 38000, 32000, 24000, 22050, 16000, 12000, 11025, 8000,
+};
+
+//与SYNTH_WIN_xxx对应
+AT(.com_rodata.synth)
+static const synth_env_t synth_env_tbl[] = {
+    {2,     0,      255,    4,      0},     //SYNTH_WIN_FADE_HALF
+    {2,     0,      255,    8,      0},     //SYNTH_WIN_FADE
+    {2,     0,      255,    1,      15},    //SYNTH_WIN_SINE
+    {2,     60,     96,     3,      0},     //SYNTH_WIN_PIANO
+};
+
+//以下音符表与bsp_piano.c里的tone表一一对应
+AT(.com_rodata.synth)
+static const synth_note_t synth_power_on_tbl[] = {
+    {200,   160,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     20,     0,                  0,                      0},
+    {302,   160,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     20,     0,                  0,                      0},
+    {400,   157,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     20,     0,                  0,                      0},
+    {501,   157,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE,         0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_power_off_tbl[] = {
+    {501,   160,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     20,     0,                  0,                      0},
+    {400,   160,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     20,     0,                  0,                      0},
+    {302,   157,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     20,     0,                  0,                      0},
+    {200,   157,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE,         0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_pair_tbl[] = {
+    {501,   100,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_disconnected_tbl[] = {
+    {380,   103,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     40,     0,                  0,                      0},
+    {380,   103,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE,         0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_connected_tbl[] = {
+    {760,   100,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_ring_tbl[] = {
+    {450,   1365,   SYNTH_WAVE_SINE,    SYNTH_WIN_SINE,         0},
+    {0,     20,     0,                  0,                      0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_maxvol_tbl[] = {
+    {2600,  100,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE,         0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_low_battery_tbl[] = {
+    {848,   207,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE,         0},
+    {0,     50,     0,                  0,                      0},
+    {639,   208,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE,         0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_redialing_tbl[] = {
+    {524,   100,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+};
+
+AT(.com_rodata.synth)
+static const synth_note_t synth_bt_mode_tbl[] = {
+    {392,   100,    SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+    {0,     53,     0,                  0,                      0},
+    {586,   98,     SYNTH_WAVE_SINE,    SYNTH_WIN_FADE_HALF,    0},
+};
+
+typedef struct {
+    const synth_note_t *tbl;
+    u8 len;
+} synth_prompt_t;
+
+//与TONE_xxx对应
+AT(.com_rodata.synth)
+static const synth_prompt_t synth_prompt_tbl[] = {
+    {synth_power_on_tbl,        sizeof(synth_power_on_tbl) / sizeof(synth_note_t)},
+    {synth_power_off_tbl,       sizeof(synth_power_off_tbl) / sizeof(synth_note_t)},
+    {synth_pair_tbl,            sizeof(synth_pair_tbl) / sizeof(synth_note_t)},
+    {synth_disconnected_tbl,    sizeof(synth_disconnected_tbl) / sizeof(synth_note_t)},
+    {synth_connected_tbl,       sizeof(synth_connected_tbl) / sizeof(synth_note_t)},
+    {synth_ring_tbl,            sizeof(synth_ring_tbl) / sizeof(synth_note_t)},
+    {synth_maxvol_tbl,          sizeof(synth_maxvol_tbl) / sizeof(synth_note_t)},
+    {synth_low_battery_tbl,     sizeof(synth_low_battery_tbl) / sizeof(synth_note_t)},
+    {synth_redialing_tbl,       sizeof(synth_redialing_tbl) / sizeof(synth_note_t)},
+    {synth_bt_mode_tbl,         sizeof(synth_bt_mode_tbl) / sizeof(synth_note_t)},
+};
+
+//phase高8bit查表, 1/4周期表对称展开
+AT(.com_text.synth)
+static s16 synth_sine(u32 phase)
+{
+    u8 idx = phase >> 24;
+    u8 i = idx & 0x3f;
+    s16 val;
+    if (idx & 0x40) {
+        val = synth_sine_tbl[64 - i];
+    } else {
+        val = synth_sine_tbl[i];
+    }
+    return (idx & 0x80) ? -val : val;
+}
+
+//进入下一个样点数不为0的包络阶段
+AT(.com_text.synth)
+static void synth_env_next(synth_voice_t *v)
+{
+    s32 target;
+    while (++v->stage < SYNTH_ENV_OFF) {
+        v->cnt = v->seg[v->stage];
+        if (v->cnt) {
+            break;
+        }
+    }
+    switch (v->stage) {
+    case SYNTH_ENV_ATTACK:
+        target = SYNTH_ENV_FULL;
+        break;
+    case SYNTH_ENV_DECAY:
+    case SYNTH_ENV_SUSTAIN:
+        target = v->sustain;
+        break;
+    case SYNTH_ENV_RELEASE:
+        target = 0;
+        break;
+    default:
+        v->env = 0;
+        v->env_step = 0;
+        return;
+    }
+    v->env_step = (target - v->env) / (s32)v->cnt;
+}
+
+AT(.com_text.synth)
+static synth_voice_t *synth_voice_alloc(synth_cb_t *s)
+{
+    for (u8 i = 0; i < SYNTH_VOICE_NUM; i++) {
+        if (s->voice[i].stage == SYNTH_ENV_OFF) {
+            return &s->voice[i];
+        }
+    }
+    //都在发声, 轮流抢占
+    synth_voice_t *v = &s->voice[s->voice_next];
+    if (++s->voice_next >= SYNTH_VOICE_NUM) {
+        s->voice_next = 0;
+    }
+    return v;
+}
+
+AT(.com_text.synth)
+static void synth_note_on(synth_cb_t *s, const synth_note_t *note, u32 total)
+{
+    const synth_env_t *e = &synth_env_tbl[note->win];
+    synth_voice_t *v = synth_voice_alloc(s);
+    u32 att = e->attack * s->spr_hz / 1000;
+    u32 dec = e->decay * s->spr_hz / 1000;
+    u32 rel = total * e->release / 8;
+
+    //attack优先, 音符太短时依次缩短release, decay
+    if (att > total) {
+        att = total;
+    }
+    if (rel > total - att) {
+        rel = total - att;
+    }
+    if (dec > total - att - rel) {
+        dec = total - att - rel;
+    }
+
+    v->phase = 0;
+    v->inc = note->freq * s->inc_unit;
+    v->lfo_phase = 0;
+    v->lfo_inc = e->lfo * s->inc_unit;
+    v->wave = note->wave;
+    v->sustain = (SYNTH_ENV_FULL / 255) * e->sustain;
+    v->seg[SYNTH_ENV_ATTACK] = att;
+    v->seg[SYNTH_ENV_DECAY] = dec;
+    v->seg[SYNTH_ENV_SUSTAIN] = total - att - dec - rel;
+    v->seg[SYNTH_ENV_RELEASE] = rel;
+    v->env = 0;
+    v->stage = (u8)-1;
+    synth_env_next(v);
+}
+
+//启动下一个音符, 带SYNTH_NOTE_CHORD的音符和后面的一起开始
+AT(.com_text.synth)
+static void synth_seq_next(synth_cb_t *s)
+{
+    while (s->idx < s->len) {
+        const synth_note_t *note = &s->tbl[s->idx++];
+        u32 total = note->time * s->spr_hz / 1000;
+        if (note->freq && total) {
+            synth_note_on(s, note, total);
+        }
+        if (!(note->flag & SYNTH_NOTE_CHORD)) {
+            s->wait = total ? total : 1;
+            return;
+        }
+    }
+    s->tbl = NULL;
+}
+
+AT(.com_text.synth)
+static void synth_set_spr(synth_cb_t *s, u8 spr)
+{
+    if (spr >= sizeof(synth_spr_tbl) / sizeof(u16)) {
+        spr = SPR_48000;
+    }
+    if (s->spr_hz && s->spr == spr) {
+        return;
+    }
+    //采样率变化, 正在发声的音符不再调整, 下一个音符生效
+    s->spr = spr;
+    s->spr_hz = synth_spr_tbl[spr];
+    s->inc_unit = 0xffffffffUL / s->spr_hz;
+}
+
+AT(.com_text.synth)
+static bool synth_is_active(synth_cb_t *s)
+{
+    if (s->tbl) {
+        return true;
+    }
+    for (u8 i = 0; i < SYNTH_VOICE_NUM; i++) {
+        if (s->voice[i].stage != SYNTH_ENV_OFF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AT(.com_text.synth)
+static s32 synth_sat16(s32 val)
+{
+    if (val > 32767) {
+        return 32767;
+    } else if (val < -32768) {
+        return -32768;
+    }
+    return val;
+}
+
+//生成一个样点, 所有发声单元求和
+AT(.com_text.synth)
+static s32 synth_render(synth_cb_t *s)
+{
+    s32 sum = 0;
+    for (u8 i = 0; i < SYNTH_VOICE_NUM; i++) {
+        synth_voice_t *v = &s->voice[i];
+        s32 val;
+        if (v->stage == SYNTH_ENV_OFF) {
+            continue;
+        }
+        if (v->wave == SYNTH_WAVE_SQUARE) {
+            val = (v->phase & 0x80000000) ? -32767 : 32767;
+        } else {
+            val = synth_sine(v->phase);
+        }
+        val = (val * (v->env >> 8)) >> 15;
+        if (v->lfo_inc) {
+            //(1 - cos) / 2, 从0开始调制
+            val = (val * ((32767 - synth_sine(v->lfo_phase + 0x40000000)) >> 1)) >> 15;
+            v->lfo_phase += v->lfo_inc;
+        }
+        sum += val;
+        v->phase += v->inc;
+        v->env += v->env_step;
+        if (--v->cnt == 0) {
+            synth_env_next(v);
+        }
+    }
+    return (synth_sat16(sum) * s->gain) >> 15;
+}
+
+//混音到ADC->DAC的PCM数据, 在sdadc回调里调用. ch_mode: 0单声道, 1双声道; spr: SPR_xxx
+AT(.com_text.synth)
+void bsp_synth_mix(u8 *ptr, u32 samples, int ch_mode, u8 spr)
+{
+    synth_cb_t *s = &synth_cb;
+    s16 *pcm = (s16 *)ptr;
+
+    synth_set_spr(s, spr);
+    s->mix_tick = tick_get();
+    if (!synth_is_active(s)) {
+        return;
+    }
+    for (u32 n = 0; n < samples; n++) {
+        if (s->wait && --s->wait == 0) {
+            synth_seq_next(s);
+        }
+        s32 val = synth_render(s);
+        *pcm = synth_sat16(*pcm + val);
+        pcm++;
+        if (ch_mode) {
+            *pcm = synth_sat16(*pcm + val);
+            pcm++;
+        }
+    }
+}
+
+AT(.text.bsp.synth)
+void bsp_synth_init(void)
+{
+    memset(&synth_cb, 0, sizeof(synth_cb));
+    for (u8 i = 0; i < SYNTH_VOICE_NUM; i++) {
+        synth_cb.voice[i].stage = SYNTH_ENV_OFF;
+    }
+}
+
+AT(.text.bsp.synth)
+bool bsp_synth_start(uint index)
+{
+    synth_cb_t *s = &synth_cb;
+    if (index >= sizeof(synth_prompt_tbl) / sizeof(synth_prompt_t)) {
+        return false;
+    }
+    GLOBAL_INT_DISABLE();
+    s->tbl = synth_prompt_tbl[index].tbl;
+    s->len = synth_prompt_tbl[index].len;
+    s->idx = 0;
+    s->wait = 1;                        //下一个样点开始
+    s->gain = get_piano_digvol();
+    GLOBAL_INT_RESTORE();
+    return true;
+}
+
+AT(.text.bsp.synth)
+void bsp_synth_stop(void)
+{
+    synth_cb_t *s = &synth_cb;
+    GLOBAL_INT_DISABLE();
+    s->tbl = NULL;
+    s->wait = 0;
+    for (u8 i = 0; i < SYNTH_VOICE_NUM; i++) {
+        s->voice[i].stage = SYNTH_ENV_OFF;
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+AT(.text.bsp.synth)
+bool bsp_synth_is_busy(void)
+{
+    return synth_is_active(&synth_cb);
+}
+
+//当前有ADC->DAC数据流在调用bsp_synth_mix
+AT(.text.bsp.synth)
+bool bsp_synth_is_streaming(void)
+{
+    return (synth_cb.spr_hz && !tick_check_expire(synth_cb.mix_tick, SYNTH_STREAM_TIMEOUT));
+}
+#endif // TONE_SYNTH_EN
@@ -0,0 +1,41 @@
+#ifndef _BSP_SYNTH_H
+#define _BSP_SYNTH_H
+
+//提示音合成器: 相位累加振荡器 + ADSR包络, 直接混音到ADC->DAC的PCM数据里(AUX/FM/扩音),
+//不用停掉当前通路去播放piano或MP3提示音. 每个样点的计算量固定(SYNTH_VOICE_NUM个振荡器)
+
+#define SYNTH_VOICE_NUM             4           //同时发声的最大音符数
+
+//波形
+enum {
+    SYNTH_WAVE_SINE = 0,
+    SYNTH_WAVE_SQUARE,
+};
+
+//窗函数, 与bsp_piano.c里的tone表注释对应
+enum {
+    SYNTH_WIN_FADE_HALF = 0,    //后1/2淡出
+    SYNTH_WIN_FADE,             //整个音符淡出
+    SYNTH_WIN_SINE,             //sine调制(15Hz)
+    SYNTH_WIN_PIANO,            //ADSR钢琴包络
+};
+
+//note flag
+#define SYNTH_NOTE_CHORD            BIT(0)      //和下一个音符同时开始
+
+typedef struct {
+    u16 freq;                   //频率Hz, 0为静音
+    u16 time;                   //持续时间ms
+    u8 wave;
+    u8 win;
+    u8 flag;
+} synth_note_t;
+
+void bsp_synth_init(void);
+bool bsp_synth_start(uint index);
+void bsp_synth_stop(void);
+bool bsp_synth_is_busy(void);
+bool bsp_synth_is_streaming(void);
+void bsp_synth_mix(u8 *ptr, u32 samples, int ch_mode, u8 spr);
+
+#endif // _BSP_SYNTH_H
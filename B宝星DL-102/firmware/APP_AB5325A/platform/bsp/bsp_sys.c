@@ -85,9 +85,12 @@ u8 get_usbtf_muxio(void)
 //const char usb_detect_str[] = "USB STA:%d\r\n";
 
 #if USB_SUPPORT_EN
+static u8 usb_det_sta;                  //上次检测结果, 给调度器的probe用, 不再单独读一次USB
+
 AT(.com_text.detect)
 void usb_detect(void)
 {
+    usb_det_sta = SCHED_PROBE_BUSY;
     if (!is_usb_support()) {
         return;
     }
@@ -124,6 +127,7 @@ void usb_detect(void)
 
 #endif
 //	printf(usb_detect_str, usb_sta);
+    usb_det_sta = usb_sta;
 
 
     if (usb_sta == USB_UDISK_CONNECTED) {
@@ -269,98 +273,212 @@ void usr_tmr1ms_isr(void)
 
 #if LED_DISP_EN
     port_2led_scan();
+    led_pat_pwm_isr();
 #endif // LED_DISP_EN
 
     plugin_tmr1ms_isr();
 }
 
-//timer tick interrupt(5ms)
-AT(.com_text.timer)
-void usr_tmr5ms_isr(void)
-{
-    tmr5ms_cnt++;
-    //5ms timer process
-    dac_fade_process();
-    bsp_key_scan();
-
-    plugin_tmr5ms_isr();
+static u8 det_job[6];                   //带probe的插拔检测任务, 唤醒后取消退避
+static u8 det_job_num;
 
 #if MUSIC_SDCARD_EN
-    sd_detect();
+AT(.com_text.detect)
+static u8 sd_detect_probe(void)
+{
+    if ((!is_sd_support()) || (IS_DET_SD_BUSY())) {
+        return SCHED_PROBE_BUSY;
+    }
+#if SD_SOFT_DETECT_EN
+    if (SD_IS_SOFT_DETECT()) {
+        return SCHED_PROBE_BUSY;
+    }
+#endif // SD_SOFT_DETECT_EN
+    return SD_IS_ONLINE();
+}
 #endif // MUSIC_SDCARD_EN
 
 #if MUSIC_SDCARD1_EN
-    sd1_detect();
+AT(.com_text.detect)
+static u8 sd1_detect_probe(void)
+{
+    if ((!is_sd1_support()) || (IS_DET_SD1_BUSY())) {
+        return SCHED_PROBE_BUSY;
+    }
+    return SD1_IS_ONLINE();
+}
 #endif // MUSIC_SDCARD1_EN
 
 #if USB_SUPPORT_EN
-    usb_detect();
+//usbchk_connect要切换复用IO, 不在probe里再调一次, 直接用usb_detect刚读到的结果
+AT(.com_text.detect)
+static u8 usb_detect_probe(void)
+{
+    return usb_det_sta;
+}
 #endif // USB_SUPPORT_EN
 
 #if LINEIN_DETECT_EN
-    linein_detect();
+AT(.com_text.detect)
+static u8 linein_detect_probe(void)
+{
+    if (IS_DET_LINEIN_BUSY()) {
+        return SCHED_PROBE_BUSY;
+    }
+    return LINEIN_IS_ONLINE();
+}
 #endif // LINEIN_DETECT_EN
 
 #if EARPHONE_DETECT_EN
-    earphone_detect();
+AT(.com_text.detect)
+static u8 earphone_detect_probe(void)
+{
+    if (IS_DET_EAR_BUSY()) {
+        return SCHED_PROBE_BUSY;
+    }
+    return EARPHONE_IS_ONLINE();
+}
 #endif // EARPHONE_DETECT_EN
 
 #if MIC_DETECT_EN
-    mic_detect();
+AT(.com_text.detect)
+static u8 mic_detect_probe(void)
+{
+    if (IS_DET_MIC_BUSY()) {
+        return SCHED_PROBE_BUSY;
+    }
+    return MIC_IS_ONLINE();
+}
 #endif // MIC_DETECT_EN
 
-    //20ms timer process
-    if ((tmr5ms_cnt % 10) == 0) {
 #if DAC_DNR_EN
-        dac_dnr_detect();
+//20ms timer process
+AT(.com_text.timer)
+static void tmr20ms_job(void)
+{
+    dac_dnr_detect();
+}
 #endif // DAC_DNR_EN
-    }
 
-    //50ms timer process
-    if ((tmr5ms_cnt % 10) == 0) {
-        ticks_50ms++;
-        led_scan();
+//50ms timer process
+AT(.com_text.timer)
+static void tmr50ms_job(void)
+{
+    ticks_50ms++;
+    led_scan();
 #if BT_PWRKEY_5S_DISCOVER_EN
-        pwrkey_5s_on_check();
+    pwrkey_5s_on_check();
 #endif // BT_PWRKEY_5S_DISCOVER_EN
-    }
+}
 
-    //100ms timer process
-    if ((tmr5ms_cnt % 20) == 0) {
-        lowpwr_tout_ticks();
+//100ms timer process
+AT(.com_text.timer)
+static void tmr100ms_job(void)
+{
+    lowpwr_tout_ticks();
 #if UDE_HID_EN
-        ude_tmr_isr();
+    ude_tmr_isr();
 #endif // UDE_HID_EN
-        gui_box_isr();                  //显示控件计数处理
+    gui_box_isr();                  //显示控件计数处理
 
-        if (sys_cb.lpwr_cnt > 0) {
-            sys_cb.lpwr_cnt++;
-        }
+    if (sys_cb.lpwr_cnt > 0) {
+        sys_cb.lpwr_cnt++;
+    }
 
-        if (sys_cb.key2unmute_cnt) {
-            sys_cb.key2unmute_cnt--;
-            if (!sys_cb.key2unmute_cnt) {
-                msg_enqueue(EVT_KEY_2_UNMUTE);
-            }
+    if (sys_cb.key2unmute_cnt) {
+        sys_cb.key2unmute_cnt--;
+        if (!sys_cb.key2unmute_cnt) {
+            msg_enqueue(EVT_KEY_2_UNMUTE);
         }
     }
+}
 
-    //500ms timer process
-    if ((tmr5ms_cnt % 100) == 0) {
-        sys_cb.cm_times++;
+//500ms timer process
+AT(.com_text.timer)
+static void tmr500ms_job(void)
+{
+    sys_cb.cm_times++;
 #if FUNC_CLOCK_EN
-        msg_enqueue(MSG_SYS_500MS);
+    msg_enqueue(MSG_SYS_500MS);
 #endif // FUNC_CLOCK_EN
-    }
+}
+
+//1s timer process
+AT(.com_text.timer)
+static void tmr1s_job(void)
+{
+    msg_enqueue(MSG_SYS_1S);
+    tmr5ms_cnt = 0;
+    sys_cb.lpwr_warning_cnt++;
+}
+
+//注册5ms定时任务, 在打开定时器前调用. 同周期的任务错开相位, 避免挤在同一个tick里
+AT(.text.bsp.sys.init)
+static void bsp_sched_init(void)
+{
+    sched_init();
+    det_job_num = 0;
+
+    //插拔检测: 状态一直不变就逐步降低检测频率, 有变化马上恢复5ms.
+    //几个检测任务相位相同, 退避后在同一个tick执行, 中间的tick没有任务到期
+#if MUSIC_SDCARD1_EN
+    det_job[det_job_num++] = sched_job_add(sd1_detect, 1, 0, sd1_detect_probe);
+#endif // MUSIC_SDCARD1_EN
+
+#if USB_SUPPORT_EN
+    det_job[det_job_num++] = sched_job_add(usb_detect, 1, 0, usb_detect_probe);
+#endif // USB_SUPPORT_EN
+
+#if MUSIC_SDCARD_EN
+    det_job[det_job_num++] = sched_job_add(sd_detect, 1, 0, sd_detect_probe);
+#endif // MUSIC_SDCARD_EN
+
+#if LINEIN_DETECT_EN
+    det_job[det_job_num++] = sched_job_add(linein_detect, 1, 0, linein_detect_probe);
+#endif // LINEIN_DETECT_EN
+
+#if EARPHONE_DETECT_EN
+    det_job[det_job_num++] = sched_job_add(earphone_detect, 1, 0, earphone_detect_probe);
+#endif // EARPHONE_DETECT_EN
+
+#if MIC_DETECT_EN
+    det_job[det_job_num++] = sched_job_add(mic_detect, 1, 0, mic_detect_probe);
+#endif // MIC_DETECT_EN
+
+#if DAC_DNR_EN
+    sched_job_add(tmr20ms_job, 4, 1, NULL);
+#endif // DAC_DNR_EN
+    sched_job_add(tmr50ms_job, 10, 2, NULL);
+    sched_job_add(tmr100ms_job, 20, 3, NULL);
+    sched_job_add(tmr500ms_job, 100, 5, NULL);
+    sched_job_add(tmr1s_job, 200, 7, NULL);
+}
 
-    //1s timer process
-    if ((tmr5ms_cnt % 200) == 0) {
-        msg_enqueue(MSG_SYS_1S);
-        tmr5ms_cnt = 0;
-        sys_cb.lpwr_warning_cnt++;
+//休眠时定时器关闭, 期间插拔不会被检测到, 唤醒后检测任务马上恢复5ms
+AT(.text.bsp.sys)
+void bsp_sched_wakeup(void)
+{
+    for (u8 i = 0; i < det_job_num; i++) {
+        sched_job_kick(det_job[i]);
     }
 }
 
+//timer tick interrupt(5ms)
+//定时器由库控制, 中断每秒仍然200次: 按键扫描要按5ms消抖, DAC淡入淡出在库里按tick走, 这两项每个tick都做.
+//时间轮只减少检测和定时任务的执行次数, 不减少中断次数
+AT(.com_text.timer)
+void usr_tmr5ms_isr(void)
+{
+    tmr5ms_cnt++;
+    //5ms timer process
+    dac_fade_process();
+    bsp_key_scan();
+
+    plugin_tmr5ms_isr();
+
+    sched_tick();
+}
+
 AT(.com_text.timer)
 void timer1_isr(void)
 {
@@ -773,6 +891,7 @@ void bsp_update_init(void)
     xosc_init();
 
     plugin_init();
+    bsp_sched_init();
     sys_set_tmr_enable(1, 1);
 
     dac_init();
@@ -875,6 +994,9 @@ void bsp_sys_init(void)
     // peripheral init
     rtc_init();
     param_init(sys_cb.rtc_first_pwron);
+#if FUNC_CLOCK_EN
+    alarm_init();
+#endif // FUNC_CLOCK_EN
 
     //晶振配置
     xosc_init();
@@ -902,6 +1024,7 @@ void bsp_sys_init(void)
 #endif // PWM_RGB_EN
 
     /// enable user timer for display & dac
+    bsp_sched_init();
     sys_set_tmr_enable(1, 1);
 
     led_power_up();
@@ -911,6 +1034,13 @@ void bsp_sys_init(void)
 #endif // FUNC_FMRX_EN
 
     dac_init();
+    audio_path_cfg_build();
+#if TONE_SYNTH_EN
+    bsp_synth_init();
+#endif // TONE_SYNTH_EN
+#if SPECTRUM_EN
+    spectrum_init();
+#endif // SPECTRUM_EN
 
     bt_init();
 
@@ -978,6 +1108,10 @@ void bsp_sys_init(void)
     eq_dbg_init();
 #endif // EQ_DBG_IN_UART
 
+#if BT_APP_LINK_EN
+    app_link_init();
+#endif // BT_APP_LINK_EN
+
 #if PLUGIN_SYS_INIT_FINISH_CALLBACK
     plugin_sys_init_finish_callback(); //初始化完成, 各方案可能还有些不同参数需要初始化,预留接口到各方案
 #endif
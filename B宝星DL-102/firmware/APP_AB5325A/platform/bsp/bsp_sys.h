@@ -92,5 +92,6 @@ void linein_detect(void);
 bool linein_micl_is_online(void);
 void tws_lr_xcfg_sel(void);
 void get_usb_chk_sta_convert(void);
+void bsp_sched_wakeup(void);
 #endif // _BSP_SYS_H
 
@@ -36,6 +36,12 @@ void fmrx_sdadc_process(u8 *ptr, u32 samples, int ch_mode)
         puts_rec_obuf(ptr, (u16)(samples << (1 + ch_mode)));
     }
 #endif // FMRX_REC_EN
+#if SPECTRUM_EN
+    spectrum_pcm_input(ptr, samples, ch_mode, audio_path_get_spr(AUDIO_PATH_FM));
+#endif // SPECTRUM_EN
+#if TONE_SYNTH_EN
+    bsp_synth_mix(ptr, samples, ch_mode, audio_path_get_spr(AUDIO_PATH_FM));
+#endif // TONE_SYNTH_EN
     sdadc_pcm_2_dac(ptr, samples, ch_mode);
 }
 
@@ -6,42 +6,41 @@
 u8  qnd_PreNoiseFloor = 40;
 u32 osc_setup_ticks;
 
+#define QND_REG_NUM             0x59
+
+//状态/RDS/CCA结果等芯片自己会改的寄存器, 不走影子
+static const u32 qnd_nocache[(QND_REG_NUM + 31) / 32] = {
+    0x040ff8ff,                 //0x00~0x07, 0x0b~0x13, 0x1a
+    0x80000001,                 //0x20, 0x3f
+    0x00008000,                 //0x4f
+};
+
+static u8 qnd_reg[QND_REG_NUM];
+static u32 qnd_valid[(QND_REG_NUM + 31) / 32];
+
+static i2c_dev_t qn8035_dev = {
+    .addr = 0x20,
+    .flag = I2C_DEV_FAST | I2C_DEV_AUTO_INC,
+    .reg_num = QND_REG_NUM,
+    .gap_us = 60,
+    .shadow = qnd_reg,
+    .valid = qnd_valid,
+    .nocache = qnd_nocache,
+};
+
 AT(.text.qn8035)
 static u8 QND_ReadReg(u8 adr)
 {
-   	u8 rdat;
-
-    bsp_i2c_start();
-    bsp_i2c_tx_byte(0x20);
-    bsp_i2c_rx_ack();
-    bsp_i2c_tx_byte(adr);
-    bsp_i2c_rx_ack();
-    bsp_i2c_stop();
-    delay_us(60);
-
-    bsp_i2c_start();
-    bsp_i2c_tx_byte(0x21);
-    bsp_i2c_rx_ack();
-    rdat = bsp_i2c_rx_byte();
-    bsp_i2c_tx_nack();
-    bsp_i2c_stop();
-    delay_us(60);
-
-    return rdat;
+    return i2c_dev_read(&qn8035_dev, adr);
 }
 
 AT(.text.qn8035)
 static void QND_WriteReg(u8 adr, u8 value)
 {
-    bsp_i2c_start();
-    bsp_i2c_tx_byte(0x20);
-    bsp_i2c_rx_ack();
-    bsp_i2c_tx_byte(adr);
-    bsp_i2c_rx_ack();
-    bsp_i2c_tx_byte(value);
-    bsp_i2c_rx_ack();
-    bsp_i2c_stop();
-    delay_us(60);
+    i2c_dev_write(&qn8035_dev, adr, value);
+    if (adr == SYSTEM1 && (value & 0x80)) {
+        i2c_dev_invalidate(&qn8035_dev);            //SWRST, 寄存器恢复默认值
+    }
 }
 
 AT(.text.qn8035)
@@ -73,6 +72,8 @@ static void QNF_SetCh(u16 freq)
     u8 temp;
 
 	freq = FREQ2CHREG(freq);
+	//按手册顺序写, 合并成一次传输(重复START)
+	i2c_dev_batch_begin(&qn8035_dev);
 	//writing lower 8 bits of CCA channel start index
 	QND_WriteReg(CH_START, (u8)freq);
 	//writing lower 8 bits of CCA channel stop index
@@ -85,6 +86,7 @@ static void QNF_SetCh(u16 freq)
 	temp |= ((u8) (freq >> 4) & CH_CH_STOP);
 	temp |= QND_STEP_CONSTANT;
 	QND_WriteReg(CH_STEP, temp);
+	i2c_dev_batch_end(&qn8035_dev);
 }
 #else
 AT(.text.qn8035)
@@ -94,6 +96,8 @@ static void QNF_SetCh(u16 start, u16 stop, u8 step)
 
 	start = FREQ2CHREG(start);
 	stop = FREQ2CHREG(stop);
+	//按手册顺序写, 合并成一次传输(重复START)
+	i2c_dev_batch_begin(&qn8035_dev);
 	//writing lower 8 bits of CCA channel start index
 	QND_WriteReg(CH_START, (u8)start);
 	//writing lower 8 bits of CCA channel stop index
@@ -106,6 +110,7 @@ static void QNF_SetCh(u16 start, u16 stop, u8 step)
 	temp |= ((u8) (stop >> 4) & CH_CH_STOP);
 	temp |= (step << 6);
 	QND_WriteReg(CH_STEP, temp);
+	i2c_dev_batch_end(&qn8035_dev);
 }
 #endif // USING_VALID_CH
 
@@ -519,6 +524,24 @@ u8 qn8035_seek(u16 freq)
     return QND_RXValidCH(freq);//qn8035 step frequency unit is 10KHZ
 }
 
+//判台并返回RSSI + SNR作为电台质量, 0为无效台
+AT(.text.qn8035)
+u8 qn8035_seek_quality(u16 freq)
+{
+    u16 quality;
+    QNF_SetMute(1);
+    if (!QND_RXValidCH(freq)) {
+        return 0;
+    }
+    quality = QNM_GetRssi() + QND_ReadReg(SNR);
+    if (quality > 255) {
+        quality = 255;
+    } else if (quality == 0) {
+        quality = 1;
+    }
+    return quality;
+}
+
 AT(.text.qn8035)
 void qn8035_mute(void)
 {
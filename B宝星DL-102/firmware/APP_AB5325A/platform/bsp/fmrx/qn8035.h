@@ -151,6 +151,7 @@ void qn8035_init(void);
 void qn8035_off(void);
 void qnd8035_set_freq(u16 freq);
 u8 qn8035_seek(u16 freq);
+u8 qn8035_seek_quality(u16 freq);
 void qn8035_set_vol(u8 volume);
 void qn8035_unmute(void);
 void qn8035_mute(void);
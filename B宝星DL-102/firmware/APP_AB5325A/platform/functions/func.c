@@ -34,20 +34,13 @@ void lowpower_vbat_process(void)
         sys_cb.lpwr_warning_cnt = 0;
         if (sys_cb.lpwr_warning_times) {        //低电语音提示次数
             if (RLED_LOWBAT_FOLLOW_EN) {
-                led_lowbat_follow_warning();
+                led_lowbat_follow_warning();    //红灯闪完自动恢复
             }
 
             sys_cb.lowbat_flag = 1;
             func_cb.mp3_res_play(RES_BUF_LOW_BATTERY_MP3, RES_LEN_LOW_BATTERY_MP3);
             plugin_lowbat_vol_reduce();         //低电降低音乐音量
 
-            if (RLED_LOWBAT_FOLLOW_EN) {
-                while (get_led_sta(1)) {        //等待红灯闪完
-                    delay_5ms(2);
-                }
-                led_lowbat_recover();
-            }
-
             if (sys_cb.lpwr_warning_times != 0xff) {
                 sys_cb.lpwr_warning_times--;
             }
@@ -92,6 +85,14 @@ void func_process(void)
 #if LE_EN
     bsp_ble_process();
 #endif
+
+#if FUNC_CLOCK_EN
+    alarm_process();
+#endif // FUNC_CLOCK_EN
+
+#if SYS_PARAM_KV_EN
+    kv_process();
+#endif // SYS_PARAM_KV_EN
 }
 
 //func common message process
@@ -312,6 +313,7 @@ void func_message(u16 msg)
 #if EQ_DBG_IN_UART || EQ_DBG_IN_SPP
         case EVT_ONLINE_SET_EQ:
             eq_parse_cmd();
+            eq_dbg_cb.rx_busy = 0;
             break;
 #endif
 #if LANG_SELECT == LANG_EN_ZH
@@ -351,12 +353,22 @@ void func_message(u16 msg)
             karaok_mic_mute();
             break;
 #endif
+#if FUNC_CLOCK_EN
+        case EVT_ALARM_RING:
+            func_cb.sta = FUNC_CLOCK;               //切到时钟模式响铃, 进入时按alarm_get_ringing()开始响
+            break;
+
+        case EVT_ALARM_SLEEP:
+            sys_cb.pwrdwn_tone_en = 1;
+            func_cb.sta = FUNC_PWROFF;              //定时关机
+            break;
+#endif // FUNC_CLOCK_EN
     }
 
     //调节音量，3秒后写入flash
     if ((sys_cb.cm_vol_change) && (sys_cb.cm_times >= 6)) {
         sys_cb.cm_vol_change = 0;
-        cm_sync();
+        param_sync();
     }
 }
 
@@ -379,14 +391,15 @@ void func_enter(void)
 #endif
 }
 
+//func_sort_table里排在cur后面的任务
 AT(.text.func)
-void func_exit(void)
+static u8 func_get_next(u8 cur)
 {
     u8 func_num;
     u8 funcs_total = get_funcs_total();
 
     for (func_num = 0; func_num != funcs_total; func_num++) {
-        if (func_cb.last == func_sort_table[func_num]) {
+        if (cur == func_sort_table[func_num]) {
             break;
         }
     }
@@ -394,7 +407,45 @@ void func_exit(void)
     if (func_num >= funcs_total) {
         func_num = 0;
     }
-    func_cb.sta = func_sort_table[func_num];        //新的任务
+    return func_sort_table[func_num];
+}
+
+//退出cur时, 下一个任务进入后最先打开的ADC通路, 给audio_path_set_next用.
+//进入时先播模式提示音(提示音要adpll在DAC_OUT_SPR), 先关KARAOK, 或者不开ADC的任务返回AUDIO_PATH_NONE
+AT(.text.func)
+u8 func_get_enter_path(u8 cur)
+{
+    u8 sta = (func_cb.sta == FUNC_NULL) ? func_get_next(cur) : func_cb.sta;
+
+    switch (sta) {
+#if FUNC_AUX_EN && !WARNING_FUNC_AUX && !SYS_KARAOK_EN
+        case FUNC_AUX:
+            if (is_linein_enter_enable() && (AUX_2_SDADC_EN & xcfg_cb.aux_2_sdadc_en)) {
+                return AUDIO_PATH_AUX;
+            }
+            break;
+#endif
+#if FUNC_FMRX_EN && !FMRX_INSIDE_EN && FMRX_2_SDADC_EN && !WARNING_FUNC_FMRX && !SYS_KARAOK_EN
+        case FUNC_FMRX:
+            if (is_func_fmrx_en()) {
+                return AUDIO_PATH_FM;
+            }
+            break;
+#endif
+#if FUNC_SPEAKER_EN && !WARNING_FUNC_SPEAKER
+        case FUNC_SPEAKER:
+            return AUDIO_PATH_SPEAKER;
+#endif
+        default:
+            break;
+    }
+    return AUDIO_PATH_NONE;
+}
+
+AT(.text.func)
+void func_exit(void)
+{
+    func_cb.sta = func_get_next(func_cb.last);      //新的任务
 #if SYS_MODE_BREAKPOINT_EN
     param_sys_mode_write(func_cb.sta);
 #endif // SYS_MODE_BREAKPOINT_EN
@@ -55,6 +55,7 @@ void func_process(void);
 void func_message(u16 msg);
 
 void func_run(void);
+u8 func_get_enter_path(u8 cur);
 void func_music(void);
 void func_idle(void);
 void func_clock(void);
@@ -72,6 +72,12 @@ void aux_sdadc_process(u8 *ptr, u32 samples, int ch_mode)
 
     //pcm_manual_amplify(ptr,(samples*2)<<ch_mode,GAIN_DIG_P7DB);  //ch_mode 0 单声道, 1双声道
     if (f_aux.aux2adc & AUX2ADC_MASK) {
+#if SPECTRUM_EN
+        spectrum_pcm_input(ptr, samples, ch_mode, audio_path_get_spr(AUDIO_PATH_AUX));
+#endif // SPECTRUM_EN
+#if TONE_SYNTH_EN
+        bsp_synth_mix(ptr, samples, ch_mode, audio_path_get_spr(AUDIO_PATH_AUX));
+#endif // TONE_SYNTH_EN
         sdadc_pcm_2_dac(ptr, samples, ch_mode);
     }
 }
@@ -180,6 +186,9 @@ static void func_aux_enter(void)
 
 #if SYS_KARAOK_EN
     dac_fade_out();
+    if (f_aux.aux2adc & (AUX2ADC_MASK | AUX2PA_ADC_MASK)) {
+        audio_path_set_next(AUDIO_PATH_AUX);            //关KARAOK后马上打开AUX通路
+    }
     bsp_karaok_exit(AUDIO_PATH_KARAOK);
 #endif
 
@@ -199,6 +208,9 @@ static void func_aux_exit(void)
 #endif // AUX_REC_EN
 
     func_aux_exit_display();
+    if (f_aux.aux2adc & (AUX2ADC_MASK | AUX2PA_ADC_MASK)) {
+        audio_path_set_next(func_get_enter_path(FUNC_AUX));
+    }
     func_aux_stop();
     func_cb.last = FUNC_AUX;
 }
@@ -30,44 +30,19 @@ void rtc_clock_init(void)
     irtc_time_write(RTCCNT_CMD, rtc_tm_to_time(&rtc_tm));
 }
 
-//多少秒后闹钟响
+//闹钟到期由func_process()里的alarm_process()处理, 这里不再轮询RTC闹钟
 AT(.text.func.clock)
-void rtc_set_alarm_relative_time(u32 nsec)
-{
-    rtc_time_to_tm(irtc_time_read(RTCCNT_CMD), &rtc_tm);         //更新时间结构体
-    irtc_time_write(RTCALM_CMD, rtc_tm_to_time(&rtc_tm) + nsec);  //设置闹钟相对于当前时间n秒后
-}
-
-//设置多少秒后闹钟唤醒
-AT(.text.func.clock)
-void rtc_set_alarm_wakeup(u32 nsec)
+void func_clock_process(void)
 {
-    uint rtccon3 = irtc_sfr_read(RTCCON3_CMD);
-
-    RTCCPND = BIT(17);                          //clear RTC alarm pending
-    irtc_sfr_write(RTCCON8_CMD, 0x02);          //clear alarm pending
-    rtc_set_alarm_relative_time(nsec);
-
-    rtccon3 |= BIT(6);                          //RTC alarm wakeup enable
-    irtc_sfr_write(RTCCON3_CMD, rtccon3);
+    func_process();
 }
 
 AT(.text.func.clock)
-void func_clock_process(void)
+void func_clock_ring_start(void)
 {
-    func_process();
-
-    //通过ALARM每隔5秒打印一次时间，仅用于测试
-    if (RTCCON & BIT(17)) {
-        RTCCPND = BIT(17);                      //clear RTC alarm pending
-        irtc_sfr_write(RTCCON8_CMD, 0x02);      //clear alarm pending
-        if (!tm_cb.setting) {
-            rtc_time_to_tm(irtc_time_read(RTCCNT_CMD), &rtc_tm);           //更新时间结构体
-            irtc_time_write(RTCALM_CMD, rtc_tm_to_time(&rtc_tm) + 4);      //设置闹钟相对于当前时间5秒后
-            printf("time:  %d.%02d.%02d   %02d:%02d:%02d  %s\n", (rtc_tm.tm_year+1970), rtc_tm.tm_mon, rtc_tm.tm_mday,
-                       rtc_tm.tm_hour, rtc_tm.tm_min, rtc_tm.tm_sec, week_str[rtc_tm.tm_wday]);
-        }
-    }
+    tm_cb.ring = 1;
+    tm_cb.ring_cnt = 0;
+    mp3_res_play(RES_BUF_RING_MP3, RES_LEN_RING_MP3);
 }
 
 static void func_clock_enter(void)
@@ -78,11 +53,14 @@ static void func_clock_enter(void)
     func_cb.mp3_res_play = mp3_res_play;
     sys_cb.rtc_first_pwron = 0;
     rtc_time_to_tm(irtc_time_read(RTCCNT_CMD), &rtc_tm);         //更新时间结构体
-    irtc_time_write(RTCALM_CMD, rtc_tm_to_time(&rtc_tm)+4);      //设置闹钟相对于当前时间5秒后
     func_clock_enter_display();
 #if WARNING_FUNC_CLOCK
     mp3_res_play(RES_BUF_CLOCK_MODE_MP3, RES_LEN_CLOCK_MODE_MP3);
 #endif // WARNING_FUNC_CLOCK
+    //其它模式退出时会清消息队列, EVT_ALARM_RING不能再排一次, 按bsp_alarm记下的响铃状态开始
+    if (alarm_get_ringing() != ALARM_NONE) {
+        func_clock_ring_start();
+    }
 }
 
 static void func_clock_exit(void)
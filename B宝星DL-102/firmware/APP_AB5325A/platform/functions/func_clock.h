@@ -15,16 +15,17 @@ extern rtc_time_t rtc_tm;
 typedef struct {
     u8 type     : 1,                    //0: 时钟界面， 1：闹钟界面
        setting  : 1,                    //时间调整标志
-       res      : 6;                    //保留
+       ring     : 1,                    //闹钟响铃中
+       res      : 5;                    //保留
 
     u8 index;                           //时间调整index
+    u8 ring_cnt;                        //响铃次数
 } time_cb_t;
 extern time_cb_t tm_cb;
 
 void func_clock_message(u16 msg);
+void func_clock_ring_start(void);
 void rtc_clock_init(void);
-void rtc_set_alarm_relative_time(u32 nsec);
-void rtc_set_alarm_wakeup(u32 nsec);
 
 #if (GUI_SELECT != GUI_NO)
 void func_clock_display(void);
@@ -5,6 +5,23 @@
 fmrx_cb_t fmrx_cb AT(.buf.fmrx.cb);
 
 #if FUNC_FMRX_EN
+//自动搜台: 先按FMRX_SCAN_COARSE_STEP粗扫记录命中频点, 再对每簇相邻命中逐点测质量, 取最好的一个存台.
+//收音芯片只有判台结果(质量只有0/1)时分不出簇里的电台, 细扫判到的每个频点都单独存台
+typedef struct {
+    u16 hit[13];                //粗扫命中的频点, 格式同fmrx_cb.buf
+    u16 freq;                   //细扫当前频点
+    u16 end;                    //细扫当前簇结束频点, 0表示没有正在细扫的簇
+    u16 best_first;             //质量最好的连续频点范围
+    u16 best_last;
+    u8  best_q;
+    u8  prev_q;                 //细扫上一个频点的质量, 用来找两个电台之间的谷底
+    u8  phase;                  //0:未搜台, 1:粗扫, 2:细扫
+    u8  done;                   //细扫正常完成
+    u8  preview;                //正在试听
+    u8  graded;                 //bsp_fmrx_seek_quality有质量高低
+    u32 tick;
+} fmrx_scan_t;
+static fmrx_scan_t fmrx_scan AT(.buf.fmrx.scan);
 
 AT(.text.func.fmrx)
 void func_fmrx_stop(void)
@@ -105,6 +122,20 @@ u16 get_ch_freq(u8 ch)
     return FM_FREQ_MIN;
 }
 
+AT(.text.func.fmrx)
+static void fmrx_scan_set_hit(u16 freq)
+{
+    u16 idx = freq / 10 - 875;
+    fmrx_scan.hit[idx / 16] |= BIT(idx % 16);
+}
+
+AT(.text.func.fmrx)
+static bool fmrx_scan_is_hit(u16 freq)
+{
+    u16 idx = freq / 10 - 875;
+    return (fmrx_scan.hit[idx / 16] & BIT(idx % 16)) ? true : false;
+}
+
 AT(.text.func.fmrx)
 void reset_fm_cb(void)
 {
@@ -176,14 +207,187 @@ void fmrx_seek_start(void)
     bsp_karaok_exit(AUDIO_PATH_KARAOK);
 #endif
     reset_fm_cb();
+    memset(&fmrx_scan, 0, sizeof(fmrx_scan));
+    fmrx_scan.phase = 1;
+    fmrx_scan.graded = bsp_fmrx_quality_graded();
     fmrx_cb.seek_start = 1;
     fmrx_cb.sta = FMRX_SEEKING;
     dac_fade_out();
 }
 
+AT(.text.func.fmrx)
+static void fmrx_scan_fine_start(void)
+{
+    fmrx_cb.freq = FM_FREQ_MIN;         //细扫时freq作为粗扫结果的查找位置
+    fmrx_scan.end = 0;
+    fmrx_scan.phase = 2;
+    fmrx_cb.sta = FMRX_SEEKING_FINE;
+}
+
+//存一个电台: 同质量的连续频点取中间(偶数个时取靠前的), 同一电台只存一次
+AT(.text.func.fmrx)
+static void fmrx_scan_save_best(void)
+{
+    fmrx_scan_t *s = &fmrx_scan;
+    if (s->best_q == 0) {
+        return;
+    }
+    u16 freq = s->best_first + (s->best_last - s->best_first) / 20 * 10;
+    save_ch_buf(freq / 10);
+    fmrx_cb.ch_cnt++;
+    fmrx_cb.ch_cur = fmrx_cb.ch_cnt;
+    s->best_q = 0;
+#if FMRX_SEEK_DISP_CH_EN
+    gui_display(DISP_FQ_CHAN);
+#endif // FMRX_SEEK_DISP_CH_EN
+}
+
+//每次只测一个频点, 不阻塞主循环. measure为0时不访问收音芯片, 直接按粗扫结果存台
+AT(.text.func.fmrx)
+static void fmrx_scan_fine_process(bool measure)
+{
+    fmrx_scan_t *s = &fmrx_scan;
+    u8 q;
+
+    if (s->end == 0) {
+        //找下一簇连续命中的频点
+        while ((fmrx_cb.freq <= FM_FREQ_MAX) && (!fmrx_scan_is_hit(fmrx_cb.freq))) {
+            fmrx_cb.freq += 10;
+        }
+        if (fmrx_cb.freq > FM_FREQ_MAX) {
+            fmrx_scan.phase = 0;
+            fmrx_scan.done = measure;
+            fmrx_cb.sta = FMRX_SEEK_STOP;
+            return;
+        }
+        u16 last = fmrx_cb.freq;
+        while ((last + FMRX_SCAN_COARSE_STEP <= FM_FREQ_MAX) && fmrx_scan_is_hit(last + FMRX_SCAN_COARSE_STEP)) {
+            last += FMRX_SCAN_COARSE_STEP;
+        }
+        //细扫范围扩到粗扫没测过的相邻频点
+        s->freq = fmrx_cb.freq - FMRX_SCAN_COARSE_STEP + 10;
+        if (s->freq < FM_FREQ_MIN) {
+            s->freq = FM_FREQ_MIN;
+        }
+        s->end = last + FMRX_SCAN_COARSE_STEP - 10;
+        if (s->end > FM_FREQ_MAX) {
+            s->end = FM_FREQ_MAX;
+        }
+        s->best_q = 0;
+        s->prev_q = 0;
+        fmrx_cb.freq = last + FMRX_SCAN_COARSE_STEP;
+        return;
+    }
+
+    bool on_grid = ((s->freq - FM_FREQ_MIN) % FMRX_SCAN_COARSE_STEP == 0);
+    if (measure && (s->graded || !on_grid)) {
+        q = bsp_fmrx_seek_quality(s->freq);
+    } else if (on_grid) {
+        q = fmrx_scan_is_hit(s->freq) ? 1 : 0;      //没有质量高低时粗扫结果就是判台结果, 不再测
+    } else if (s->graded) {
+        //粗扫没测过的频点, 下一个粗扫点命中时算作当前连续范围的一部分
+        u16 next = s->freq + FMRX_SCAN_COARSE_STEP - (s->freq - FM_FREQ_MIN) % FMRX_SCAN_COARSE_STEP;
+        q = fmrx_scan_is_hit(next) ? s->best_q : 0;
+    } else {
+        q = 0;
+    }
+    if (!s->graded) {
+        //判到的频点都是电台, 不能按连续范围合并, 否则相邻两个台会合成中间一个不存在的台
+        if (q) {
+            s->best_q = q;
+            s->best_first = s->freq;
+            s->best_last = s->freq;
+            fmrx_scan_save_best();
+        }
+    } else {
+        if ((q == 0) || ((q > s->prev_q) && (s->prev_q != 0) && (s->prev_q < s->best_q))) {
+            fmrx_scan_save_best();      //簇里测到无台或质量的谷底, 前后是不同的电台
+        }
+        if (q > s->best_q) {
+            s->best_q = q;
+            s->best_first = s->freq;
+            s->best_last = s->freq;
+        } else if ((q != 0) && (q == s->best_q) && (s->best_last + 10 == s->freq)) {
+            s->best_last = s->freq;
+        }
+    }
+    s->prev_q = q;
+    s->freq += 10;
+    if (s->freq > s->end) {
+        fmrx_scan_save_best();
+        s->end = 0;
+    }
+}
+
+//搜台被打断时, 还没细扫的粗扫结果直接存台
+AT(.text.func.fmrx)
+static void fmrx_scan_flush(void)
+{
+    if (fmrx_scan.phase == 1) {
+        fmrx_scan_fine_start();
+    }
+    while (fmrx_scan.phase == 2) {
+        fmrx_scan_fine_process(0);
+    }
+}
+
+#if FMRX_SCAN_PREVIEW_EN
+AT(.text.func.fmrx)
+static void fmrx_scan_preview_next(void)
+{
+    fmrx_cb.freq = get_ch_freq(fmrx_cb.ch_cur);
+    gui_box_show_chan();
+    bsp_fmrx_set_freq(fmrx_cb.freq);
+    dac_fade_in();
+    fmrx_scan.tick = tick_get();
+}
+
+AT(.text.func.fmrx)
+static void fmrx_scan_preview_process(void)
+{
+    if (!tick_check_expire(fmrx_scan.tick, FMRX_SCAN_PREVIEW_TIME)) {
+        return;
+    }
+    if (fmrx_cb.ch_cur >= fmrx_cb.ch_cnt) {
+        fmrx_cb.ch_cur = 1;
+        fmrx_cb.sta = FMRX_SEEK_STOP;           //试听完回到第一个台
+        return;
+    }
+    dac_fade_out();
+    dac_fade_wait();
+    fmrx_cb.ch_cur++;
+    fmrx_scan_preview_next();
+}
+#endif // FMRX_SCAN_PREVIEW_EN
+
 AT(.text.func.fmrx)
 void fmrx_seek_stop(void)
 {
+#if FMRX_SCAN_PREVIEW_EN
+    if (fmrx_scan.preview) {
+        //试听结束或按键打断, 停在当前台
+        fmrx_scan.preview = 0;
+        fmrx_cb.sta = FMRX_PLAY;
+        fmrx_set_curch_freq();
+        return;
+    }
+    if (fmrx_scan.done && (fmrx_cb.ch_cnt > 1)) {
+        fmrx_scan.done = 0;
+        fmrx_cb.ch_cur = 1;
+        param_fmrx_chcnt_write();
+        param_fmrx_chbuf_write();
+        param_sync();
+        fmrx_scan.preview = 1;
+        fmrx_cb.sta = FMRX_SEEK_PREVIEW;
+        fmrx_scan_preview_next();
+#if SYS_KARAOK_EN
+        bsp_karaok_init(AUDIO_PATH_KARAOK, FUNC_FMRX);
+#endif
+        return;
+    }
+#endif // FMRX_SCAN_PREVIEW_EN
+    fmrx_scan_flush();
+    fmrx_scan.done = 0;
     fmrx_cb.sta = FMRX_PLAY;
     fmrx_cb.freq = FM_FREQ_MIN;
     if (fmrx_cb.ch_cnt > 0) {
@@ -293,25 +497,25 @@ void func_fmrx_process(void)
             break;
 
         case FMRX_SEEKING:
-            if (bsp_fmrx_check_freq(fmrx_cb.freq)) {
-                fmrx_cb.ch_cnt++;
-                save_ch_buf(fmrx_cb.freq / 10);
-//                printf("ch freq: %d\n", fmrx_cb.freq);
-                fmrx_cb.ch_cur = fmrx_cb.ch_cnt;
-                bsp_fmrx_set_freq(fmrx_cb.freq);
-#if FMRX_SEEK_DISP_CH_EN
-                gui_display(DISP_FQ_CHAN);
-#endif // FMRX_SEEK_DISP_CH_EN
-                dac_fade_in();
-                delay_5ms(300);
-                dac_fade_out();
+            if (bsp_fmrx_seek_quality(fmrx_cb.freq)) {
+                fmrx_scan_set_hit(fmrx_cb.freq);
             }
-            fmrx_cb.freq += 10;
+            fmrx_cb.freq += FMRX_SCAN_COARSE_STEP;
             if (fmrx_cb.freq > FM_FREQ_MAX) {
-                fmrx_cb.sta = FMRX_SEEK_STOP;
+                fmrx_scan_fine_start();
             }
             break;
 
+        case FMRX_SEEKING_FINE:
+            fmrx_scan_fine_process(1);
+            break;
+
+#if FMRX_SCAN_PREVIEW_EN
+        case FMRX_SEEK_PREVIEW:
+            fmrx_scan_preview_process();
+            break;
+#endif // FMRX_SCAN_PREVIEW_EN
+
         case FMRX_SEEK_STOP:
             led_fm_play();
             fmrx_seek_stop();
@@ -347,6 +551,9 @@ void func_fmrx_enter(void)
 
 #if SYS_KARAOK_EN
     dac_fade_out();
+#if !FMRX_INSIDE_EN && FMRX_2_SDADC_EN
+    audio_path_set_next(AUDIO_PATH_FM);                 //关KARAOK后马上打开外置收音通路
+#endif
     bsp_karaok_exit(AUDIO_PATH_KARAOK);
 #endif
 #if BT_BACKSTAGE_EN
@@ -394,6 +601,9 @@ void func_fmrx_exit(void)
 #endif // FMRX_REC_EN
 
 #if !FMRX_INSIDE_EN
+#if FMRX_2_SDADC_EN
+    audio_path_set_next(func_get_enter_path(FUNC_FMRX));
+#endif
     bsp_aux_stop(FMRX_CHANNEL_CFG, ((u8)FMRX_2_SDADC_EN << 7) | AUDIO_PATH_FM);
 #endif
 
@@ -4,7 +4,9 @@
 enum {
     FMRX_IDLE = 0,
     FMRX_SEEK_START,
-    FMRX_SEEKING,
+    FMRX_SEEKING,                   //粗扫
+    FMRX_SEEKING_FINE,              //细扫, 对粗扫命中的频点排序去重
+    FMRX_SEEK_PREVIEW,              //搜台结束后逐台试听
     FMRX_SEEK_STOP,
     FMRX_SEEKING_HALF,              //半自动搜台
     FMRX_PLAY,
@@ -57,6 +57,12 @@ uint32_t sleep_timer(void)
         sys_cb.sleep_wakeup_time = -1L;
     }
 
+#if FUNC_CLOCK_EN
+    if (alarm_is_pending()) {
+        ret = 2;                                //闹钟/定时关机到期才唤醒
+    }
+#endif // FUNC_CLOCK_EN
+
     if(sys_cb.pwroff_delay != -1L) {
         if(sys_cb.pwroff_delay > 5) {
             sys_cb.pwroff_delay -= 5;
@@ -85,6 +91,9 @@ static void sfunc_sleep(void)
 
     printf("%s\n", __func__);
 
+#if SYS_PARAM_KV_EN
+    kv_flush();                         //休眠中可能掉电, 先把参数写到flash
+#endif // SYS_PARAM_KV_EN
 #if SYS_KARAOK_EN
     bsp_karaok_exit(AUDIO_PATH_KARAOK);
 #endif
@@ -204,6 +213,7 @@ static void sfunc_sleep(void)
     charge_disp_sta(sys_cb.charge_sta);      //update充灯状态
 #endif // CHARGE_EN
     sys_set_tmr_enable(1, 1);
+    bsp_sched_wakeup();
 
     if (DAC_FAST_SETUP_EN) {
         bsp_loudspeaker_mute();
@@ -258,6 +268,9 @@ void func_sleepmode(void)
     u8 sys_clk, p111_en;
 //    printf("%s\n", __func__);
 
+#if SYS_PARAM_KV_EN
+    kv_flush();
+#endif // SYS_PARAM_KV_EN
     gui_display(DISP_OFF);
 #if DAC_DNR_EN
     u8 sta = dac_dnr_get_sta();
@@ -388,6 +401,7 @@ void func_sleepmode(void)
     charge_set_stop_time(18000);
 #endif // CHARGE_EN
     sys_set_tmr_enable(1, 1);
+    bsp_sched_wakeup();
 
     if (DAC_FAST_SETUP_EN) {
         bsp_loudspeaker_mute();
@@ -496,6 +510,9 @@ AT(.text.lowpwr.pwroff)
 void func_pwroff(int pwroff_tone_en)
 {
     printf("%s\n", __func__);
+#if SYS_PARAM_KV_EN
+    kv_flush();                         //关机前把参数写到flash
+#endif // SYS_PARAM_KV_EN
     led_power_down();
 #if WARNING_POWER_OFF
     if (SOFT_POWER_ON_OFF) {
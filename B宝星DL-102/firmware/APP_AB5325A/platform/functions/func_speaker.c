@@ -101,6 +101,12 @@ void speaker_sdadc_process(u8 *ptr, u32 samples, int ch_mode)
     }
 #endif //MIC_REC_EN
 
+#if SPECTRUM_EN
+    spectrum_pcm_input(ptr, samples, ch_mode, audio_path_get_spr(AUDIO_PATH_SPEAKER));
+#endif // SPECTRUM_EN
+#if TONE_SYNTH_EN
+    bsp_synth_mix(ptr, samples, ch_mode, audio_path_get_spr(AUDIO_PATH_SPEAKER));
+#endif // TONE_SYNTH_EN
     sdadc_pcm_2_dac(ptr, samples, ch_mode);
 }
 
@@ -137,6 +143,7 @@ static void func_speaker_exit(void)
 
     func_speaker_exit_display();
     led_idle();
+    audio_path_set_next(func_get_enter_path(FUNC_SPEAKER));
     func_speaker_stop();
     func_cb.last = FUNC_SPEAKER;
 }
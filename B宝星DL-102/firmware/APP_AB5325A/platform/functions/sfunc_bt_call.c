@@ -72,6 +72,7 @@ void sco_audio_init(void)
 #endif
 
 #if SYS_KARAOK_EN
+    audio_path_set_next(AUDIO_PATH_BTMIC);              //关KARAOK后马上打开通话MIC
     bsp_karaok_exit(AUDIO_PATH_KARAOK);
     sys_cb.hfp_karaok_en = BT_HFP_CALL_KARAOK_EN;       //通话是否支持KARAOK
     plugin_hfp_karaok_configure();
@@ -99,6 +100,7 @@ void sco_audio_exit(void)
 #if SYS_KARAOK_EN
     if (sys_cb.hfp_karaok_en) {
         kara_sco_stop();
+        audio_path_set_next(AUDIO_PATH_KARAOK);
         bsp_karaok_exit(AUDIO_PATH_BTMIC);
         sys_cb.hfp_karaok_en = 0;
     } else
@@ -107,6 +109,9 @@ void sco_audio_exit(void)
         dac_fade_out();
         dac_set_anl_offset(0);
         bsp_change_volume(sys_cb.vol);
+#if SYS_KARAOK_EN
+        audio_path_set_next(AUDIO_PATH_KARAOK);         //退出通话后马上重新打开KARAOK
+#endif
         audio_path_exit(AUDIO_PATH_BTMIC);
         bt_voice_exit();
     }
@@ -17,6 +17,15 @@
 #define ENERGY_LED_EN               0
 #endif
 
+#ifndef SPECTRUM_EN
+#define SPECTRUM_EN                 0
+#endif
+
+#if (!ENERGY_LED_EN && ((GUI_SELECT & DISPLAY_LEDSEG) != DISPLAY_LEDSEG))
+#undef SPECTRUM_EN
+#define SPECTRUM_EN                 0
+#endif
+
 #ifndef PLUGIN_SYS_INIT_FINISH_CALLBACK
 #define PLUGIN_SYS_INIT_FINISH_CALLBACK  0
 #endif
@@ -50,6 +59,15 @@
 #ifndef SPIFLASH_SPEED_UP_EN
 #define SPIFLASH_SPEED_UP_EN         1
 #endif
+
+#ifndef SYS_PARAM_KV_EN
+#define SYS_PARAM_KV_EN             0
+#endif
+
+#if SYS_PARAM_RTCRAM                        //参数保存到RTCRAM时不用flash日志
+#undef SYS_PARAM_KV_EN
+#define SYS_PARAM_KV_EN             0
+#endif
 /*****************************************************************************
  * Module    : 音乐功能配置
  *****************************************************************************/
@@ -226,6 +244,18 @@
 #define FMRX_SEEK_DISP_CH_EN            0
 #endif // FMRX_SEEK_DISP_CH_EN
 
+#ifndef FMRX_SCAN_COARSE_STEP
+#define FMRX_SCAN_COARSE_STEP           10
+#endif // FMRX_SCAN_COARSE_STEP
+
+#ifndef FMRX_SCAN_PREVIEW_EN
+#define FMRX_SCAN_PREVIEW_EN            0
+#endif // FMRX_SCAN_PREVIEW_EN
+
+#ifndef FMRX_SCAN_PREVIEW_TIME
+#define FMRX_SCAN_PREVIEW_TIME          1500
+#endif // FMRX_SCAN_PREVIEW_TIME
+
 #ifndef SD_SOFT_DETECT_EN
 #define SD_SOFT_DETECT_EN               0
 #undef SD_IS_SOFT_DETECT
@@ -293,6 +323,10 @@
 #define I2C_MUX_SD_EN               0
 #endif
 
+#ifndef I2C_FAST_MODE_EN
+#define I2C_FAST_MODE_EN            0
+#endif // I2C_FAST_MODE_EN
+
 #if ((GUI_SELECT & DISPLAY_LCD) == DISPLAY_LCD)
 #define GUI_LCD_EN                      1
 #else
@@ -540,6 +574,10 @@
 #define WARNING_BT_PAIR                0
 #endif
 
+#ifndef TONE_SYNTH_EN
+#define TONE_SYNTH_EN                  0
+#endif // TONE_SYNTH_EN
+
 #if ((!MUSIC_UDISK_EN) && (!MUSIC_SDCARD_EN) && (!MUSIC_SDCARD1_EN))
 #undef  USB_SD_UPDATE_EN
 #define USB_SD_UPDATE_EN               0
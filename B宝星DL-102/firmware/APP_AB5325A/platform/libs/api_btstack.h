@@ -286,6 +286,7 @@ void le_enable_adv(u8 allow);
 void le_disable_adv(void);
 void le_disconnect(void);
 bool le_tx_notify(u8 index, u8* buf, u8 len);
+u16 le_get_gatt_mtu(void);                      //当前连接每包最多能发的数据长度(ATT MTU - 3, 库里限制最大120)
 bool le_set_adv_data(const u8 *adv_buf, u32 size);
 
 #endif //_API_BTSTACK_H
@@ -33,7 +33,7 @@
 #define USB_SD_UPDATE_EN                1                       //是否支持UDISK/SD的离线升级
 #define SYS_ADJ_DIGVOL_EN               0                       //系统是否调数字音量
 #define GUI_SELECT                      GUI_NO                  //GUI Display Select
-#define FLASH_SIZE                      FSIZE_512K              //LQFP48芯片内置1MB，其它封装芯片内置512KB(实际导出prd文件要小于492K)
+#define FLASH_SIZE                      FSIZE_512K              //LQFP48芯片内置1MB，其它封装芯片内置512KB(实际导出prd文件要小于492K, 最后20K是参数区)
 #define UART0_PRINTF_SEL                PRINTF_NONE              //选择UART打印信息输出IO，或关闭打印信息输出
 #define SPIFLASH_SPEED_UP_EN            1                       //SPI FLASH提速。注意5327A,5327C,5325F不支持提速，这三颗芯请配置成0
 /*****************************************************************************
@@ -89,6 +89,7 @@
 #define BT_A2DP_EN                      1   //是否打开蓝牙音乐服务
 #define BT_HFP_EN                       1   //是否打开蓝牙通话服务
 #define BT_SPP_EN                       1   //是否打开蓝牙串口服务
+#define BT_APP_LINK_EN                  1   //是否打开APP分帧通信协议(CRC16校验, 序号, 拼包, 批量命令), 兼容旧版APP命令
 #define BT_HID_EN                       0   //是否打开蓝牙HID服务（自拍器）
 #define BT_HID_MENU_EN                  0   //蓝牙HID是否需要手动连接/断开
 #define BT_HID_DISCON_DEFAULT_EN        0   //蓝牙HID服务默认不连接，需要手动进行连接。
@@ -131,6 +132,9 @@
 #define FMRX_HALF_SEEK_EN               1   //是否打开半自动搜台
 #define FMRX_INSIDE_EN                  1   //是否使用内置收音
 #define FMRX_QN8035_EN                  0
+#define FMRX_SCAN_COARSE_STEP           10  //自动搜台粗扫步进(10KHz为单位), 10为逐点粗扫. 改为20时不在200KHz栅格上的弱台会漏掉, 内置收音不在栅格上的台全部漏掉
+#define FMRX_SCAN_PREVIEW_EN            0   //自动搜台结束后是否逐台试听
+#define FMRX_SCAN_PREVIEW_TIME          1500 //每个台试听时间(ms)
 
 ///外接收音芯片相关配置
 #define FMRX_2_SDADC_EN                 1                               //外接收音是否进SDADC，否则直通DAC。进SDADC可以调EQ，FMRX录音等功能。
@@ -302,6 +306,7 @@
  *****************************************************************************/
 #define I2C_EN                          0           //是否使能I2C功能
 #define I2C_MUX_SD_EN                   1           //是否I2C复用SD卡的IO
+#define I2C_FAST_MODE_EN                1           //codec/收音等I2C设备是否允许使用快速时序
 
 #define I2C_SCL_IN()                    SD_CMD_DIR_IN()
 #define I2C_SCL_OUT()                   SD_CMD_DIR_OUT()
@@ -370,12 +375,14 @@
  *****************************************************************************/
 #define RGB_SERIAL_EN                   0           //RGB串行推灯功能
 #define PWM_RGB_EN                      0           //PWM RGB三色灯功能
-#define ENERGY_LED_EN                   0           //能量灯软件PWM显示,声音越大,点亮的灯越多.
+#define ENERGY_LED_EN                   0           //能量灯软件PWM显示,声音越大,点亮的灯越多. 按频段显示, 要SPECTRUM_EN=1
+#define SPECTRUM_EN                     0           //能量灯/数码管按频段显示(FFT频谱), 要ENERGY_LED_EN=1或GUI_SELECT选GUI_LEDSEG_xxx才编译
 #define SYS_PARAM_RTCRAM                0           //是否系统参数保存到RTCRAM
+#define SYS_PARAM_KV_EN                 1           //系统参数用追加写日志保存在参数区最后4K(CM区缩到16K), 空闲时合并写flash, 整理前备份到CM, 掉电安全
 #define PWRON_ENTER_BTMODE_EN           0           //是否上电默认进蓝牙模式
 #define VBAT_DETECT_EN                  1           //电池电量检测功能
 #define VBAT2_ADCCH                     ADCCH_VBAT  //ADCCH_VBAT为内部1/2电压通路，带升压应用需要外部ADC通路检测1/2电池电压
-#define VBAT_FILTER_USE_PEAK            0           //电池检测滤波选则://0 取平均值.//1 取峰值(适用于播放音乐时,电池波动比较大的音箱方案).
+#define VBAT_FUEL_GAUGE_EN              1           //电量计: 按音量和输出能量补偿播放时的电池压降, EMA滤波, OCV曲线查电量百分比(适用于播放音乐时,电池波动比较大的音箱方案), 低电提醒按开路电压估计, 低电关机仍用实测电压
 #define EQ_MODE_EN                      1           //是否调节EQ MODE (POP, Rock, Jazz, Classic, Country)
 #define EQ_DBG_IN_UART                  1           //是否使能UART在线调节EQ
 #define EQ_DBG_IN_SPP                   1           //是否使能SPP在线调节EQ
@@ -386,6 +393,7 @@
 #define LPWR_OFF_VBAT                   xcfg_cb.lpwr_off_vbat       //低电关机电压
 #define LOWPWR_REDUCE_VOL_EN            1                           //低电是否降低音量
 #define LPWR_WARING_TIMES               0xff                        //报低电次数
+#define MSG_PRIO_QUEUE_EN               1                           //是否使用分优先级的消息队列(按键 > 音频控制 > 定时/插拔), 并合并重复消息
 /*****************************************************************************
  * Module    : LED指示灯配置
  *****************************************************************************/
@@ -455,6 +463,7 @@
  *****************************************************************************/
 #define WARNING_TONE_EN                 1            //是否打开提示音功能, 总开关
 #define WARING_MAXVOL_MP3               0            //最大音量提示音WAV或MP3选择， 播放WAV可以与MUSIC叠加播放。
+#define TONE_SYNTH_EN                   1            //AUX/FM/扩音模式下, tone提示音直接合成混音到ADC->DAC数据流
 #define WARNING_VOLUME                  xcfg_cb.warning_volume   //播放提示音的音量级数
 #define LANG_SELECT                     LANG_EN      //提示音语言选择
 
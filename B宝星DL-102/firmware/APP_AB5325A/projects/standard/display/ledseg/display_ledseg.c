@@ -27,6 +27,37 @@ const u8 ledseg_playmode_table[4][3] =
     {T_LEDSEG_R, T_LEDSEG_D, T_LEDSEG_O},   //随机播放
 };
 
+#if SPECTRUM_EN
+//频谱柱从下往上点亮: D, C+E, G, B+F, A
+AT(.rodata.ledseg)
+const u8 ledseg_bar_table[6] = {
+    0,
+    SEG_D,
+    SEG_D | SEG_C | SEG_E,
+    SEG_D | SEG_C | SEG_E | SEG_G,
+    SEG_D | SEG_C | SEG_E | SEG_G | SEG_B | SEG_F,
+    SEG_D | SEG_C | SEG_E | SEG_G | SEG_B | SEG_F | SEG_A,
+};
+
+//每位数码管显示一个频段, 峰值高于柱时用横段(D/G/A)标出
+AT(.text.display.ledseg)
+static void ledseg_disp_spectrum(void)
+{
+    u8 i, bar, peak;
+    if (!spectrum_is_active()) {
+        return;
+    }
+    for (i = 0; i < 4; i++) {
+        bar = (spectrum_get_level(i) * 5 + SPECTRUM_LEVEL_MAX / 2) / SPECTRUM_LEVEL_MAX;
+        peak = (spectrum_get_peak(i) * 5 + SPECTRUM_LEVEL_MAX / 2) / SPECTRUM_LEVEL_MAX;
+        ledseg_buf[i] = ledseg_bar_table[bar];
+        if (peak > bar) {
+            ledseg_buf[i] |= (peak >= 5) ? SEG_A : (peak >= 3) ? SEG_G : SEG_D;
+        }
+    }
+}
+#endif // SPECTRUM_EN
+
 //Display functions icon
 AT(.text.ledseg)
 static void ledseg_msc_icon(void)
@@ -168,6 +199,10 @@ void ledseg_disp_aux(void)
     ledseg_buf[4] |= ICON_AUX;
     if (f_aux.pause) {
         ledseg_buf[4] |= ICON_PAUSE;
+#if SPECTRUM_EN
+    } else {
+        ledseg_disp_spectrum();
+#endif // SPECTRUM_EN
     }
 #endif // FUNC_AUX_EN
 }
@@ -214,6 +249,10 @@ void ledseg_disp_speaker(void)
     ledseg_buf[3] = T_LEDSEG_T;
     if (f_spk.pause) {
         ledseg_buf[4] |= ICON_PAUSE;
+#if SPECTRUM_EN
+    } else {
+        ledseg_disp_spectrum();
+#endif // SPECTRUM_EN
     }
 #endif // FUNC_SPEAKER_EN
 }
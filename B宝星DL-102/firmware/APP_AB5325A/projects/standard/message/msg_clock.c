@@ -3,10 +3,87 @@
 #include "func_clock.h"
 
 #if FUNC_CLOCK_EN
+#define ALARM_RING_TIMES        60          //响铃多少次(约1秒一次)没人按键自动贪睡
+#define ALARM_UI_ID             0           //按键只设置第一个闹钟, 其它闹钟通过alarm_set()设置
+
+//闹钟界面按REPEAT切换: 只响一次, 每天, 周一~周五
+AT(.rodata.func.clock.msg)
+static const u8 alarm_wday_tbl[] = {0x00, 0x7f, 0x3e};
+
+//长按PREV切换定时关机(分钟), 0为取消
+AT(.rodata.func.clock.msg)
+static const u8 sleep_min_tbl[] = {0, 15, 30, 60, 90};
+
+//闹钟界面借用rtc_tm显示闹钟时间, MSG_SYS_500MS不会刷新成当前时间
+AT(.text.func.clock.msg)
+static void clock_alarm_load(void)
+{
+    const alarm_cfg_t *cfg = alarm_get(ALARM_UI_ID);
+    rtc_tm.tm_hour = cfg->hour;
+    rtc_tm.tm_min = cfg->min;
+    rtc_tm.tm_sec = 0;
+}
+
+AT(.text.func.clock.msg)
+static void clock_alarm_save(u8 wday, u8 en)
+{
+    alarm_cfg_t cfg;
+    cfg.hour = rtc_tm.tm_hour;
+    cfg.min = rtc_tm.tm_min;
+    cfg.wday = wday;
+    cfg.en = en;
+    alarm_set(ALARM_UI_ID, &cfg);
+}
+
+//按剩余时间切到下一档, 最后一档之后取消
+AT(.text.func.clock.msg)
+static void clock_sleep_timer_next(void)
+{
+    u32 left = alarm_sleep_timer_left();
+    u8 i = 0;
+    while (i < sizeof(sleep_min_tbl) && (u32)sleep_min_tbl[i] * 60 <= left + 60) {
+        i++;
+    }
+    if (i >= sizeof(sleep_min_tbl)) {
+        i = 0;
+    }
+    alarm_sleep_timer_set((u32)sleep_min_tbl[i] * 60);
+    printf("sleep timer: %d min\n", sleep_min_tbl[i]);
+}
+
 AT(.text.func.clock.msg)
 void func_clock_message(u16 msg)
 {
+    if (tm_cb.ring) {
+        if (msg == KL_PLAY) {
+            tm_cb.ring = 0;
+            alarm_stop();                   //长按PLAY关闹钟
+            return;
+        }
+        if ((msg & KEY_TYPE_MASK) == KEY_SHORT_UP) {
+            tm_cb.ring = 0;
+            alarm_snooze();                 //响铃时短按任意键贪睡
+            return;
+        }
+    }
+
     switch (msg) {
+        case EVT_ALARM_RING:
+            func_clock_ring_start();
+            break;
+
+        case MSG_SYS_1S:
+            if (tm_cb.ring) {
+                if (++tm_cb.ring_cnt >= ALARM_RING_TIMES) {
+                    tm_cb.ring = 0;
+                    alarm_snooze();
+                } else {
+                    mp3_res_play(RES_BUF_RING_MP3, RES_LEN_RING_MP3);
+                }
+            }
+            func_message(msg);
+            break;
+
         case KU_PLAY:
         case KU_PLAY_HSF:
         case KU_PLAY_POWER:
@@ -14,15 +91,58 @@ void func_clock_message(u16 msg)
             if (tm_cb.setting) {
                 tm_cb.setting = 0;
                 rtc_tm.tm_sec = 0;
-                irtc_time_write(RTCCNT_CMD, rtc_tm_to_time(&rtc_tm));
+                if (tm_cb.type) {
+                    clock_alarm_save(alarm_get(ALARM_UI_ID)->wday, 1);  //设好闹钟时间就打开
+                } else {
+                    alarm_time_set(rtc_tm_to_time(&rtc_tm));    //闹钟按新时间重新排
+                }
             } else {
                 tm_cb.setting = 1;
                 tm_cb.index = 1;
                 gui_box_flicker_set(5, 0xff, tm_cb.index);        //flicker freq 100ms*5
+                if (!tm_cb.type) {
+                    rtc_time_to_tm(irtc_time_read(RTCCNT_CMD), &rtc_tm);
+                }
+            }
+            break;
+
+        //长按NEXT切换时钟/闹钟界面
+        case KL_NEXT:
+            if (tm_cb.setting) {
+                break;
+            }
+            tm_cb.type ^= 1;
+            if (tm_cb.type) {
+                clock_alarm_load();
+            } else {
                 rtc_time_to_tm(irtc_time_read(RTCCNT_CMD), &rtc_tm);
             }
             break;
 
+        //闹钟界面: 长按PLAY开关闹钟, REPEAT切换重复方式
+        case KL_PLAY:
+            if (tm_cb.type && !tm_cb.setting) {
+                clock_alarm_save(alarm_get(ALARM_UI_ID)->wday, !alarm_get(ALARM_UI_ID)->en);
+            } else {
+                func_message(msg);
+            }
+            break;
+
+        case KU_REPEAT:
+            if (tm_cb.type) {
+                u8 i = 0;
+                while (i < sizeof(alarm_wday_tbl) && alarm_wday_tbl[i] != alarm_get(ALARM_UI_ID)->wday) {
+                    i++;
+                }
+                i = (i + 1) % sizeof(alarm_wday_tbl);
+                clock_alarm_save(alarm_wday_tbl[i], alarm_get(ALARM_UI_ID)->en);
+            }
+            break;
+
+        case KL_PREV:
+            clock_sleep_timer_next();
+            break;
+
         case KU_NEXT:
             tm_cb.index = (tm_cb.index == 1) ? 2 : 1;
             gui_box_flicker_set(5, 0xff, tm_cb.index);
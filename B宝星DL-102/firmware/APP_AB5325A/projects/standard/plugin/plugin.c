@@ -93,6 +93,9 @@ void plugin_var_init(void)
 AT(.com_text.plugin)
 void plugin_tmr5ms_isr(void)
 {
+#if SPECTRUM_EN
+    spectrum_5ms_process();
+#endif
 #if ENERGY_LED_EN
     energy_led_level_calc();
 #endif
@@ -368,37 +371,10 @@ void plugin_music_eq(void)
 AT(.com_text.port.vbat)
 void plugin_vbat_filter(u32 *vbat)
 {
-#if  VBAT_FILTER_USE_PEAK
-    //电源波动比较大的音箱方案, 取一定时间内的电量"最大值"或"次大值",更能真实反应电量.
-    #define VBAT_MAX_TIME  (3000/5)   //电量峰值判断时间 3S
-    static u16 cnt = 0;
-	static u16 vbat_max_cnt = 0;
-    static u32 vbat_max[2] = {0,0};
-    static u32 vbat_ret = 0;
-    u32 vbat_cur = *vbat;
-    if (cnt++  < VBAT_MAX_TIME) {
-        if (vbat_max[0] < vbat_cur) {
-            vbat_max[1] = vbat_max[0];  //vbat_max[1] is less max (次大值)
-            vbat_max[0] = vbat_cur;     //vbat_max[0] is max(最大值)
-            vbat_max_cnt = 0;
-        } else if (vbat_max[0] == vbat_cur) {
-            vbat_max_cnt ++;
-        }
-    } else {
-        if (vbat_max_cnt >= VBAT_MAX_TIME/5) {  //总次数的(1/5)都采到最大值,则返回最大值.
-            vbat_ret = vbat_max[0];
-        } else if (vbat_max[1] != 0) {   //最大值次数较少,则返回次大值(舍弃最大值)
-            vbat_ret = vbat_max[1];
-        }
-        vbat_max[0] = 0;
-        vbat_max[1] = 0;
-        vbat_max_cnt = 0;
-        cnt = 0;
-    }
-    //返回值
-    if (vbat_ret != 0) {
-        *vbat = vbat_ret;
-    }
+#if (VBAT_DETECT_EN && VBAT_FUEL_GAUGE_EN)
+    //电源波动比较大的音箱方案, 采样送给电量计补偿喇叭负载上的压降, 用来算电量(fuel_get_level)和低电提醒(fuel_lowbat_warning).
+    //*vbat不改, sys_cb.vbat还是实测电压的均值, 低电关机按带负载的端电压判断
+    fuel_filter(*vbat);
 #endif
 }
 
@@ -51,7 +51,7 @@ void led_bt_idle(void)
     if (xcfg_cb.led_btpair_config_en) {
         led_cfg_set_sta((led_cfg_t *)&xcfg_cb.led_pairing);
     } else {
-        led_set_sta(0x00, 0xaa, 10, 0);          //500ms˸
+        led_pat_play(LED_PAT_BT_PAIR);          //1s˫, TWSͬ
     }
 }
 
@@ -0,0 +1,304 @@
+//bsp_alarm闹钟调度: RTC计数/闹钟比较器/参数区用变量模拟, 从2024.2.27 23:50开始跑10天(跨闰年2月底和月底),
+//检查每次响铃和定时关机的时间, 唤醒次数和写RTCALM的次数. 再跑时钟模式的按键界面和从其它模式切过来时补上响铃
+#include "include.h"
+#include "host_test.h"
+
+//RTC的SFR换成变量
+static unsigned long sim_rtccon, sim_cpnd;
+#undef RTCCON
+#undef RTCCPND
+#define RTCCON                      sim_rtccon
+#define RTCCPND                     sim_cpnd
+
+//资源地址是flash上的变量, 主机上换成常数
+#undef RES_BUF_RING_MP3
+#undef RES_LEN_RING_MP3
+#undef RES_BUF_CLOCK_MODE_MP3
+#undef RES_LEN_CLOCK_MODE_MP3
+#define RES_BUF_RING_MP3            0x1000
+#define RES_LEN_RING_MP3            0x100
+#define RES_BUF_CLOCK_MODE_MP3      0x2000
+#define RES_LEN_CLOCK_MODE_MP3      0x100
+
+#include "bsp_alarm.c"
+#include "func_clock.c"
+#include "message/msg_clock.c"
+
+#define SIM_DAYS            10
+#define SIM_START           1709077800UL        //2024.2.27(周二) 23:50:00
+
+static u32 sim_now, sim_alm;
+static u8 sim_con3;
+static u8 sim_param[64];
+static u16 msgs[16];
+static int msg_num;
+static unsigned long wakeups, flash_writes, ring_plays;
+
+func_cb_t func_cb;
+sys_cb_t sys_cb;
+xcfg_cb_t xcfg_cb;
+gui_box_t box_cb;
+
+u32 irtc_time_read(u32 cmd)
+{
+    return (cmd == RTCCNT_CMD) ? sim_now : sim_alm;
+}
+
+void irtc_time_write(u32 cmd, u32 dat)
+{
+    if (cmd == RTCCNT_CMD) {
+        sim_now = dat;
+    } else {
+        sim_alm = dat;
+    }
+}
+
+u8 irtc_sfr_read(u32 cmd)
+{
+    return (cmd == RTCCON3_CMD) ? sim_con3 : 0;
+}
+
+void irtc_sfr_write(u32 cmd, u8 dat)
+{
+    if (cmd == RTCCON3_CMD) {
+        sim_con3 = dat;
+    }
+    if (cmd == RTCCON8_CMD && (dat & 0x02)) {
+        sim_rtccon &= ~BIT(17);
+    }
+}
+
+void param_alarm_write(u8 *buf)
+{
+    memcpy(sim_param, buf, sizeof(alarm_cfg_t) * ALARM_NUM);
+    flash_writes++;
+}
+
+void param_alarm_read(u8 *buf)
+{
+    memcpy(buf, sim_param, sizeof(alarm_cfg_t) * ALARM_NUM);
+}
+
+void param_sync(void) {}
+
+//消息队列: 只记录, 模式切换时清掉
+void bsp_msg_enqueue(u16 msg)
+{
+    msgs[msg_num++] = msg;
+}
+
+void bsp_msg_clear(void)
+{
+    msg_num = 0;
+}
+
+u16 bsp_msg_dequeue(void)
+{
+    func_cb.sta = FUNC_NULL;                    //func_clock()只跑一圈
+    return NO_MSG;
+}
+
+void mp3_res_play(u32 addr, u32 len)
+{
+    if (addr == RES_BUF_RING_MP3) {
+        ring_plays++;
+    }
+}
+
+//时间换算按1970年起的秒数, 只用到时分秒
+void rtc_time_to_tm(unsigned long time, void *param)
+{
+    rtc_time_t *tm = param;
+    tm->tm_sec = time % 60;
+    tm->tm_min = time / 60 % 60;
+    tm->tm_hour = time / 3600 % 24;
+}
+
+unsigned long rtc_tm_to_time(void *param)
+{
+    rtc_time_t *tm = param;
+    return sim_now / 86400 * 86400 + tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+}
+
+u8 get_weekday(u8 year, u8 month, u8 day) { return 0; }
+void func_process(void) {}
+void func_message(u16 msg) {}
+void gui_box_flicker_set(u8 cnt, u8 icon, u8 pos) {}
+
+//模拟RTC走一秒, 计数等于闹钟寄存器且使能唤醒时置pending
+static void sim_tick(void)
+{
+    sim_now++;
+    if (sim_now == sim_alm && (sim_con3 & BIT(6))) {
+        sim_rtccon |= BIT(17);
+    }
+}
+
+static const alarm_cfg_t cfg0 = {7, 0, 0x7f, 1};        //每天7:00
+static const alarm_cfg_t cfg1 = {23, 59, 0, 1};         //单次23:59
+static const alarm_cfg_t cfg2 = {6, 30, 0x3e, 1};       //周一~周五6:30
+
+static int expect_alarm(const alarm_cfg_t *c, u32 t)
+{
+    if (t % 86400 != (u32)c->hour * 3600 + c->min * 60) {
+        return 0;
+    }
+    return (c->wday >> ((t / 86400 + ALARM_EPOCH_WDAY) % 7)) & 1;
+}
+
+static void key(u16 msg)
+{
+    func_clock_message(msg);
+}
+
+int main(void)
+{
+    memset(sim_param, 0xff, sizeof(sim_param));         //没写过的参数区
+    sim_now = SIM_START;
+    alarm_init();
+    CHECK(alarm_cb.num == 0 && !(sim_con3 & BIT(6)));
+    CHECK(alarm_set(0, &cfg0) && alarm_set(1, &cfg1) && alarm_set(2, &cfg2));
+    CHECK(!alarm_set(ALARM_NUM, &cfg0));
+
+    //重新上电, 从参数区恢复
+    alarm_init();
+    CHECK(alarm_cb.num == 3 && alarm_get(1)->en && alarm_get(2)->wday == 0x3e);
+    alarm_sleep_timer_set(600);
+    CHECK(alarm_sleep_timer_left() == 600);
+    CHECK(sim_alm == SIM_START + 540);                  //23:59的单次闹钟在前
+
+    u32 start = sim_now, snooze_due = 0, sleep_due = start + 600;
+    int rings = 0, sleeps = 0;
+    bool snoozed = false;
+    unsigned long prog0 = alarm_cb.stat.program;
+    for (u32 i = 0; i < SIM_DAYS * 86400; i++) {
+        sim_tick();
+        u32 t = sim_now;
+        int exp = expect_alarm(&cfg0, t) | expect_alarm(&cfg2, t);
+        if (t == start + 540) {
+            exp = 1;                                    //单次闹钟只响第一天
+        }
+        if (snooze_due && t == snooze_due) {
+            exp = 1;
+            snooze_due = 0;
+        }
+        if (sim_rtccon & BIT(17)) {
+            wakeups++;
+        }
+        msg_num = 0;
+        alarm_process();
+        int r = 0, s = 0;
+        for (int k = 0; k < msg_num; k++) {
+            r += (msgs[k] == EVT_ALARM_RING);
+            s += (msgs[k] == EVT_ALARM_SLEEP);
+        }
+        CHECK(r == exp);
+        CHECK(s == (t == sleep_due));
+        rings += r;
+        sleeps += s;
+        if (r && !snoozed) {
+            snoozed = true;
+            alarm_snooze();
+            snooze_due = t + ALARM_SNOOZE_TIME;
+        } else if (r) {
+            alarm_stop();
+        }
+    }
+    CHECK(!alarm_get(1)->en);                           //单次闹钟响过后关掉
+    CHECK(sleeps == 1);
+    (printf)("%d days: rings %d, sleep %d, wakeups %lu, rtcalm writes %lu, flash writes %lu, heap hwm %d\n",
+             SIM_DAYS, rings, sleeps, wakeups, (unsigned long)(alarm_cb.stat.program - prog0), flash_writes, alarm_cb.stat.hwm);
+    CHECK(wakeups == (unsigned long)(rings + sleeps));
+    CHECK(alarm_cb.stat.program - prog0 <= (unsigned long)(rings + sleeps) + 1);
+
+    //调时间: 往回调1天, 闹钟按新时间排, 定时关机剩余时间不变
+    alarm_sleep_timer_set(3600);
+    alarm_time_set(sim_now - 86400);
+    CHECK(alarm_sleep_timer_left() == 3600);
+    CHECK(alarm_cb.heap[0].due > sim_now && alarm_cb.heap[0].due - sim_now <= 86400);
+    alarm_sleep_timer_set(0);
+
+    //在其它模式时响铃: 消息在退出模式时被清掉, 进入时钟模式后按记下的状态开始响
+    alarm_time_set(sim_now / 86400 * 86400 + 7 * 3600 - 10);
+    msg_num = 0;
+    for (int i = 0; i < 10; i++) {
+        sim_tick();
+        alarm_process();
+    }
+    CHECK(msg_num == 1 && msgs[0] == EVT_ALARM_RING && alarm_get_ringing() == 0);
+    msg_queue_clear();
+    ring_plays = 0;
+    func_cb.sta = FUNC_CLOCK;
+    func_clock();
+    CHECK(tm_cb.ring && ring_plays == 1);
+    key(KU_NEXT);                                       //短按贪睡
+    CHECK(!tm_cb.ring && alarm_get_ringing() == ALARM_NONE);
+    CHECK(alarm_cb.heap[0].type == ALARM_TYPE_SNOOZE && alarm_cb.heap[0].due == sim_now + ALARM_SNOOZE_TIME);
+    //没有响铃时进入不响
+    func_cb.sta = FUNC_CLOCK;
+    func_clock();
+    CHECK(!tm_cb.ring && ring_plays == 1);
+    key(EVT_ALARM_RING);
+    key(KL_PLAY);                                       //长按PLAY关闹钟, 贪睡也取消
+    CHECK(!tm_cb.ring);
+    for (u8 i = 0; i < alarm_cb.num; i++) {
+        CHECK(alarm_cb.heap[i].type != ALARM_TYPE_SNOOZE);
+    }
+
+    //按键界面设置闹钟: 长按NEXT到闹钟界面, PLAY进入设置, 分钟+3, 小时-1, PLAY保存并打开
+    alarm_cfg_t off = {6, 0, 0, 0};
+    alarm_set(ALARM_UI_ID, &off);
+    key(KL_NEXT);
+    CHECK(tm_cb.type && rtc_tm.tm_hour == 6 && rtc_tm.tm_min == 0);
+    key(KU_PLAY);
+    key(KU_VOL_UP);
+    key(KU_VOL_UP);
+    key(KU_VOL_UP);
+    key(KU_NEXT);
+    key(KU_VOL_DOWN);
+    key(KU_PLAY);
+    CHECK(!tm_cb.setting);
+    CHECK(alarm_get(ALARM_UI_ID)->hour == 5 && alarm_get(ALARM_UI_ID)->min == 3 && alarm_get(ALARM_UI_ID)->en);
+    //设置闹钟时间不能改RTC
+    CHECK(sim_now % 86400 == 7 * 3600);
+    //REPEAT: 单次 -> 每天 -> 工作日 -> 单次
+    key(KU_REPEAT);
+    CHECK(alarm_get(ALARM_UI_ID)->wday == 0x7f);
+    key(KU_REPEAT);
+    CHECK(alarm_get(ALARM_UI_ID)->wday == 0x3e);
+    key(KU_REPEAT);
+    CHECK(alarm_get(ALARM_UI_ID)->wday == 0);
+    //长按PLAY开关
+    key(KL_PLAY);
+    CHECK(!alarm_get(ALARM_UI_ID)->en);
+    key(KL_PLAY);
+    CHECK(alarm_get(ALARM_UI_ID)->en && alarm_get(ALARM_UI_ID)->hour == 5);
+    //回到时钟界面显示当前时间
+    key(KL_NEXT);
+    CHECK(!tm_cb.type && rtc_tm.tm_hour == 7);
+    //闹钟到时间会响
+    bool rang = false;
+    for (u32 i = 0; i < 86400 && !rang; i++) {
+        sim_tick();
+        msg_num = 0;
+        alarm_process();
+        rang = (msg_num == 1 && sim_now % 86400 == 5 * 3600 + 3 * 60);
+    }
+    CHECK(rang);
+
+    //长按PREV切换定时关机: 15, 30, 60, 90分钟, 取消
+    static const u32 sleep_steps[] = {15, 30, 60, 90, 0};
+    for (u8 i = 0; i < sizeof(sleep_steps) / sizeof(sleep_steps[0]); i++) {
+        key(KL_PREV);
+        CHECK(alarm_sleep_timer_left() == sleep_steps[i] * 60);
+        sim_now += 20;                                  //按键之间过了一点时间
+    }
+    key(KL_PREV);
+    sim_now += 15 * 60;
+    sim_rtccon |= BIT(17);
+    msg_num = 0;
+    alarm_process();
+    CHECK(msg_num == 1 && msgs[0] == EVT_ALARM_SLEEP);
+    (printf)("PASS\n");
+    return 0;
+}
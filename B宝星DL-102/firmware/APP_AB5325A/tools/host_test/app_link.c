@@ -0,0 +1,240 @@
+//bsp_app_link回环测试: 发送端组帧(批量命令, 多帧传输), 随机拆包/合包/插入垃圾后送进app_link_rx,
+//ACK从bt_spp_tx回到发送端. 检查命令是否一条不少地执行, 统计每秒能处理的帧数
+#include "include.h"
+#include "host_test.h"
+#include "bsp_app_link.c"
+
+#define SIM_XFERS           20000
+
+//crc16/MODBUS, 和库里的calc_crc算法无关, 收发两端一致就行
+uint calc_crc(void *buf, uint len, uint seed)
+{
+    u8 *p = buf;
+    uint crc = seed;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc & 0xffff;
+}
+
+static unsigned long ack_ok, ack_err, cmd_cnt, cmd_bytes;
+static u8 cmd_expect;                   //命令数据内容按顺序递增, 用来检查有没有错位
+
+uint bt_get_status(void)
+{
+    return BT_STA_CONNECTED;
+}
+
+//回环: 设备发出的ACK
+int bt_spp_tx(uint8_t *packet, uint16_t len)
+{
+    CHECK(len == APP_LINK_HEAD_LEN + 4);
+    CHECK(packet[0] == APP_LINK_SYNC0 && packet[1] == APP_LINK_SYNC1 && (packet[5] & APP_FRM_ACK));
+    CHECK(calc_crc(&packet[2], 6, APP_LINK_CRC_SEED) == (uint)(packet[8] | (packet[9] << 8)));
+    if (packet[7] == APP_ACK_OK) {
+        ack_ok++;
+    } else {
+        ack_err++;
+    }
+    return 0;
+}
+
+bool ble_send_packet(u8 *buf, u16 len)
+{
+    return true;
+}
+
+int eq_huart_putcs(uint8_t *packet, uint16_t len)
+{
+    return 0;
+}
+
+bool bt_app_cmd_exec(u8 cmd, u8 *data, u16 size)
+{
+    CHECK(cmd == APP_CMD_RGB || cmd == APP_CMD_EQ);
+    for (u16 i = 0; i < size; i++) {
+        CHECK(data[i] == cmd_expect);
+        cmd_expect++;
+    }
+    cmd_cnt++;
+    cmd_bytes += size;
+    return true;
+}
+
+//发送端
+static u8 tx_seq;
+static u8 tx_data;
+static u8 stream[64 * 1024];
+static uint stream_len;
+
+static void tx_frame(u8 flag, u8 *payload, u16 len)
+{
+    u8 *f = &stream[stream_len];
+    f[0] = APP_LINK_SYNC0;
+    f[1] = APP_LINK_SYNC1;
+    f[2] = len;
+    f[3] = len >> 8;
+    f[4] = tx_seq++;
+    f[5] = flag;
+    memcpy(&f[APP_LINK_HEAD_LEN], payload, len);
+    u16 crc = calc_crc(&f[2], APP_LINK_HEAD_LEN - 2 + len, APP_LINK_CRC_SEED);
+    f[APP_LINK_HEAD_LEN + len] = crc;
+    f[APP_LINK_HEAD_LEN + len + 1] = crc >> 8;
+    stream_len += APP_LINK_HEAD_LEN + len + 2;
+}
+
+//一次传输: n条命令, 超过单帧payload就拆成多帧
+static uint tx_xfer(int eq)
+{
+    u8 buf[APP_LINK_XFER_SIZE];
+    u16 len = 0;
+    uint frames = 0;
+    if (eq) {
+        u16 size = EQ_BUFFER_LEN;
+        buf[len++] = APP_CMD_EQ;
+        buf[len++] = size;
+        buf[len++] = size >> 8;
+        for (u16 i = 0; i < size; i++) {
+            buf[len++] = tx_data++;
+        }
+    } else {
+        int n = 1 + rand() % 20;
+        for (int i = 0; i < n; i++) {
+            buf[len++] = APP_CMD_RGB;
+            buf[len++] = 4;
+            buf[len++] = 0;
+            for (int k = 0; k < 4; k++) {
+                buf[len++] = tx_data++;
+            }
+        }
+    }
+    for (u16 pos = 0; pos < len; pos += APP_LINK_PAYLOAD_MAX) {
+        u16 n = len - pos;
+        u8 flag = 0;
+        if (n > APP_LINK_PAYLOAD_MAX) {
+            n = APP_LINK_PAYLOAD_MAX;
+            flag |= APP_FRM_MORE;
+        }
+        tx_frame(flag, &buf[pos], n);
+        frames++;
+    }
+    return frames;
+}
+
+//把字节流随机拆成1~chunk_max字节的包送给接收端
+static void rx_stream(uint chunk_max)
+{
+    for (uint pos = 0; pos < stream_len; ) {
+        uint n = 1 + rand() % chunk_max;
+        if (pos + n > stream_len) {
+            n = stream_len - pos;
+        }
+        app_link_rx(APP_LINK_SPP, &stream[pos], n);
+        pos += n;
+    }
+    stream_len = 0;
+}
+
+int main(void)
+{
+    uint frames = 0;
+    srand(26);
+
+    //1. 正常数据流, 随机拆包合包(一包最多约4帧, 比ring还大)
+    app_link_init();
+    long t0 = clock();
+    for (int i = 0; i < SIM_XFERS; i++) {
+        frames += tx_xfer(i % 10 == 0);
+        if (stream_len > sizeof(stream) - 2048) {
+            rx_stream(1000);
+        }
+    }
+    rx_stream(1000);
+    long us = clock() - t0;
+    const app_link_stat_t *st = app_link_get_stat();
+    (printf)("split/merge: %u frames, %lu xfers, %lu cmds (%lu bytes), ack ok %lu err %lu, %.0f frames/s, %.2f MB/s (host)\n",
+             frames, st->rx_xfers, cmd_cnt, cmd_bytes, ack_ok, ack_err,
+             frames * (double)HOST_CLOCKS_PER_SEC / us, cmd_bytes / (double)us);
+    CHECK(st->rx_frames == frames && st->rx_xfers == SIM_XFERS && ack_ok == SIM_XFERS);
+    CHECK(st->crc_err == 0 && st->seq_err == 0 && st->overflow == 0);
+
+    //2. 帧之间插垃圾和假sync, 每帧都要收到
+    app_link_init();
+    ack_ok = ack_err = 0;
+    for (int i = 0; i < 2000; i++) {
+        tx_xfer(0);
+        stream[stream_len++] = APP_LINK_SYNC0;
+        stream[stream_len++] = rand();
+        if (i % 3 == 0) {
+            stream[stream_len++] = APP_LINK_SYNC0;      //假的帧头, 长度超范围
+            stream[stream_len++] = APP_LINK_SYNC1;
+            stream[stream_len++] = 0xff;
+            stream[stream_len++] = 0xff;
+        }
+        if (stream_len > sizeof(stream) - 2048) {
+            rx_stream(64);
+        }
+    }
+    rx_stream(64);
+    (printf)("garbage: ack ok %lu err %lu, crc_err %d\n", ack_ok, ack_err, app_link_get_stat()->crc_err);
+    CHECK(ack_ok == 2000);
+
+    //3. 改错一个字节: 这一次传输丢掉, 不能执行错的数据, 后面的传输正常
+    app_link_init();
+    ack_ok = 0;
+    u8 save = tx_data;
+    tx_xfer(0);
+    stream[APP_LINK_HEAD_LEN + 4] ^= 0x55;
+    tx_data = save;                             //被丢掉的这次不会执行, 期望值从它开始
+    tx_xfer(0);
+    rx_stream(16);
+    CHECK(app_link_get_stat()->crc_err >= 1 && ack_ok == 1);
+
+    //4. 一次送进比ring大很多的数据(SPP一包可以超过512字节), 分段解析, 最后一帧要能收到
+    for (uint big = APP_LINK_RING_SIZE + 100; big <= 3 * APP_LINK_RING_SIZE; big += 300) {
+        app_link_init();
+        ack_ok = 0;
+        memset(stream, 0, big);
+        stream_len = big;
+        tx_xfer(0);
+        app_link_rx(APP_LINK_SPP, stream, stream_len);
+        stream_len = 0;
+        CHECK(ack_ok == 1 && app_link_get_stat()->overflow == 0 && app_link_ring_len() == 0);
+    }
+
+    //5. ring_write本身: 写入超过剩余空间和超过整个ring时, 只丢最老的数据, 长度正好是ring大小
+    for (uint big = 100; big <= 3 * APP_LINK_RING_SIZE; big += 100) {
+        app_link_init();
+        for (uint i = 0; i < big; i++) {
+            stream[i] = i;
+        }
+        app_link_ring_write(stream, 300);
+        app_link_ring_write(stream, big);
+        u16 len = app_link_ring_len();
+        CHECK(len == (300 + big > APP_LINK_RING_SIZE ? APP_LINK_RING_SIZE : 300 + big));
+        CHECK(app_link_ring_peek(len - 1) == (u8)(big - 1));
+        if (big >= APP_LINK_RING_SIZE) {
+            CHECK(app_link_ring_peek(0) == (u8)(big - APP_LINK_RING_SIZE));
+        }
+    }
+    stream_len = 0;
+
+    //6. 多帧传输丢了后一帧: 下一次传输的帧seq不连续, 报seq错误, 拼了一半的EQ数据不执行, 新传输正常执行
+    app_link_init();
+    ack_ok = ack_err = 0;
+    save = tx_data;
+    tx_xfer(1);                                 //EQ包拆成两帧, 只发第一帧
+    stream_len = APP_LINK_HEAD_LEN + APP_LINK_PAYLOAD_MAX + 2;
+    tx_data = save;                             //EQ数据不会执行, 期望值从下一次传输开始
+    tx_seq++;                                   //丢掉的那帧占了一个seq
+    tx_xfer(0);
+    rx_stream(100);
+    (printf)("lost frame: seq_err %d, ack ok %lu err %lu\n", app_link_get_stat()->seq_err, ack_ok, ack_err);
+    CHECK(app_link_get_stat()->seq_err == 1 && ack_ok == 1 && ack_err == 0);
+
+    (printf)("PASS\n");
+    return 0;
+}
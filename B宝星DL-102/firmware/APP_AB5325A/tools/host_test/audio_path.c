@@ -0,0 +1,211 @@
+//bsp_audio通路切换模型: sdadc/adpll/MICL操作用桩记录, 按模型耗时算每种切换的断音时间(exit开始到新通路start完成),
+//对比不给提示(原来的做法, 每次都完整关闭)和audio_path_set_next提示下一个通路.
+//只跑固件里真的会调用set_next的切换(fw_trans), 中间要播提示音的切换固件不给提示, 不在表里
+#include "include.h"
+#include "host_test.h"
+
+//MICL的GPIO寄存器换成变量
+static u32 host_gpiof_dir, host_gpiof_de, host_gpiof_pu;
+#undef GPIOFDIR
+#undef GPIOFDE
+#undef GPIOFPU
+#define GPIOFDIR                    host_gpiof_dir
+#define GPIOFDE                     host_gpiof_de
+#define GPIOFPU                     host_gpiof_pu
+
+#include "bsp_audio.c"
+
+//模型参数(us), 按库函数的大概流程估的, 不是实测
+#define COST_SDADC_EXIT             500
+#define COST_ADPLL                  2000        //adpll重新锁定
+#define COST_SDADC_INIT             3000        //含adpll按新采样率设置
+#define COST_MICL_CLAIM             0
+#define COST_SDADC_START            1500        //ADC上电到有数据
+
+xcfg_cb_t xcfg_cb;
+sys_cb_t sys_cb;
+volatile int micl2gnd_flag;
+
+static unsigned long now_us;
+static u8 ops_seen;
+static sdadc_cfg_t last_cfg;
+
+bool is_linein_det_mux_micl(void)
+{
+    return true;
+}
+
+int sdadc_init(const sdadc_cfg_t *p_cfg)
+{
+    last_cfg = *p_cfg;
+    ops_seen |= AUDIO_OP_SDADC_INIT;
+    now_us += COST_SDADC_INIT;
+    return 0;
+}
+
+int sdadc_start(u8 channel)
+{
+    CHECK(channel == last_cfg.channel);
+    ops_seen |= AUDIO_OP_SDADC_START;
+    now_us += COST_SDADC_START;
+    return 0;
+}
+
+int sdadc_exit(u8 channel)
+{
+    ops_seen |= AUDIO_OP_SDADC_EXIT;
+    now_us += COST_SDADC_EXIT;
+    return 0;
+}
+
+void adpll_spr_set(u8 out48k_flag)
+{
+    ops_seen |= AUDIO_OP_ADPLL_RESTORE;
+    now_us += COST_ADPLL;
+}
+
+void delay_us(uint n)
+{
+    now_us += n;
+}
+
+void sdadc_dummy(u8 *ptr, u32 samples, int ch_mode) {}
+void bt_aec_process(u8 *ptr, u32 samples, int ch_mode) {}
+void bt_sco_process(u8 *ptr, u32 samples, int ch_mode) {}
+void bt_alc_process(u8 *ptr, u32 samples, int ch_mode) {}
+void aux_sdadc_process(u8 *ptr, u32 samples, int ch_mode) {}
+void speaker_sdadc_process(u8 *ptr, u32 samples, int ch_mode) {}
+void usbmic_sdadc_process(u8 *ptr, u32 samples, int ch_mode) {}
+void karaok_sdadc_process(u8 *ptr, u32 samples, int ch_mode) {}
+void fmrx_sdadc_process(u8 *ptr, u32 samples, int ch_mode) {}
+
+static const char *path_name[] = {"AUX", "FM", "SPEAKER", "BTMIC", "USBMIC", "KARAOK"};
+
+static int op_count(u8 ops)
+{
+    int n = 0;
+    for (; ops; ops &= ops - 1) {
+        n++;
+    }
+    return n;
+}
+
+//和bsp_aux/func_speaker/sfunc_bt_call一样的调用顺序, 返回断音时间, plan为切换前audio_path_plan的结果
+static unsigned long transition(u8 from, u8 to, bool hint, u8 *ops, u8 *plan)
+{
+    audio_path_init(from);
+    audio_path_start(from);
+    *plan = audio_path_plan(from, to);
+    ops_seen = 0;
+    now_us = 0;
+    if (hint) {
+        audio_path_set_next(to);
+    }
+    u8 micl = sys_cb.micl_en;
+    audio_path_exit(from);
+    if (micl && !sys_cb.micl_en) {
+        ops_seen |= AUDIO_OP_MICL_RELEASE;                  //耗时就是里面的delay_us
+    }
+    audio_path_init(to);
+    micl = sys_cb.micl_en;
+    audio_path_start(to);
+    if (!micl && sys_cb.micl_en) {
+        ops_seen |= AUDIO_OP_MICL_CLAIM;
+        now_us += COST_MICL_CLAIM;
+    }
+    *ops = ops_seen;
+    //切换后MICL状态要和新通路一致
+    CHECK(sys_cb.micl_en == audio_path_is_micl(audio_path_get_cfg(to)));
+    unsigned long gap = now_us;
+    audio_path_exit(to);                                    //回到空闲, MICL还给LINEIN检测
+    CHECK(!sys_cb.micl_en);
+    return gap;
+}
+
+//固件里给audio_path_set_next的切换
+static const u8 fw_trans[][2] = {
+    {AUDIO_PATH_KARAOK,  AUDIO_PATH_BTMIC},         //sco_audio_init: 关KARAOK开通话MIC
+    {AUDIO_PATH_BTMIC,   AUDIO_PATH_KARAOK},        //sco_audio_exit: 通话结束重新开KARAOK
+    {AUDIO_PATH_KARAOK,  AUDIO_PATH_AUX},           //func_aux_enter: 关KARAOK开AUX
+    {AUDIO_PATH_KARAOK,  AUDIO_PATH_FM},            //func_fmrx_enter: 关KARAOK开外置收音
+    //func_xxx_exit -> 下一个模式enter, 下一个模式不播提示音时(func_get_enter_path)
+    {AUDIO_PATH_AUX,     AUDIO_PATH_FM},
+    {AUDIO_PATH_AUX,     AUDIO_PATH_SPEAKER},
+    {AUDIO_PATH_FM,      AUDIO_PATH_AUX},
+    {AUDIO_PATH_FM,      AUDIO_PATH_SPEAKER},
+    {AUDIO_PATH_SPEAKER, AUDIO_PATH_AUX},
+    {AUDIO_PATH_SPEAKER, AUDIO_PATH_FM},
+};
+
+int main(void)
+{
+    unsigned long gap_old = 0, gap_new = 0;
+    int ops_old = 0, ops_new = 0, n = 0;
+
+    xcfg_cb.auxl_sel = 2;
+    xcfg_cb.auxr_sel = 2;
+    xcfg_cb.aux_anl_gain = 3;
+    xcfg_cb.aux_dig_gain = 7;
+    xcfg_cb.bt_ch_mic = 0;
+    host_gpiof_de = BIT(2);                 //开机时MICL用于LINEIN检测
+    audio_path_cfg_build();
+
+    //缓存里的配置按xcfg_cb解析
+    CHECK(audio_path_get_cfg(AUDIO_PATH_AUX)->channel == ((2 << 4) | 2));
+    CHECK(audio_path_get_cfg(AUDIO_PATH_AUX)->gain == ((3 << 5) | 7));
+    CHECK(audio_path_get_cfg(AUDIO_PATH_BTMIC)->channel == CH_MIC_PF2);
+    sys_cb.hfp_karaok_en = 1;
+    CHECK(audio_path_get_cfg(AUDIO_PATH_BTMIC)->sample_rate == SPR_48000);
+    sys_cb.hfp_karaok_en = 0;
+    CHECK(audio_path_get_cfg(AUDIO_PATH_BTMIC)->sample_rate == SPR_8000);
+    //ADC回调里混音/频谱用的采样率取自通路配置
+    CHECK(audio_path_get_spr(AUDIO_PATH_AUX) == rec_cfg_tbl[AUDIO_PATH_AUX].sample_rate);
+    CHECK(audio_path_get_spr(AUDIO_PATH_SPEAKER) == SPR_16000 && audio_path_get_spr(AUDIO_PATH_FM) == SPR_44100);
+
+    (printf)("%-8s -> %-8s  %-22s  %-22s\n", "from", "to", "full exit: ops gap(us)", "set_next: ops gap(us)");
+    for (u8 i = 0; i < sizeof(fw_trans) / sizeof(fw_trans[0]); i++) {
+        u8 from = fw_trans[i][0], to = fw_trans[i][1], o_old, o_new, plan;
+        unsigned long g_old = transition(from, to, false, &o_old, &plan);
+        CHECK(o_old & AUDIO_OP_ADPLL_RESTORE);                  //不提示时每次都先切回DAC_OUT_SPR
+        unsigned long g_new = transition(from, to, true, &o_new, &plan);
+        //提示下一个通路时, 实际的操作就是plan算出来的, 而且不比完整关闭多
+        CHECK(o_new == plan);
+        CHECK((o_new & ~o_old) == 0 && g_new <= g_old);
+        CHECK(!(o_new & AUDIO_OP_ADPLL_RESTORE));
+        (printf)("%-8s -> %-8s  %2d ops %6lu          %2d ops %6lu\n", path_name[from], path_name[to],
+                 op_count(o_old), g_old, op_count(o_new), g_new);
+        gap_old += g_old;
+        gap_new += g_new;
+        ops_old += op_count(o_old);
+        ops_new += op_count(o_new);
+        n++;
+    }
+    (printf)("average: full exit %.1f ops %lu us, set_next %.1f ops %lu us\n",
+             ops_old / (double)n, gap_old / n, ops_new / (double)n, gap_new / n);
+
+    //通话KARAOK: 关KARAOK马上开通话MIC, 两个都用MICL, 不释放也不重新认领
+    u8 ops, plan;
+    transition(AUDIO_PATH_KARAOK, AUDIO_PATH_BTMIC, true, &ops, &plan);
+    CHECK(!(ops & (AUDIO_OP_MICL_RELEASE | AUDIO_OP_MICL_CLAIM)));
+
+    //关闭后不再打开其它通路: adpll切回DAC_OUT_SPR, MICL还给LINEIN检测
+    audio_path_init(AUDIO_PATH_BTMIC);
+    audio_path_start(AUDIO_PATH_BTMIC);
+    CHECK(sys_cb.micl_en && !(host_gpiof_de & BIT(2)));
+    ops_seen = 0;
+    audio_path_exit(AUDIO_PATH_BTMIC);
+    CHECK(!sys_cb.micl_en && (host_gpiof_de & BIT(2)) && (ops_seen & AUDIO_OP_ADPLL_RESTORE));
+
+    //xcfg_cb修改后, 下次打开通路时自动重新生成
+    xcfg_cb.aux_anl_gain = 1;
+    audio_path_init(AUDIO_PATH_AUX);
+    CHECK(last_cfg.gain == ((1 << 5) | 7));
+    xcfg_cb.bt_ch_mic = 1;
+    audio_path_init(AUDIO_PATH_KARAOK);
+    CHECK(last_cfg.channel == CH_MIC_PF5);
+    xcfg_cb.auxl_sel = 3;
+    audio_path_init(AUDIO_PATH_AUX);
+    CHECK(last_cfg.channel == ((2 << 4) | 3));
+    (printf)("PASS\n");
+    return 0;
+}
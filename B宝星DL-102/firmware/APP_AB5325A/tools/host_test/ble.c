@@ -0,0 +1,212 @@
+//bsp_ble发送队列: le_tx_notify接到模拟的协议栈(4个包缓存, 每个15ms连接间隔发出2包), 主循环每ms调用一次bsp_ble_process,
+//统计APP数据的吞吐, 检查收到的字节流, 按le_get_gatt_mtu分包, 电量通知(CCCD打开后才发, 旧状态被覆盖)和接收队列满的处理
+#include "include.h"
+#include "host_test.h"
+
+//发送路径上的打印会拖慢主循环, 主机上去掉
+#undef printf
+#undef print_r
+#define printf(...)
+#define print_r(...)
+
+#include "bsp_ble.c"
+
+#define SIM_MS              10000
+#define SIM_FRAME           64              //每ms送一帧APP数据
+#define STACK_BUF_NUM       4
+#define STACK_CONN_PKTS     2               //每个连接间隔发出的包数
+#define OLD_BPS             (20 * 1000 / 30)        //原来的ble_send_packet: 每30ms一包, 最多20字节
+
+xcfg_cb_t xcfg_cb;
+sys_cb_t sys_cb;
+
+static bool connected = true;
+static u16 gatt_payload = BLE_MTU_DEF - 3;  //le_get_gatt_mtu的返回值
+static int stack_num;                       //协议栈里还没发出去的包
+static u8 out[1 << 20];
+static unsigned long out_len, bat_pkts;
+static u8 bat_last;
+static u16 seg_max;
+static uint bat_level = 80;
+static unsigned long cmd_num;
+
+bool le_is_connect(void)
+{
+    return connected;
+}
+
+u16 le_get_gatt_mtu(void)
+{
+    return gatt_payload;
+}
+
+bool le_tx_notify(u8 index, u8 *buf, u8 len)
+{
+    if (stack_num >= STACK_BUF_NUM) {
+        return false;
+    }
+    stack_num++;
+    CHECK(len <= gatt_payload);
+    if (index == BLE_IDX_BAT) {
+        CHECK(len == 1);
+        bat_last = buf[0];
+        bat_pkts++;
+        return true;
+    }
+    CHECK(index == BLE_IDX_APP);
+    memcpy(out + out_len, buf, len);
+    out_len += len;
+    if (len > seg_max) {
+        seg_max = len;
+    }
+    return true;
+}
+
+uint fuel_get_level(void)
+{
+    return bat_level;
+}
+
+void ble_init_att_do(u8 index, u16 handle, u8 config , u8* buf, u8 len) {}
+bool app_link_is_frame(u8 link, u8 *ptr, u16 size) { return false; }
+void app_link_rx(u8 link, u8 *ptr, u16 size) {}
+
+void bt_app_cmd_process(u8 *ptr, u16 size)
+{
+    cmd_num++;
+}
+
+//1ms: 连接间隔到了协议栈发出包, 然后跑一次主循环
+static void step(void)
+{
+    host_ms++;
+    if (host_ms % BLE_TX_INTERVAL == 0) {
+        stack_num = (stack_num > STACK_CONN_PKTS) ? stack_num - STACK_CONN_PKTS : 0;
+    }
+    bsp_ble_process();
+}
+
+//APP数据吞吐, 交换MTU前后各跑一遍
+static unsigned long stream(u16 payload)
+{
+    static u8 in[1 << 20];
+    unsigned long in_len = 0, worst = 0;
+    u8 frame[SIM_FRAME];
+
+    ble_init_att();
+    gatt_payload = payload;
+    out_len = 0;
+    seg_max = 0;
+    stack_num = 0;
+    for (int t = 0; t < SIM_MS; t++) {
+        for (int i = 0; i < SIM_FRAME; i++) {
+            frame[i] = (u8)(in_len + i);
+        }
+        if (ble_send_packet(frame, SIM_FRAME)) {
+            memcpy(in + in_len, frame, SIM_FRAME);
+            in_len += SIM_FRAME;
+        }
+        unsigned long c = clock();
+        step();
+        c = clock() - c;
+        if (c > worst) {
+            worst = c;
+        }
+    }
+    const ble_stat_t *st = ble_get_stat();
+    unsigned long bps = out_len * 1000 / SIM_MS;
+    (printf)("att mtu %3d: %5lu B/s, pkts %lu, max seg %u, busy %u, drop %u, worst loop %lu us\n",
+             payload + 3, bps, (unsigned long)st->tx_pkts, seg_max, st->tx_busy, st->tx_drop, worst);
+    //收到的是发出去的前缀, 分包用满交换后的MTU
+    CHECK(out_len <= in_len && memcmp(in, out, out_len) == 0);
+    CHECK(seg_max == (payload < SIM_FRAME ? payload : SIM_FRAME));
+    CHECK(ble_cb.mtu == payload + 3);
+    return bps;
+}
+
+int main(void)
+{
+    //默认MTU和库里最大的MTU(le_get_gatt_mtu最大返回120)
+    unsigned long bps23 = stream(BLE_MTU_DEF - 3);
+    unsigned long bps123 = stream(120);
+    (printf)("old ble_send_packet: %d B/s\n", OLD_BPS);
+    CHECK(bps23 > 3 * OLD_BPS && bps123 > 2 * bps23);
+
+    //发送中途交换MTU, 下个节拍开始按新MTU分包
+    u8 big[200];
+    memset(big, 0x5a, sizeof(big));
+    ble_init_att();
+    gatt_payload = BLE_MTU_DEF - 3;
+    stack_num = 0;
+    seg_max = 0;
+    ble_send_packet(big, sizeof(big));
+    step();
+    CHECK(seg_max == BLE_MTU_DEF - 3);
+    gatt_payload = 120;
+    for (int t = 0; t < BLE_TX_INTERVAL; t++) {
+        step();
+    }
+    CHECK(seg_max == 120);
+
+    //电量: 手机打开CCCD之前不发
+    ble_init_att();
+    bat_pkts = 0;
+    for (int t = 0; t < 3000; t++) {
+        step();
+    }
+    CHECK(bat_pkts == 0);
+    ble_client_cfg_callback(att_hdl_tbl[BLE_IDX_BAT].hdl + 1, 1);
+    for (int t = 0; t < BLE_TX_INTERVAL; t++) {
+        step();
+    }
+    CHECK(bat_pkts == 1 && bat_last == 80);
+    //没变化不发, 变化后1s内发出
+    for (int t = 0; t < 3000; t++) {
+        step();
+    }
+    CHECK(bat_pkts == 1);
+    bat_level = 79;
+    for (int t = 0; t < BLE_BAT_INTERVAL + BLE_TX_INTERVAL; t++) {
+        step();
+    }
+    CHECK(bat_pkts == 2 && bat_last == 79);
+
+    //协议栈一直忙时电量连续变化, 队列里只留最新的一个
+    stack_num = STACK_BUF_NUM;
+    for (int i = 0; i < 5; i++) {
+        bat_level = 70 - i;
+        host_ms += BLE_BAT_INTERVAL;
+        bsp_ble_process();
+    }
+    CHECK((u8)(ble_cb.tx_wptr - ble_cb.tx_rptr) == 1 && ble_get_stat()->tx_coalesce == 4);
+    for (int t = 0; t < 2 * BLE_TX_INTERVAL; t++) {
+        step();
+    }
+    CHECK(bat_pkts == 3 && bat_last == 66);
+
+    //断开后要等手机重新打开通知
+    connected = false;
+    step();
+    connected = true;
+    bat_level = 50;
+    for (int t = 0; t < 3000; t++) {
+        step();
+    }
+    CHECK(bat_pkts == 3);
+
+    //接收队列: 满了丢新命令, 太长的丢掉, 收到的按顺序处理
+    ble_init_att();
+    u8 cmd[BLE_CMD_DATA_MAX + 1] = {0};
+    int ok = 0;
+    for (int i = 0; i < 12; i++) {
+        ok += ble_att_write_callback(0x0009, cmd, 5);
+    }
+    ble_att_write_callback(0x0009, cmd, sizeof(cmd));
+    CHECK(ok == BLE_CMD_BUF_LEN && ble_get_stat()->rx_drop == 12 - BLE_CMD_BUF_LEN && ble_get_stat()->rx_oversize == 1);
+    for (int i = 0; i < 20; i++) {
+        bsp_ble_process();
+    }
+    CHECK(cmd_num == BLE_CMD_BUF_LEN);
+    (printf)("PASS\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+//func_fmrx自动搜台: 用模拟收音芯片(随机电台表, 偏调时质量下降)跑完整的粗扫+细扫,
+//统计搜台时间和找台准确率, 和原来逐点判台+每台试听1.5s的搜台对比.
+//分别模拟有质量高低的外置芯片(RSSI+SNR)和只有判台结果的内置收音(0/1), 每个电台都要找到, 漏一个就失败
+#include "include.h"
+#include "host_test.h"
+
+//进出FM模式时写的MEMCON换成变量
+static unsigned long sim_memcon;
+#undef MEMCON
+#define MEMCON                      sim_memcon
+
+#include "func_fmrx.c"
+
+#define SIM_ROUNDS          200         //随机电台表的次数
+#define SIM_PROBE_MS        25          //判一个频点的时间(设频率+等锁定+读RSSI/SNR)
+#define SIM_OLD_HIT_MS      (300 * 5 + 2 * 100)     //原来每个命中: delay_5ms(300)试听加淡入淡出
+#define STA_MAX             40
+#define Q_VALID             20          //质量低于这个值判为无台
+#define Q_DROP_100K         12          //偏调100KHz质量下降
+#define Q_DROP_200K         30          //偏调200KHz质量下降
+
+//模拟电台表, 频率单位10KHz, 在100KHz栅格上
+static u16 sta_freq[STA_MAX];
+static u8 sta_q[STA_MAX];
+static int sta_num;
+static unsigned long probes;
+static bool graded;                     //false: 模拟内置收音, 只返回0/1
+
+static u8 sim_quality(u16 freq)
+{
+    int best = 0;
+    for (int i = 0; i < sta_num; i++) {
+        int d = abs((int)freq - (int)sta_freq[i]);
+        int q = sta_q[i] - (d == 0 ? 0 : d == 10 ? Q_DROP_100K : d == 20 ? Q_DROP_200K : 255);
+        if (q > best) {
+            best = q;
+        }
+    }
+    return (best >= Q_VALID) ? best : 0;
+}
+
+//内置收音的fmrx_check_freq只在电台频点上判为有台, 偏调的频点判无台
+static bool sim_is_station(u16 freq)
+{
+    u8 q = sim_quality(freq);
+    return q && q > sim_quality(freq - 10) && q > sim_quality(freq + 10);
+}
+
+u8 bsp_fmrx_seek_quality(u16 freq)
+{
+    CHECK(freq >= FM_FREQ_MIN && freq <= FM_FREQ_MAX && freq % 10 == 0);
+    probes++;
+    if (!graded) {
+        return sim_is_station(freq);
+    }
+    return sim_quality(freq);
+}
+
+bool bsp_fmrx_quality_graded(void)
+{
+    return graded;
+}
+
+u8 bsp_fmrx_check_freq(u16 freq)
+{
+    return bsp_fmrx_seek_quality(freq) != 0;
+}
+
+//用到的其他模块
+func_cb_t func_cb;
+gui_box_t box_cb;
+void func_process(void) {}
+void bsp_fmrx_set_freq(u16 freq) {}
+void bsp_fmrx_init(void) {}
+void bsp_fmrx_exit(void) {}
+void bsp_clr_mute_sta(void) {}
+void dac_fade_in(void) {}
+void dac_fade_out(void) {}
+void dac_fade_wait(void) {}
+void fmrx_digital_start(void) {}
+void fmrx_digital_stop(void) {}
+bool gui_box_process(void) { return false; }
+void gui_box_show_chan(void) {}
+void led_fm_play(void) {}
+void led_fm_scan(void) {}
+void led_idle(void) {}
+void mp3_res_play(u32 addr, u32 len) {}
+void amp_sel_cfg_ab(void) {}
+void amp_sel_cfg_d(void) {}
+bool is_func_fmrx_en(void) { return true; }
+void func_fmrx_message(u16 msg) {}
+void param_fmrx_chbuf_read(void) {}
+void param_fmrx_chbuf_write(void) {}
+void param_fmrx_chcnt_read(void) {}
+void param_fmrx_chcnt_write(void) {}
+void param_fmrx_chcur_read(void) {}
+void param_fmrx_chcur_write(void) {}
+void param_sync(void) {}
+void bsp_msg_clear(void) {}
+u16 bsp_msg_dequeue(void) { return NO_MSG; }
+void sfunc_record_stop(void) {}
+void sfunc_record_pause(void) {}
+void sfunc_record_continue(void) {}
+
+//随机电台表: 相邻电台至少隔200KHz, 有不少只隔200/300KHz, 粗扫时落在同一簇.
+//每个电台都是质量的峰值(隔200KHz的两台质量差小于Q_DROP_100K, 隔300KHz的小于Q_DROP_200K),
+//否则真实的芯片也分不出是电台还是旁边强台偏调
+static void sim_gen_stations(void)
+{
+    sta_num = 0;
+    u16 f = FM_FREQ_MIN + (rand() % 4) * 10;
+    while (sta_num < STA_MAX) {
+        u16 d = 20 + (rand() % 4 == 0 ? (rand() % 2) * 10 : (rand() % 20) * 10);
+        f += d;
+        if (f > FM_FREQ_MAX) {
+            break;
+        }
+        int q = Q_VALID + rand() % 50, lim = (d == 20) ? Q_DROP_100K - 1 : (d == 30) ? Q_DROP_200K - 1 : 0;
+        if (sta_num && lim) {
+            q = sta_q[sta_num - 1] - lim + rand() % (2 * lim + 1);
+            q = (q < Q_VALID) ? Q_VALID : (q > Q_VALID + 49) ? Q_VALID + 49 : q;
+        }
+        sta_freq[sta_num] = f;
+        sta_q[sta_num] = q;
+        sta_num++;
+    }
+    for (int i = 0; i < sta_num; i++) {
+        CHECK(sim_is_station(sta_freq[i]));
+    }
+}
+
+//原来的搜台: 每个频点判一次, 命中就存台并试听
+static unsigned long sim_old_scan(int *ch)
+{
+    unsigned long ms = 0;
+    *ch = 0;
+    for (u16 f = FM_FREQ_MIN; f <= FM_FREQ_MAX; f += 10) {
+        ms += SIM_PROBE_MS;
+        if (graded ? sim_quality(f) : sim_is_station(f)) {
+            (*ch)++;
+            ms += SIM_OLD_HIT_MS;
+        }
+    }
+    return ms;
+}
+
+//跑一次自动搜台, stop_at非0时在第stop_at次判台后模拟按键打断
+static unsigned long sim_scan(unsigned long stop_at)
+{
+    unsigned long loops = 0;
+    probes = 0;
+    fmrx_cb.sta = FMRX_SEEK_START;
+    while (fmrx_cb.sta != FMRX_PLAY) {
+        if (stop_at && probes >= stop_at && fmrx_cb.sta != FMRX_SEEK_STOP) {
+            fmrx_cb.sta = FMRX_SEEK_STOP;
+        }
+        func_fmrx_process();
+        loops++;
+        CHECK(loops < 10000);
+    }
+    return probes * SIM_PROBE_MS;
+}
+
+//跑SIM_ROUNDS次随机电台表, 每个电台都要存到, 不能有重复和不存在的台
+static void sim_run(bool g)
+{
+    unsigned long new_ms = 0, old_ms = 0, new_probes = 0;
+    unsigned long stations = 0, found = 0, exact = 0, missed = 0, dup = 0, false_ch = 0, old_ch = 0;
+    graded = g;
+    srand(28);
+
+    memset(&fmrx_cb, 0, sizeof(fmrx_cb));
+    for (int r = 0; r < SIM_ROUNDS; r++) {
+        sim_gen_stations();
+        int och;
+        old_ms += sim_old_scan(&och);
+        old_ch += och;
+
+        new_ms += sim_scan(0);
+        new_probes += probes;
+
+        //每个存下的台都要对应一个电台, 同一电台不能存两次
+        u8 hit[STA_MAX] = {0};
+        for (u8 ch = 1; ch <= fmrx_cb.ch_cnt; ch++) {
+            u16 f = get_ch_freq(ch);
+            int k = -1;
+            for (int i = 0; i < sta_num; i++) {
+                if (abs((int)f - (int)sta_freq[i]) <= 10) {
+                    k = i;
+                }
+            }
+            if (k < 0) {
+                false_ch++;
+                continue;
+            }
+            if (hit[k]++) {
+                dup++;
+                continue;
+            }
+            exact += (f == sta_freq[k]);
+        }
+        for (int i = 0; i < sta_num; i++) {
+            stations++;
+            if (hit[i]) {
+                found++;
+            } else {
+                missed++;
+            }
+        }
+    }
+    (printf)("%s quality, coarse step %d (x10KHz), %d rounds, %lu stations\n",
+             graded ? "graded" : "0/1", FMRX_SCAN_COARSE_STEP, SIM_ROUNDS, stations);
+    (printf)("  new scan: %.1f probes, %.1f s per scan; found %lu (exact freq %lu), missed %lu, dup %lu, false %lu\n",
+             new_probes / (double)SIM_ROUNDS, new_ms / 1000.0 / SIM_ROUNDS, found, exact, missed, dup, false_ch);
+    (printf)("  old scan: %.1f s per scan, %.1f channels saved per scan\n",
+             old_ms / 1000.0 / SIM_ROUNDS, old_ch / (double)SIM_ROUNDS);
+    CHECK(missed == 0 && dup == 0 && false_ch == 0 && exact == found);
+    CHECK(new_ms * 3 < old_ms);
+
+    //粗扫中途按键打断: 已有的粗扫结果直接存台, 不能重复, 不能存不存在的台
+    for (int r = 0; r < SIM_ROUNDS; r++) {
+        sim_gen_stations();
+        sim_scan(30 + rand() % 60);
+        u16 last = 0;
+        for (u8 ch = 1; ch <= fmrx_cb.ch_cnt; ch++) {
+            u16 f = get_ch_freq(ch);
+            CHECK(graded ? (sim_quality(f) || sim_quality(f - 10) || sim_quality(f + 10)) : sim_is_station(f));
+            CHECK(f > last);
+            last = f;
+        }
+    }
+}
+
+int main(void)
+{
+    sim_run(true);
+    sim_run(false);
+    (printf)("PASS\n");
+    return 0;
+}
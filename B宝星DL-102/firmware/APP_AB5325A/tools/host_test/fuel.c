@@ -0,0 +1,153 @@
+//bsp_fuel电量计: 回放合成的2小时放电(开路电压4.10V->3.45V, 音乐250ms一段的负载, 内阻压降最大220mV)和充电曲线,
+//每5ms送一个采样, 每秒读一次电量. 统计上报电量的跳动, 和原来用sys_cb.vbat(get_vbat_val的滤波)线性计算的电量对比.
+//低电提醒: 开路电压降到提醒电压以前不报, 原来按端电压判断会提前报
+#include "include.h"
+#include "host_test.h"
+
+static u8 host_charge;
+#undef CHARGE_DC_IN
+#define CHARGE_DC_IN()              host_charge
+
+#include "bsp_fuel.c"
+
+#define SIM_TICKS           (2 * 3600 * 200)        //2小时, 5ms一个采样
+#define OCV_START           4100
+#define OCV_END             3450
+#define DROP_MAX            220                     //模拟电池的内阻压降, 比FUEL_LOAD_DROP_MAX小一点
+
+xcfg_cb_t xcfg_cb;
+sys_cb_t sys_cb;
+static u16 host_pow;
+static u32 old_total;
+static u16 old_val, old_bak;
+
+u16 dac_pcm_pow_get(void)
+{
+    return host_pow;
+}
+
+//原来的算法: 关机电压到4.2V之间线性
+static uint level_linear(u16 mv)
+{
+    uint off = LPWR_OFF_VBAT * 100 + 2700;
+    return (mv < off) ? 0 : (mv - off) / ((4200 - off) / 100);
+}
+
+//原来的sys_cb.vbat: 和get_vbat_val一样, 32点滑动平均, 变化30mV以上才更新
+static u16 old_vbat(u16 v)
+{
+    if (old_total == 0) {
+        old_val = old_bak = v;
+        old_total = (u32)v << 5;
+    }
+    old_total = old_total - old_val + v;
+    old_val = old_total >> 5;
+    if (abs((int)old_val - old_bak) >= 30) {
+        old_bak = old_val;
+    }
+    return old_bak;
+}
+
+//模拟电池, 返回带负载的端电压
+static u16 cell_sample(u32 t, int ocv)
+{
+    bool burst = ((t / 50) % 4) != 0;
+    host_pow = burst ? 20000 + rand() % 25000 : rand() % 2000;
+    int drop = (long)DROP_MAX * host_pow / FUEL_LOAD_POW_FULL * sys_cb.vol * sys_cb.vol / (VOL_MAX * VOL_MAX);
+    return ocv - drop + rand() % 21 - 10;
+}
+
+int main(void)
+{
+    unsigned long travel_old = 0, travel_new = 0, rises = 0;
+    uint last_old = 0, last_new = 0;
+    int err_max = 0, gap_max = 0;
+    long warn_true = -1, warn_old = -1, warn_new = -1, warn_new_early = 0;
+    srand(47);
+
+    xcfg_cb.vol_max = 32;
+    xcfg_cb.lpwr_off_vbat = 5;                      //3.2V关机
+    xcfg_cb.lpwr_warning_vbat = 8;                  //3.6V提醒
+    sys_cb.vol = 28;
+    u16 warn_mv = LPWR_WARNING_VBAT * 100 + 2800;
+
+    //放电, 边播边测
+    for (u32 t = 0; t < SIM_TICKS; t++) {
+        int ocv = OCV_START - (OCV_START - OCV_END) * (long)t / SIM_TICKS;
+        u16 v = cell_sample(t, ocv);
+        sys_cb.vbat = old_vbat(v);
+        fuel_filter(v);
+        //开路电压估计比端电压高出的部分, 低电判断不能用它(sys_cb.vbat保持实测电压)
+        if ((int)fuel_get_ocv() - v > gap_max) {
+            gap_max = (int)fuel_get_ocv() - v;
+        }
+        if (t % 200 == 0) {
+            //低电提醒: 每秒判一次, 记第一次报的时间(s)
+            long sec = t / 200;
+            if (warn_true < 0 && ocv < warn_mv) {
+                warn_true = sec;
+            }
+            if (warn_old < 0 && sys_cb.vbat < warn_mv) {
+                warn_old = sec;
+            }
+            if (fuel_lowbat_warning()) {
+                if (warn_new < 0) {
+                    warn_new = sec;
+                }
+            } else if (warn_new >= 0) {
+                warn_new_early++;                   //报了又回到提醒电压以上
+            }
+            uint lo = level_linear(sys_cb.vbat), ln = fuel_get_level();
+            if (t) {
+                travel_old += (lo > last_old) ? lo - last_old : last_old - lo;
+                travel_new += (ln > last_new) ? ln - last_new : last_new - ln;
+                rises += (ln > last_new);
+            }
+            last_old = lo;
+            last_new = ln;
+            //EMA稳定后, 估计的开路电压和真实值相差不大
+            if (t > 200 * 30) {
+                int e = (int)fuel_get_ocv() - ocv;
+                if (abs(e) > err_max) {
+                    err_max = abs(e);
+                }
+            }
+        }
+    }
+    uint soc_start = fuel_ocv_to_soc(OCV_START), soc_end = fuel_ocv_to_soc(OCV_END);
+    //travel: 每秒上报电量变化量的绝对值之和, 单调下降时等于总降幅
+    (printf)("discharge: sum of level steps linear %lu%%, gauge %lu%% (rises %lu), true drop %u%% of soc, ocv error max %d mV\n",
+             travel_old, travel_new, rises, soc_start - soc_end, err_max);
+    (printf)("ocv estimate above terminal voltage: max %d mV\n", gap_max);
+    (printf)("low battery warning at %d mV: ocv crosses at %ld s, terminal voltage warns at %ld s, gauge at %ld s (%ld s flapping)\n",
+             warn_mv, warn_true, warn_old, warn_new, warn_new_early);
+    CHECK(rises == 0);
+    CHECK(travel_new < 120 && travel_old > 3 * travel_new);
+    CHECK(err_max < 60 && gap_max > DROP_MAX / 2);
+    CHECK(warn_true > 0 && warn_old >= 0 && warn_new >= 0);
+    CHECK(warn_old + 600 < warn_true);                          //原来的判断提前10分钟以上
+    //补偿按FUEL_LOAD_DROP_MAX(比模拟电池大30mV), 开路电压估计偏高约10mV, 放电0.09mV/s, 晚2分钟左右
+    CHECK(warn_new > warn_true - 60 && warn_new < warn_true + 200 && warn_new_early < 30);
+
+    //充电: 端电压比开路电压高, 电量只升不降
+    host_charge = 1;
+    last_new = fuel_get_level();
+    rises = 0;
+    for (u32 t = 0; t < SIM_TICKS / 2; t++) {
+        int ocv = OCV_END + (OCV_START - OCV_END) * (long)t / (SIM_TICKS / 2);
+        u16 v = ocv + FUEL_CHARGE_RISE + rand() % 21 - 10;
+        host_pow = 0;
+        fuel_filter(v);
+        if (t % 200 == 0) {
+            uint ln = fuel_get_level();
+            CHECK(ln >= last_new);
+            rises += (ln > last_new);
+            last_new = ln;
+        }
+    }
+    (printf)("charge: level %u%% after %d min, %lu steps up\n", last_new, SIM_TICKS / 2 / 200 / 60, rises);
+    CHECK(last_new > 80);
+
+    (printf)("PASS\n");
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+//主机测试公用定义, 在include.h之后, 被测的.c之前包含
+//注意: 主机上u32/s32是8字节, 结构体大小和芯片上不同
+
+//固件里printf是宏, 用(printf)调用libc的
+int (printf)(const char *fmt, ...);
+int (sprintf)(char *buf, const char *fmt, ...);
+long clock(void);
+#define HOST_CLOCKS_PER_SEC         1000000
+
+//关中断在主机上不需要
+#undef GLOBAL_INT_DISABLE
+#undef GLOBAL_INT_RESTORE
+#define GLOBAL_INT_DISABLE()
+#define GLOBAL_INT_RESTORE()
+
+#define CHECK(c) do { \
+    if (!(c)) { \
+        (printf)("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); \
+        abort(); \
+    } \
+} while (0)
+
+static inline unsigned long long host_rdtsc(void)
+{
+    unsigned int lo, hi;
+    __asm__ volatile("lfence; rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+//模拟的系统时间(ms), 每个测试只有一个.c, 桩函数直接定义在这里
+u32 host_ms;
+
+u32 tick_get(void)
+{
+    return host_ms;
+}
+
+bool tick_check_expire(u32 tick, u32 expire_val)
+{
+    return (u32)(host_ms - tick) >= expire_val;
+}
+
+#endif // _HOST_TEST_H
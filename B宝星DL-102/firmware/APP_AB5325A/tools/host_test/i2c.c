@@ -0,0 +1,303 @@
+//I2C设备层: SCL/SDA接到模拟的总线上, 按位解码START/STOP/字节/ACK, 总线上挂模拟的QN8035和WM8978.
+//检查时序(SCL频率不超过400KHz), 寄存器写顺序和内容, 统计批量写/影子跳过省掉的传输次数和总线时间
+#include "include.h"
+#include "host_test.h"
+
+//IO换成模拟总线, 开漏: 线上电平 = 主机 & 从机
+static u8 m_scl = 1, m_sda = 1, s_sda = 1;
+static unsigned long bus_us;                //按delay_us累计的总线时间, 不含IO翻转开销, 所以算出的SCL频率偏高
+static unsigned long wait_us;               //delay_ms/delay_5ms等待芯片的时间, 不算总线时间
+static unsigned long scl_edge_us, scl_min_high = 1000, scl_min_low = 1000;
+static void sim_scl(u8 v);
+static void sim_sda(u8 v);
+
+#undef I2C_SCL_H
+#undef I2C_SCL_L
+#undef I2C_SDA_H
+#undef I2C_SDA_L
+#undef I2C_SDA_IN
+#undef I2C_SDA_OUT
+#undef I2C_SCL_OUT
+#undef I2C_SDA_IS_H
+#define I2C_SCL_H()                 sim_scl(1)
+#define I2C_SCL_L()                 sim_scl(0)
+#define I2C_SDA_H()                 sim_sda(1)
+#define I2C_SDA_L()                 sim_sda(0)
+#define I2C_SDA_IN()                sim_sda(1)
+#define I2C_SDA_OUT()
+#define I2C_SCL_OUT()
+#define I2C_SDA_IS_H()              (m_sda & s_sda)
+#undef WDT_CLR
+#define WDT_CLR()
+
+#include "bsp_i2c.c"
+#include "bsp_i2s_wm8978.c"
+#include "fmrx/qn8035.c"
+
+void delay_us(uint n)
+{
+    bus_us += n;
+}
+
+void delay_ms(uint n)
+{
+    wait_us += n * 1000;
+}
+
+void delay_5ms(uint n)
+{
+    wait_us += n * 5000;
+    host_ms += n * 5;
+}
+
+//模拟从机
+typedef struct {
+    u8 addr;
+    u8 reg9;                    //WM8978: 7bit地址 + 9bit数据
+    u16 reg[0x60];
+    u16 log_reg[64];            //最近的写寄存器顺序
+    u8 log_num;
+    unsigned long writes;       //寄存器写次数
+} sim_slave_t;
+
+static sim_slave_t qn = {.addr = 0x20};
+static sim_slave_t wm = {.addr = 0x34, .reg9 = 1};
+
+static struct {
+    sim_slave_t *dev;           //当前被寻址的从机
+    u8 bits, byte, nbyte;
+    u8 rd, ptr, tx, out, mack;
+    u8 clk;                     //START之后有过SCL上升沿
+    unsigned long starts, stops;
+} bus;
+
+static void slave_write(sim_slave_t *d, u8 reg, u16 val)
+{
+    if (d->log_num < 64) {
+        d->log_reg[d->log_num++] = reg;
+    }
+    d->writes++;
+    if (d == &wm && reg == 0) {
+        memcpy(d->reg, tbl_wm8978_reg, sizeof(tbl_wm8978_reg));         //软件复位
+    } else {
+        d->reg[reg] = val;
+    }
+}
+
+static void slave_byte(u8 dat)
+{
+    if (bus.nbyte == 0) {
+        bus.dev = ((dat & 0xfe) == qn.addr) ? &qn : ((dat & 0xfe) == wm.addr) ? &wm : NULL;
+        bus.rd = dat & 1;
+    } else if (bus.dev && !bus.rd) {
+        if (bus.dev->reg9) {
+            if (bus.nbyte == 1) {
+                bus.ptr = dat;
+            } else if (bus.nbyte == 2) {
+                slave_write(bus.dev, bus.ptr >> 1, ((bus.ptr & 1) << 8) | dat);
+            }
+        } else if (bus.nbyte == 1) {
+            bus.ptr = dat;
+        } else {
+            slave_write(bus.dev, bus.ptr++, dat);                       //地址自增
+        }
+    }
+    bus.nbyte++;
+}
+
+static void sim_scl(u8 v)
+{
+    if (v == m_scl) {
+        return;
+    }
+    unsigned long t = bus_us - scl_edge_us;
+    scl_edge_us = bus_us;
+    if (v) {
+        if (t < scl_min_low) {
+            scl_min_low = t;
+        }
+        //上升沿采样
+        bus.clk = 1;
+        if (bus.bits < 8) {
+            bus.byte = (bus.byte << 1) | (m_sda & s_sda);
+        } else {
+            bus.mack = !m_sda;                                          //从机发送时主机的ACK
+        }
+    } else {
+        if (t < scl_min_high) {
+            scl_min_high = t;
+        }
+        //下降沿改变从机输出, START之后的第一个下降沿不是数据时钟
+        if (!bus.clk) {
+        } else if (bus.bits < 8) {
+            bus.bits++;
+            if (bus.bits == 8) {
+                if (!bus.tx) {
+                    slave_byte(bus.byte);
+                    s_sda = bus.dev ? 0 : 1;                            //ACK
+                } else {
+                    s_sda = 1;                                          //放开总线等主机ACK/NACK
+                }
+            } else if (bus.tx) {
+                s_sda = (bus.out >> (7 - bus.bits)) & 1;
+            }
+        } else {
+            //ACK时钟结束, 读操作时地址字节之后从机开始发送, 主机NACK后停止
+            bus.bits = 0;
+            bus.byte = 0;
+            s_sda = 1;
+            if (bus.dev && bus.rd) {
+                if (!bus.tx) {
+                    bus.tx = (bus.nbyte == 1);
+                } else {
+                    bus.ptr++;
+                    bus.tx = bus.mack;
+                }
+                if (bus.tx) {
+                    bus.out = (u8)bus.dev->reg[bus.ptr];
+                    s_sda = bus.out >> 7;
+                }
+            }
+        }
+    }
+    m_scl = v;
+}
+
+static void sim_sda(u8 v)
+{
+    if (m_scl && m_sda && !v) {
+        bus.starts++;                                                   //START或重复START
+        bus.dev = NULL;
+        bus.bits = bus.byte = bus.nbyte = 0;
+        bus.tx = bus.clk = 0;
+        s_sda = 1;
+    } else if (m_scl && !m_sda && v) {
+        bus.stops++;
+        bus.dev = NULL;
+        bus.tx = 0;
+        s_sda = 1;
+    }
+    m_sda = v;
+}
+
+bool is_det_sdcard_busy(void)
+{
+    return false;
+}
+
+//一段操作的统计
+typedef struct {
+    const char *name;
+    unsigned long writes, trans, starts, bytes, skip, us;
+} seg_t;
+
+static unsigned long mark_us, mark_writes, mark_starts, mark_stops;
+static i2c_dev_stat_t mark_stat;
+
+static void seg_begin(i2c_dev_t *dev, sim_slave_t *d)
+{
+    mark_us = bus_us;
+    mark_writes = d->writes;
+    mark_starts = bus.starts;
+    mark_stops = bus.stops;
+    mark_stat = dev->stat;
+    d->log_num = 0;
+}
+
+static void seg_end(const char *name, i2c_dev_t *dev, sim_slave_t *d)
+{
+    unsigned long writes = d->writes - mark_writes;
+    unsigned long trans = dev->stat.trans - mark_stat.trans;
+    unsigned long starts = dev->stat.start - mark_stat.start;
+    unsigned long bytes = dev->stat.bytes - mark_stat.bytes;
+    unsigned long us = bus_us - mark_us;
+    //层里的计数要和总线上解码出来的一致
+    CHECK(starts == bus.starts - mark_starts);
+    CHECK(trans == bus.stops - mark_stops);
+    //原来的驱动: 每次调用写寄存器都是一次传输, 3字节 * 9个时钟 + START/STOP, 标准时序5us半时钟
+    unsigned long skip = dev->stat.skip - mark_stat.skip;
+    unsigned long old_us = (writes + skip) * ((3 * 9 + 2) * 2 * I2C_DELAY_STD + dev->gap_us);
+    (printf)("%-24s reg writes %3lu (skip %3lu) trans %3lu starts %3lu bytes %4lu bus %6lu us | old: trans %3lu bus %6lu us\n",
+             name, writes, skip, trans, starts, bytes, us, writes + skip, old_us);
+}
+
+static bool slave_matches_shadow(i2c_dev_t *dev, sim_slave_t *d)
+{
+    for (u8 r = 0; r < dev->reg_num; r++) {
+        if (dev->valid[r >> 5] & BIT(r & 0x1f)) {
+            u16 v = (dev->flag & I2C_DEV_REG9) ? ((u16 *)dev->shadow)[r] : ((u8 *)dev->shadow)[r];
+            if (r != 0 && !(dev->nocache && (dev->nocache[r >> 5] & BIT(r & 0x1f))) && d->reg[r] != v) {
+                (printf)("reg %02x slave %03x shadow %03x\n", r, d->reg[r], v);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    //WM8978
+    seg_begin(&wm8978_dev, &wm);
+    bsp_wm8978_init();
+    seg_end("wm8978 init", &wm8978_dev, &wm);
+    CHECK(slave_matches_shadow(&wm8978_dev, &wm));
+
+    seg_begin(&wm8978_dev, &wm);
+    for (u8 v = 0; v < 64; v++) {
+        bsp_wm8978_speaker_vol(v);
+    }
+    seg_end("wm8978 spk vol 0..63", &wm8978_dev, &wm);
+    CHECK(slave_matches_shadow(&wm8978_dev, &wm));
+
+    seg_begin(&wm8978_dev, &wm);
+    for (u8 i = 0; i < 64; i++) {
+        bsp_wm8978_speaker_vol(63);
+    }
+    seg_end("wm8978 spk vol same x64", &wm8978_dev, &wm);
+    CHECK(wm.log_num == 0);
+
+    //只改左声道, 右声道(VU位)也要重写才会生效
+    seg_begin(&wm8978_dev, &wm);
+    bsp_wm8978_hp_vol(20, 25);
+    bsp_wm8978_hp_vol(21, 25);
+    seg_end("wm8978 hp left only x2", &wm8978_dev, &wm);
+    CHECK(wm.log_num == 4 && wm.log_reg[1] == wm.log_reg[0] + 1 && wm.log_reg[3] == wm.log_reg[1]);
+
+    //QN8035
+    seg_begin(&qn8035_dev, &qn);
+    qn8035_init();
+    seg_end("qn8035 init", &qn8035_dev, &qn);
+    CHECK(slave_matches_shadow(&qn8035_dev, &qn));
+
+    //设频率: 按手册顺序CH_START, CH_STOP, CH, CH_STEP, 一次传输
+    seg_begin(&qn8035_dev, &qn);
+    QNF_SetCh(9810, 9810, 1);
+    seg_end("qn8035 set ch", &qn8035_dev, &qn);
+    CHECK(qn.log_num == 4);
+    CHECK(qn.log_reg[0] == CH_START && qn.log_reg[1] == CH_STOP && qn.log_reg[2] == CH && qn.log_reg[3] == CH_STEP);
+    CHECK(slave_matches_shadow(&qn8035_dev, &qn));
+
+    seg_begin(&qn8035_dev, &qn);
+    QNF_SetCh(9810, 9810, 1);
+    seg_end("qn8035 set same ch", &qn8035_dev, &qn);
+    CHECK(qn.log_num == 1 && qn.log_reg[0] == CH);                      //CH会被CCA改写, 不走影子
+
+    seg_begin(&qn8035_dev, &qn);
+    for (u16 f = 8750; f <= 10800; f += 10) {
+        QNF_SetCh(f, f, 1);
+    }
+    seg_end("qn8035 set ch x206", &qn8035_dev, &qn);
+    CHECK(slave_matches_shadow(&qn8035_dev, &qn));
+
+    //读寄存器走总线, 结果和从机一致
+    qn.reg[RSSISIG] = 0x5a;
+    CHECK(QND_ReadReg(RSSISIG) == 0x5a);
+
+    //时序: 只算delay_us, 实际还要加IO开销, 所以这是SCL频率的上限
+    unsigned long scl_khz = 1000 / (scl_min_high + scl_min_low);
+    (printf)("SCL min high %lu us, min low %lu us, max %lu KHz\n", scl_min_high, scl_min_low, scl_khz);
+    CHECK(scl_min_high >= 1 && scl_min_low >= 2 && scl_khz <= 400);        //tHIGH >= 0.6us, tLOW >= 1.3us
+    (printf)("PASS\n");
+    return 0;
+}
@@ -0,0 +1,624 @@
+//bsp_kv参数日志: SPI flash用数组模拟(编程只能1变0, 按字节写, 擦除按256字节一段), 可以在任意一个字节操作后掉电.
+//整个20K参数区都模拟: CM用cm.o的模型(按反汇编), 日志在最后4K.
+//检查连续调音量只写一次flash, 20万次随机修改中约2%掉电, 重新上电后每个字节只能是旧值或新值; 整理扇区的每个字节掉电;
+//老固件20K CM的镜像升级上来(按20K用库重写, 看门狗复位后按16K初始化, 迁移中每个字节掉电), 蓝牙配对页和参数不丢; 升级暂存驱动不碰日志扇区
+#include "include.h"
+#include "host_test.h"
+#include <setjmp.h>
+
+static jmp_buf reset_env;
+#undef WDT_RST
+#define WDT_RST()           longjmp(reset_env, 1)
+
+#include "bsp_kv.c"
+
+#define SIM_FLUSHES         200000
+#define SIM_IMAGES          200                     //升级测试的老CM镜像数
+#define SIM_CUT_IMAGES      12                      //其中每个字节掉电都试一遍的镜像数
+#define SIM_GC_SWEEPS       16                      //每个字节掉电都试一遍的整理次数
+#define FLASH_BASE          0x7b000                 //512K flash最后20K参数区
+#define PARAM_AREA          0x5000
+#define CM_AREA             (PARAM_AREA - KV_SIZE)
+#define KV_BASE             (FLASH_BASE + CM_AREA)
+#define UPD_DRIVER_LEN      9728                    //V1.0 fw5000.upd里升级驱动0x2c00字节减去头1536字节, 暂存在CM区
+#define SECTOR_NUM          (PARAM_AREA / 0x1000)
+
+static u8 flash[PARAM_AREA];
+static unsigned long erase_cnt[SECTOR_NUM], prog_bytes;
+static long cut_at = -1;                            //再操作多少个字节后掉电, -1不掉电
+static jmp_buf cut_env;
+static unsigned long flushes, cut_late;             //longjmp回来后还要用, 不放在寄存器里
+static u8 cut_in_release;                           //掉电时CM库正在整理扇区
+
+//CM库模型, 按libplatform.a(cm.o)反汇编: 格号=地址>>8, 16格一个扇区, 写指针循环, 保持至少16个空格.
+//cm_init从第一个最后一格为空的扇区往回找每页最新的一份; 页表不清零, 所以每次上电只能调一次
+static struct {
+    u32 start, end, wptr, free;
+    u32 table[8];
+    u8 max_page, cur, state, boot;                  //state: 0没装页, 1已装页, 2已改
+    u8 releasing;
+    u8 buf[256];
+} cm;
+
+//每个字节操作前检查是否到了掉电点
+static void flash_op(void)
+{
+    if (cut_at >= 0 && cut_at-- == 0) {
+        cut_in_release = cm.releasing;
+        longjmp(cut_env, 1);
+    }
+}
+
+void os_spiflash_read(void *buf, u32 addr, uint len)
+{
+    CHECK(addr >= FLASH_BASE && addr + len <= FLASH_BASE + PARAM_AREA);
+    memcpy(buf, &flash[addr - FLASH_BASE], len);
+}
+
+void os_spiflash_program(void *buf, u32 addr, uint len)
+{
+    u8 *p = buf;
+    CHECK(addr >= FLASH_BASE && addr + len <= FLASH_BASE + PARAM_AREA);
+    for (uint i = 0; i < len; i++) {
+        flash_op();
+        flash[addr - FLASH_BASE + i] &= p[i];
+        prog_bytes++;
+    }
+}
+
+void os_spiflash_erase(u32 addr)
+{
+    u32 off = addr - FLASH_BASE;
+    CHECK(addr >= FLASH_BASE && off < PARAM_AREA && off % 0x1000 == 0);
+    erase_cnt[off / 0x1000]++;
+    for (uint i = 0; i < 0x1000; i += 256) {
+        flash_op();
+        memset(&flash[off + i], 0xff, 256);
+    }
+}
+
+//crc16/CCITT查表, 和库里的calc_crc算法无关, 读写一致就行. 每次上电要扫整个参数区, 按位算太慢
+uint calc_crc(void *buf, uint len, uint seed)
+{
+    static u16 tbl[256];
+    u8 *p = buf;
+    u16 crc = seed;
+    if (tbl[1] == 0) {
+        for (int i = 0; i < 256; i++) {
+            u16 c = i << 8;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+            }
+            tbl[i] = c;
+        }
+    }
+    while (len--) {
+        crc = (crc << 8) ^ tbl[(crc >> 8) ^ *p++];
+    }
+    return crc;
+}
+
+
+static void cm_loadpage(u32 slot)
+{
+    os_spiflash_read(cm.buf, slot << 8, 256);
+}
+
+static int cm_check_page(u32 slot)
+{
+    cm_loadpage(slot);
+    if ((cm.buf[250] | (cm.buf[251] << 8)) != 0xd2c3) {
+        for (int i = 0; i < 256; i++) {
+            if (cm.buf[i] != 0xff) {
+                return -2;
+            }
+        }
+        return -1;
+    }
+    if ((uint)(cm.buf[254] | (cm.buf[255] << 8)) != calc_crc(cm.buf, 254, 0x2018) || cm.buf[253] >= cm.max_page) {
+        return -2;
+    }
+    return cm.buf[253];
+}
+
+static void cm_next_freepage(void)
+{
+    if (++cm.wptr >= cm.end) {
+        cm.wptr = cm.start;
+    }
+    cm.free--;
+}
+
+static void cm_write_cfgpage(u8 page)
+{
+    cm.buf[250] = 0xc3;
+    cm.buf[251] = 0xd2;
+    cm.buf[252] = 0;
+    cm.buf[253] = page;
+    u16 crc = calc_crc(cm.buf, 254, 0x2018);
+    cm.buf[254] = crc;
+    cm.buf[255] = crc >> 8;
+    os_spiflash_program(cm.buf, cm.wptr << 8, 256);
+    cm.state = 1;
+    cm.table[page] = cm.wptr;
+    cm_next_freepage();
+}
+
+static void cm_movepage(u8 page)
+{
+    cm_loadpage(cm.table[page]);
+    os_spiflash_program(cm.buf, cm.wptr << 8, 256);
+    cm.cur = page;
+    cm.table[page] = cm.wptr;
+    cm_next_freepage();
+}
+
+//擦写指针后面的扇区, 先把最新一份在那里的页搬走
+static void cm_release(void)
+{
+    u32 s = (cm.wptr & ~15) + 16;
+    if (s >= cm.end) {
+        s = cm.start;
+    }
+    cm.releasing = 1;
+    for (u8 i = 0; i < cm.max_page; i++) {
+        if ((cm.table[i] & ~15) == s) {
+            cm_movepage(i);
+        }
+    }
+    cm.state = 1;
+    os_spiflash_erase(s << 8);
+    cm.free += 16;
+    cm.releasing = 0;
+}
+
+//升级前调用: 所有页收到CM最后一个扇区, 其它扇区擦掉
+static void cm_release_all(void)
+{
+    u32 s;
+    do {
+        s = cm.wptr & ~15;
+        for (u8 i = 0; i < cm.max_page; i++) {
+            if ((cm.table[i] & ~15) != s) {
+                cm_movepage(i);
+            }
+        }
+    } while ((cm.wptr & ~15) != s);
+    for (u32 e = cm.start; e < cm.end; e += 16) {
+        if (e != s) {
+            os_spiflash_erase(e << 8);
+        }
+    }
+    if (s == cm.end - 16) {
+        return;
+    }
+    cm.wptr = cm.end - 16;
+    cm.free = cm.end - cm.start;
+    for (u8 i = 0; i < cm.max_page; i++) {
+        cm_movepage(i);
+    }
+    os_spiflash_erase(s << 8);
+}
+
+static u32 cm_get_startaddr(void)
+{
+    return cm.start;
+}
+
+static u32 cm_get_area(void)
+{
+    return cm.end - cm.start;
+}
+
+static u8 cm_check_loadpage(u32 addr, uint len)
+{
+    u8 page = addr >> 8, off = addr & 0xff;
+    CHECK(page < cm.max_page && off + len <= 250);
+    if (cm.state) {
+        if (cm.cur == page) {
+            return off;
+        }
+        if (cm.state == 2) {
+            cm_write_cfgpage(cm.cur);
+        }
+    }
+    cm.cur = page;
+    cm.state = 1;
+    cm_loadpage(cm.table[page]);
+    return off;
+}
+
+void cm_init(uint max_page, u32 addr, uint len)
+{
+    u32 s1, s2, n, found = 0;
+    bool lead = true;
+
+    CHECK(!cm.boot && max_page <= 7 && len > 0x1fff);
+    cm.boot = 1;
+    cm.max_page = max_page;
+    cm.start = addr >> 8;
+    cm.end = cm.start + (len >> 8);
+    if (cm_check_page(cm.start) < 0) {
+        s1 = cm.end - 1;
+    } else {
+        for (s2 = cm.start; ; s2 += 16) {
+            s1 = s2 + 15;
+            if (s1 >= cm.end || cm_check_page(s1) == -1) {
+                break;
+            }
+        }
+    }
+    cm.free = 0;
+    s2 = cm.start;
+    if (s1 < cm.end) {
+        s2 = (s1 + 16) & ~15;
+        if (s2 >= cm.end) {
+            s2 = cm.start;
+        }
+        for (n = cm.end - cm.start - 1; n != 0; n--) {
+            int r = cm_check_page(s1);
+            if (lead && r == -1) {
+                cm.wptr = s1;
+                cm.free++;
+            } else {
+                if (r >= 0 && cm.table[r] == 0) {
+                    cm.table[r] = s1;
+                    if (++found >= cm.max_page) {
+                        break;
+                    }
+                }
+                lead = false;
+            }
+            s1 = (s1 <= cm.start) ? cm.end - 1 : s1 - 1;
+        }
+        if (found == 0) {
+            s2 = cm.start;
+            cm.free = 0;
+        }
+    }
+    if (cm.free <= 15) {
+        for (s1 = s2; s1 < s2 + 16; s1++) {
+            cm_loadpage(s1);
+            int i = 0;
+            while (i < 256 && cm.buf[i] == 0xff) {
+                i++;
+            }
+            if (i < 256) {
+                os_spiflash_erase(s2 << 8);
+                break;
+            }
+        }
+        if (cm.free == 0) {
+            cm.wptr = s2;
+        }
+        cm.free += 16;
+    }
+    for (u8 i = 0; i < cm.max_page; i++) {
+        if (cm.table[i] == 0) {
+            memset(cm.buf, 0, 250);                 //cm_factory: 出厂值
+            cm_write_cfgpage(i);
+        }
+    }
+    if (cm.free <= 15) {
+        cm_release();
+    }
+    cm.state = 0;
+}
+
+void cm_sync(void)
+{
+    if (cm.state == 2) {
+        cm_write_cfgpage(cm.cur);
+        if (cm.free <= 15) {
+            cm_release();
+        }
+    }
+}
+
+void cm_read(void *buf, u32 addr, uint len)
+{
+    memcpy(buf, &cm.buf[cm_check_loadpage(addr, len)], len);
+}
+
+void cm_write(void *buf, u32 addr, uint len)
+{
+    memcpy(&cm.buf[cm_check_loadpage(addr, len)], buf, len);
+    cm.state = 2;
+}
+
+//重新上电: RAM清零, 按现在的固件初始化CM和日志, 看门狗复位后再来一次
+static unsigned long resets;
+
+static void boot(void)
+{
+    if (setjmp(reset_env)) {
+        resets++;
+    }
+    memset(&cm, 0, sizeof(cm));
+    kv_cm_init(FLASH_BASE, CM_AREA, PARAM_AREA);
+}
+
+//老固件上电: CM占整个参数区
+static void boot_old(void)
+{
+    memset(&cm, 0, sizeof(cm));
+    cm_init(MAX_CM_PAGE, FLASH_BASE, PARAM_AREA);
+}
+
+static void cm_page_write(u8 page, const u8 *data)
+{
+    cm_write((void *)data, PAGE0(0) + (page << 8), KV_CM_PAGE_SIZE);
+    cm_sync();
+}
+
+static bool cm_page_check(u8 page, const u8 *data)
+{
+    u8 buf[KV_CM_PAGE_SIZE];
+    cm_read(buf, PAGE0(0) + (page << 8), KV_CM_PAGE_SIZE);
+    return memcmp(buf, data, KV_CM_PAGE_SIZE) == 0;
+}
+
+//配对页只允许在CM库整理扇区时掉电丢失(库的问题, 老固件每次存参数都可能碰到):
+//写格让空格降到15个后, 搬页之前掉电, 上电cm_init看到空格不足16个, 直接擦下一个扇区, 不管里面还没搬走的页
+static unsigned long key_lost;
+
+static void link_key_check(const u8 *link_key)
+{
+    if (!cm_page_check(1, link_key)) {
+        CHECK(cut_in_release);
+        key_lost++;
+        cm_page_write(1, link_key);                 //重新配对
+    }
+}
+
+static void fill_rand(u8 *buf, uint len)
+{
+    for (uint i = 0; i < len; i++) {
+        buf[i] = rand();
+    }
+}
+
+//老固件用一段时间: 参数(PAGE0)改得多, 配对(PAGE1..)改得少, 中间有几次重新上电
+static void old_history(u8 expect[MAX_CM_PAGE][KV_CM_PAGE_SIZE])
+{
+    memset(flash, 0xff, sizeof(flash));
+    memset(expect, 0, MAX_CM_PAGE * KV_CM_PAGE_SIZE);
+    boot_old();
+    int n = rand() % 400;
+    for (int k = 0; k < n; k++) {
+        u8 page = (rand() % 3) ? 0 : 1 + rand() % (MAX_CM_PAGE - 1);
+        fill_rand(expect[page], KV_CM_PAGE_SIZE);
+        cm_page_write(page, expect[page]);
+        if (rand() % 50 == 0) {
+            boot_old();
+        }
+    }
+}
+
+//现在的固件读到的页和参数是否和老固件最后写的一样
+static bool upgrade_check(u8 expect[MAX_CM_PAGE][KV_CM_PAGE_SIZE])
+{
+    u8 img[KV_IMAGE_SIZE];
+    bool ok = true;
+    for (u8 p = 1; p < MAX_CM_PAGE; p++) {
+        ok = ok && cm_page_check(p, expect[p]);
+    }
+    kv_read(img, 0, KV_IMAGE_SIZE);
+    return ok && memcmp(img, expect[0], KV_IMAGE_SIZE) == 0;
+}
+
+static void test_upgrade(void)
+{
+    static u8 expect[MAX_CM_PAGE][KV_CM_PAGE_SIZE], image[PARAM_AREA];
+    static int img, naive_lost, in_top, moved, cut_fail, cut_lib, cut_runs;
+    static long k;
+    u8 buf[KV_CM_PAGE_SIZE];
+
+    for (img = 0; img < SIM_IMAGES; img++) {
+        old_history(expect);
+        for (u8 p = 0; p < MAX_CM_PAGE; p++) {
+            in_top += (cm.table[p] << 8) >= KV_BASE;
+        }
+        memcpy(image, flash, sizeof(flash));
+
+        //对比: 直接按新大小cm_init(原来的做法), 最新一份在日志扇区里的页读到的是旧值或出厂值
+        memset(&cm, 0, sizeof(cm));
+        cm_init(MAX_CM_PAGE, FLASH_BASE, CM_AREA);
+        for (u8 p = 0; p < MAX_CM_PAGE; p++) {
+            cm_read(buf, PAGE0(0) + (p << 8), KV_CM_PAGE_SIZE);
+            naive_lost += memcmp(buf, expect[p], KV_CM_PAGE_SIZE) != 0;
+        }
+        memcpy(flash, image, sizeof(flash));
+
+        unsigned long r0 = resets;
+        boot();
+        CHECK(kv_get_stat()->gc == 1 && upgrade_check(expect));
+        moved += resets != r0;                      //按20K把页重写到前面后复位过
+        boot();
+        CHECK(kv_get_stat()->gc == 0 && upgrade_check(expect));
+
+        //迁移过程中每个字节操作后掉电, 再上电(不掉电)
+        for (k = 0; img < SIM_CUT_IMAGES; k++) {
+            memcpy(flash, image, sizeof(flash));
+            cut_at = k;
+            cut_in_release = 0;
+            if (setjmp(cut_env) == 0) {
+                boot();
+                cut_at = -1;
+                break;                              //迁移做完了还没到掉电点
+            }
+            cut_at = -1;
+            boot();
+            cut_runs++;
+            if (!upgrade_check(expect)) {
+                cut_fail++;
+                cut_lib += cut_in_release;
+            }
+        }
+    }
+    (printf)("upgrade from 20K CM: %d images, %d pages had the newest copy in the log sector, cm_init(16K) alone loses %d pages\n",
+             SIM_IMAGES, in_top, naive_lost);
+    (printf)("%d images rewritten through a 20K CM and reset before the 16K cm_init\n", moved);
+    (printf)("power cut during upgrade: %d cut points on %d images, %d lost a page or param (%d inside cm_release)\n",
+             cut_runs, SIM_CUT_IMAGES, cut_fail, cut_lib);
+    CHECK(in_top > 0 && naive_lost > 0 && moved > 0);
+    CHECK(cut_fail == cut_lib);
+}
+
+//升级: cm_release_all后把驱动写到CM前面, 日志扇区不变, 升级后页和参数还在
+static void test_update_staging(void)
+{
+    u8 expect[MAX_CM_PAGE][KV_CM_PAGE_SIZE], kv_sector[KV_SIZE];
+
+    old_history(expect);
+    boot();
+    CHECK(upgrade_check(expect));
+    memcpy(kv_sector, &flash[CM_AREA], KV_SIZE);
+    cm_release_all();
+    u32 room = (cm_get_area() - 16) << 8;
+    (printf)("update driver staging: %lu bytes room for %d bytes (12K CM: %d)\n",
+             (unsigned long)room, UPD_DRIVER_LEN, (0x3000 / 256 - 16) * 256);
+    CHECK(room >= UPD_DRIVER_LEN);
+    u32 addr = cm_get_startaddr() << 8;
+    for (int i = 0; i < UPD_DRIVER_LEN; i++) {
+        CHECK(flash[addr - FLASH_BASE + i] == 0xff);
+    }
+    static u8 drv[UPD_DRIVER_LEN];
+    fill_rand(drv, UPD_DRIVER_LEN);
+    os_spiflash_program(drv, addr, UPD_DRIVER_LEN);
+    CHECK(memcmp(kv_sector, &flash[CM_AREA], KV_SIZE) == 0);
+    boot();
+    CHECK(kv_get_stat()->gc == 0 && upgrade_check(expect));
+}
+
+int main(void)
+{
+    u8 committed[KV_IMAGE_SIZE], pending[KV_IMAGE_SIZE], img[KV_IMAGE_SIZE];
+    u8 link_key[KV_CM_PAGE_SIZE];
+    unsigned long recovers = 0, gcs = 0, cuts = 0, writes = 0, gc_cuts = 0, gc_old = 0;
+    srand(49);
+
+    //没擦过的flash: CM格式化, 日志从PAGE0(出厂值)建立, 写入后能读回
+    memset(flash, 0xa5, sizeof(flash));
+    boot();
+    CHECK(kv_get_stat()->gc == 1);
+    for (int i = 0; i < KV_IMAGE_SIZE; i++) {
+        img[i] = i;
+    }
+    kv_write(img, 0, KV_IMAGE_SIZE);
+    kv_flush();
+    fill_rand(link_key, KV_CM_PAGE_SIZE);
+    cm_page_write(1, link_key);
+    boot();
+    CHECK(kv_get_stat()->gc == 0 && cm_page_check(1, link_key));
+    kv_read(committed, 0, KV_IMAGE_SIZE);
+    CHECK(memcmp(committed, img, KV_IMAGE_SIZE) == 0);
+
+    //音量连续调20次(每次50ms), 空闲KV_IDLE_TIME后只写一条记录
+    u16 rec0 = kv_get_stat()->rec;
+    for (u8 v = 0; v < 20; v++) {
+        kv_write(&v, PARAM_SYS_VOL, 1);
+        kv_sync();
+        host_ms += 50;
+        kv_process();
+    }
+    CHECK(kv_get_stat()->rec == rec0);
+    host_ms += KV_IDLE_TIME;
+    kv_process();
+    (printf)("volume burst: 20 writes -> %d record\n", kv_get_stat()->rec - rec0);
+    CHECK(kv_get_stat()->rec == rec0 + 1);
+    kv_read(committed, 0, KV_IMAGE_SIZE);
+
+    for (long it = 0; it < SIM_FLUSHES; it++) {
+        //随机改几个参数(音量, 断点, FM频道...)
+        memcpy(pending, committed, KV_IMAGE_SIZE);
+        int n = 1 + rand() % 3;
+        for (int k = 0; k < n; k++) {
+            int key = rand() % (KV_IMAGE_SIZE - 10), len = 1 + rand() % 10;
+            for (int i = 0; i < len; i++) {
+                pending[key + i] = rand();
+            }
+            kv_write(&pending[key], key, len);
+            writes++;
+        }
+        //掉电点: 多数落在追加记录里, 也有落在整理扇区的备份, 擦除和复制里
+        bool cut = (rand() % 50) == 0;
+        if (cut) {
+            cut_at = (rand() % 4) ? rand() % 40 : rand() % (KV_SECTOR_SIZE / 256 + 600);
+            cuts++;
+        }
+        cut_in_release = 0;
+        if (setjmp(cut_env) == 0) {
+            kv_flush();
+            flushes++;
+            cut_late += cut;                        //写完了还没到掉电点
+        }
+        cut_at = -1;
+        if (cut || it % 1000 == 0) {
+            //重新上电: 每个字节只能是旧值或新值, 配对信息不变
+            gcs += kv_get_stat()->gc;
+            boot();
+            link_key_check(link_key);
+            recovers += kv_get_stat()->recover;
+            kv_read(img, 0, KV_IMAGE_SIZE);
+            for (int i = 0; i < KV_IMAGE_SIZE; i++) {
+                CHECK(img[i] == committed[i] || img[i] == pending[i]);
+            }
+            if (!cut) {
+                CHECK(memcmp(img, pending, KV_IMAGE_SIZE) == 0);
+            }
+            memcpy(committed, img, KV_IMAGE_SIZE);
+        } else {
+            memcpy(committed, pending, KV_IMAGE_SIZE);
+        }
+        if (it % 5000 == 0) {
+            fill_rand(link_key, KV_CM_PAGE_SIZE);   //偶尔重新配对
+            cm_page_write(1, link_key);
+        }
+    }
+    (printf)("%lu flushes, %lu param writes, %lu power cuts (%lu after the flush finished), recover %lu, gc %lu\n",
+             flushes, writes, cuts, cut_late, recovers, gcs);
+    (printf)("bytes programmed per flush: %lu\n", prog_bytes / flushes);
+    CHECK(cuts > cut_late && recovers > 0);
+
+    //整理扇区(备份到CM, 擦除, 写镜像, 写扇区头)的每个字节操作后掉电, 每个掉电点都从整理前的flash开始:
+    //上电后是整理前或整理后的镜像. 连续整理SIM_GC_SWEEPS次, CM的备份会跨过扇区, 掉电点也落在cm_release里
+    static u8 snapshot[PARAM_AREA];
+    for (int g = 0; g < SIM_GC_SWEEPS; g++) {
+        memcpy(snapshot, flash, sizeof(flash));
+        memcpy(pending, committed, KV_IMAGE_SIZE);
+        fill_rand(&pending[g * 8 % KV_IMAGE_SIZE], 8);
+        for (long k = 0; ; k++) {
+            memcpy(flash, snapshot, sizeof(flash));
+            boot();
+            kv_write(&pending[g * 8 % KV_IMAGE_SIZE], g * 8 % KV_IMAGE_SIZE, 8);
+            kv_cb.wptr = KV_SECTOR_SIZE;           //下次写flash要整理
+            cut_at = k;
+            cut_in_release = 0;
+            if (setjmp(cut_env) == 0) {
+                kv_flush();
+                cut_at = -1;
+                break;
+            }
+            cut_at = -1;
+            boot();
+            gc_cuts++;
+            link_key_check(link_key);
+            kv_read(img, 0, KV_IMAGE_SIZE);
+            CHECK(memcmp(img, committed, KV_IMAGE_SIZE) == 0 || memcmp(img, pending, KV_IMAGE_SIZE) == 0);
+            gc_old += memcmp(img, committed, KV_IMAGE_SIZE) == 0;
+        }
+        memcpy(committed, pending, KV_IMAGE_SIZE);
+    }
+    (printf)("power cut at each step of a gc: %lu cut points, %lu kept the old image, the rest the new one\n", gc_cuts, gc_old);
+    (printf)("link key lost to a cut inside cm_release: %lu\n", key_lost);
+    for (u8 s = 0; s < SECTOR_NUM; s++) {
+        (printf)("sector %d (%s): erase %lu\n", s, (s < CM_AREA / 0x1000) ? "cm" : "kv", erase_cnt[s]);
+    }
+    CHECK(kv_get_erase_cnt(0) <= erase_cnt[SECTOR_NUM - 1]);
+
+    test_upgrade();
+    test_update_staging();
+    (printf)("PASS\n");
+    return 0;
+}
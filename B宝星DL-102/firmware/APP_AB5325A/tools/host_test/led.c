@@ -0,0 +1,127 @@
+//bsp_led字节码闪灯: 按led_scan(50ms)和led_pat_pwm_isr(1ms)的节拍跑, LED输出接到变量上,
+//检查蓝牙配对心跳的时序和TWS同步, 低电提示闪完恢复, get_led_sta按红蓝灯返回, 中间亮度的PWM占空比
+#include "include.h"
+#include "host_test.h"
+
+static u8 rled, bled;
+static unsigned long rled_ms, bled_ms;          //1ms节拍里亮的次数
+
+#undef LED_INIT
+#undef LED_SET_ON
+#undef LED_SET_OFF
+#undef LED_PWR_INIT
+#undef LED_PWR_SET_ON
+#undef LED_PWR_SET_OFF
+#define LED_INIT()
+#define LED_SET_ON()                bled = 1
+#define LED_SET_OFF()               bled = 0
+#define LED_PWR_INIT()
+#define LED_PWR_SET_ON()            rled = 1
+#define LED_PWR_SET_OFF()           rled = 0
+
+#include "bsp_led.c"
+#include "port/port_led.c"
+
+xcfg_cb_t xcfg_cb;
+sys_cb_t sys_cb;
+volatile u32 ticks_50ms;
+static bool tws_connected;
+
+bool bt_tws_is_connected(void)
+{
+    return tws_connected;
+}
+
+void bsp_gpio_cfg_init(gpio_t *g, u8 io_num) {}
+
+//跑n个50ms, 每个50ms里50次1ms的PWM, trace记录每个50ms开始时蓝灯的状态
+static void run(int n, char *trace)
+{
+    for (int t = 0; t < n; t++) {
+        ticks_50ms++;
+        led_scan();
+        if (trace) {
+            trace[t] = bled ? '#' : '.';
+        }
+        for (int ms = 0; ms < 50; ms++) {
+            led_pat_pwm_isr();
+            rled_ms += rled;
+            bled_ms += bled;
+        }
+    }
+    if (trace) {
+        trace[n] = 0;
+    }
+}
+
+int main(void)
+{
+    char a[64], b[64];
+
+    led_init();
+
+    //配对(没有用工具配置闪灯): 1s周期双闪, 在ticks_50ms为20的倍数时开始
+    ticks_50ms = 3;
+    led_bt_idle();
+    CHECK(led_cb.pat == led_pat_bt_pair);
+    CHECK(get_led_sta(0) == 0xff && get_led_sta(1) == 0x00);
+    run(16, NULL);
+    bled_ms = 0;
+    run(40, a);
+    (printf)("bt pair:  %s\n", a);
+    CHECK(strcmp(a, "##..##..............##..##..............") == 0);
+    CHECK(bled_ms == 2 * 4 * 50);
+
+    //TWS同步: 两边在不同时间进入配对, 同步后闪灯一致
+    ticks_50ms = 0;
+    led_bt_idle();
+    run(7, NULL);
+    tmr5ms_set_sync();
+    run(40, a);
+    ticks_50ms = 0;
+    led_bt_idle();
+    run(13, NULL);
+    tmr5ms_set_sync();
+    run(40, b);
+    (printf)("tws a:    %s\ntws b:    %s\n", a, b);
+    CHECK(strcmp(a, b) == 0);
+
+    //低电提示: 红灯闪2次, 闪完恢复配对闪灯, 中间get_led_sta按红蓝灯分开
+    rled_ms = 0;
+    led_lowbat_follow_warning();
+    CHECK(get_led_sta(1) == 0xff && get_led_sta(0) == 0x00);
+    run(10, NULL);
+    CHECK(rled_ms == 2 * 2 * 50);
+    CHECK(led_cb.pat == led_pat_bt_pair && !(led_cb.flag & LED_TOG_LBAT));
+    CHECK(get_led_sta(0) == 0xff && get_led_sta(1) == 0x00);
+
+    //工具配置了配对闪灯时用配置, 不走字节码
+    xcfg_cb.led_btpair_config_en = 1;
+    xcfg_cb.led_pairing.redpat = 0x0f;
+    xcfg_cb.led_pairing.bluepat = 0xf0;
+    xcfg_cb.led_pairing.unit = 2;
+    led_bt_idle();
+    CHECK(led_cb.pat == NULL && get_led_sta(1) == 0x0f && get_led_sta(0) == 0xf0);
+
+    //状态切换(已连接)会停掉字节码闪灯
+    xcfg_cb.led_btpair_config_en = 0;
+    led_bt_idle();
+    led_bt_connected();
+    CHECK(led_cb.pat == NULL && get_led_sta(0) == 0x02);
+
+    //渐变: 1s内蓝灯从0渐亮到最亮, 占空比单调增加, 平均约一半
+    static const u8 ramp[] = {LP_RAMP(0, 8, 20), LP_END()};
+    led_set_sta(0, 0, 0, 0);
+    led_cb.pat = ramp;
+    bled_ms = 0;
+    u8 last = 0;
+    for (int t = 0; t < 20; t++) {
+        run(1, NULL);
+        CHECK(led_cb.duty[1] >= last);
+        last = led_cb.duty[1];
+    }
+    (printf)("ramp: blue on %lu of 1000 ms\n", bled_ms);
+    CHECK(last == LED_PAT_LVL_MAX && bled_ms > 400 && bled_ms < 600);
+    (printf)("PASS\n");
+    return 0;
+}
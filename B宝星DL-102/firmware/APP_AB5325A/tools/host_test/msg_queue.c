@@ -0,0 +1,250 @@
+//bsp_msg优先级消息队列: 回放蓝牙和按键的突发消息, 统计按键从入队到被处理的延迟分布,
+//和库里的单FIFO(这里用16深度的FIFO模拟)对比
+#include "include.h"
+#include "host_test.h"
+#include "bsp_msg.c"
+
+#define SIM_TIME            (120 * 1000)        //模拟120s, 1ms一步
+#define LIB_QUEUE_LEN       16
+#define LAT_MAX             1000
+
+//库里原来的FIFO
+static u16 lib_buf[LIB_QUEUE_LEN];
+static u8 lib_rptr, lib_wptr;
+static unsigned long lib_drop;
+
+void msg_queue_init(void)
+{
+    lib_rptr = lib_wptr = 0;
+}
+
+void msg_queue_clear(void)
+{
+    lib_rptr = lib_wptr;
+}
+
+void msg_enqueue(u16 msg)
+{
+    if ((u8)(lib_wptr - lib_rptr) >= LIB_QUEUE_LEN) {
+        lib_drop++;
+        return;
+    }
+    lib_buf[lib_wptr++ % LIB_QUEUE_LEN] = msg;
+}
+
+u16 msg_dequeue(void)
+{
+    if (lib_rptr == lib_wptr) {
+        return NO_MSG;
+    }
+    return lib_buf[lib_rptr++ % LIB_QUEUE_LEN];
+}
+
+void msg_queue_detach(u16 msg)
+{
+    u8 w = lib_rptr;
+    for (u8 r = lib_rptr; r != lib_wptr; r++) {
+        if (lib_buf[r % LIB_QUEUE_LEN] != msg) {
+            lib_buf[w++ % LIB_QUEUE_LEN] = lib_buf[r % LIB_QUEUE_LEN];
+        }
+    }
+    lib_wptr = w;
+}
+
+//主循环处理一条消息的时间(ms)
+static int msg_cost(u16 msg)
+{
+    switch (msg) {
+    case EVT_A2DP_SET_VOL:
+        return 6;                   //音量淡入淡出
+    case EVT_ONLINE_SET_EQ:
+        return 12;                  //写EQ系数
+    case MSG_SYS_500MS:
+        return 3;                   //刷新显示
+    case EVT_A2DP_MUSIC_PLAY:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+typedef struct {
+    unsigned long lat[LAT_MAX + 1];     //按键延迟直方图(ms)
+    unsigned long keys, lost, handled, busy;
+    u32 key_time[0x2000];               //按键消息入队时间, 按消息值索引
+} sim_result_t;
+
+static sim_result_t res_fifo, res_prio;
+
+static void sim_enqueue(int prio, u16 msg)
+{
+    sim_result_t *r = prio ? &res_prio : &res_fifo;
+    if (!msg_is_event(msg)) {
+        //同一个按键消息还没处理又来一次(连按被合并)时, 按最早一次算延迟
+        if (!r->key_time[msg]) {
+            r->key_time[msg] = host_ms + 1;
+        }
+        r->keys++;
+    }
+    if (prio) {
+        bsp_msg_enqueue(msg);
+    } else {
+        if (!msg_is_event(msg) && (msg & KEY_TYPE_MASK) == KEY_LONG_UP) {
+            msg_queue_detach(msg | KEY_HOLD);
+        }
+        msg_enqueue(msg);
+    }
+}
+
+static void sim_run(int prio)
+{
+    sim_result_t *r = prio ? &res_prio : &res_fifo;
+    u32 busy_until = 0, next_key = 200, next_bt = 700, hold_end = 0, next_hold = 0;
+    u16 hold_key = 0;
+
+    srand(1234);
+    memset(r, 0, sizeof(*r));
+    msg_queue_init();
+    bsp_msg_init();
+    for (host_ms = 0; host_ms < SIM_TIME; host_ms++) {
+        //定时消息
+        if (host_ms % 500 == 0) {
+            sim_enqueue(prio, MSG_SYS_500MS);
+        }
+        if (host_ms % 1000 == 0) {
+            sim_enqueue(prio, MSG_SYS_1S);
+        }
+        //蓝牙突发: 手机拖音量条, 同时APP发EQ和播放状态
+        if (host_ms == next_bt) {
+            int n = 8 + rand() % 24;
+            for (int i = 0; i < n; i++) {
+                sim_enqueue(prio, EVT_A2DP_SET_VOL);
+                if (i % 8 == 0) {
+                    sim_enqueue(prio, EVT_ONLINE_SET_EQ);
+                }
+            }
+            sim_enqueue(prio, EVT_A2DP_MUSIC_PLAY);
+            next_bt += 800 + rand() % 2500;
+        }
+        //按键: 短按播放, 或者长按音量加(每175ms一个HOLD)
+        if (host_ms == next_key) {
+            if (rand() % 2) {
+                sim_enqueue(prio, KU_PLAY);
+            } else {
+                hold_key = KEY_VOL_UP;
+                sim_enqueue(prio, hold_key | KEY_LONG);
+                next_hold = host_ms + 175;
+                hold_end = host_ms + 500 + rand() % 1500;
+            }
+            next_key += 400 + rand() % 2000;
+        }
+        if (hold_key && host_ms == next_hold) {
+            if (host_ms >= hold_end) {
+                sim_enqueue(prio, hold_key | KEY_LONG_UP);
+                hold_key = 0;
+            } else {
+                sim_enqueue(prio, hold_key | KEY_HOLD);
+                next_hold += 175;
+            }
+        }
+
+        //主循环: 上一条处理完才取下一条
+        if (host_ms < busy_until) {
+            r->busy++;
+            continue;
+        }
+        u16 msg = prio ? bsp_msg_dequeue() : msg_dequeue();
+        if (msg == NO_MSG) {
+            continue;
+        }
+        r->handled++;
+        if (!msg_is_event(msg) && r->key_time[msg]) {
+            u32 lat = host_ms + 1 - r->key_time[msg];
+            r->lat[lat > LAT_MAX ? LAT_MAX : lat]++;
+            r->key_time[msg] = 0;
+        }
+        busy_until = host_ms + msg_cost(msg);
+    }
+}
+
+static u32 lat_percentile(sim_result_t *r, int pct)
+{
+    unsigned long total = 0, acc = 0;
+    for (int i = 0; i <= LAT_MAX; i++) {
+        total += r->lat[i];
+    }
+    for (int i = 0; i <= LAT_MAX; i++) {
+        acc += r->lat[i];
+        if (acc * 100 >= total * pct) {
+            return i;
+        }
+    }
+    return LAT_MAX;
+}
+
+static void report(const char *name, sim_result_t *r, unsigned long drop)
+{
+    unsigned long n = 0;
+    for (int i = 0; i <= LAT_MAX; i++) {
+        n += r->lat[i];
+    }
+    (printf)("%-10s key msgs %5lu handled %5lu, key latency ms p50 %3lu p90 %3lu p99 %3lu max %4lu, handled total %6lu, busy %3lu%%, drop %lu\n",
+             name, r->keys, n, lat_percentile(r, 50), lat_percentile(r, 90), lat_percentile(r, 99),
+             lat_percentile(r, 100), r->handled, r->busy * 100 / SIM_TIME, drop);
+}
+
+int main(void)
+{
+    sim_run(0);
+    unsigned long fifo_drop = lib_drop;
+    report("lib fifo", &res_fifo, fifo_drop);
+
+    lib_drop = 0;
+    sim_run(1);
+    unsigned long prio_drop = 0;
+    for (u8 i = 0; i < MSG_PRIO_NUM; i++) {
+        const msg_prio_stat_t *s = bsp_msg_get_stat(i);
+        (printf)("prio %d: hwm %d drop %d coalesce %d\n", i, s->hwm, s->drop, s->coalesce);
+        prio_drop += s->drop;
+    }
+    report("prio", &res_prio, prio_drop);
+
+    CHECK(bsp_msg_get_stat(MSG_PRIO_INPUT)->drop == 0);
+    CHECK(bsp_msg_get_stat(MSG_PRIO_HOUSEKEEP)->drop == 0);
+    CHECK(lat_percentile(&res_prio, 100) <= 12 + 6);        //最多等一条正在处理的EQ消息
+    CHECK(lat_percentile(&res_prio, 99) < lat_percentile(&res_fifo, 99));
+
+    //长按抬键要清掉还没处理的HOLD
+    bsp_msg_init();
+    bsp_msg_enqueue(KH_VOL_UP);
+    bsp_msg_enqueue(KH_VOL_UP);
+    bsp_msg_enqueue(KLU_VOL_UP);
+    CHECK(bsp_msg_dequeue() == KLU_VOL_UP);
+    CHECK(bsp_msg_dequeue() == NO_MSG);
+
+    //主循环卡住时SD/U盘/LINEIN反复插拔, 加上定时消息: 不丢, 每种只留最后一条, 最后的插拔状态不变
+    bsp_msg_init();
+    for (int i = 0; i < 50; i++) {
+        bsp_msg_enqueue(MSG_SYS_500MS);
+        bsp_msg_enqueue((i & 1) ? EVT_SD_REMOVE : EVT_SD_INSERT);
+        bsp_msg_enqueue((i & 1) ? EVT_UDISK_REMOVE : EVT_UDISK_INSERT);
+        bsp_msg_enqueue((i & 1) ? EVT_LINEIN_INSERT : EVT_LINEIN_REMOVE);
+        if (i % 2 == 0) {
+            bsp_msg_enqueue(MSG_SYS_1S);
+        }
+    }
+    static const u16 plug_last[] = {EVT_SD_INSERT, EVT_UDISK_INSERT, EVT_LINEIN_REMOVE, MSG_SYS_1S,
+                                    MSG_SYS_500MS, EVT_SD_REMOVE, EVT_UDISK_REMOVE, EVT_LINEIN_INSERT};
+    for (u8 i = 0; i < sizeof(plug_last) / sizeof(u16); i++) {
+        CHECK(bsp_msg_dequeue() == plug_last[i]);
+    }
+    CHECK(bsp_msg_dequeue() == NO_MSG && bsp_msg_get_stat(MSG_PRIO_HOUSEKEEP)->drop == 0);
+
+    //库里发的消息也按优先级取
+    msg_enqueue(MSG_SYS_1S);
+    bsp_msg_enqueue(KU_PLAY);
+    CHECK(bsp_msg_dequeue() == KU_PLAY);
+    CHECK(bsp_msg_dequeue() == MSG_SYS_1S);
+    (printf)("PASS\n");
+    return 0;
+}
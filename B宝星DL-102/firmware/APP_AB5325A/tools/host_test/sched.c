@@ -0,0 +1,161 @@
+//bsp_sched时间轮: 按bsp_sched_init注册同样的任务(SD/USB/LINEIN检测, DNR, 50ms/100ms/500ms/1s),
+//模拟10分钟里偶尔插拔, 统计每秒的任务执行次数, 中断时间和有任务到期的tick数, 和原来每个tick全部判一遍对比.
+//中断每秒200次不变, 按键扫描/DAC淡入淡出/plugin每个tick都算进中断时间
+#include "include.h"
+#include "host_test.h"
+#include "bsp_sched.c"
+
+#define SIM_SEC             600
+#define SIM_TICKS           (SIM_SEC * 200)
+
+//模型参数(us), 中断里每部分的大概耗时, 不是实测
+#define COST_TICK           2           //原来的%判断, 或者时间轮处理一个有任务到期的tick
+#define COST_IDLE           1           //没有任务到期, sched_tick直接返回
+#define COST_DETECT         3           //一个插拔检测(读IO, 滤波)
+#define COST_GROUP          5           //20ms/50ms/100ms/500ms/1s的一组任务
+#define COST_KEY_SCAN       4           //bsp_key_scan: 取ADC值, 查表, 消抖
+#define COST_DAC_FADE       1           //dac_fade_process, 不在淡入淡出时只判一下状态
+#define COST_PLUGIN         1           //plugin_tmr5ms_isr
+#define COST_PER_TICK       (COST_KEY_SCAN + COST_DAC_FADE + COST_PLUGIN)
+#define DET_NUM             3
+
+static unsigned long cnt_detect, cnt_group;
+static u8 det_in[DET_NUM];              //SD, LINEIN, USB的输入状态
+static u8 usb_det_sta;                  //usb_detect读到的结果, probe直接返回
+static u32 det_last[DET_NUM];
+static u32 det_max_gap[DET_NUM];        //稳定状态下两次检测的最大间隔
+static u32 det_change[DET_NUM];         //输入变化的tick
+static u32 det_max_delay[DET_NUM];
+static u32 grp_last[5], grp_err;
+static const u8 grp_period[5] = {4, 10, 20, 100, 200};
+
+static void det_run(int k)
+{
+    u32 now = sched_cb.ticks;
+    if (det_last[k] && now - det_last[k] > det_max_gap[k]) {
+        det_max_gap[k] = now - det_last[k];
+    }
+    det_last[k] = now;
+    if (det_change[k]) {
+        if (now - det_change[k] > det_max_delay[k]) {
+            det_max_delay[k] = now - det_change[k];
+        }
+        det_change[k] = 0;
+    }
+    cnt_detect++;
+}
+
+void sd_detect(void)            { det_run(0); }
+void linein_detect(void)        { det_run(1); }
+void usb_detect(void)           { det_run(2); usb_det_sta = det_in[2]; }
+static u8 sd_probe(void)        { return det_in[0]; }
+static u8 linein_probe(void)    { return det_in[1]; }
+static u8 usb_probe(void)       { return usb_det_sta; }
+
+static void grp_run(int k)
+{
+    u32 now = sched_cb.ticks;
+    if (grp_last[k] && now - grp_last[k] != grp_period[k]) {
+        grp_err++;
+    }
+    grp_last[k] = now;
+    cnt_group++;
+}
+
+static void tmr20ms_job(void)   { grp_run(0); }
+static void tmr50ms_job(void)   { grp_run(1); }
+static void tmr100ms_job(void)  { grp_run(2); }
+static void tmr500ms_job(void)  { grp_run(3); }
+static void tmr1s_job(void)     { grp_run(4); }
+
+static u8 det_job[DET_NUM];
+
+static void sim_init(void)
+{
+    sched_init();
+    det_job[2] = sched_job_add(usb_detect, 1, 0, usb_probe);
+    det_job[0] = sched_job_add(sd_detect, 1, 0, sd_probe);
+    det_job[1] = sched_job_add(linein_detect, 1, 0, linein_probe);
+    sched_job_add(tmr20ms_job, 4, 1, NULL);
+    sched_job_add(tmr50ms_job, 10, 2, NULL);
+    sched_job_add(tmr100ms_job, 20, 3, NULL);
+    sched_job_add(tmr500ms_job, 100, 5, NULL);
+    sched_job_add(tmr1s_job, 200, 7, NULL);
+}
+
+int main(void)
+{
+    srand(32);
+
+    //原来的usr_tmr5ms_isr: 每个tick三个检测, %10/%20/%100/%200判断, 20ms的分支实际50ms一次
+    unsigned long old_detect = (unsigned long)DET_NUM * SIM_TICKS;
+    unsigned long old_group = SIM_TICKS / 10 * 2 + SIM_TICKS / 20 + SIM_TICKS / 100 + SIM_TICKS / 200;
+    unsigned long old_us = SIM_TICKS * (COST_PER_TICK + COST_TICK) + old_detect * COST_DETECT + old_group * COST_GROUP;
+
+    sim_init();
+    unsigned long plugs = 0;
+    for (u32 t = 0; t < SIM_TICKS; t++) {
+        //平均20s插拔一次
+        if (rand() % 4000 == 0) {
+            int k = rand() % DET_NUM;
+            det_in[k] = !det_in[k];
+            det_change[k] = sched_cb.ticks + 1;
+            plugs++;
+        }
+        sched_tick();
+    }
+    const sched_stat_t *st = sched_get_stat();
+    unsigned long busy = SIM_TICKS - st->idle;
+    unsigned long new_us = SIM_TICKS * COST_PER_TICK + busy * COST_TICK + st->idle * COST_IDLE +
+                           cnt_detect * COST_DETECT + cnt_group * COST_GROUP;
+    CHECK(st->run == cnt_detect + cnt_group);
+
+    (printf)("%d s, %lu plug events, timer interrupts 200/s in both cases\n", SIM_SEC, plugs);
+    (printf)("per-tick work (key scan, dac fade, plugin): %d us/s\n", 200 * COST_PER_TICK);
+    (printf)("old fan-out: jobs %6.1f/s, ticks with jobs %5.1f/s, isr %5.0f us/s\n",
+             (old_detect + old_group) / (double)SIM_SEC, 200.0, old_us / (double)SIM_SEC);
+    (printf)("wheel:       jobs %6.1f/s, ticks with jobs %5.1f/s, isr %5.0f us/s, backoff %u\n",
+             st->run / (double)SIM_SEC, busy / (double)SIM_SEC, new_us / (double)SIM_SEC, st->backoff);
+    (printf)("detect sd/linein/usb: max stable gap %lu/%lu/%lu ticks, max delay after change %lu/%lu/%lu ticks\n",
+             (unsigned long)det_max_gap[0], (unsigned long)det_max_gap[1], (unsigned long)det_max_gap[2],
+             (unsigned long)det_max_delay[0], (unsigned long)det_max_delay[1], (unsigned long)det_max_delay[2]);
+
+    //定时任务周期不变(DNR 20ms), 检测最多退避到8倍, 变化后最多一个退避周期被检测到
+    CHECK(grp_err == 0);
+    for (int k = 0; k < DET_NUM; k++) {
+        CHECK(det_max_gap[k] == (1 << SCHED_BACKOFF_MAX) && det_max_delay[k] < (1 << SCHED_BACKOFF_MAX));
+    }
+    CHECK(busy * 3 < SIM_TICKS * 2 && new_us * 3 < old_us * 2);
+
+    //唤醒后kick: 下一个tick就检测, 之后从5ms开始重新退避
+    for (int i = 0; i < 200; i++) {
+        sched_tick();
+    }
+    u32 t0 = sched_cb.ticks;
+    det_last[1] = 0;
+    sched_job_kick(det_job[1]);
+    sched_tick();
+    CHECK(det_last[1] == t0 + 1);
+    sched_tick();
+    CHECK(det_last[1] == t0 + 2);
+
+    //probe忙的时候不计入退避
+    sim_init();
+    memset(det_last, 0, sizeof(det_last));
+    det_in[0] = SCHED_PROBE_BUSY;
+    for (int i = 0; i < 400; i++) {
+        sched_tick();
+    }
+    CHECK(sched_cb.job[det_job[0]].shift == 0);
+
+    //超过一圈的周期
+    sim_init();
+    memset(grp_last, 0, sizeof(grp_last));
+    grp_err = 0;
+    for (int i = 0; i < 2000; i++) {
+        sched_tick();
+    }
+    CHECK(grp_err == 0 && grp_last[4] != 0);
+    (printf)("PASS\n");
+    return 0;
+}
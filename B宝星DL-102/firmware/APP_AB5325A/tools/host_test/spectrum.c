@@ -0,0 +1,221 @@
+//bsp_spectrum频谱: 正弦/双音/噪声/随机单音(44.1k立体声, 16k单声道)抽取后算定点FFT, 和双精度加窗DFT逐点比较SNR,
+//按频段比较能量. 再检查log2近似误差, 包络的峰值保持和下降, 没有PCM时的VU, 统计每帧的CPU(主机周期)
+#include "include.h"
+#include "host_test.h"
+#include <math.h>
+
+#ifdef SPECTRUM_TEST_N
+#undef SPECTRUM_FFT_N
+#define SPECTRUM_FFT_N              SPECTRUM_TEST_N
+#endif
+
+#include "bsp_spectrum.c"
+
+#define SIM_RAND_TONES      200
+#define SIM_BENCH_ITERS     20000
+#define BAND_MIN_DB         30          //只比较能量在这之上(约-50dBFS)的频段
+
+u16 dac_pcm_pow_get(void)
+{
+    return 0;
+}
+
+static double ref_re[SPECTRUM_FFT_N], ref_im[SPECTRUM_FFT_N];
+static s16 pcm[SPECTRUM_FFT_N * 4 * 2];
+static double worst_snr = 1e9, worst_band_db;
+
+//双精度参考: 和定点相同的抽取结果, Hann窗, 除以N, 再乘0.5(定点加窗后多右移1位)
+static void ref_dft(const s16 *x)
+{
+    for (int k = 0; k < SPECTRUM_FFT_N; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < SPECTRUM_FFT_N; n++) {
+            double v = x[n] * 0.5 * (1 - cos(2 * M_PI * n / SPECTRUM_FFT_N)) * 0.5;
+            re += v * cos(2 * M_PI * k * n / SPECTRUM_FFT_N);
+            im -= v * sin(2 * M_PI * k * n / SPECTRUM_FFT_N);
+        }
+        ref_re[k] = re / SPECTRUM_FFT_N;
+        ref_im[k] = im / SPECTRUM_FFT_N;
+    }
+}
+
+static double noise(void)
+{
+    return rand() / 1073741823.5 - 1;
+}
+
+//送一帧PCM(20ms节拍), 算FFT后和参考比较, name为NULL时只算不统计
+static void run(const char *name, double f1, double a1, double f2, double a2, double na, u8 spr, int ch)
+{
+    double fs = (spr == SPR_16000) ? 16000 : 44100;
+    int samples = SPECTRUM_FFT_N * ((fs > 24000) ? 4 : 2);
+    for (int i = 0; i < samples; i++) {
+        double v = a1 * sin(2 * M_PI * f1 * i / fs) + a2 * sin(2 * M_PI * f2 * i / fs) + na * noise();
+        v = (v > 32767) ? 32767 : (v < -32768) ? -32768 : v;
+        if (ch) {
+            pcm[2 * i] = v;
+            pcm[2 * i + 1] = v;
+        } else {
+            pcm[i] = v;
+        }
+    }
+    host_ms += 20;
+    spectrum_pcm_input((u8 *)pcm, samples, ch, spr);
+    CHECK(spectrum_cb.ready);
+    CHECK(spectrum_process() && !spectrum_cb.ready);
+    if (name == NULL) {
+        return;
+    }
+
+    ref_dft(spectrum_cb.buf[spectrum_cb.wbuf ^ 1]);
+    double err = 0, sig = 0, band_fix[SPECTRUM_BAND_NUM] = {0}, band_ref[SPECTRUM_BAND_NUM] = {0};
+    double sc = 1.0 / (1 << spectrum_cb.shift);
+    for (int p = 0; p < SPECTRUM_FFT_N; p++) {
+        int k = spectrum_pos_to_bin(p);
+        double re = spectrum_cb.x[p].re * sc, im = spectrum_cb.x[p].im * sc;
+        double dr = re - ref_re[k], di = im - ref_im[k];
+        err += dr * dr + di * di;
+        sig += ref_re[k] * ref_re[k] + ref_im[k] * ref_im[k];
+        u8 b = spectrum_cb.pos_band[p];
+        if (b != SPECTRUM_NONE) {
+            band_fix[b] += re * re + im * im;
+            band_ref[b] += ref_re[k] * ref_re[k] + ref_im[k] * ref_im[k];
+        }
+    }
+    double snr = 10 * log10(sig / (err + 1e-12));
+    if (sig > 1e4 && snr < worst_snr) {
+        worst_snr = snr;
+    }
+    if (name[0]) {
+        (printf)("%-20s SNR %5.1f dB, band dB fix/ref:", name, snr);
+    }
+    for (int b = 0; b < SPECTRUM_BAND_NUM; b++) {
+        double df = 10 * log10(band_fix[b] + 1e-9), dr = 10 * log10(band_ref[b] + 1e-9);
+        if (dr > BAND_MIN_DB && fabs(df - dr) > worst_band_db) {
+            worst_band_db = fabs(df - dr);
+        }
+        if (name[0]) {
+            (printf)(" %5.1f/%5.1f", df, dr);
+        }
+    }
+    if (name[0]) {
+        (printf)("  level:");
+        for (int b = 0; b < SPECTRUM_BAND_NUM; b++) {
+            (printf)(" %d", spectrum_get_level(b));
+        }
+        (printf)("\n");
+    }
+}
+
+int main(void)
+{
+    srand(50);
+    host_ms = 1000;
+    spectrum_init();
+
+    //每个频段至少一个频点, 直流和负频率不计入
+    int cnt[SPECTRUM_BAND_NUM] = {0};
+    for (int p = 0; p < SPECTRUM_FFT_N; p++) {
+        u8 b = spectrum_cb.pos_band[p];
+        if (b != SPECTRUM_NONE) {
+            CHECK(spectrum_pos_to_bin(p) > 0 && spectrum_pos_to_bin(p) <= SPECTRUM_FFT_N / 2);
+            cnt[b]++;
+        }
+    }
+    (printf)("N=%d, bins per band:", SPECTRUM_FFT_N);
+    for (int b = 0; b < SPECTRUM_BAND_NUM; b++) {
+        (printf)(" %d", cnt[b]);
+        CHECK(cnt[b] > 0);
+    }
+    (printf)("\n");
+
+    //log2近似误差
+    double lerr = 0;
+    for (uint x = 1; x < 0x80000000u; x = x + x / 100 + 1) {
+        double e = fabs(spectrum_log2(x) / 256.0 - log2(x));
+        lerr = (e > lerr) ? e : lerr;
+    }
+    (printf)("log2 max error %.3f (%.2f dB)\n", lerr, lerr * 3.01);
+    CHECK(lerr < 0.1);
+
+    run("sine 200Hz 0dBFS", 200, 32000, 0, 0, 0, SPR_44100, 1);
+    CHECK(spectrum_get_level(0) == SPECTRUM_LEVEL_MAX);
+    run("sine 1kHz -20dB", 1000, 3200, 0, 0, 0, SPR_44100, 1);
+    run("sine 4kHz -6dB", 4000, 16000, 0, 0, 0, SPR_44100, 0);
+    run("two-tone 150+3k", 150, 16000, 3000, 8000, 0, SPR_44100, 1);
+    run("sine 500Hz -40dB", 500, 320, 0, 0, 0, SPR_44100, 1);
+    run("noise -10dB", 0, 0, 0, 0, 10000, SPR_44100, 1);
+    run("mic 16k 1kHz", 1000, 12000, 0, 0, 0, SPR_16000, 0);
+    run("mic 16k two-tone", 300, 10000, 2500, 10000, 200, SPR_16000, 0);
+    for (int i = 0; i < SIM_RAND_TONES; i++) {
+        double f = 60 + rand() % 5000, a = 100 + rand() % 30000;
+        run("", f, a, 0, 0, a / 20, SPR_44100, 1);
+    }
+    (printf)("worst bin SNR %.1f dB, worst band error %.2f dB (bands above -50dBFS)\n", worst_snr, worst_band_db);
+    CHECK(worst_snr > 45 && worst_band_db < 1);
+
+    //包络: 满幅后静音, 峰值保持SPECTRUM_HOLD帧, 显示级数每帧下降SPECTRUM_DECAY
+    spectrum_init();
+    run(NULL, 200, 32000, 0, 0, 0, SPR_44100, 1);
+    CHECK(spectrum_get_level(0) == SPECTRUM_LEVEL_MAX && spectrum_get_peak(0) == SPECTRUM_LEVEL_MAX);
+    int last = SPECTRUM_LEVEL_MAX, zero_at = 0, level0 = spectrum_cb.env[0].level;
+    (printf)("decay (frame:level/peak):");
+    for (int f = 1; f <= 80; f++) {
+        run(NULL, 200, 0, 0, 0, 0, SPR_44100, 1);
+        CHECK(spectrum_get_level(0) <= last);
+        last = spectrum_get_level(0);
+        if (f <= SPECTRUM_HOLD) {
+            CHECK(spectrum_get_peak(0) == SPECTRUM_LEVEL_MAX);
+        }
+        if (!zero_at && last == 0) {
+            zero_at = f;
+        }
+        if (f % 10 == 0) {
+            (printf)(" %d:%d/%d", f, last, spectrum_get_peak(0));
+        }
+    }
+    (printf)("\n");
+    CHECK(zero_at == (level0 - 128) / SPECTRUM_DECAY + 1);         //按Q8四舍五入显示
+    CHECK(spectrum_get_peak(0) == 0);
+
+    //没有PCM: SPECTRUM_TIMEOUT后不算FFT, 5ms节拍里改用dac_pcm_pow_get()画VU
+    host_ms += SPECTRUM_TIMEOUT;
+    CHECK(!spectrum_is_active() && !spectrum_process());
+    static const u16 pows[] = {100, 600, 1500, 5000, 15000, 45000};
+    int bars = 0;
+    (printf)("vu pow -> levels:");
+    for (u8 i = 0; i < sizeof(pows) / sizeof(pows[0]); i++) {
+        spectrum_init();
+        spectrum_vu_process(pows[i]);
+        int sum = 0;
+        (printf)(" %d:[", pows[i]);
+        for (int b = 0; b < SPECTRUM_BAND_NUM; b++) {
+            (printf)("%s%d", b ? " " : "", spectrum_get_level(b));
+            sum += spectrum_get_level(b);
+        }
+        (printf)("]");
+        CHECK(sum >= bars);
+        bars = sum;
+    }
+    (printf)("\n");
+    CHECK(bars == SPECTRUM_BAND_NUM * SPECTRUM_LEVEL_MAX);
+
+    //每帧耗时: 每次重新置ready, 包括加窗/FFT/分频段/包络
+    spectrum_init();
+    run(NULL, 1000, 16000, 3000, 4000, 300, SPR_44100, 1);
+    unsigned long long best = ~0ull, best_fft = ~0ull;
+    for (int i = 0; i < SIM_BENCH_ITERS; i++) {
+        spectrum_cb.ready = 1;
+        unsigned long long t = host_rdtsc();
+        spectrum_process();
+        t = host_rdtsc() - t;
+        best = (t < best) ? t : best;
+        t = host_rdtsc();
+        spectrum_fft(spectrum_cb.x);
+        t = host_rdtsc() - t;
+        best_fft = (t < best_fft) ? t : best_fft;
+    }
+    (printf)("cycles per frame (host, min of %d): process %llu, fft %llu\n", SIM_BENCH_ITERS, best, best_fft);
+    (printf)("PASS\n");
+    return 0;
+}
@@ -0,0 +1,3 @@
+//spectrum.c用128点FFT(多一级基2)对比
+#define SPECTRUM_TEST_N             128
+#include "spectrum.c"
@@ -0,0 +1,157 @@
+//APP_LINK帧经bt_app_cmd_process到bt_app_cmd_exec: 在线EQ要打开eq_dgb_spp_en才执行, eq_rx_buf只有一份,
+//同一批里两包EQ时第二包被拒并回APP_ACK_CMD_ERR, 上一包处理完(EVT_ONLINE_SET_EQ)以后才能收下一包
+#include "include.h"
+#include "host_test.h"
+
+#undef printf
+#undef print_r
+#define printf(...)
+#define print_r(...)
+
+#include "bsp_app_link.c"
+#include "bsp_spp.c"
+
+xcfg_cb_t xcfg_cb;
+eq_dbg_cb_t eq_dbg_cb;
+u8 eq_rx_buf[EQ_BUFFER_LEN];
+
+static unsigned long ack_ok, ack_err, eq_msgs;
+static u8 last_ack;
+
+uint calc_crc(void *buf, uint len, uint seed)
+{
+    u8 *p = buf;
+    uint crc = seed;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc & 0xffff;
+}
+
+uint bt_get_status(void)
+{
+    return BT_STA_CONNECTED;
+}
+
+int bt_spp_tx(uint8_t *packet, uint16_t len)
+{
+    last_ack = packet[7];
+    if (last_ack == APP_ACK_OK) {
+        ack_ok++;
+    } else {
+        ack_err++;
+    }
+    return 0;
+}
+
+bool ble_send_packet(u8 *buf, u16 len)
+{
+    return true;
+}
+
+int eq_huart_putcs(uint8_t *packet, uint16_t len)
+{
+    return 0;
+}
+
+void msg_enqueue(u16 msg)
+{
+    if (msg == EVT_ONLINE_SET_EQ) {
+        eq_msgs++;
+    }
+}
+
+void pwm_rgb_write(u8 red, u8 green, u8 blue)
+{
+}
+
+void pwm_rgb_close(void)
+{
+}
+
+//主循环处理EVT_ONLINE_SET_EQ, 和func_message里一样
+static void eq_done(void)
+{
+    memset(eq_rx_buf, 0, sizeof(eq_rx_buf));
+    eq_dbg_cb.rx_busy = 0;
+}
+
+static u8 tx_seq;
+
+//一次传输: neq包EQ(每包fill填满), 后面跟一条RGB命令, 整个传输放在一帧或多帧里
+static void tx_xfer(int neq, u8 fill)
+{
+    static u8 buf[APP_LINK_XFER_SIZE], frm[APP_LINK_HEAD_LEN + APP_LINK_PAYLOAD_MAX + 2];
+    u16 len = 0;
+    for (int e = 0; e < neq; e++) {
+        buf[len++] = APP_CMD_EQ;
+        buf[len++] = 100;
+        buf[len++] = 0;
+        memset(&buf[len], fill + e, 100);
+        len += 100;
+    }
+    buf[len++] = APP_CMD_RGB;
+    buf[len++] = 4;
+    buf[len++] = 0;
+    memset(&buf[len], 0, 4);
+    len += 4;
+    for (u16 pos = 0; pos < len; pos += APP_LINK_PAYLOAD_MAX) {
+        u16 n = len - pos;
+        u8 flag = 0;
+        if (n > APP_LINK_PAYLOAD_MAX) {
+            n = APP_LINK_PAYLOAD_MAX;
+            flag |= APP_FRM_MORE;
+        }
+        frm[0] = APP_LINK_SYNC0;
+        frm[1] = APP_LINK_SYNC1;
+        frm[2] = n;
+        frm[3] = n >> 8;
+        frm[4] = tx_seq++;
+        frm[5] = flag;
+        memcpy(&frm[APP_LINK_HEAD_LEN], &buf[pos], n);
+        u16 crc = calc_crc(&frm[2], APP_LINK_HEAD_LEN - 2 + n, APP_LINK_CRC_SEED);
+        frm[APP_LINK_HEAD_LEN + n] = crc;
+        frm[APP_LINK_HEAD_LEN + n + 1] = crc >> 8;
+        bt_app_cmd_process(frm, APP_LINK_HEAD_LEN + n + 2);
+    }
+}
+
+int main(void)
+{
+    app_link_init();
+
+    //1. eq_dgb_spp_en没打开: EQ命令被拒, 不动eq_rx_buf
+    xcfg_cb.eq_dgb_spp_en = 0;
+    tx_xfer(1, 0x11);
+    CHECK(last_ack == APP_ACK_CMD_ERR && eq_msgs == 0 && eq_rx_buf[0] == 0 && !eq_dbg_cb.rx_busy);
+
+    //2. 打开后单包EQ正常执行
+    xcfg_cb.eq_dgb_spp_en = 1;
+    tx_xfer(1, 0x22);
+    CHECK(last_ack == APP_ACK_OK && eq_msgs == 1 && eq_rx_buf[99] == 0x22 && eq_dbg_cb.rx_busy);
+
+    //3. 上一包还没处理: 新的EQ被拒, eq_rx_buf里还是上一包
+    tx_xfer(1, 0x33);
+    CHECK(last_ack == APP_ACK_CMD_ERR && eq_msgs == 1 && eq_rx_buf[0] == 0x22);
+    eq_done();
+
+    //4. 同一批两包EQ: 第一包收下, 第二包被拒, 后面的RGB命令照常执行
+    unsigned long err0 = app_link_get_stat()->cmd_err;
+    tx_xfer(2, 0x44);
+    (printf)("eq batch of 2: ack %d, eq msgs %lu, buf 0x%02x, cmd_err %d\n",
+             last_ack, eq_msgs, eq_rx_buf[0], app_link_get_stat()->cmd_err);
+    CHECK(last_ack == APP_ACK_CMD_ERR && eq_msgs == 2 && eq_rx_buf[0] == 0x44 && eq_rx_buf[99] == 0x44);
+    CHECK(app_link_get_stat()->cmd_err == err0 + 1);
+    eq_done();
+
+    //5. 处理完以后又能收
+    tx_xfer(1, 0x55);
+    CHECK(last_ack == APP_ACK_OK && eq_msgs == 3 && eq_rx_buf[0] == 0x55);
+    (printf)("ack ok %lu err %lu\n", ack_ok, ack_err);
+    CHECK(ack_ok == 2 && ack_err == 3);
+    (printf)("PASS\n");
+    return 0;
+}
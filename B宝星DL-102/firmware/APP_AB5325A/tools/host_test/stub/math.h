@@ -0,0 +1,12 @@
+#ifndef _HOST_STUB_MATH_H
+#define _HOST_STUB_MATH_H
+
+//主机测试用: 算双精度参考值, 链接-lm
+#define M_PI                        3.14159265358979323846
+double sin(double x);
+double cos(double x);
+double fabs(double x);
+double log2(double x);
+double log10(double x);
+
+#endif
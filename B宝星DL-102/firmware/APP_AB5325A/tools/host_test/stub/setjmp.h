@@ -0,0 +1,10 @@
+#ifndef _HOST_STUB_SETJMP_H
+#define _HOST_STUB_SETJMP_H
+
+//主机测试用: 模拟掉电时从flash操作里跳回测试主循环, 大小按glibc的jmp_buf留足
+typedef long jmp_buf[64];
+int _setjmp(jmp_buf env);
+void longjmp(jmp_buf env, int val);
+#define setjmp(env)                 _setjmp(env)
+
+#endif
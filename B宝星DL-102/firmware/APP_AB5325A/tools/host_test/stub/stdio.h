@@ -0,0 +1,10 @@
+#ifndef _HOST_STUB_STDIO_H
+#define _HOST_STUB_STDIO_H
+
+//主机测试用: 只声明输出文件用到的函数, printf在host_test.h里
+typedef struct _IO_FILE FILE;
+FILE *fopen(const char *path, const char *mode);
+unsigned int fwrite(const void *ptr, unsigned int size, unsigned int n, FILE *fp);
+int fclose(FILE *fp);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _HOST_STUB_STDLIB_H
+#define _HOST_STUB_STDLIB_H
+
+//主机测试用: 固件头文件以-nostdinc编译, 只声明用到的libc函数
+void *malloc(unsigned int size);
+void free(void *ptr);
+int abs(int x);
+int rand(void);
+void srand(unsigned int seed);
+void abort(void);
+
+#endif
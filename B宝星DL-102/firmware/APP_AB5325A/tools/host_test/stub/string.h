@@ -0,0 +1,13 @@
+#ifndef _HOST_STUB_STRING_H
+#define _HOST_STUB_STRING_H
+
+//主机测试用: size_t在typedef.h里是unsigned int, 这里按同样的类型声明
+void *memcpy(void *dst, const void *src, unsigned int len);
+void *memset(void *dst, int val, unsigned int len);
+void *memmove(void *dst, const void *src, unsigned int len);
+int memcmp(const void *a, const void *b, unsigned int len);
+unsigned int strlen(const char *str);
+char *strcpy(char *dst, const char *src);
+int strcmp(const char *a, const char *b);
+
+#endif
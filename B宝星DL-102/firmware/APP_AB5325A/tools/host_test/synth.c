@@ -0,0 +1,134 @@
+//bsp_synth提示音合成: 每个tone渲染成build/synth/tone_N.wav, 检查时长/峰值/有没有爆音,
+//混音到已有PCM是否正确, 统计每个样点的CPU(主机周期)
+#include "include.h"
+#include "host_test.h"
+#include <stdio.h>
+#include "bsp_synth.c"
+
+#define SIM_BLOCK           128         //sdadc回调一次的样点数
+#define SIM_GAIN            0x5000      //piano数字音量, Q15
+#define SIM_MAX_SAMPLES     (48000 * 3)
+
+u32 get_piano_digvol(void)
+{
+    return SIM_GAIN;
+}
+
+static s16 pcm[SIM_MAX_SAMPLES * 2];
+
+static void wav_put32(u8 *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static void wav_write(const char *path, const s16 *buf, unsigned int samples, unsigned int spr)
+{
+    u8 hdr[44];
+    memcpy(hdr, "RIFF\0\0\0\0WAVEfmt \x10\0\0\0\x01\0\x02\0\0\0\0\0\0\0\0\0\x04\0\x10\0data", 40);
+    wav_put32(&hdr[4], 36 + samples * 4);
+    wav_put32(&hdr[24], spr);
+    wav_put32(&hdr[28], spr * 4);
+    wav_put32(&hdr[40], samples * 4);
+    FILE *fp = fopen(path, "wb");
+    CHECK(fp != NULL);
+    fwrite(hdr, 1, sizeof(hdr), fp);
+    fwrite(buf, 4, samples, fp);
+    fclose(fp);
+}
+
+//渲染一个提示音, 双声道, 返回样点数
+static unsigned int render(uint index, u8 spr, unsigned long long *cycles)
+{
+    unsigned int n = 0;
+    memset(pcm, 0, sizeof(pcm));
+    bsp_synth_init();
+    bsp_synth_mix((u8 *)pcm, 0, 1, spr);            //数据流已经在跑
+    CHECK(bsp_synth_start(index));
+    unsigned long long t0 = host_rdtsc();
+    while (bsp_synth_is_busy()) {
+        CHECK(n + SIM_BLOCK <= SIM_MAX_SAMPLES);
+        bsp_synth_mix((u8 *)&pcm[n * 2], SIM_BLOCK, 1, spr);
+        n += SIM_BLOCK;
+    }
+    *cycles = host_rdtsc() - t0;
+    return n;
+}
+
+int main(void)
+{
+    const unsigned int tone_num = sizeof(synth_prompt_tbl) / sizeof(synth_prompt_t);
+    unsigned long long cycles, total_cycles = 0, total_samples = 0;
+    char path[64];
+
+    for (uint t = 0; t < tone_num; t++) {
+        const synth_prompt_t *p = &synth_prompt_tbl[t];
+        unsigned int ms = 0, fmax = 0;
+        for (u8 i = 0; i < p->len; i++) {
+            ms += p->tbl[i].time;
+            if (p->tbl[i].freq > fmax) {
+                fmax = p->tbl[i].freq;
+            }
+        }
+        unsigned int n = render(t, SPR_48000, &cycles);
+        total_cycles += cycles;
+        total_samples += n;
+
+        int peak = 0, step = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            CHECK(pcm[i * 2] == pcm[i * 2 + 1]);
+            if (abs(pcm[i * 2]) > peak) {
+                peak = abs(pcm[i * 2]);
+            }
+            if (i && abs(pcm[i * 2] - pcm[i * 2 - 2]) > step) {
+                step = abs(pcm[i * 2] - pcm[i * 2 - 2]);
+            }
+        }
+        //相邻样点最大差: 正弦表256点不插值, 每个样点最多跨ceil(256 * f / fs)个表项, 每项最多差804(Q15),
+        //包络或相位跳变(爆音)会远超过这个值
+        int step_max = SIM_GAIN * 804 / 32767 * (256 * fmax / 48000 + 1) + 64;
+        sprintf(path, "build/synth/tone_%u.wav", t);
+        wav_write(path, pcm, n, 48000);
+        (printf)("tone %u: %4u ms (table %4u ms), peak %5d, max step %5d (limit %5d), %.1f cycles/sample\n",
+                 t, n / 48, ms, peak, step, step_max, (double)cycles / n);
+        CHECK(n / 48 >= ms && n / 48 <= ms + 1 + SIM_BLOCK / 48);
+        CHECK(peak <= SIM_GAIN && peak > SIM_GAIN / 2);
+        CHECK(step <= step_max);
+        CHECK(abs(pcm[(n - 1) * 2]) < 64);                              //结束时淡出到0
+    }
+    (printf)("all tones: %.1f cycles/sample (host, %d voices)\n", (double)total_cycles / total_samples, SYNTH_VOICE_NUM);
+
+    //采样率不同时长不变
+    unsigned int n16 = render(TONE_POWER_ON, SPR_16000, &cycles);
+    unsigned int n48 = render(TONE_POWER_ON, SPR_48000, &cycles);
+    CHECK(abs((int)(n16 * 3) - (int)n48) <= SIM_BLOCK * 3);
+
+    //混音: 结果 = 原PCM + 合成的提示音
+    static s16 tone[SIM_MAX_SAMPLES * 2];
+    memcpy(tone, pcm, n48 * 4);
+    for (unsigned int i = 0; i < n48 * 2; i++) {
+        pcm[i] = (i & 0x3f) * 256 - 8192;
+    }
+    bsp_synth_init();
+    bsp_synth_mix((u8 *)pcm, 0, 1, SPR_48000);
+    bsp_synth_start(TONE_POWER_ON);
+    for (unsigned int n = 0; n < n48; n += SIM_BLOCK) {
+        bsp_synth_mix((u8 *)&pcm[n * 2], SIM_BLOCK, 1, SPR_48000);
+    }
+    for (unsigned int i = 0; i < n48 * 2; i++) {
+        int exp = (i & 0x3f) * 256 - 8192 + tone[i];
+        exp = exp > 32767 ? 32767 : exp < -32768 ? -32768 : exp;
+        CHECK(pcm[i] == exp);
+    }
+
+    //停止后不再混音
+    bsp_synth_start(TONE_BT_RING);
+    bsp_synth_stop();
+    memset(pcm, 0, SIM_BLOCK * 4);
+    bsp_synth_mix((u8 *)pcm, SIM_BLOCK, 1, SPR_48000);
+    CHECK(!bsp_synth_is_busy() && pcm[SIM_BLOCK - 1] == 0);
+    (printf)("PASS\n");
+    return 0;
+}
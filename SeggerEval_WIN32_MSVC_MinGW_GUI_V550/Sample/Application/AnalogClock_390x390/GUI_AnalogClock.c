@@ -45,13 +45,19 @@ Additional information:
 **********************************************************************
 */
 typedef struct {
-  WM_HWIN    hWin;
-  U16        Index;
-  U16        LastIndex;
-  U16        Destination;
-  U16        NumItems;
-  U8         Time;
-  U8         AnimInProgress;
+  WM_HWIN           hWin;
+  U16               Index;
+  U16               LastIndex;
+  U16               Destination;
+  U16               NumItems;
+  U8                Time;
+  U8                AnimInProgress;
+  GUI_POINT       * pPos;        // Tip positions of the hand
+  GUI_MEMDEV_Handle hMem;        // Pre-rendered hand, 0 if the hand is drawn directly
+  GUI_RECT          Rect;        // Bounding box of the hand at IndexDrawn
+  U16               IndexDrawn;  // Position the bounding box (and sprite) belongs to
+  U8                PenSize;
+  U8                UseSprite;
 } ANIM_DATA;
 
 /*********************************************************************
@@ -110,6 +116,17 @@ typedef struct {
 #define TIME_M   59
 #define TIME_H   15
 
+//
+// 1: Invalidate only the area swept by a moving hand and draw the
+//    minute and hour hand from pre-rendered memory devices
+// 0: Invalidate and redraw the complete clock on each animation step
+//
+#define CLOCK_OPTIMIZE  1
+
+#define INDEX_NONE      0xFFFF
+
+#define TIME_STAT       1000
+
 /*********************************************************************
 *
 *       Static data
@@ -15740,6 +15757,15 @@ static GUI_POINT _aSecPos[3600];
 static GUI_POINT _aMinPos[3600];
 static GUI_POINT _aHourPos[3600];
 
+//
+// Statistics shown in the upper left corner
+//
+static GUI_RECT _RectStat = { 4, 4, 120, 34 };
+static U32      _NumFrames;
+static U32      _NumPixels;
+static U32      _Fps;
+static U32      _PixelsPerFrame;
+
 /*********************************************************************
 *
 *       Static code
@@ -15791,6 +15817,119 @@ static void _DrawIndicator(GUI_POINT Point, GUI_COLOR Color, int PenSize) {
   GUI_AA_SetFactor(AAFactorOld);
 }
 
+/*********************************************************************
+*
+*       _GetHandRect
+*
+* Function description
+*   Calculates the bounding box of a hand including pen size and the
+*   anti-aliased border.
+*/
+static void _GetHandRect(ANIM_DATA * pData, int Index, GUI_RECT * pRect) {
+  int xCenter;
+  int yCenter;
+  int xTip;
+  int yTip;
+  int Margin;
+
+  xCenter = LCD_GetXSize() >> 1;
+  yCenter = LCD_GetYSize() >> 1;
+  xTip    = pData->pPos[Index].x / AA_FACTOR;
+  yTip    = pData->pPos[Index].y / AA_FACTOR;
+  Margin  = pData->PenSize + 1;
+  pRect->x0 = GUI_MIN(xCenter, xTip) - Margin;
+  pRect->y0 = GUI_MIN(yCenter, yTip) - Margin;
+  pRect->x1 = GUI_MAX(xCenter, xTip) + Margin;
+  pRect->y1 = GUI_MAX(yCenter, yTip) + Margin;
+}
+
+/*********************************************************************
+*
+*       _RenderHand
+*
+* Function description
+*   Calculates the bounding box of the hand at its current position and,
+*   if enabled for the hand, renders it anti-aliased into a transparent
+*   32bpp memory device. The device is kept until the hand moves.
+*/
+static void _RenderHand(ANIM_DATA * pData) {
+  GUI_MEMDEV_Handle hMemOld;
+  unsigned          PreserveTransOld;
+
+  _GetHandRect(pData, pData->Index, &pData->Rect);
+  pData->IndexDrawn = pData->Index;
+  if (pData->UseSprite == 0) {
+    return;
+  }
+  if (pData->hMem) {
+    GUI_MEMDEV_Delete(pData->hMem);
+  }
+  pData->hMem = GUI_MEMDEV_CreateFixed32(pData->Rect.x0, pData->Rect.y0, pData->Rect.x1 - pData->Rect.x0 + 1, pData->Rect.y1 - pData->Rect.y0 + 1);
+  if (pData->hMem == 0) {
+    return;  // Not enough memory, the hand is drawn directly
+  }
+  hMemOld = GUI_MEMDEV_Select(pData->hMem);
+  GUI_SetBkColor(GUI_TRANSPARENT);
+  GUI_Clear();
+  //
+  // Keep the alpha values of the anti-aliased pixels
+  //
+  PreserveTransOld = GUI_PreserveTrans(1);
+  _DrawIndicator(pData->pPos[pData->Index], GUI_BLACK, pData->PenSize);
+  GUI_PreserveTrans(PreserveTransOld);
+  GUI_MEMDEV_Select(hMemOld);
+}
+
+/*********************************************************************
+*
+*       _DrawHand
+*/
+static void _DrawHand(ANIM_DATA * pData) {
+  if (pData->hMem) {
+    GUI_MEMDEV_WriteAt(pData->hMem, pData->Rect.x0, pData->Rect.y0);
+  } else {
+    _DrawIndicator(pData->pPos[pData->Index], GUI_BLACK, pData->PenSize);
+  }
+}
+
+/*********************************************************************
+*
+*       _UpdateHand
+*
+* Function description
+*   Invalidates the area which needs to be redrawn after the hand has
+*   been moved, which is the union of the old and the new bounding box.
+*/
+static void _UpdateHand(ANIM_DATA * pData) {
+#if CLOCK_OPTIMIZE
+  GUI_RECT Rect;
+
+  if (pData->IndexDrawn == pData->Index) {
+    return;
+  }
+  Rect = pData->Rect;
+  _RenderHand(pData);
+  GUI_MergeRect(&Rect, &Rect, &pData->Rect);
+  WM_InvalidateRect(pData->hWin, &Rect);
+#else
+  WM_InvalidateWindow(pData->hWin);
+#endif
+}
+
+/*********************************************************************
+*
+*       _DrawStat
+*/
+static void _DrawStat(void) {
+  GUI_SetFont(GUI_FONT_13_ASCII);
+  GUI_SetColor(GUI_WHITE);
+  GUI_SetTextMode(GUI_TM_TRANS);
+  GUI_DispStringAt("fps: ", _RectStat.x0, _RectStat.y0);
+  GUI_DispDecMin(_Fps);
+  GUI_DispStringAt("pixels/frame: ", _RectStat.x0, _RectStat.y0 + 15);
+  GUI_DispDecMin(_PixelsPerFrame);
+}
+
 /*********************************************************************
 *
 *       _AnimateSecond
@@ -15802,7 +15941,6 @@ static void _AnimateSecond(GUI_ANIM_INFO * pInfo, void * pVoid) {
   pData  = (ANIM_DATA *)pVoid;
   pData->Index = pData->LastIndex + (pData->Destination * pInfo->Pos) / GUI_ANIM_RANGE;
   pData->Time = pData->Index / 60;
-  WM_InvalidateWindow(pData->hWin);
   if (pInfo->State == GUI_ANIM_END) {
     pData->LastIndex = pData->Index;
   }
@@ -15812,6 +15950,7 @@ static void _AnimateSecond(GUI_ANIM_INFO * pInfo, void * pVoid) {
     pData->Index = 0;
     pData->LastIndex = 0;
   }
+  _UpdateHand(pData);
 }
 
 /*********************************************************************
@@ -15829,7 +15968,6 @@ static void _AnimateMinute(GUI_ANIM_INFO * pInfo, void * pVoid) {
     Msg.MsgId = MSG_ANIM_HOUR;
     WM_BroadcastMessage(&Msg);
   }
-  WM_InvalidateWindow(pData->hWin);
   if (pInfo->State == GUI_ANIM_END) {
     pData->LastIndex = pData->Index;
   }
@@ -15837,6 +15975,7 @@ static void _AnimateMinute(GUI_ANIM_INFO * pInfo, void * pVoid) {
     pData->Index = 0;
     pData->LastIndex = 0;
   }
+  _UpdateHand(pData);
 }
 
 /*********************************************************************
@@ -15861,7 +16000,6 @@ static void _AnimateHour(GUI_ANIM_INFO * pInfo, void * pVoid) {
   pData->Index = pData->LastIndex + (pData->Destination * pInfo->Pos) / GUI_ANIM_RANGE;
   pData->Time = pData->Index / 300;
   
-  WM_InvalidateWindow(pData->hWin);
   if (pInfo->State == GUI_ANIM_END) {
     pData->LastIndex = pData->Index;
   }
@@ -15869,6 +16007,7 @@ static void _AnimateHour(GUI_ANIM_INFO * pInfo, void * pVoid) {
     pData->Index = 0;
     pData->LastIndex = 0;
   }
+  _UpdateHand(pData);
 }
 
 /*********************************************************************
@@ -15881,6 +16020,8 @@ static void _cbClock(WM_MESSAGE * pMsg) {
   int                      xSize;
   int                      ySize;
   int                      AAFactorOld;
+  unsigned                 i;
+  GUI_RECT               * pRect;
 
   switch (pMsg->MsgId) {
   case WM_CREATE:
@@ -15908,15 +16049,54 @@ static void _cbClock(WM_MESSAGE * pMsg) {
     aAnimData[HOUR].NumItems    = GUI_COUNTOF(_aHourPos);
     aAnimData[HOUR].LastIndex   = TIME_START_H(TIME_H);
 
+    aAnimData[SECOND].pPos      = _aSecPos;
+    aAnimData[SECOND].PenSize   = 3;
+    aAnimData[MINUTE].pPos      = _aMinPos;
+    aAnimData[MINUTE].PenSize   = 7;
+    aAnimData[HOUR].pPos        = _aHourPos;
+    aAnimData[HOUR].PenSize     = 8;
+#if CLOCK_OPTIMIZE
+    //
+    // The second hand moves on each step, a sprite would be rendered
+    // for each frame and never be reused. So it is drawn directly.
+    //
+    aAnimData[MINUTE].UseSprite = 1;
+    aAnimData[HOUR].UseSprite   = 1;
+#endif
+    for (i = 0; i < GUI_COUNTOF(aAnimData); i++) {
+      aAnimData[i].IndexDrawn = INDEX_NONE;
+      _RenderHand(&aAnimData[i]);
+    }
+    WM_CreateTimer(pMsg->hWin, 0, TIME_STAT, 0);
+
     ahAnim[SECOND] = GUI_ANIM_Create(TIME_ANIM, 10, (void *)&aAnimData[SECOND], NULL);
     GUI_ANIM_AddItem(ahAnim[SECOND], 0, TIME_ANIM, ANIM_LINEAR, (void *)&aAnimData[SECOND], _AnimateSecond);
     GUI_ANIM_StartEx(ahAnim[SECOND], -1, NULL);
     break;
+  case WM_TIMER:
+    //
+    // Update statistics once per second
+    //
+    _Fps            = (_NumFrames * 1000) / TIME_STAT;
+    _PixelsPerFrame = _NumFrames ? _NumPixels / _NumFrames : 0;
+    _NumFrames      = 0;
+    _NumPixels      = 0;
+    WM_InvalidateRect(pMsg->hWin, &_RectStat);
+    WM_RestartTimer(pMsg->Data.v, TIME_STAT);
+    break;
   case WM_PAINT:
+    //
+    // Count frames and pixels touched by the invalid area
+    //
+    pRect = (GUI_RECT *)pMsg->Data.p;
+    if (pRect) {
+      _NumPixels += (U32)(pRect->x1 - pRect->x0 + 1) * (U32)(pRect->y1 - pRect->y0 + 1);
+    }
+    _NumFrames++;
     GUI_DrawBitmap(&BM_FACE, 0, 0);
-    _DrawIndicator(_aHourPos[aAnimData[HOUR].Index],   GUI_BLACK, 8);
-    _DrawIndicator(_aMinPos [aAnimData[MINUTE].Index], GUI_BLACK, 7);
-    _DrawIndicator(_aSecPos [aAnimData[SECOND].Index], GUI_BLACK, 3);
+    _DrawHand(&aAnimData[HOUR]);
+    _DrawHand(&aAnimData[MINUTE]);
+    _DrawHand(&aAnimData[SECOND]);
     xSize = (LCD_GetXSize() >> 1) * AA_FACTOR;
     ySize = (LCD_GetYSize() >> 1) * AA_FACTOR;
     AAFactorOld = GUI_AA_GetFactor();
@@ -15926,7 +16106,7 @@ static void _cbClock(WM_MESSAGE * pMsg) {
     GUI_AA_FillCircle(xSize, ySize, 10 * AA_FACTOR);
     GUI_AA_SetFactor(AAFactorOld);
     GUI_AA_DisableHiRes();
-
+    _DrawStat();
     break;
   case MSG_ANIM_MINUTE:
     ahAnim[MINUTE] = GUI_ANIM_Create(300, 10, (void *)&aAnimData[MINUTE], NULL);
@@ -33,6 +33,7 @@ Purpose     : Simple single layer movie player.
 #endif
 
 #include "Resource.h"
+#include "DataSource.h"
 
 /*********************************************************************
 *
@@ -81,6 +82,49 @@ Purpose     : Simple single layer movie player.
 #define MODE_PLAY  1
 #define MODE_PAUSE 2
 
+//
+// Decode-ahead pipeline
+//
+#define PIPE_NUM_FRAMES  4     // Maximum number of frames decoded in advance
+#define PIPE_MIN_DELAY   2     // Minimum period of the playback timer in ms
+#define PIPE_STAT_PERIOD 1000  // Period used for measuring the frame rate in ms
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  GUI_MEMDEV_Handle hMem;
+  U32               Frame;         // Frame index held by the memory device
+  GUI_TIMER_TIME    tDue;          // Time at which the frame should be shown
+} PIPE_SLOT;
+
+typedef struct {
+  GUI_MOVIE_HANDLE hMovie;         // Used as decoder only, never shown by emWin itself
+  PIPE_SLOT        aSlot[PIPE_NUM_FRAMES];
+  int              NumSlots;       // Number of memory devices which could be allocated
+  int              iRead;          // Slot to be shown next
+  int              NumFull;        // Number of decoded frames waiting to be shown
+  U32              NumFrames;
+  U32              NextDecode;     // Next frame to be decoded
+  U32              CurrentFrame;   // Frame currently visible
+  GUI_TIMER_TIME   tNextDue;       // Due time of the next frame to be decoded
+  int              Period;
+  int              xPos, yPos;
+  int              DecodeAvg;      // Average decoding time in 1/8 ms
+  //
+  // Statistics
+  //
+  U32              NumShown;
+  U32              NumDropped;
+  int              LatencyMax;     // Worst delay between due time and display time
+  int              Fps;
+  U32              NumShownStat;
+  GUI_TIMER_TIME   tStat;
+} PIPE;
+
 /*********************************************************************
 *
 *       Static data
@@ -316,56 +360,256 @@ static char * _ChooseFile(void) {
 
 /*********************************************************************
 *
-*       _cbNotify
+*       _PipeCreate
 *
 * Function description
-*   Callback function for movie player. Uses multiple buffering if
-*   available to avoid tearing effects.
+*   Creates the decoder and the ring of memory devices the frames are
+*   decoded into. The number of frames decoded in advance depends on
+*   the available memory, at least one frame is required.
 */
-void _cbNotify(GUI_HMEM hMem, int Notification, U32 CurrentFrame) {
-  WM_HWIN hWin;
-  WM_MESSAGE Msg;
+static int _PipeCreate(PIPE * pPipe, DATASOURCE * pSrc, GUI_MOVIE_INFO * pInfo, int xPos, int yPos) {
+  GUI_MEMDEV_Handle hMem;
+  int               i;
 
-  switch (Notification) {
-  case GUI_MOVIE_NOTIFICATION_PREDRAW:
-    GUI_MULTIBUF_Begin();
-    break;
-  case GUI_MOVIE_NOTIFICATION_POSTDRAW:
-    GUI_MULTIBUF_End();
-    hWin = WM_GetFirstChild(WM_HBKWIN);
-    GUI_ZEROFILL(&Msg, sizeof(Msg));
-    Msg.Data.v = CurrentFrame;
-    Msg.MsgId = APP_SETFRAME;
-    WM_SendMessage(hWin, &Msg);
-    break;
-  case GUI_MOVIE_NOTIFICATION_STOP:
-    break;
+  GUI_ZEROFILL(pPipe, sizeof(PIPE));
+  pPipe->hMovie = GUI_MOVIE_CreateEx(DATASOURCE_GetDataCopy, pSrc, NULL);
+  if (pPipe->hMovie == 0) {
+    return 1;
   }
+  for (i = 0; i < PIPE_NUM_FRAMES; i++) {
+    hMem = GUI_MEMDEV_CreateEx(xPos, yPos, pInfo->xSize, pInfo->ySize, GUI_MEMDEV_NOTRANS);
+    if (hMem == 0) {
+      //
+      // Out of memory, give one device back to leave room for the decoder
+      //
+      if (pPipe->NumSlots > 1) {
+        GUI_MEMDEV_Delete(pPipe->aSlot[--pPipe->NumSlots].hMem);
+      }
+      break;
+    }
+    pPipe->aSlot[pPipe->NumSlots++].hMem = hMem;
+  }
+  if (pPipe->NumSlots == 0) {
+    GUI_MOVIE_Delete(pPipe->hMovie);
+    pPipe->hMovie = 0;
+    return 1;
+  }
+  pPipe->NumFrames = pInfo->NumFrames;
+  pPipe->Period    = pInfo->msPerFrame;
+  pPipe->xPos      = xPos;
+  pPipe->yPos      = yPos;
+  pPipe->DecodeAvg = pPipe->Period * 4;  // Start with the half frame period
+  return 0;
 }
 
 /*********************************************************************
 *
-*       _GetData
+*       _PipeDelete
+*/
+static void _PipeDelete(PIPE * pPipe) {
+  int i;
+
+  if (pPipe->hMovie) {
+    GUI_MOVIE_Delete(pPipe->hMovie);
+    pPipe->hMovie = 0;
+  }
+  for (i = 0; i < pPipe->NumSlots; i++) {
+    GUI_MEMDEV_Delete(pPipe->aSlot[i].hMem);
+  }
+  pPipe->NumSlots = 0;
+}
+
+/*********************************************************************
+*
+*       _PipeRebase
 *
 * Function description
-*   Reading data directly from file system
+*   Sets the due times of the frames waiting in the ring relative to
+*   the current time. Called when playback starts or continues.
 */
-int _GetData(void * p, const U8 ** ppData, unsigned NumBytes, U32 Off) {
-  U32 NumBytesRead;
-#ifdef WIN32
-  HANDLE hFile;
+static void _PipeRebase(PIPE * pPipe) {
+  GUI_TIMER_TIME t;
+  int            i;
 
-  hFile = *(HANDLE *)p;
-  SetFilePointer(hFile, Off, 0, FILE_BEGIN);
-  ReadFile(hFile, (U8 *)*ppData, NumBytes, &NumBytesRead, NULL);
-#else
-  FS_FILE * pFile;
+  t = GUI_GetTime();
+  for (i = 0; i < pPipe->NumFull; i++) {
+    pPipe->aSlot[(pPipe->iRead + i) % pPipe->NumSlots].tDue = t;
+    t += pPipe->Period;
+  }
+  pPipe->tNextDue     = t;
+  pPipe->tStat        = GUI_GetTime();
+  pPipe->NumShownStat = pPipe->NumShown;
+}
 
-  pFile = (FS_FILE *)p;
-  FS_SetFilePos(pFile, Off, FS_FILE_BEGIN);
-  NumBytesRead = FS_Read(pFile, (U8 *)*ppData, NumBytes);
-#endif
-  return NumBytesRead;
+/*********************************************************************
+*
+*       _PipeDecode
+*
+* Function description
+*   Decodes the next frame into the next free slot of the ring. If
+*   AllowDrop is set, frames which could not be ready before their
+*   successor is due are dropped without decoding them. The decision
+*   is based on the measured average decoding time.
+*/
+static void _PipeDecode(PIPE * pPipe, int AllowDrop) {
+  PIPE_SLOT       * pSlot;
+  GUI_MEMDEV_Handle hMemOld;
+  WM_HWIN           hWinOld;
+  GUI_TIMER_TIME    t0;
+  U32               i;
+
+  t0 = GUI_GetTime();
+  for (i = AllowDrop ? 1 : pPipe->NumFrames; i < pPipe->NumFrames; i++) {
+    if ((int)(pPipe->tNextDue + pPipe->Period - t0 - (pPipe->DecodeAvg >> 3)) >= 0) {
+      break;
+    }
+    pPipe->NextDecode = (pPipe->NextDecode + 1) % pPipe->NumFrames;
+    pPipe->tNextDue  += pPipe->Period;
+    pPipe->NumDropped++;
+  }
+  pSlot   = &pPipe->aSlot[(pPipe->iRead + pPipe->NumFull) % pPipe->NumSlots];
+  hWinOld = WM_SelectWindow(WM_HBKWIN);
+  hMemOld = GUI_MEMDEV_Select(pSlot->hMem);
+  GUI_MOVIE_DrawFrame(pPipe->hMovie, pPipe->NextDecode, pPipe->xPos, pPipe->yPos);
+  GUI_MEMDEV_Select(hMemOld);
+  WM_SelectWindow(hWinOld);
+  pPipe->DecodeAvg += (GUI_GetTime() - t0) - (pPipe->DecodeAvg >> 3);
+  pSlot->Frame      = pPipe->NextDecode;
+  pSlot->tDue       = pPipe->tNextDue;
+  pPipe->NextDecode = (pPipe->NextDecode + 1) % pPipe->NumFrames;
+  pPipe->tNextDue  += pPipe->Period;
+  pPipe->NumFull++;
+}
+
+/*********************************************************************
+*
+*       _PipeShow
+*
+* Function description
+*   Shows the given slot and the playback statistics. Uses multiple
+*   buffering if available to avoid tearing effects.
+*/
+static void _PipeShow(PIPE * pPipe, PIPE_SLOT * pSlot) {
+  WM_HWIN        hWinOld;
+  GUI_TIMER_TIME t;
+
+  t = GUI_GetTime();
+  if ((int)(t - pPipe->tStat) >= PIPE_STAT_PERIOD) {
+    pPipe->Fps          = ((pPipe->NumShown - pPipe->NumShownStat) * 1000) / (t - pPipe->tStat);
+    pPipe->NumShownStat = pPipe->NumShown;
+    pPipe->tStat        = t;
+  }
+  hWinOld = WM_SelectWindow(WM_HBKWIN);
+  GUI_MULTIBUF_Begin();
+  GUI_MEMDEV_Write(pSlot->hMem);
+  GUI_SetFont(GUI_FONT_13_ASCII);
+  GUI_SetTextMode(GUI_TM_NORMAL);
+  GUI_SetBkColor(GUI_DARKGRAY);
+  GUI_SetColor(GUI_WHITE);
+  GUI_GotoXY(2, 2);
+  GUI_DispDecMin(pPipe->Fps);
+  GUI_DispString(" fps, max. latency ");
+  GUI_DispDecMin(pPipe->LatencyMax);
+  GUI_DispString(" ms, dropped ");
+  GUI_DispDecMin(pPipe->NumDropped);
+  GUI_DispCEOL();
+  GUI_MULTIBUF_End();
+  WM_SelectWindow(hWinOld);
+  pPipe->CurrentFrame = pSlot->Frame;
+  pPipe->NumShown++;
+}
+
+/*********************************************************************
+*
+*       _PipeExec
+*
+* Function description
+*   Called by the playback timer. Shows the latest frame which is due,
+*   older frames are dropped, and decodes ahead as long as the next
+*   frame is not due.
+*
+* Return value
+*   Delay in ms until the function should be called again.
+*/
+static int _PipeExec(PIPE * pPipe) {
+  PIPE_SLOT    * pSlot;
+  GUI_TIMER_TIME Now;
+  int            Latency;
+  int            Delay;
+
+  Now   = GUI_GetTime();
+  pSlot = NULL;
+  while (pPipe->NumFull) {
+    if ((int)(pPipe->aSlot[pPipe->iRead].tDue - Now) > 0) {
+      break;
+    }
+    if (pSlot) {
+      pPipe->NumDropped++;
+    }
+    pSlot = &pPipe->aSlot[pPipe->iRead];
+    pPipe->iRead = (pPipe->iRead + 1) % pPipe->NumSlots;
+    pPipe->NumFull--;
+  }
+  if (pSlot) {
+    _PipeShow(pPipe, pSlot);
+    Latency = GUI_GetTime() - pSlot->tDue;
+    if (Latency > pPipe->LatencyMax) {
+      pPipe->LatencyMax = Latency;
+    }
+  }
+  while (pPipe->NumFull < pPipe->NumSlots) {
+    if (pPipe->NumFull) {
+      Delay = pPipe->aSlot[pPipe->iRead].tDue - GUI_GetTime();
+      if (Delay <= (pPipe->DecodeAvg >> 3)) {
+        break;
+      }
+    }
+    _PipeDecode(pPipe, 1);
+  }
+  Delay = pPipe->aSlot[pPipe->iRead].tDue - GUI_GetTime();
+  return (Delay < PIPE_MIN_DELAY) ? PIPE_MIN_DELAY : Delay;
+}
+
+/*********************************************************************
+*
+*       _PipeGoto
+*
+* Function description
+*   Shows the given frame immediately. Every frame of a movie file is a
+*   complete JPEG image and GUI_MOVIE_DrawFrame() locates it by the frame
+*   offset table of the file, so seeking costs one decoding step. Frames
+*   already decoded behind the requested one are kept.
+*/
+static void _PipeGoto(PIPE * pPipe, U32 Frame) {
+  PIPE_SLOT * pSlot;
+
+  while (pPipe->NumFull && (pPipe->aSlot[pPipe->iRead].Frame != Frame)) {
+    pPipe->iRead = (pPipe->iRead + 1) % pPipe->NumSlots;
+    pPipe->NumFull--;
+  }
+  if (pPipe->NumFull == 0) {
+    pPipe->iRead      = 0;
+    pPipe->NextDecode = Frame;
+    pPipe->tNextDue   = GUI_GetTime();
+    _PipeDecode(pPipe, 0);
+  }
+  pSlot = &pPipe->aSlot[pPipe->iRead];
+  pPipe->iRead = (pPipe->iRead + 1) % pPipe->NumSlots;
+  pPipe->NumFull--;
+  _PipeShow(pPipe, pSlot);
+}
+
+/*********************************************************************
+*
+*       _SendFrame
+*/
+static void _SendFrame(WM_HWIN hWin, U32 Frame) {
+  WM_MESSAGE Msg;
+
+  GUI_ZEROFILL(&Msg, sizeof(Msg));
+  Msg.Data.v = Frame;
+  Msg.MsgId  = APP_SETFRAME;
+  WM_SendMessage(hWin, &Msg);
 }
 
 /*********************************************************************
@@ -524,13 +768,10 @@ static void _SetPlayButtonBitmap(WM_HWIN hWin, int Index) {
 *       _cbPlayer
 */
 static void _cbPlayer(WM_MESSAGE * pMsg) {
-#ifdef WIN32
-  static HANDLE    hFile;
-  #define PARAM    &hFile
-#else
-  static FS_FILE * pFile;
-  #define PARAM    pFile
-#endif
+  static DATASOURCE * pSrc;
+  static PIPE Pipe;
+  static WM_HMEM hTimer;
+  static int Scrub;
   static GUI_RECT RectMovie;
   static int Pos1000;
   static WM_HWIN hWinSlider;
@@ -547,13 +788,14 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
   U32 Frame;
   const char * pFileName;
   static GUI_MOVIE_INFO   Info;
-  static GUI_MOVIE_HANDLE hMovie;
 
   hWin = pMsg->hWin;
   switch (pMsg->MsgId) {
   case APP_CONTINUE:
-    if (hMovie && (Mode == MODE_PLAY)) {
-      GUI_MOVIE_Play(hMovie);
+    Scrub = 0;
+    if (Pipe.hMovie && (Mode == MODE_PLAY)) {
+      _PipeRebase(&Pipe);
+      WM_RestartTimer(hTimer, PIPE_MIN_DELAY);
     }
     break;
   case APP_SETPLAY:
@@ -573,18 +815,17 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
     Mode = MODE_STOP;
     break;
   case APP_SETPOS1000:
-    if (hMovie) {
+    if (Pipe.hMovie) {
+      Scrub = 1;
       Frame = (Pos1000 * Info.NumFrames) / 1000;
-      GUI_MOVIE_GotoFrame(hMovie, Frame);
-      if (Mode != MODE_PLAY) {
-        GUI_MOVIE_DrawFrame(hMovie, Frame, xPosMovie, yPosMovie);
+      if (Frame >= Info.NumFrames) {
+        Frame = Info.NumFrames - 1;
       }
-      GUI_MOVIE_Pause(hMovie);
+      _PipeGoto(&Pipe, Frame);
     }
     break;
   case APP_SETFRAME:
     Frame = pMsg->Data.v;
-    GUI_MOVIE_GotoFrame(hMovie, Frame);
     Pos1000 = (Frame * 1000) / Info.NumFrames;
     WM_InvalidateWindow(hWinSlider);
     break;
@@ -608,8 +849,17 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
     WM_SetUserData(hWinSlider, &pPos1000, sizeof(pPos1000));
     WM_SendMessageNoPara(hWin, APP_SETSTOP);
     _EnablePlayStop(hWin, 0, hWinSlider);
+    hTimer = WM_CreateTimer(hWin, 0, PIPE_MIN_DELAY, 0);
+    break;
+  case WM_DELETE:
+    WM_DeleteTimer(hTimer);
+    _PipeDelete(&Pipe);
     break;
   case WM_TIMER:
+    if (Pipe.hMovie && (Mode == MODE_PLAY) && (Scrub == 0)) {
+      WM_RestartTimer(hTimer, _PipeExec(&Pipe));
+      _SendFrame(hWin, Pipe.CurrentFrame);
+    }
     break;
   case WM_TOUCH:
     break;
@@ -621,25 +871,36 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
     if (NCode == WM_NOTIFICATION_RELEASED) {
       switch (Id - GUI_ID_BUTTON0) {
       case INDEX_NEXT:
-        Frame = GUI_MOVIE_GetFrameIndex(hMovie);
-        if (Frame < Info.NumFrames - 1) {
-          Frame++;
-          GUI_MOVIE_GotoFrame(hMovie, Frame);
-        }
-        GUI_MOVIE_DrawFrame(hMovie, Frame, xPosMovie, yPosMovie);
-        break;
       case INDEX_BACK:
-        Frame = GUI_MOVIE_GetFrameIndex(hMovie);
-        if (Frame > 0) {
-          Frame--;
-          GUI_MOVIE_GotoFrame(hMovie, Frame);
+        if (Pipe.hMovie == 0) {
+          break;
+        }
+        Frame = Pipe.CurrentFrame;
+        if ((Id - GUI_ID_BUTTON0) == INDEX_NEXT) {
+          if (Frame < Info.NumFrames - 1) {
+            Frame++;
+          }
+        } else {
+          if (Frame > 0) {
+            Frame--;
+          }
+        }
+        _PipeGoto(&Pipe, Frame);
+        _SendFrame(hWin, Frame);
+        //
+        // The ring now continues behind the new frame, its due times still
+        // refer to the old position. Rebase them when playing, otherwise the
+        // timer would show the following frames late or drop them.
+        //
+        if (Mode == MODE_PLAY) {
+          Scrub = 0;
+          _PipeRebase(&Pipe);
+          WM_RestartTimer(hTimer, PIPE_MIN_DELAY);
         }
-        GUI_MOVIE_DrawFrame(hMovie, Frame, xPosMovie, yPosMovie);
         break;
       case INDEX_STOP:
-        if (hMovie) {
-          GUI_MOVIE_Delete(hMovie);
-          hMovie = 0;
+        if (Pipe.hMovie) {
+          _PipeDelete(&Pipe);
           Pos1000 = 0;
           _EnablePlayStop(hWin, 0, hWinSlider);
           WM_SendMessageNoPara(WM_HBKWIN, APP_CLEARSKIP);
@@ -649,12 +910,12 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
       case INDEX_PLAY:
         switch (Mode) {
         case MODE_PLAY:
-          GUI_MOVIE_Pause(hMovie);
           WM_SendMessageNoPara(hWin, APP_SETPAUSE);
           break;
         case MODE_STOP:
         case MODE_PAUSE:
-          GUI_MOVIE_Play(hMovie);
+          _PipeRebase(&Pipe);
+          WM_RestartTimer(hTimer, PIPE_MIN_DELAY);
           WM_SendMessageNoPara(hWin, APP_SETPLAY);
           break;
         }
@@ -662,35 +923,26 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
       case INDEX_EJECT:
         OldMode = Mode;
         if (OldMode == MODE_PLAY) {
-          GUI_MOVIE_Pause(hMovie);
           WM_SendMessageNoPara(hWin, APP_SETPAUSE);
         }
         pFileName = _ChooseFile();
         if (pFileName) {
-          if (hMovie) {
-            GUI_MOVIE_Delete(hMovie);
-            hMovie = 0;
+          if (Pipe.hMovie) {
+            _PipeDelete(&Pipe);
             _EnablePlayStop(hWin, 0, hWinSlider);
           }
-          #ifdef WIN32
-            if (hFile) {
-              CloseHandle(hFile);
-            }
-            hFile = CreateFile(pFileName, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-          #else
-            if (pFile) {
-              FS_FClose(pFile);
-            }
-            pFile = FS_FOpen(pFileName, "r");
-          #endif
-          if (GUI_MOVIE_GetInfoEx(_GetData, PARAM, &Info) == 0) {
+          if (pSrc) {
+            DATASOURCE_Close(pSrc);
+          }
+          pSrc = DATASOURCE_Open(pFileName);
+          if (pSrc && (GUI_MOVIE_GetInfoEx(DATASOURCE_GetDataCopy, pSrc, &Info) == 0)) {
             if ((Info.xSize <= RectMovie.x1) && (Info.ySize <= RectMovie.y1)) {
-              hMovie = GUI_MOVIE_CreateEx(_GetData, PARAM, _cbNotify);
-              if (hMovie) {
-                xPosMovie = (RectMovie.x1 - Info.xSize + 1) / 2;
-                yPosMovie = (RectMovie.y1 - Info.ySize + 1) / 2;
-                GUI_MOVIE_Show(hMovie, xPosMovie, yPosMovie, 1);
+              xPosMovie = (RectMovie.x1 - Info.xSize + 1) / 2;
+              yPosMovie = (RectMovie.y1 - Info.ySize + 1) / 2;
+              if (_PipeCreate(&Pipe, pSrc, &Info, xPosMovie, yPosMovie) == 0) {
                 WM_SendMessageNoPara(WM_HBKWIN, APP_SETSKIP);
+                _PipeRebase(&Pipe);
+                WM_RestartTimer(hTimer, PIPE_MIN_DELAY);
               }
               WM_SendMessageNoPara(hWin, APP_SETPLAY);
             }
@@ -701,13 +953,13 @@ static void _cbPlayer(WM_MESSAGE * pMsg) {
             WM_SendMessageNoPara(hWin, APP_SETSTOP);
           }
         } else {
-          if (hMovie) {
+          if (Pipe.hMovie) {
             if (OldMode == MODE_PLAY) {
-              GUI_MOVIE_Play(hMovie);
+              _PipeRebase(&Pipe);
+              WM_RestartTimer(hTimer, PIPE_MIN_DELAY);
               WM_SendMessageNoPara(hWin, APP_SETPLAY);
             } else {
-              Frame = GUI_MOVIE_GetFrameIndex(hMovie);
-              GUI_MOVIE_DrawFrame(hMovie, Frame, xPosMovie, yPosMovie);
+              _PipeGoto(&Pipe, Pipe.CurrentFrame);
             }
           }
         }
@@ -54,6 +54,54 @@ emLoad       - Easy firmware updates
 #define APP_SET_DATA   (WM_USER + 0)
 #define APP_SET_DEVICE (WM_USER + 1)
 
+//
+// Image preloader. The devices of the radial menu show a placeholder
+// until the image has been decoded. PRELOAD_BATCH images are decoded
+// one after the other per period of the preloader timer, all in the
+// GUI task.
+//
+#define PRELOAD_BATCH        1   // 1, 2 or 4
+#define PRELOAD_PERIOD       20
+
+//
+// Decoded pixels are kept in a cache file per image, named by the hash
+// of the PNG data. The simulation uses the C library. On a target the
+// cache is off by default and every start decodes all images. Targets
+// with emFile and a mounted volume enable it by defining PRELOAD_CACHE
+// as PRELOAD_CACHE_EMFILE in the project settings.
+//
+#define PRELOAD_CACHE_NONE   0
+#define PRELOAD_CACHE_STDIO  1   // fopen() + fread()/fwrite()
+#define PRELOAD_CACHE_EMFILE 2   // FS_FOpen() + FS_Read()/FS_Write(), volume mounted by the application
+
+#ifndef   PRELOAD_CACHE
+  #ifdef WIN32
+    #define PRELOAD_CACHE  PRELOAD_CACHE_STDIO
+  #else
+    #define PRELOAD_CACHE  PRELOAD_CACHE_NONE
+  #endif
+#endif
+#define CACHE_MAGIC          (0x50534331UL + GUI_USE_ARGB)  // 'PSC1', pixel format depends on GUI_USE_ARGB
+
+#if   (PRELOAD_CACHE == PRELOAD_CACHE_STDIO)
+  #include <stdio.h>
+  #define CACHE_FILE                FILE
+  #define CACHE_OPEN(sName, sMode)  fopen(sName, sMode "b")
+  #define CACHE_READ(pFile, p, n)   fread(p, 1, n, pFile)
+  #define CACHE_WRITE(pFile, p, n)  fwrite(p, 1, n, pFile)
+  #define CACHE_CLOSE(pFile)        fclose(pFile)
+  #define CACHE_REMOVE(sName)       remove(sName)
+#elif (PRELOAD_CACHE == PRELOAD_CACHE_EMFILE)
+  #include <stdio.h>
+  #include "FS.h"
+  #define CACHE_FILE                FS_FILE
+  #define CACHE_OPEN(sName, sMode)  FS_FOpen(sName, sMode)
+  #define CACHE_READ(pFile, p, n)   FS_Read(pFile, p, n)
+  #define CACHE_WRITE(pFile, p, n)  FS_Write(pFile, p, n)
+  #define CACHE_CLOSE(pFile)        FS_FClose(pFile)
+  #define CACHE_REMOVE(sName)       FS_Remove(sName)
+#endif
+
 //
 // Recommended memory to run the sample with adequate performance
 //
@@ -7865,6 +7913,17 @@ typedef struct {
   GUI_MEMDEV_Handle hMem;
 } IMAGE_DATA;
 
+typedef struct {
+  WM_HWIN hWin;           // Window to be invalidated when an image gets ready
+  int     NextImage;      // Next image to be decoded
+  int     NumDecoded;     // Number of images decoded from PNG
+  int     NumCached;      // Number of images read from the cache
+  int     TimeStart;
+  int     TimeFirstFrame; // Time until the first frame has been shown
+  int     TimeDecode;     // Sum of the time used for decoding or reading the cache
+  int     TimeReady;      // Time until all images are available, 0 while loading
+} PRELOAD;
+
 /*********************************************************************
 *
 *       Types (Radial menu)
@@ -7919,11 +7978,13 @@ static const U8 * _apImage[] = {
 };
 
 static const int _aImageSize[] = {
-  (U8)sizeof(_acImage0), (U8)sizeof(_acImage1), (U8)sizeof(_acImage2)
+  sizeof(_acImage0), sizeof(_acImage1), sizeof(_acImage2)
 };
 
 static IMAGE_DATA _aImageData[3];
 
+static PRELOAD _Preload;
+
 static const char * _apProduct[] = {
   "Flasher",
   "J-Link PRO",
@@ -8116,9 +8177,210 @@ static WM_HWIN _CreateRadialMenu(int xPos, int yPos, int xSize, int ySize, int r
 *
 **********************************************************************
 */
+/*********************************************************************
+*
+*       _GetHash
+*
+*  Function description:
+*    Calculates the FNV-1a hash of the given data.
+*/
+static U32 _GetHash(const U8 * pData, int NumBytes) {
+  U32 Hash;
+
+  Hash = 2166136261UL;
+  while (NumBytes--) {
+    Hash ^= *pData++;
+    Hash *= 16777619UL;
+  }
+  return Hash;
+}
+
+#if (PRELOAD_CACHE != PRELOAD_CACHE_NONE)
+
+/*********************************************************************
+*
+*       _GetCacheFileName
+*/
+static void _GetCacheFileName(char * acName, U32 Hash) {
+  sprintf(acName, "ProductShow_%08lX.bin", (unsigned long)Hash);
+}
+
+/*********************************************************************
+*
+*       _ReadCache
+*
+*  Return value:
+*    0 if the pixels have been read from the cache, 1 otherwise
+*/
+static int _ReadCache(U32 Hash, void * pPixels, U32 NumBytes) {
+  CACHE_FILE * pFile;
+  U32          aHeader[2];
+  int          r;
+  char         acName[32];
+
+  _GetCacheFileName(acName, Hash);
+  pFile = CACHE_OPEN(acName, "r");
+  if (pFile == NULL) {
+    return 1;
+  }
+  r = 1;
+  if (CACHE_READ(pFile, aHeader, sizeof(aHeader)) == sizeof(aHeader)) {
+    if ((aHeader[0] == CACHE_MAGIC) && (aHeader[1] == NumBytes)) {
+      if (CACHE_READ(pFile, pPixels, NumBytes) == NumBytes) {
+        r = 0;
+      }
+    }
+  }
+  CACHE_CLOSE(pFile);
+  return r;
+}
+
+/*********************************************************************
+*
+*       _WriteCache
+*/
+static void _WriteCache(U32 Hash, const void * pPixels, U32 NumBytes) {
+  CACHE_FILE * pFile;
+  U32          aHeader[2];
+  char         acName[32];
+
+  _GetCacheFileName(acName, Hash);
+  pFile = CACHE_OPEN(acName, "w");
+  if (pFile == NULL) {
+    return;
+  }
+  aHeader[0] = CACHE_MAGIC;
+  aHeader[1] = NumBytes;
+  if ((CACHE_WRITE(pFile, aHeader, sizeof(aHeader)) != sizeof(aHeader)) || (CACHE_WRITE(pFile, pPixels, NumBytes) != NumBytes)) {
+    CACHE_CLOSE(pFile);
+    CACHE_REMOVE(acName);  // Do not keep incomplete files
+    return;
+  }
+  CACHE_CLOSE(pFile);
+}
+
+#else
+
+//
+// No file system, every image is decoded.
+//
+static int _ReadCache(U32 Hash, void * pPixels, U32 NumBytes) {
+  (void)Hash;
+  (void)pPixels;
+  (void)NumBytes;
+  return 1;
+}
+
+static void _WriteCache(U32 Hash, const void * pPixels, U32 NumBytes) {
+  (void)Hash;
+  (void)pPixels;
+  (void)NumBytes;
+}
+
+#endif
+
+/*********************************************************************
+*
+*       _DrawPlaceholder
+*
+*  Function description:
+*    Draws the placeholder shown until the image is available into the
+*    currently selected device.
+*/
+static void _DrawPlaceholder(int xSize, int ySize) {
+  GUI_SetBkColor(GUI_TRANSPARENT);
+  GUI_Clear();
+  GUI_SetColor(GUI_LIGHTGRAY);
+  GUI_DrawRoundedFrame(0, 0, xSize - 1, ySize - 1, 10, 3);
+  GUI_SetFont(&GUI_Font20_ASCII);
+  GUI_SetTextMode(GUI_TM_TRANS);
+  GUI_DispStringHCenterAt("Loading...", xSize / 2, (ySize - GUI_GetFontSizeY()) / 2);
+}
+
+/*********************************************************************
+*
+*       _LoadImage
+*
+*  Function description:
+*    Makes the pixels of the given image available in its device, either
+*    from the cache or by decoding the PNG data.
+*/
+static void _LoadImage(PRELOAD * pPreload, int Index) {
+  GUI_MEMDEV_Handle hMemOld;
+  IMAGE_DATA      * pImage;
+  void            * pPixels;
+  U32               NumBytes;
+  U32               Hash;
+  int               TimeStart;
+
+  TimeStart = GUI_GetTime();
+  pImage    = &_aImageData[Index];
+  Hash      = _GetHash(_apImage[Index], _aImageSize[Index]);
+  NumBytes  = (U32)pImage->xSize * pImage->ySize * 4;
+  pPixels   = GUI_MEMDEV_GetDataPtr(pImage->hMem);
+  if (_ReadCache(Hash, pPixels, NumBytes) == 0) {
+    pPreload->NumCached++;
+  } else {
+    hMemOld = GUI_MEMDEV_Select(pImage->hMem);
+    GUI_SetBkColor(GUI_TRANSPARENT);
+    GUI_Clear();
+    GUI_PNG_Draw(_apImage[Index], _aImageSize[Index], 0, 0);
+    GUI_MEMDEV_Select(hMemOld);
+    _WriteCache(Hash, GUI_MEMDEV_GetDataPtr(pImage->hMem), NumBytes);
+    pPreload->NumDecoded++;
+  }
+  pPreload->TimeDecode += GUI_GetTime() - TimeStart;
+}
+
+/*********************************************************************
+*
+*       _cbPreload
+*
+*  Function description:
+*    Timer callback of the preloader, loads the next images and shows
+*    them in the radial menu.
+*/
+static void _cbPreload(GUI_TIMER_MESSAGE * pTM) {
+  PRELOAD * pPreload;
+  int       i;
+
+  pPreload = (PRELOAD *)pTM->Context;
+  for (i = 0; (i < PRELOAD_BATCH) && (pPreload->NextImage < (int)GUI_COUNTOF(_apImage)); i++) {
+    _LoadImage(pPreload, pPreload->NextImage++);
+  }
+  WM_InvalidateWindow(pPreload->hWin);
+  if (pPreload->NextImage < (int)GUI_COUNTOF(_apImage)) {
+    GUI_TIMER_Restart(pTM->hTimer);
+  } else {
+    pPreload->TimeReady = GUI_GetTime() - pPreload->TimeStart;
+    GUI_TIMER_Delete(pTM->hTimer);
+    WM_InvalidateWindow(WM_HBKWIN);  // Show the result
+  }
+}
+
+/*********************************************************************
+*
+*       _StartPreload
+*/
+static int _StartPreload(PRELOAD * pPreload, WM_HWIN hWin) {
+  GUI_TIMER_HANDLE hTimer;
+
+  pPreload->hWin = hWin;
+  hTimer = GUI_TIMER_Create(_cbPreload, GUI_GetTime() + PRELOAD_PERIOD, (PTR_ADDR)pPreload, 0);
+  if (hTimer == 0) {
+    return 1;
+  }
+  GUI_TIMER_SetPeriod(hTimer, PRELOAD_PERIOD);
+  return 0;
+}
+
 /*********************************************************************
 *
 *       _CreateDevices
+*
+*  Function description:
+*    Creates the devices of the radial menu with a placeholder. The
+*    images are loaded later on by the preloader.
 */
 static int _CreateDevices(void) {
   unsigned i;
@@ -8131,9 +8393,7 @@ static int _CreateDevices(void) {
       return 1;
     }
     GUI_MEMDEV_Select(_aImageData[i].hMem);
-    GUI_SetBkColor(GUI_TRANSPARENT);
-    GUI_Clear();
-    GUI_PNG_Draw(_apImage[i], _aImageSize[i], 0, 0);
+    _DrawPlaceholder(_aImageData[i].xSize, _aImageData[i].ySize);
     GUI_MEMDEV_Select(0);
   }
   return 0;
@@ -8217,6 +8477,26 @@ static void _cbBk(WM_MESSAGE * pMsg) {
     GUI_SetFont(&GUI_Font48);
     GUI_SetTextMode(GUI_TM_TRANS);
     GUI_DispStringHCenterAt("Development- and production tools", 160 + (xSize - 160) / 2, 21);
+    //
+    // Preloader result
+    //
+    if (_Preload.TimeReady) {
+      GUI_SetFont(&GUI_Font13_ASCII);
+      GUI_GotoXY(10, ySize - 20);
+      GUI_DispString("Batch: ");
+      GUI_DispDecMin(PRELOAD_BATCH);
+      GUI_DispString(", first frame: ");
+      GUI_DispDecMin(_Preload.TimeFirstFrame);
+      GUI_DispString(" ms, decode: ");
+      GUI_DispDecMin(_Preload.TimeDecode);
+      GUI_DispString(" ms, all images: ");
+      GUI_DispDecMin(_Preload.TimeReady);
+      GUI_DispString(" ms (");
+      GUI_DispDecMin(_Preload.NumDecoded);
+      GUI_DispString(" decoded, ");
+      GUI_DispDecMin(_Preload.NumCached);
+      GUI_DispString(" cached)");
+    }
     break;
   default:
     WM_DefaultProc(pMsg);
@@ -8725,6 +9005,7 @@ void MainTask(void) {
   //
   // Create image devices for rotation menu
   //
+  _Preload.TimeStart = GUI_GetTime();
   _CreateDevices();
   //
   // Create radial menu
@@ -8760,6 +9041,12 @@ void MainTask(void) {
   GUI_PNG_Draw(_SeggerLogo_139x70, sizeof(_SeggerLogo_139x70), 0, 0);
   GUI_MEMDEV_Select(0);
   //
+  // Show the first frame with placeholders and start loading the images
+  //
+  GUI_Exec();
+  _Preload.TimeFirstFrame = GUI_GetTime() - _Preload.TimeStart;
+  _StartPreload(&_Preload, Data.hWin);
+  //
   // Animation loop
   //
   Cnt = 0;
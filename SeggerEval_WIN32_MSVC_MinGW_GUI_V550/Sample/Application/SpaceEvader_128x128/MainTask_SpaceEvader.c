@@ -17,12 +17,15 @@ distributed in any way. We appreciate your understanding and fairness.
 ----------------------------------------------------------------------
 File        : MainTask_SpaceEvader.c
 Purpose     : Spaceship game, evade the asteroids.
+              Requires Sample\Collision\Collision.c in the project and
+              Sample\Collision in the include path.
 ---------------------------END-OF-HEADER------------------------------
 */
 
 #include "GUI.h"
 #include "GUI_Private.h"
 #include "WM.h"
+#include "Collision.h"
 
 #include "stdlib.h"
 
@@ -63,6 +66,17 @@ extern GUI_CONST_STORAGE GUI_BITMAP bmBang;
 #define CONTROL_TYPE_JOY 1
 #define CONTROL_TYPE     CONTROL_TYPE_PID
 
+//
+// Set BENCHMARK to 1 to measure the collision detection of many
+// moving asteroids before the game starts. Nothing is drawn during
+// the measurement.
+//
+#define BENCHMARK           0
+#define BENCH_NUM_OBJECTS   1000
+#define BENCH_XSIZE         2048  // Size of the area the asteroids move in
+#define BENCH_YSIZE         2048
+#define BENCH_PERIOD        2000
+
 /*********************************************************************
 *
 *       Types
@@ -80,12 +94,67 @@ typedef struct {
   int yPos;
 } ASTEROID;
 
+typedef struct {
+  GUI_CONST_STORAGE GUI_BITMAP * pBitmap;
+  COLLISION_MASK                 Mask;
+} SPRITE;
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+//
+// Collision masks of all sprites, created at startup
+//
+static SPRITE _aSprite[] = {
+  { &bmSpaceShipTop_Small    },
+  { &bmSpaceShipLeft_Small   },
+  { &bmSpaceShipRight_Small  },
+  { &bmSpaceShipBottom_Small },
+  { &bmAsteroid              },
+};
+
+#if BENCHMARK
+static COLLISION_OBJ   _aBenchObj  [BENCH_NUM_OBJECTS];
+static COLLISION_OBJ * _apBenchObj [BENCH_NUM_OBJECTS];
+static I8              _aBenchSpeed[BENCH_NUM_OBJECTS][2];
+#endif
+
 /*********************************************************************
 *
 *       Static code
 *
 **********************************************************************
 */
+/*********************************************************************
+*
+*       _CreateMasks()
+*/
+static void _CreateMasks(void) {
+  unsigned i;
+
+  for (i = 0; i < GUI_COUNTOF(_aSprite); i++) {
+    COLLISION_CreateMask(&_aSprite[i].Mask, _aSprite[i].pBitmap);
+  }
+}
+
+/*********************************************************************
+*
+*       _GetMask()
+*/
+static const COLLISION_MASK * _GetMask(GUI_CONST_STORAGE GUI_BITMAP * pBitmap) {
+  unsigned i;
+
+  for (i = 0; i < GUI_COUNTOF(_aSprite); i++) {
+    if (_aSprite[i].pBitmap == pBitmap) {
+      return &_aSprite[i].Mask;
+    }
+  }
+  return NULL;
+}
+
 /*********************************************************************
 *
 *       _GetDirection()
@@ -249,50 +318,114 @@ static void _Asteroid(ASTEROID * pAsteroid) {
 *       _CheckCollision()
 */
 static int _CheckCollision(ASTEROID * pAsteroid, ASTEROID * pAsteroid2, SHIP * pShip) {
-  GUI_RECT RectShip, RectAsteroid;
-  int xPos, yPos;
-  int i, r;
-  LCD_PIXELINDEX Index;
+  int r;
 
   r = 0;
-  RectShip.x0 = pShip->xPos;
-  RectShip.y0 = pShip->yPos;
-  RectShip.x1 = RectShip.x0 + pShip->pBitmap->XSize - 1;
-  RectShip.y1 = RectShip.y0 + pShip->pBitmap->YSize - 1;
-  RectAsteroid.x0 = pAsteroid->xPos;
-  RectAsteroid.y0 = pAsteroid->yPos;
-  RectAsteroid.x1 = RectAsteroid.x0 + bmAsteroid.XSize - 1;
-  RectAsteroid.y1 = RectAsteroid.y0 + bmAsteroid.YSize - 1;
-  //
-  // First a simple check if rectangles of bitmaps overlap
-  //
-  if (GUI_RectsIntersect(&RectShip, &RectAsteroid)) {
+  //
+  // Compare the opaque pixels of both bitmaps. The masks are only
+  // tested if the rectangles of the bitmaps overlap.
+  //
+  if (COLLISION_TestMasks(_GetMask(pShip->pBitmap), pShip->xPos,    pShip->yPos,
+                          _GetMask(&bmAsteroid),    pAsteroid->xPos, pAsteroid->yPos)) {
+    GUI_Clear();
+    GUI_DrawBitmap(&bmBang, 0, 20);
+    LCD_ControlCache(LCD_CC_UNLOCK);
+    LCD_ControlCache(LCD_CC_LOCK);
+    GUI_Delay(1000);
+    GUI_Clear();
+    pAsteroid->yPos = pAsteroid2->yPos - YSIZE_DISPLAY / 2;
+    r = 1;
+  }
+  return r;
+}
+
+#if BENCHMARK
+/*********************************************************************
+*
+*       _Benchmark()
+*
+*  Function description:
+*    Moves BENCH_NUM_OBJECTS asteroids in an area of BENCH_XSIZE *
+*    BENCH_YSIZE pixels and detects all collisions between them for
+*    BENCH_PERIOD ms. Shows the number of frames per second, the
+*    number of pairs per second the sweep actually checked and the
+*    number of pairs tested bit by bit. For comparison the number of
+*    pairs per second a test of each asteroid against each other one
+*    would have to check at the same frame rate is shown as well.
+*/
+static void _Benchmark(void) {
+  COLLISION_LIST         List;
+  COLLISION_OBJ        * pObj;
+  const COLLISION_MASK * pMask;
+  GUI_TIMER_TIME         t0, tUsed;
+  U32                    NumFrames, NumHits, NumPairs;
+  int                    xMax, yMax;
+  int                    i;
+
+  pMask = _GetMask(&bmAsteroid);
+  xMax  = BENCH_XSIZE - pMask->xSize;
+  yMax  = BENCH_YSIZE - pMask->ySize;
+  COLLISION_InitList(&List, _apBenchObj, BENCH_NUM_OBJECTS);
+  for (i = 0; i < BENCH_NUM_OBJECTS; i++) {
+    pObj = &_aBenchObj[i];
+    pObj->pMask = pMask;
+    pObj->x     = rand() % xMax;
+    pObj->y     = rand() % yMax;
+    _aBenchSpeed[i][0] = (I8)(rand() % 7 - 3);
+    _aBenchSpeed[i][1] = (I8)(rand() % 7 - 3);
+    COLLISION_AddObj(&List, pObj);
+  }
+  NumFrames = 0;
+  NumHits   = 0;
+  t0        = GUI_GetTime();
+  do {
     //
-    // Check if lower row of asteroid collides with plane
+    // Move the asteroids, bounce at the borders of the area
     //
-    yPos = RectAsteroid.y0 - RectShip.y0 + bmAsteroid.YSize - 1;
-    if (yPos < pShip->pBitmap->XSize) {
-      for (i = 0; i < bmAsteroid.XSize; i++) {
-        xPos = RectAsteroid.x0 - RectShip.x0 + i;
-        if ((xPos >= 0) && (xPos < pShip->pBitmap->XSize)) {
-          Index = GUI_GetBitmapPixelIndex(pShip->pBitmap, xPos, yPos);
-          if ((Index > 0) && (Index < 255))  {
-            GUI_Clear();
-            GUI_DrawBitmap(&bmBang, 0, 20);
-            LCD_ControlCache(LCD_CC_UNLOCK);
-            LCD_ControlCache(LCD_CC_LOCK);
-            GUI_Delay(1000);
-            GUI_Clear();
-            pAsteroid->yPos = pAsteroid2->yPos - YSIZE_DISPLAY / 2;
-            r = 1;
-            break;
-          }
-        }
+    for (i = 0; i < BENCH_NUM_OBJECTS; i++) {
+      pObj = &_aBenchObj[i];
+      pObj->x += _aBenchSpeed[i][0];
+      pObj->y += _aBenchSpeed[i][1];
+      if ((pObj->x < 0) || (pObj->x > xMax)) {
+        _aBenchSpeed[i][0] = -_aBenchSpeed[i][0];
+        pObj->x += 2 * _aBenchSpeed[i][0];
+      }
+      if ((pObj->y < 0) || (pObj->y > yMax)) {
+        _aBenchSpeed[i][1] = -_aBenchSpeed[i][1];
+        pObj->y += 2 * _aBenchSpeed[i][1];
       }
     }
-  }
-  return r;
+    COLLISION_Update(&List);
+    NumHits += COLLISION_FindPairs(&List, NULL, NULL);
+    NumFrames++;
+  } while ((tUsed = GUI_GetTime() - t0) < BENCH_PERIOD);
+  //
+  // Show the result
+  //
+  NumPairs = (U32)BENCH_NUM_OBJECTS * (BENCH_NUM_OBJECTS - 1) / 2;
+  GUI_Clear();
+  GUI_DispStringHCenterAt("Collision benchmark", XSIZE_DISPLAY / 2, 2);
+  GUI_DrawHLine(YSIZE_BAR - 1, 0, XSIZE_DISPLAY - 1);
+  GUI_DispStringAt("Asteroids:  ", 2, 20);
+  GUI_DispDecMin(BENCH_NUM_OBJECTS);
+  GUI_DispStringAt("Frames/s:   ", 2, 30);
+  GUI_DispDecMin((int)((NumFrames * 1000) / tUsed));
+  GUI_DispStringAt("Checks/s:   ", 2, 40);
+  GUI_DispDecMin((int)((float)List.Stat.NumPairs / tUsed));
+  GUI_DispString("k");
+  GUI_DispStringAt("Bit tests/s:", 2, 50);
+  GUI_DispDecMin((int)((float)List.Stat.NumTests / tUsed));
+  GUI_DispString("k");
+  GUI_DispStringAt("Hits/frame: ", 2, 60);
+  GUI_DispDecMin((int)(NumHits / NumFrames));
+  GUI_DispStringAt("All pairs/s:", 2, 74);
+  GUI_DispDecMin((int)((float)NumPairs * NumFrames / tUsed));
+  GUI_DispString("k");
+  GUI_DispStringAt("(brute force, ref.)", 2, 84);
+  GUI_Delay(5000);
+  GUI_Clear();
 }
+#endif
 
 /*********************************************************************
 *
@@ -407,6 +540,13 @@ void MainTask(void) {
   //
   GUI_SetColor(GUI_BLACK);
   GUI_SetBkColor(GUI_WHITE);
+  //
+  // Create the collision masks of the sprites
+  //
+  _CreateMasks();
+#if BENCHMARK
+  _Benchmark();
+#endif
   //
   // Explanation
   //
@@ -27,6 +27,7 @@ Requirements: WindowManager - ( )
 */
 
 #include <stddef.h>
+#include <string.h>
 
 #include "DIALOG.h"
 
@@ -67,9 +68,22 @@ Requirements: WindowManager - ( )
 #define TIME_IDLE 5000
 
 //
-// Recommended memory to run the sample with adequate performance
+// Page transitions are composed in a memory device of screen size:
+// The visible part is moved by the distance of the step and only the
+// exposed strip is drawn from the background bitmaps. Set to 0 to
+// draw the complete bitmaps on each step for comparison.
 //
-#define RECOMMENDED_MEMORY (24 * 1024) // Should be adapted, value is too less
+#define PAGE_COMPOSE 1
+
+#define XPOS_STAT   10
+#define XSIZE_STAT 440
+#define YOFF_STAT   20
+
+//
+// Recommended memory to run the sample with adequate performance,
+// including the compositor device of screen size at 32bpp
+//
+#define RECOMMENDED_MEMORY ((24 * 1024) + PAGE_COMPOSE * 800L * 480 * 4)
 
 /*********************************************************************
 *
@@ -133,6 +147,14 @@ struct WINDOW_DATA {
   int             IndexAnimOut;
   int             HasStopped;
   int             Diff;
+  GUI_MEMDEV_Handle hMemBk;     // Compositor device, 0 if backgrounds are drawn directly
+  int             xPosMem;      // Position drawn into hMemBk, -1 if nothing drawn yet
+  int             xPosAnim0;    // Start and end position of the idle page transition
+  int             xPosAnim1;
+  GUI_TIMER_TIME  TimeAnim;     // Start time of the transition
+  U32             NumFrames;    // Number of frames drawn during the transition
+  U32             NumPixels;    // Number of bitmap pixels drawn during the transition
+  U32             NumCopied;    // Number of pixels moved in hMemBk and written to the screen during the transition
 };
 
 /*********************************************************************
@@ -491,38 +513,230 @@ static void _AnimDropIn(GUI_ANIM_INFO * pInfo, void * pVoid) {
   WM_InvalidateWindow(pData->hText);
 }
 
+/*********************************************************************
+*
+*       _DrawBackground
+*
+* Purpose:
+*   Draws the background image(s) visible at the current position
+*/
+static void _DrawBackground(WINDOW_DATA * pData) {
+  int i, x0, Index, NumItems;
+
+  NumItems = GUI_COUNTOF(_apBmBack);
+  for (i = 0; i <= NumItems; i++) {
+    Index = (i == NumItems) ? 0 : i;
+    x0 = pData->xPos - i * pData->xSize;
+    if ((x0 > -(int)pData->xSize) && (x0 < (int)pData->xSize)) {
+      GUI_DrawBitmap(_apBmBack[_aCity[Index].Weather], x0, 0);
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       _Compose
+*
+* Purpose:
+*   Brings the compositor device up to the current position. The
+*   content drawn at the previous position is moved and only the
+*   exposed strip is drawn. Returns the number of pixels drawn, the
+*   number of pixels moved is stored at pNumMoved if it is not NULL.
+*/
+static U32 _Compose(WINDOW_DATA * pData, U32 * pNumMoved) {
+  GUI_MEMDEV_Handle hMemPrev;
+  GUI_RECT          Rect;
+  U8              * pLine;
+  U32               NumMoved;
+  int               dx, xSizeAll, BytesPerPixel, BytesPerLine, y;
+
+  xSizeAll = GUI_COUNTOF(_apBmBack) * pData->xSize;
+  dx = pData->xPos - pData->xPosMem;
+  if (dx > xSizeAll / 2) {
+    dx -= xSizeAll;
+  } else if (dx < -xSizeAll / 2) {
+    dx += xSizeAll;
+  }
+  BytesPerPixel = GUI_MEMDEV_GetBitsPerPixel(pData->hMemBk) / 8;
+  NumMoved = 0;
+  Rect.y0 = 0;
+  Rect.y1 = pData->ySize - 1;
+  if ((pData->xPosMem < 0) || (dx >= pData->xSize) || (dx <= -pData->xSize) || (BytesPerPixel < 2)) {
+    //
+    // Nothing usable in the device, draw all
+    //
+    Rect.x0 = 0;
+    Rect.x1 = pData->xSize - 1;
+  } else if (dx == 0) {
+    if (pNumMoved) {
+      *pNumMoved = 0;
+    }
+    return 0;
+  } else {
+    //
+    // Move the visible part, the bitmaps are only drawn into the exposed strip
+    //
+    BytesPerLine = pData->xSize * BytesPerPixel;
+    pLine = (U8 *)GUI_MEMDEV_GetDataPtr(pData->hMemBk);
+    for (y = 0; y < pData->ySize; y++) {
+      if (dx > 0) {
+        memmove(pLine + dx * BytesPerPixel, pLine, (pData->xSize - dx) * BytesPerPixel);
+      } else {
+        memmove(pLine, pLine - dx * BytesPerPixel, (pData->xSize + dx) * BytesPerPixel);
+      }
+      pLine += BytesPerLine;
+    }
+    NumMoved = (U32)(pData->xSize - ((dx > 0) ? dx : -dx)) * pData->ySize;
+    Rect.x0 = (dx > 0) ? 0      : pData->xSize + dx;
+    Rect.x1 = (dx > 0) ? dx - 1 : pData->xSize - 1;
+  }
+  hMemPrev = GUI_MEMDEV_Select(pData->hMemBk);
+  GUI_SetClipRect(&Rect);
+  _DrawBackground(pData);
+  GUI_SetClipRect(NULL);
+  GUI_MEMDEV_Select(hMemPrev);
+  pData->xPosMem = pData->xPos;
+  if (pNumMoved) {
+    *pNumMoved = NumMoved;
+  }
+  return (U32)(Rect.x1 - Rect.x0 + 1) * pData->ySize;
+}
+
+/*********************************************************************
+*
+*       _SetPos
+*
+* Purpose:
+*   Sets a new position of the backgrounds. Used by the motion support
+*   of the window and by the idle page transition.
+*/
+static void _SetPos(WINDOW_DATA * pData, int xPos, int FinalMove) {
+  int NumItems;
+  U32 NumPixels;
+  U32 NumMoved;
+
+  NumItems = GUI_COUNTOF(_apBmBack);
+  pData->xPos = xPos;
+  if (pData->xPos >= (int)(NumItems * pData->xSize)) {
+    pData->xPos -= NumItems * pData->xSize;
+  }
+  if (pData->xPos < 0) {
+    pData->xPos += NumItems * pData->xSize;
+  }
+  //
+  // Calculate distance
+  //
+  pData->Diff = pData->xPos - pData->IndexCity * pData->xSize;
+  if ((pData->IndexCity == 0) && (pData->Diff > pData->xSize)) {
+    pData->Diff -= pData->xSize * NumItems;
+  }
+  pData->Diff = (pData->Diff > 0) ? pData->Diff : -pData->Diff;
+  //
+  // Calculate alpha value in dependence of window position
+  //
+  if (pData->Diff < pData->xSize) {
+    pData->Alpha = (pData->Diff * 255) / pData->xSize;
+  } else {
+    pData->Alpha = 255;
+  }
+  WM_InvalidateWindow(pData->hText);
+  if (FinalMove) {
+    //
+    // After last move timer method should show forecast
+    //
+    pData->HasStopped = 1;
+    _DrawIndicators(pData);
+  } else {
+    //
+    // On first move hide forecast
+    //
+    pData->HasStopped = 0;
+    if (pData->Diff > (pData->xSize / 3)) {
+      if (pData->LastJob != JOB_ANIM_OUT) {
+        pData->IndexAnimOut = pData->IndexCity;
+        pData->Job = JOB_ANIM_OUT;
+      }
+    }
+  }
+  //
+  // Update compositor and make sure that WM redraws window
+  //
+  if (pData->hMemBk) {
+    NumPixels = _Compose(pData, &NumMoved);
+    if (pData->hAnimBackground) {
+      pData->NumPixels += NumPixels;
+      pData->NumCopied += NumMoved;
+    }
+  }
+  WM_InvalidateWindow(pData->hWin);
+}
+
+/*********************************************************************
+*
+*       _DrawStat
+*
+* Purpose:
+*   Shows frame rate and pixels per frame of the last page transition:
+*   Bitmap pixels drawn and pixels copied, which are the pixels moved
+*   in the compositor device and the pixels written to the screen.
+*/
+static void _DrawStat(WINDOW_DATA * pData) {
+  GUI_RECT Rect;
+  int      tUsed;
+
+  tUsed = GUI_GetTime() - pData->TimeAnim;
+  WM_SelectWindow(pData->hWin);
+  GUI_SelectLayer(1);
+  Rect.x0 = XPOS_STAT;
+  Rect.y0 = pData->ySize - YOFF_STAT;
+  Rect.x1 = Rect.x0 + XSIZE_STAT - 1;
+  Rect.y1 = Rect.y0 + GUI_Font13_ASCII.YSize - 1;
+  GUI_SetBkColor(GUI_TRANSPARENT);
+  GUI_ClearRectEx(&Rect);
+  if (pData->NumFrames && tUsed) {
+    GUI_SetFont(&GUI_Font13_ASCII);
+    GUI_SetColor(GUI_WHITE);
+    GUI_SetTextMode(GUI_TM_TRANS);
+    GUI_DispStringAt("Page: ", Rect.x0, Rect.y0);
+    GUI_DispDecMin((pData->NumFrames * 1000) / tUsed);
+    GUI_DispString(" fps, ");
+    GUI_DispDecMin(pData->NumPixels / pData->NumFrames);
+    GUI_DispString(" drawn + ");
+    GUI_DispDecMin(pData->NumCopied / pData->NumFrames);
+    GUI_DispString(" copied pixels/frame (screen: ");
+    GUI_DispDecMin(pData->xSize * pData->ySize);
+    GUI_DispString(")");
+  }
+  GUI_SelectLayer(0);
+}
+
 /*********************************************************************
 *
 *       _AnimBackground
 *
 * Purpose:
-*   Animation of background pictures. Done by feeding the PID buffer.
+*   Idle page transition of the background pictures. Moves the
+*   backgrounds by one page in a random direction without touching
+*   the PID buffer.
 */
 static void _AnimBackground(GUI_ANIM_INFO * pInfo, void * pVoid) {
   WINDOW_DATA * pData;
-  GUI_PID_STATE State;
-  static int Sign;
+  int xPos;
 
   pData = (WINDOW_DATA *)pVoid;
   pData->TimeLastTouch = GUI_GetTime();
   if (pInfo->State == GUI_ANIM_START) {
-    Sign = ((GUI_GetTime() & 1) * 2) - 1;
-  }
-  State.Layer = 0;
-  State.Pressed = 1;
-  switch (Sign) {
-  case -1:
-    State.x = ((pData->xSize / 2 + 10) * pInfo->Pos) / GUI_ANIM_RANGE;
-    break;
-  case +1:
-    State.x = ((pData->xSize / 2 + 10) * (GUI_ANIM_RANGE - pInfo->Pos)) / GUI_ANIM_RANGE;
-    break;
+    pData->xPosAnim0 = pData->xPos;
+    pData->xPosAnim1 = pData->xPos + (((GUI_GetTime() & 1) * 2) - 1) * pData->xSize;
+    pData->TimeAnim  = GUI_GetTime();
+    pData->NumFrames = 0;
+    pData->NumPixels = 0;
+    pData->NumCopied = 0;
   }
-  State.y = 0;
-  GUI_PID_StoreState(&State);
+  xPos = pData->xPosAnim0 + ((pData->xPosAnim1 - pData->xPosAnim0) * pInfo->Pos) / GUI_ANIM_RANGE;
+  _SetPos(pData, xPos, pInfo->State == GUI_ANIM_END);
   if (pInfo->State == GUI_ANIM_END) {
-    State.Pressed = 0;
-    GUI_PID_StoreState(&State);
+    _DrawStat(pData);
   }
 }
 
@@ -595,7 +809,7 @@ static void _OnTimer(WINDOW_DATA * pData) {
     case JOB_ANIM_IDLE:
       if (pData->hAnimBackground == 0) {
         pData->hAnimBackground = GUI_ANIM_Create(1000, 25, pData, NULL);
-        GUI_ANIM_AddItem(pData->hAnimBackground, 0, 1000, ANIM_ACCEL, pData, _AnimBackground);
+        GUI_ANIM_AddItem(pData->hAnimBackground, 0, 1000, ANIM_ACCELDECEL, pData, _AnimBackground);
         GUI_ANIM_StartEx(pData->hAnimBackground, 1, _OnDeleteAnimBackground);
         pData->Job = 0;
       }
@@ -650,10 +864,8 @@ static void _cbWin(WM_MESSAGE * pMsg) {
   WM_HWIN hWin;
   WINDOW_DATA * pData;
   GUI_PID_STATE State;
-  int i, x0, Index, NumItems;
 
   hWin = pMsg->hWin;
-  NumItems = GUI_COUNTOF(_apBmBack);
   WM_GetUserData(hWin, &pData, sizeof(WINDOW_DATA *));
   if (pData) {
     if (pData->hTimer == 0) {
@@ -667,13 +879,20 @@ static void _cbWin(WM_MESSAGE * pMsg) {
   // Draw background image(s)
   //
   case WM_PAINT:
-    for (i = 0; i <= NumItems; i++) {
-      Index = (i == NumItems) ? 0 : i;
-      x0 = pData->xPos - i * pData->xSize;
-      if ((x0 > -(int)pData->xSize) && (x0 < (int)pData->xSize)) {
-        GUI_DrawBitmap(_apBmBack[_aCity[Index].Weather], x0, 0);
+    if (pData->hMemBk) {
+      GUI_MEMDEV_WriteAt(pData->hMemBk, 0, 0);
+      if (pData->hAnimBackground) {
+        pData->NumCopied += pData->xSize * pData->ySize;
+      }
+    } else {
+      _DrawBackground(pData);
+      if (pData->hAnimBackground) {
+        pData->NumPixels += pData->xSize * pData->ySize;
       }
     }
+    if (pData->hAnimBackground) {
+      pData->NumFrames++;
+    }
     break;
   //
   // Timer keeps the demo alive
@@ -686,16 +905,15 @@ static void _cbWin(WM_MESSAGE * pMsg) {
   //
   case WM_MOTION:
     //
-    // Stop idle animation if it is currently running
+    // Stop idle animation if it is currently running. The animation
+    // does not use the PID buffer, so each touch is a real one.
     //
     GUI_PID_GetCurrentState(&State);
     if (State.Pressed) {
-      if (State.y != 0) {
-        if (pData->hAnimBackground) {
-          GUI_ANIM_Stop(pData->hAnimBackground);
-          GUI_ANIM_Delete(pData->hAnimBackground);
-          pData->hAnimBackground = 0;
-        }
+      if (pData->hAnimBackground) {
+        GUI_ANIM_Stop(pData->hAnimBackground);
+        GUI_ANIM_Delete(pData->hAnimBackground);
+        pData->hAnimBackground = 0;
       }
     }
     //
@@ -719,52 +937,7 @@ static void _cbWin(WM_MESSAGE * pMsg) {
       //
       // Manage motion message
       //
-      pData->xPos += pInfo->dx;
-      if (pData->xPos >= (int)(NumItems * pData->xSize)) {
-        pData->xPos -= NumItems * pData->xSize;
-      }
-      if (pData->xPos < 0) {
-        pData->xPos += NumItems * pData->xSize;
-      }
-      //
-      // Calculate distance
-      //
-      pData->Diff = pData->xPos - pData->IndexCity * pData->xSize;
-      if ((pData->IndexCity == 0) && (pData->Diff > pData->xSize)) {
-        pData->Diff -= pData->xSize * NumItems;
-      }
-      pData->Diff = (pData->Diff > 0) ? pData->Diff : -pData->Diff;
-      //
-      // Calculate alpha value in dependence of window position
-      //
-      if (pData->Diff < pData->xSize) {
-        pData->Alpha = (pData->Diff * 255) / pData->xSize;
-      } else {
-        pData->Alpha = 255;
-      }
-      WM_InvalidateWindow(pData->hText);
-      if (pInfo->FinalMove) {
-        //
-        // After last move timer method should show forecast
-        //
-        pData->HasStopped = 1;
-        _DrawIndicators(pData);
-      } else {
-        //
-        // On first move hide forecast
-        //
-        pData->HasStopped = 0;
-        if (pData->Diff > (pData->xSize / 3)) {
-          if (pData->LastJob != JOB_ANIM_OUT) {
-            pData->IndexAnimOut = pData->IndexCity;
-            pData->Job = JOB_ANIM_OUT;
-          }
-        }
-      }
-      //
-      // Make sure that WM redraws window
-      //
-      WM_Invalidate(hWin);
+      _SetPos(pData, pData->xPos + pInfo->dx, pInfo->FinalMove);
       break;
     case WM_MOTION_GETPOS:
       pInfo->xPos = pData->xPos;
@@ -850,6 +1023,16 @@ void MainTask(void) {
   Data.ySize = LCD_GetYSize();
   Data.TimeLastTouch = GUI_GetTime();
   WM_SetSize(WM_HBKWIN, Data.xSize, Data.ySize);
+  //
+  // Create compositor device for the backgrounds
+  //
+  Data.xPosMem = -1;
+#if (PAGE_COMPOSE)
+  Data.hMemBk = GUI_MEMDEV_CreateEx(0, 0, Data.xSize, Data.ySize, GUI_MEMDEV_NOTRANS);
+  if (Data.hMemBk) {
+    _Compose(pData, NULL);
+  }
+#endif
   //
   // Create background window
   //
@@ -0,0 +1,316 @@
+/*********************************************************************
+File        : Collision.c
+Purpose     : Pixel exact collision detection of bitmap sprites.
+
+              Each sprite bitmap is converted once into a mask with
+              one bit per opaque pixel. Two sprites collide if any row
+              of their masks has a common bit at the same screen
+              position. The rows are compared 32 pixels at a time: The
+              bits of the first mask are shifted to the position of
+              each word of the second mask and both are ANDed, so a
+              row of up to 64 pixels costs two or three operations
+              instead of a function call per pixel.
+
+              Many objects are handled by a sweep-and-prune list: The
+              objects are kept sorted by their x-position, only pairs
+              with overlapping x-ranges are checked further. Since the
+              objects move only a few pixels per frame, the order of
+              the previous frame is nearly sorted and re-sorting it by
+              insertion costs about one comparison per object.
+
+              To use it with a sample, add this file to the project
+              and Sample\Collision to the include path.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#include <string.h>
+
+#include "GUI_Private.h"
+#include "Collision.h"
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       _GetBits
+*
+* Function description
+*   Returns 32 bits of a mask row starting with pixel Off. Pixels
+*   outside of the row are 0.
+*/
+static U32 _GetBits(const U32 * pRow, int NumWords, int Off) {
+  U32 r;
+  int Word;
+  int Shift;
+
+  if ((Off <= -32) || (Off >= NumWords * 32)) {
+    return 0;
+  }
+  if (Off < 0) {
+    return pRow[0] << -Off;
+  }
+  Word  = Off >> 5;
+  Shift = Off & 31;
+  r     = pRow[Word] >> Shift;
+  if (Shift && (Word + 1 < NumWords)) {
+    r |= pRow[Word + 1] << (32 - Shift);
+  }
+  return r;
+}
+
+/*********************************************************************
+*
+*       _Overlap
+*
+* Function description
+*   Checks if the rectangles of two objects overlap in y and tests the
+*   masks if they do. The x-ranges are known to overlap.
+*/
+static int _Overlap(COLLISION_LIST * pList, const COLLISION_OBJ * pObj0, const COLLISION_OBJ * pObj1) {
+  pList->Stat.NumPairs++;
+  if ((pObj1->y >= pObj0->y + pObj0->pMask->ySize) || (pObj0->y >= pObj1->y + pObj1->pMask->ySize)) {
+    return 0;
+  }
+  pList->Stat.NumTests++;
+  if (COLLISION_TestMasks(pObj0->pMask, pObj0->x, pObj0->y, pObj1->pMask, pObj1->x, pObj1->y) == 0) {
+    return 0;
+  }
+  pList->Stat.NumHits++;
+  return 1;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       COLLISION_CreateMask
+*
+* Function description
+*   Creates the mask of a bitmap. If the palette of the bitmap has
+*   transparency, index 0 is transparent, otherwise all pixels are
+*   opaque.
+*
+* Return value
+*   0 on success, 1 if the bitmap is larger than the maximum size.
+*/
+int COLLISION_CreateMask(COLLISION_MASK * pMask, const GUI_BITMAP * pBitmap) {
+  int HasTrans;
+  int x;
+  int y;
+
+  memset(pMask, 0, sizeof(COLLISION_MASK));
+  if ((pBitmap->XSize > COLLISION_MAX_XSIZE) || (pBitmap->YSize > COLLISION_MAX_YSIZE)) {
+    return 1;
+  }
+  pMask->xSize    = pBitmap->XSize;
+  pMask->ySize    = pBitmap->YSize;
+  pMask->NumWords = (pMask->xSize + 31) >> 5;
+  HasTrans        = pBitmap->pPal ? pBitmap->pPal->HasTrans : 0;
+  for (y = 0; y < pMask->ySize; y++) {
+    for (x = 0; x < pMask->xSize; x++) {
+      if ((HasTrans == 0) || GUI_GetBitmapPixelIndex(pBitmap, x, y)) {
+        pMask->aaRow[y][x >> 5] |= (U32)1 << (x & 31);
+      }
+    }
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       COLLISION_TestMasks
+*
+* Function description
+*   Checks if two masks at the given positions have a common opaque
+*   pixel.
+*
+* Return value
+*   1 if the masks collide, 0 if not.
+*/
+int COLLISION_TestMasks(const COLLISION_MASK * pMask0, int x0, int y0, const COLLISION_MASK * pMask1, int x1, int y1) {
+  const U32 * pRow0;
+  const U32 * pRow1;
+  int         yStart;
+  int         yEnd;
+  int         dx;
+  int         y;
+  int         i;
+
+  yStart = (y0 > y1) ? y0 : y1;
+  yEnd   = ((y0 + pMask0->ySize) < (y1 + pMask1->ySize)) ? (y0 + pMask0->ySize) : (y1 + pMask1->ySize);
+  dx     = x1 - x0;
+  if ((dx >= pMask0->xSize) || (-dx >= pMask1->xSize)) {
+    return 0;
+  }
+  for (y = yStart; y < yEnd; y++) {
+    pRow0 = pMask0->aaRow[y - y0];
+    pRow1 = pMask1->aaRow[y - y1];
+    for (i = 0; i < pMask1->NumWords; i++) {
+      if (pRow1[i] & _GetBits(pRow0, pMask0->NumWords, dx + i * 32)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       COLLISION_InitList
+*
+* Function description
+*   Initializes an empty list. The array papObj is used to keep the
+*   sorted objects and has to remain valid as long as the list is used.
+*/
+void COLLISION_InitList(COLLISION_LIST * pList, COLLISION_OBJ ** papObj, int NumObjectsMax) {
+  memset(pList, 0, sizeof(COLLISION_LIST));
+  pList->papObj        = papObj;
+  pList->NumObjectsMax = NumObjectsMax;
+}
+
+/*********************************************************************
+*
+*       COLLISION_AddObj
+*
+* Return value
+*   0 on success, 1 if the list is full.
+*/
+int COLLISION_AddObj(COLLISION_LIST * pList, COLLISION_OBJ * pObj) {
+  if (pList->NumObjects >= pList->NumObjectsMax) {
+    return 1;
+  }
+  pList->papObj[pList->NumObjects++] = pObj;
+  if (pList->xSizeMax < pObj->pMask->xSize) {
+    pList->xSizeMax = pObj->pMask->xSize;
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       COLLISION_Update
+*
+* Function description
+*   Sorts the list by x after the objects have been moved. Has to be
+*   called before COLLISION_Query() or COLLISION_FindPairs().
+*/
+void COLLISION_Update(COLLISION_LIST * pList) {
+  COLLISION_OBJ ** papObj;
+  COLLISION_OBJ  * pObj;
+  int              i;
+  int              j;
+
+  papObj = pList->papObj;
+  for (i = 1; i < pList->NumObjects; i++) {
+    pObj = papObj[i];
+    for (j = i; (j > 0) && (papObj[j - 1]->x > pObj->x); j--) {
+      papObj[j] = papObj[j - 1];
+    }
+    papObj[j] = pObj;
+  }
+}
+
+/*********************************************************************
+*
+*       COLLISION_Query
+*
+* Function description
+*   Finds the objects of the list colliding with the given object. The
+*   object itself may be part of the list, it is skipped then.
+*
+* Return value
+*   Number of colliding objects. Only the first NumHitsMax of them are
+*   stored in papHit.
+*/
+int COLLISION_Query(COLLISION_LIST * pList, const COLLISION_OBJ * pObj, COLLISION_OBJ ** papHit, int NumHitsMax) {
+  COLLISION_OBJ * pObj1;
+  int             xStart;
+  int             xEnd;
+  int             NumHits;
+  int             i0;
+  int             i1;
+  int             i;
+
+  //
+  // Binary search for the first object which may reach into the
+  // x-range of the given object
+  //
+  xStart = pObj->x - pList->xSizeMax + 1;
+  xEnd   = pObj->x + pObj->pMask->xSize;
+  i0     = 0;
+  i1     = pList->NumObjects;
+  while (i0 < i1) {
+    i = (i0 + i1) >> 1;
+    if (pList->papObj[i]->x < xStart) {
+      i0 = i + 1;
+    } else {
+      i1 = i;
+    }
+  }
+  NumHits = 0;
+  for (i = i0; i < pList->NumObjects; i++) {
+    pObj1 = pList->papObj[i];
+    if (pObj1->x >= xEnd) {
+      break;
+    }
+    if ((pObj1 == pObj) || (pObj1->x + pObj1->pMask->xSize <= pObj->x)) {
+      continue;
+    }
+    if (_Overlap(pList, pObj, pObj1)) {
+      if (NumHits < NumHitsMax) {
+        papHit[NumHits] = pObj1;
+      }
+      NumHits++;
+    }
+  }
+  return NumHits;
+}
+
+/*********************************************************************
+*
+*       COLLISION_FindPairs
+*
+* Function description
+*   Finds all colliding pairs of objects of the list and calls the
+*   given function for each of them.
+*
+* Return value
+*   Number of colliding pairs.
+*/
+int COLLISION_FindPairs(COLLISION_LIST * pList, COLLISION_PAIR_FUNC * pfPair, void * p) {
+  COLLISION_OBJ * pObj0;
+  COLLISION_OBJ * pObj1;
+  int             NumHits;
+  int             xEnd;
+  int             i;
+  int             j;
+
+  NumHits = 0;
+  for (i = 0; i < pList->NumObjects; i++) {
+    pObj0 = pList->papObj[i];
+    xEnd  = pObj0->x + pObj0->pMask->xSize;
+    for (j = i + 1; j < pList->NumObjects; j++) {
+      pObj1 = pList->papObj[j];
+      if (pObj1->x >= xEnd) {
+        break;
+      }
+      if (_Overlap(pList, pObj0, pObj1)) {
+        if (pfPair) {
+          pfPair(pObj0, pObj1, p);
+        }
+        NumHits++;
+      }
+    }
+  }
+  return NumHits;
+}
+
+/*************************** End of file ****************************/
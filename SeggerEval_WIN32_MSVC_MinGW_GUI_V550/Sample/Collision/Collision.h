@@ -0,0 +1,88 @@
+/*********************************************************************
+File        : Collision.h
+Purpose     : Pixel exact collision detection of bitmap sprites for
+              the game samples.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "GUI.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+//
+// Maximum size of a sprite bitmap in pixels
+//
+#ifndef   COLLISION_MAX_XSIZE
+  #define COLLISION_MAX_XSIZE  64
+#endif
+#ifndef   COLLISION_MAX_YSIZE
+  #define COLLISION_MAX_YSIZE  64
+#endif
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+#define COLLISION_NUM_WORDS  ((COLLISION_MAX_XSIZE + 31) / 32)  // Number of 32 bit words per mask row
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  U32 aaRow[COLLISION_MAX_YSIZE][COLLISION_NUM_WORDS];  // One bit per pixel, bit n of word m is pixel 32 * m + n
+  int xSize;
+  int ySize;
+  int NumWords;                                         // Number of words used per row
+} COLLISION_MASK;
+
+typedef struct {
+  const COLLISION_MASK * pMask;
+  int                    x;      // Position of the upper left corner of the sprite
+  int                    y;
+} COLLISION_OBJ;
+
+typedef struct {
+  U32 NumPairs;    // Number of pairs with overlapping x-ranges found by the sweep
+  U32 NumTests;    // Number of pairs with overlapping rectangles tested bit by bit
+  U32 NumHits;     // Number of colliding pairs
+} COLLISION_STAT;
+
+typedef struct {
+  COLLISION_OBJ ** papObj;        // Objects sorted by x, array of the application
+  int              NumObjects;
+  int              NumObjectsMax;
+  int              xSizeMax;      // Width of the widest object, limits the search range of a query
+  COLLISION_STAT   Stat;
+} COLLISION_LIST;
+
+typedef void COLLISION_PAIR_FUNC(COLLISION_OBJ * pObj0, COLLISION_OBJ * pObj1, void * p);
+
+/*********************************************************************
+*
+*       Public functions
+*
+**********************************************************************
+*/
+int  COLLISION_CreateMask(COLLISION_MASK * pMask, const GUI_BITMAP * pBitmap);
+int  COLLISION_TestMasks (const COLLISION_MASK * pMask0, int x0, int y0, const COLLISION_MASK * pMask1, int x1, int y1);
+void COLLISION_InitList  (COLLISION_LIST * pList, COLLISION_OBJ ** papObj, int NumObjectsMax);
+int  COLLISION_AddObj    (COLLISION_LIST * pList, COLLISION_OBJ * pObj);
+void COLLISION_Update    (COLLISION_LIST * pList);
+int  COLLISION_Query     (COLLISION_LIST * pList, const COLLISION_OBJ * pObj, COLLISION_OBJ ** papHit, int NumHitsMax);
+int  COLLISION_FindPairs (COLLISION_LIST * pList, COLLISION_PAIR_FUNC * pfPair, void * p);
+
+#endif // COLLISION_H
+
+/*************************** End of file ****************************/
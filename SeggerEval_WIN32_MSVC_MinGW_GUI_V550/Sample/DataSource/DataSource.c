@@ -0,0 +1,509 @@
+/*********************************************************************
+File        : DataSource.c
+Purpose     : Shared block cached data source for the GetData
+              callbacks of the streamed image, movie and XBF samples.
+
+              All samples which stream their data from a file system
+              use the functions of this module instead of an own
+              seek-then-read callback. Requests are served from a
+              small cache of aligned blocks. Sequential accesses (movie
+              frames, JPEG scan data, PNG chunks) are detected and
+              served by reading several blocks with one backend call.
+              With the mmap backend the data is accessed directly
+              without any copy.
+
+              To use it with a sample, add this file to the project
+              and Sample\DataSource to the include path.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+//
+// pread() is not declared by glibc in strict ISO C mode (-std=c99).
+// The feature test macro has to be defined before the first include.
+//
+#if !defined(WIN32) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE  200809L
+#endif
+
+#include <string.h>
+
+#include "DataSource.h"
+
+#if   (DATASOURCE_BACKEND == DATASOURCE_BACKEND_WIN32)
+  #include <windows.h>
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_POSIX) || (DATASOURCE_BACKEND == DATASOURCE_BACKEND_MMAP)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+#else
+  #include "FS.h"
+#endif
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+#define BLOCK_INVALID  0xFFFFFFFF
+
+#if (DATASOURCE_BACKEND != DATASOURCE_BACKEND_MMAP)
+  #define USE_CACHE  1
+#else
+  #define USE_CACHE  0
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+struct DATASOURCE {
+  int             InUse;
+  U32             FileSize;
+#if   (DATASOURCE_BACKEND == DATASOURCE_BACKEND_WIN32)
+  HANDLE          hFile;
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_POSIX)
+  int             hFile;
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_MMAP)
+  int             hFile;
+  const U8      * pMap;
+#else
+  FS_FILE       * pFile;
+#endif
+#if USE_CACHE
+  U32             aBlock[DATASOURCE_NUM_BLOCKS];  // Index of the file block held by each cache block
+  U32             aAge  [DATASOURCE_NUM_BLOCKS];  // Time of last use, for LRU replacement
+  U32             Age;
+  U32             LastBlock;                      // Last block read from the backend
+  unsigned        NumSeq;                         // Number of sequential misses in a row
+  U32             aCache[DATASOURCE_NUM_BLOCKS * DATASOURCE_BLOCK_SIZE / 4];
+  U32             aStage[DATASOURCE_BLOCK_SIZE / 4];  // Used for requests crossing a block boundary
+#endif
+  DATASOURCE_STAT Stat;
+};
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static DATASOURCE _aSource[DATASOURCE_MAX_OPEN];
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+#if USE_CACHE
+/*********************************************************************
+*
+*       _ReadBackend
+*
+* Function description
+*   Reads the given number of bytes from the file. Returns the number
+*   of bytes read.
+*/
+static U32 _ReadBackend(DATASOURCE * pSrc, void * pBuffer, U32 Off, U32 NumBytes) {
+  U32 NumBytesRead;
+
+#if   (DATASOURCE_BACKEND == DATASOURCE_BACKEND_WIN32)
+  DWORD NumBytesWin;
+
+  pSrc->Stat.NumSysCalls += 2;
+  SetFilePointer(pSrc->hFile, Off, 0, FILE_BEGIN);
+  if (!ReadFile(pSrc->hFile, pBuffer, NumBytes, &NumBytesWin, NULL)) {
+    NumBytesWin = 0;
+  }
+  NumBytesRead = NumBytesWin;
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_POSIX)
+  ssize_t r;
+
+  pSrc->Stat.NumSysCalls++;
+  r = pread(pSrc->hFile, pBuffer, NumBytes, Off);
+  NumBytesRead = (r > 0) ? (U32)r : 0;
+#else
+  pSrc->Stat.NumSysCalls += 2;
+  FS_SetFilePos(pSrc->pFile, Off, FS_FILE_BEGIN);
+  NumBytesRead = FS_Read(pSrc->pFile, pBuffer, NumBytes);
+#endif
+  pSrc->Stat.NumBytesRead += NumBytesRead;
+  return NumBytesRead;
+}
+
+/*********************************************************************
+*
+*       _GetBlock
+*
+* Function description
+*   Returns a pointer to the cached data of the given file block.
+*   On a miss the block is read from the backend. If the previous
+*   miss was the block before, the number of blocks read at once is
+*   doubled up to DATASOURCE_READ_AHEAD.
+*/
+static U8 * _GetBlock(DATASOURCE * pSrc, U32 Block) {
+  U32      NumBlocksFile;
+  U32      NumBytes;
+  U8     * pCache;
+  unsigned NumRead;
+  unsigned iOld;
+  unsigned i;
+
+  pCache = (U8 *)pSrc->aCache;
+  for (i = 0; i < DATASOURCE_NUM_BLOCKS; i++) {
+    if (pSrc->aBlock[i] == Block) {
+      pSrc->aAge[i] = ++pSrc->Age;
+      return pCache + i * DATASOURCE_BLOCK_SIZE;
+    }
+  }
+  //
+  // Detect sequential access and calculate number of blocks to be read
+  //
+  if ((pSrc->LastBlock != BLOCK_INVALID) && (Block == pSrc->LastBlock + 1)) {
+    if ((1u << pSrc->NumSeq) < DATASOURCE_READ_AHEAD) {
+      pSrc->NumSeq++;
+    }
+  } else {
+    pSrc->NumSeq = 0;
+  }
+  NumRead = 1u << pSrc->NumSeq;
+  if (NumRead > DATASOURCE_READ_AHEAD) {
+    NumRead = DATASOURCE_READ_AHEAD;
+  }
+  NumBlocksFile = (pSrc->FileSize + DATASOURCE_BLOCK_SIZE - 1) / DATASOURCE_BLOCK_SIZE;
+  if (Block + NumRead > NumBlocksFile) {
+    NumRead = NumBlocksFile - Block;
+  }
+  //
+  // Use the least recently used block. The blocks of a read ahead have
+  // to be contiguous in the cache.
+  //
+  iOld = 0;
+  for (i = 1; i < DATASOURCE_NUM_BLOCKS; i++) {
+    if (pSrc->aAge[i] < pSrc->aAge[iOld]) {
+      iOld = i;
+    }
+  }
+  if (iOld + NumRead > DATASOURCE_NUM_BLOCKS) {
+    iOld = DATASOURCE_NUM_BLOCKS - NumRead;
+  }
+  NumBytes = _ReadBackend(pSrc, pCache + iOld * DATASOURCE_BLOCK_SIZE, Block * DATASOURCE_BLOCK_SIZE, NumRead * DATASOURCE_BLOCK_SIZE);
+  if (NumBytes == 0) {
+    for (i = 0; i < NumRead; i++) {
+      pSrc->aBlock[iOld + i] = BLOCK_INVALID;
+    }
+    pSrc->LastBlock = BLOCK_INVALID;
+    return NULL;
+  }
+  NumRead = (NumBytes + DATASOURCE_BLOCK_SIZE - 1) / DATASOURCE_BLOCK_SIZE;
+  for (i = 0; i < NumRead; i++) {
+    pSrc->aBlock[iOld + i] = Block + i;
+    pSrc->aAge  [iOld + i] = ++pSrc->Age;
+  }
+  pSrc->LastBlock = Block + NumRead - 1;
+  return pCache + iOld * DATASOURCE_BLOCK_SIZE;
+}
+#endif
+
+/*********************************************************************
+*
+*       _ClipRequest
+*
+* Function description
+*   Clips the request to the end of the file and updates the statistics.
+*/
+static unsigned _ClipRequest(DATASOURCE * pSrc, U32 Off, unsigned NumBytes) {
+  pSrc->Stat.NumReq++;
+  if (Off >= pSrc->FileSize) {
+    return 0;
+  }
+  if (NumBytes > pSrc->FileSize - Off) {
+    NumBytes = pSrc->FileSize - Off;
+  }
+  pSrc->Stat.NumBytesReq += NumBytes;
+  return NumBytes;
+}
+
+/*********************************************************************
+*
+*       _Read
+*/
+static unsigned _Read(DATASOURCE * pSrc, U8 * pBuffer, U32 Off, unsigned NumBytes) {
+#if USE_CACHE
+  unsigned NumBytesBlock;
+  unsigned NumBytesCopied;
+  unsigned OffBlock;
+  U8     * pBlock;
+
+  NumBytesCopied = 0;
+  while (NumBytes) {
+    pBlock = _GetBlock(pSrc, Off / DATASOURCE_BLOCK_SIZE);
+    if (pBlock == NULL) {
+      break;
+    }
+    OffBlock      = Off & (DATASOURCE_BLOCK_SIZE - 1);
+    NumBytesBlock = DATASOURCE_BLOCK_SIZE - OffBlock;
+    if (NumBytesBlock > NumBytes) {
+      NumBytesBlock = NumBytes;
+    }
+    memcpy(pBuffer, pBlock + OffBlock, NumBytesBlock);
+    pBuffer        += NumBytesBlock;
+    Off            += NumBytesBlock;
+    NumBytes       -= NumBytesBlock;
+    NumBytesCopied += NumBytesBlock;
+  }
+  return NumBytesCopied;
+#else
+  memcpy(pBuffer, pSrc->pMap + Off, NumBytes);
+  return NumBytes;
+#endif
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       DATASOURCE_Open
+*
+* Function description
+*   Opens the given file for reading. Returns NULL on error.
+*/
+DATASOURCE * DATASOURCE_Open(const char * sFileName) {
+  DATASOURCE * pSrc;
+  unsigned     i;
+#if (DATASOURCE_BACKEND == DATASOURCE_BACKEND_POSIX) || (DATASOURCE_BACKEND == DATASOURCE_BACKEND_MMAP)
+  struct stat  Stat;
+#endif
+
+  pSrc = NULL;
+  for (i = 0; i < DATASOURCE_MAX_OPEN; i++) {
+    if (_aSource[i].InUse == 0) {
+      pSrc = &_aSource[i];
+      break;
+    }
+  }
+  if (pSrc == NULL) {
+    return NULL;
+  }
+  memset(&pSrc->Stat, 0, sizeof(pSrc->Stat));
+#if   (DATASOURCE_BACKEND == DATASOURCE_BACKEND_WIN32)
+  pSrc->hFile = CreateFile(sFileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if (pSrc->hFile == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+  pSrc->FileSize = GetFileSize(pSrc->hFile, NULL);
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_POSIX) || (DATASOURCE_BACKEND == DATASOURCE_BACKEND_MMAP)
+  pSrc->hFile = open(sFileName, O_RDONLY);
+  if (pSrc->hFile < 0) {
+    return NULL;
+  }
+  if (fstat(pSrc->hFile, &Stat) != 0) {
+    close(pSrc->hFile);
+    return NULL;
+  }
+  pSrc->FileSize = (U32)Stat.st_size;
+  #if (DATASOURCE_BACKEND == DATASOURCE_BACKEND_MMAP)
+  pSrc->pMap = NULL;
+  if (pSrc->FileSize) {
+    void * p;
+
+    p = mmap(NULL, pSrc->FileSize, PROT_READ, MAP_PRIVATE, pSrc->hFile, 0);
+    if (p == MAP_FAILED) {
+      close(pSrc->hFile);
+      return NULL;
+    }
+    pSrc->pMap = (const U8 *)p;
+  }
+  #endif
+#else
+  pSrc->pFile = FS_FOpen(sFileName, "r");
+  if (pSrc->pFile == NULL) {
+    return NULL;
+  }
+  pSrc->FileSize = FS_GetFileSize(pSrc->pFile);
+#endif
+  pSrc->InUse = 1;
+  DATASOURCE_Invalidate(pSrc);
+  return pSrc;
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_Close
+*/
+void DATASOURCE_Close(DATASOURCE * pSrc) {
+  if ((pSrc == NULL) || (pSrc->InUse == 0)) {
+    return;
+  }
+#if   (DATASOURCE_BACKEND == DATASOURCE_BACKEND_WIN32)
+  CloseHandle(pSrc->hFile);
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_POSIX)
+  close(pSrc->hFile);
+#elif (DATASOURCE_BACKEND == DATASOURCE_BACKEND_MMAP)
+  if (pSrc->pMap) {
+    munmap((void *)pSrc->pMap, pSrc->FileSize);
+  }
+  close(pSrc->hFile);
+#else
+  FS_FClose(pSrc->pFile);
+#endif
+  pSrc->InUse = 0;
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_GetSize
+*/
+U32 DATASOURCE_GetSize(DATASOURCE * pSrc) {
+  return pSrc->FileSize;
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_GetStat
+*/
+void DATASOURCE_GetStat(DATASOURCE * pSrc, DATASOURCE_STAT * pStat) {
+  *pStat = pSrc->Stat;
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_Invalidate
+*
+* Function description
+*   Discards all cached blocks, e.g. if the file has been changed.
+*/
+void DATASOURCE_Invalidate(DATASOURCE * pSrc) {
+#if USE_CACHE
+  unsigned i;
+
+  for (i = 0; i < DATASOURCE_NUM_BLOCKS; i++) {
+    pSrc->aBlock[i] = BLOCK_INVALID;
+    pSrc->aAge[i]   = 0;
+  }
+  pSrc->Age       = 0;
+  pSrc->LastBlock = BLOCK_INVALID;
+  pSrc->NumSeq    = 0;
+#else
+  GUI_USE_PARA(pSrc);
+#endif
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_Read
+*
+* Function description
+*   Copies data of the file into the given buffer. Returns the number
+*   of bytes copied.
+*/
+int DATASOURCE_Read(DATASOURCE * pSrc, void * pBuffer, U32 Off, unsigned NumBytes) {
+  U32 NumSysCalls;
+  int r;
+
+  NumSysCalls = pSrc->Stat.NumSysCalls;
+  NumBytes    = _ClipRequest(pSrc, Off, NumBytes);
+  r           = _Read(pSrc, (U8 *)pBuffer, Off, NumBytes);
+  if (NumSysCalls == pSrc->Stat.NumSysCalls) {
+    pSrc->Stat.NumHits++;
+  }
+  return r;
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_GetData
+*
+* Function description
+*   GetData function for the decoders which use the data at the
+*   location *ppData is set to (JPEG, GIF, BMP). The data is valid
+*   until the next call. Requests crossing a block boundary are
+*   copied into a staging buffer of DATASOURCE_BLOCK_SIZE bytes, so
+*   larger requests return a short count.
+*
+* Return value
+*   Number of data bytes available.
+*/
+int DATASOURCE_GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off) {
+  DATASOURCE * pSrc;
+#if USE_CACHE
+  U32          NumSysCalls;
+  unsigned     OffBlock;
+  U8         * pBlock;
+#endif
+
+  pSrc        = (DATASOURCE *)p;
+  NumBytesReq = _ClipRequest(pSrc, Off, NumBytesReq);
+  if (NumBytesReq == 0) {
+    return 0;
+  }
+#if USE_CACHE
+  NumSysCalls = pSrc->Stat.NumSysCalls;
+  OffBlock    = Off & (DATASOURCE_BLOCK_SIZE - 1);
+  if (OffBlock + NumBytesReq <= DATASOURCE_BLOCK_SIZE) {
+    //
+    // Request fits into one block, no copy required
+    //
+    pBlock = _GetBlock(pSrc, Off / DATASOURCE_BLOCK_SIZE);
+    if (pBlock == NULL) {
+      return 0;
+    }
+    *ppData = pBlock + OffBlock;
+  } else {
+    if (NumBytesReq > DATASOURCE_BLOCK_SIZE) {
+      NumBytesReq = DATASOURCE_BLOCK_SIZE;
+    }
+    NumBytesReq = _Read(pSrc, (U8 *)pSrc->aStage, Off, NumBytesReq);
+    *ppData     = (const U8 *)pSrc->aStage;
+  }
+  if (NumSysCalls == pSrc->Stat.NumSysCalls) {
+    pSrc->Stat.NumHits++;
+  }
+#else
+  *ppData = pSrc->pMap + Off;
+  pSrc->Stat.NumHits++;
+#endif
+  return NumBytesReq;
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_GetDataCopy
+*
+* Function description
+*   GetData function for the decoders which pass their own buffer in
+*   *ppData (PNG, movie).
+*
+* Return value
+*   Number of data bytes copied.
+*/
+int DATASOURCE_GetDataCopy(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off) {
+  return DATASOURCE_Read((DATASOURCE *)p, (U8 *)*ppData, Off, NumBytesReq);
+}
+
+/*********************************************************************
+*
+*       DATASOURCE_GetDataXBF
+*
+* Function description
+*   GetData function for XBF fonts.
+*
+* Return value
+*   0 on success, 1 on error
+*/
+int DATASOURCE_GetDataXBF(U32 Off, U16 NumBytes, void * p, void * pBuffer) {
+  if (DATASOURCE_Read((DATASOURCE *)p, pBuffer, Off, NumBytes) != NumBytes) {
+    return 1; // Error
+  }
+  return 0;   // Ok
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,110 @@
+/*********************************************************************
+File        : DataSource.h
+Purpose     : Shared block cached data source for the GetData
+              callbacks of the streamed image, movie and XBF samples.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#ifndef DATASOURCE_H
+#define DATASOURCE_H
+
+#include "GUI.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+//
+// Backend used to access the files. The default depends on the
+// build environment and can be overridden by the project settings.
+//
+#define DATASOURCE_BACKEND_WIN32   0  // SetFilePointer() + ReadFile()
+#define DATASOURCE_BACKEND_POSIX   1  // pread()
+#define DATASOURCE_BACKEND_MMAP    2  // mmap() of the complete file, no block cache required
+#define DATASOURCE_BACKEND_EMFILE  3  // FS_SetFilePos() + FS_Read()
+
+#ifndef   DATASOURCE_BACKEND
+  #if   defined(WIN32)
+    #define DATASOURCE_BACKEND  DATASOURCE_BACKEND_WIN32
+  #elif defined(__unix__) || defined(__APPLE__)
+    #define DATASOURCE_BACKEND  DATASOURCE_BACKEND_MMAP
+  #else
+    #define DATASOURCE_BACKEND  DATASOURCE_BACKEND_EMFILE
+  #endif
+#endif
+
+//
+// Size of one cache block, has to be a power of 2. Blocks are aligned
+// to multiples of this size within the file.
+//
+#ifndef   DATASOURCE_BLOCK_SIZE
+  #define DATASOURCE_BLOCK_SIZE  4096
+#endif
+
+//
+// Number of cache blocks per data source
+//
+#ifndef   DATASOURCE_NUM_BLOCKS
+  #define DATASOURCE_NUM_BLOCKS  8
+#endif
+
+//
+// Maximum number of blocks read by one access when sequential
+// reading has been detected
+//
+#ifndef   DATASOURCE_READ_AHEAD
+  #define DATASOURCE_READ_AHEAD  4
+#endif
+
+//
+// Maximum number of data sources opened at the same time
+//
+#ifndef   DATASOURCE_MAX_OPEN
+  #define DATASOURCE_MAX_OPEN    2
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct DATASOURCE DATASOURCE;
+
+typedef struct {
+  U32 NumReq;       // Number of requests of the decoder
+  U32 NumHits;      // Number of requests served completely from the cache
+  U32 NumSysCalls;  // Number of seek and read calls to the backend
+  U32 NumBytesReq;  // Number of bytes requested by the decoder
+  U32 NumBytesRead; // Number of bytes read from the backend
+} DATASOURCE_STAT;
+
+/*********************************************************************
+*
+*       Public functions
+*
+**********************************************************************
+*/
+DATASOURCE * DATASOURCE_Open      (const char * sFileName);
+void         DATASOURCE_Close     (DATASOURCE * pSrc);
+U32          DATASOURCE_GetSize   (DATASOURCE * pSrc);
+void         DATASOURCE_GetStat   (DATASOURCE * pSrc, DATASOURCE_STAT * pStat);
+void         DATASOURCE_Invalidate(DATASOURCE * pSrc);
+int          DATASOURCE_Read      (DATASOURCE * pSrc, void * pBuffer, U32 Off, unsigned NumBytes);
+
+//
+// GetData functions to be passed to emWin. The application defined
+// pointer p has to be the DATASOURCE pointer returned by DATASOURCE_Open().
+// DATASOURCE_GetData() returns at most DATASOURCE_BLOCK_SIZE bytes for a
+// request crossing a block boundary, so the return value may be less
+// than NumBytesReq.
+//
+int DATASOURCE_GetData    (void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off);  // Sets *ppData to the cache (JPEG, GIF, BMP)
+int DATASOURCE_GetDataCopy(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off);  // Copies into the buffer given by *ppData (PNG, movie)
+int DATASOURCE_GetDataXBF (U32 Off, U16 NumBytes, void * p, void * pBuffer);              // GUI_XBF_GET_DATA_FUNC
+
+#endif // DATASOURCE_H
+
+/*************************** End of file ****************************/
@@ -0,0 +1,315 @@
+/*********************************************************************
+File        : DataSource_Bench.c
+Purpose     : Host benchmark of the data source module. Not part of
+              the simulation project.
+
+              Replays the access patterns of the streamed samples
+              against a generated file and compares the data source
+              with the seek-then-read callbacks the samples used
+              before. Reports backend calls per request and MB/s for
+              each pattern and checks the returned data.
+
+              Build and run on a POSIX host, once per backend:
+                gcc -std=c99 -O2 -IGUI/Include -IConfig -ISample/DataSource
+                    -DDATASOURCE_BACKEND=1 Sample/DataSource/DataSource.c
+                    Sample/DataSource/DataSource_Bench.c -o dsbench
+                ./dsbench [file]
+              DATASOURCE_BACKEND=1 is pread() with the block cache,
+              2 is mmap(). The timings depend on the page cache of the
+              host, the number of backend calls does not.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#if !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE  200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "DataSource.h"
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+#define FILE_SIZE      (4 * 1024 * 1024)
+#define MIN_BYTES      (64 * 1024 * 1024)  // Each pattern is repeated until at least this much data has been requested
+#define NUM_RANDOM     4096
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  U32      Off;
+  unsigned NumBytes;
+} REQ;
+
+typedef struct {
+  const char * sName;
+  int          Mode;      // 0: GetData (pointer), 1: GetDataCopy, 2: GetDataXBF
+  REQ        * paReq;
+  unsigned     NumReq;
+} PATTERN;
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static U8       * _pRef;
+static U8         _aBuffer[64 * 1024];
+static int        _hFile;
+static unsigned   _NumSysCallsOld;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       _GetDataOld
+*
+* Function description
+*   Callback as used by the samples before: seek and read for every
+*   request, also for the requests which ask for a few bytes only.
+*/
+static int _GetDataOld(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off) {
+  int NumBytesRead;
+
+  GUI_USE_PARA(p);
+  _NumSysCallsOld += 2;
+  lseek(_hFile, Off, SEEK_SET);
+  NumBytesRead = (int)read(_hFile, (void *)*ppData, NumBytesReq);
+  return (NumBytesRead < 0) ? 0 : NumBytesRead;
+}
+
+/*********************************************************************
+*
+*       _Seconds
+*/
+static double _Seconds(void) {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*********************************************************************
+*
+*       _Rand
+*/
+static U32 _Rand(void) {
+  static U32 Seed = 34;
+
+  Seed = Seed * 1103515245 + 12345;
+  return Seed >> 8;
+}
+
+/*********************************************************************
+*
+*       _MakePatterns
+*
+* Function description
+*   Builds the request lists of the samples:
+*   - JPEG/BMP/GIF decoders read the file front to back in small
+*     pieces and use the data at the returned pointer.
+*   - The PNG decoder copies chunks of a few KB.
+*   - The movie player copies one complete frame per request.
+*   - XBF fonts read the index entry and the glyph data of each
+*     character, spread over the whole file.
+*   - Random requests of 1 to 6000 bytes as the worst case.
+*/
+static unsigned _MakePatterns(PATTERN * paPattern) {
+  static REQ aJPEG[FILE_SIZE / 512];
+  static REQ aPNG[FILE_SIZE / 8192 + 1];
+  static REQ aMovie[FILE_SIZE / 20000 + 1];
+  static REQ aXBF[NUM_RANDOM * 2];
+  static REQ aRandom[NUM_RANDOM];
+  unsigned  i;
+  unsigned  n;
+  U32       Off;
+
+  for (i = 0; i < GUI_COUNTOF(aJPEG); i++) {
+    aJPEG[i].Off      = i * 512;
+    aJPEG[i].NumBytes = 512;
+  }
+  for (n = 0, Off = 0; Off < FILE_SIZE; n++) {
+    aPNG[n].Off      = Off;
+    aPNG[n].NumBytes = 8192 - (_Rand() % 4096);
+    Off += aPNG[n].NumBytes;
+  }
+  paPattern[1].NumReq = n;
+  for (n = 0, Off = 0; Off < FILE_SIZE; n++) {
+    aMovie[n].Off      = Off;
+    aMovie[n].NumBytes = 20000 + (_Rand() % 8000);
+    Off += aMovie[n].NumBytes;
+  }
+  paPattern[2].NumReq = n;
+  for (i = 0; i < NUM_RANDOM; i++) {
+    U32 Char = _Rand() % 3000;
+
+    aXBF[2 * i].Off          = 256 + Char * 8;
+    aXBF[2 * i].NumBytes     = 8;
+    aXBF[2 * i + 1].Off      = 65536 + Char * 600;
+    aXBF[2 * i + 1].NumBytes = 40 + (_Rand() % 200);
+    aRandom[i].Off           = _Rand() % (FILE_SIZE - 6000);
+    aRandom[i].NumBytes      = 1 + (_Rand() % 6000);
+  }
+  paPattern[0].sName = "JPEG 512 B seq";
+  paPattern[0].Mode  = 0;
+  paPattern[0].paReq = aJPEG;
+  paPattern[0].NumReq = GUI_COUNTOF(aJPEG);
+  paPattern[1].sName = "PNG 4-8 KB copy";
+  paPattern[1].Mode  = 1;
+  paPattern[1].paReq = aPNG;
+  paPattern[2].sName = "movie frame copy";
+  paPattern[2].Mode  = 1;
+  paPattern[2].paReq = aMovie;
+  paPattern[3].sName = "XBF glyphs";
+  paPattern[3].Mode  = 2;
+  paPattern[3].paReq = aXBF;
+  paPattern[3].NumReq = GUI_COUNTOF(aXBF);
+  paPattern[4].sName = "random 1-6000 B";
+  paPattern[4].Mode  = 0;
+  paPattern[4].paReq = aRandom;
+  paPattern[4].NumReq = NUM_RANDOM;
+  return 5;
+}
+
+/*********************************************************************
+*
+*       _Run
+*
+* Function description
+*   Runs one pattern with the old callback (pSrc == NULL) or with the
+*   data source. Returns the number of errors.
+*/
+static int _Run(const PATTERN * pPattern, DATASOURCE * pSrc, double * pMBs, double * pCallsPerReq) {
+  DATASOURCE_STAT Stat;
+  double          Bytes;
+  double          t;
+  unsigned        NumReq;
+  unsigned        i;
+  const U8      * pData;
+  int             r;
+  int             NumErrors;
+
+  NumErrors       = 0;
+  Bytes           = 0;
+  NumReq          = 0;
+  _NumSysCallsOld = 0;
+  if (pSrc) {
+    DATASOURCE_Invalidate(pSrc);
+    DATASOURCE_GetStat(pSrc, &Stat);
+    _NumSysCallsOld = 0 - Stat.NumSysCalls;  // The statistics are never reset, use the difference
+  }
+  t = _Seconds();
+  do {
+    for (i = 0; i < pPattern->NumReq; i++) {
+      const REQ * pReq = &pPattern->paReq[i];
+      unsigned    NumBytes;
+
+      NumBytes = pReq->NumBytes;
+      if (pReq->Off + NumBytes > FILE_SIZE) {
+        NumBytes = FILE_SIZE - pReq->Off;
+      }
+      pData = _aBuffer;
+      if (pSrc == NULL) {
+        r = _GetDataOld(NULL, &pData, NumBytes, pReq->Off);
+      } else if (pPattern->Mode == 0) {
+        r = DATASOURCE_GetData(pSrc, &pData, NumBytes, pReq->Off);
+      } else if (pPattern->Mode == 1) {
+        r = DATASOURCE_GetDataCopy(pSrc, &pData, NumBytes, pReq->Off);
+      } else {
+        r = DATASOURCE_GetDataXBF(pReq->Off, (U16)NumBytes, pSrc, _aBuffer) ? 0 : (int)NumBytes;
+      }
+      //
+      // GetData may return a short count for requests crossing a block boundary
+      //
+      if (r <= 0 || (unsigned)r > NumBytes || (pPattern->Mode && (unsigned)r != NumBytes) || memcmp(pData, _pRef + pReq->Off, r)) {
+        NumErrors++;
+      }
+      Bytes += r;
+      NumReq++;
+    }
+  } while (Bytes < MIN_BYTES);
+  t = _Seconds() - t;
+  if (pSrc) {
+    DATASOURCE_GetStat(pSrc, &Stat);
+    _NumSysCallsOld += Stat.NumSysCalls;
+  }
+  *pMBs         = Bytes / t / 1e6;
+  *pCallsPerReq = (double)_NumSysCallsOld / NumReq;
+  return NumErrors;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       main
+*/
+int main(int argc, char ** argv) {
+  PATTERN      aPattern[5];
+  DATASOURCE * pSrc;
+  const char * sFileName;
+  FILE       * pFile;
+  unsigned     NumPatterns;
+  unsigned     i;
+  double       MBsOld, CallsOld, MBsNew, CallsNew;
+  int          NumErrors;
+
+  sFileName = (argc > 1) ? argv[1] : "DataSource_Bench.bin";
+  _pRef     = malloc(FILE_SIZE);
+  for (i = 0; i < FILE_SIZE; i++) {
+    _pRef[i] = (U8)_Rand();
+  }
+  pFile = fopen(sFileName, "wb");
+  if (pFile == NULL || fwrite(_pRef, 1, FILE_SIZE, pFile) != FILE_SIZE) {
+    printf("Can not write %s\n", sFileName);
+    return 1;
+  }
+  fclose(pFile);
+  _hFile = open(sFileName, O_RDONLY);
+  pSrc   = DATASOURCE_Open(sFileName);
+  if (_hFile < 0 || pSrc == NULL) {
+    printf("Can not open %s\n", sFileName);
+    return 1;
+  }
+  NumPatterns = _MakePatterns(aPattern);
+  NumErrors   = 0;
+  printf("backend %d, block %d bytes x %d, read ahead %d blocks\n",
+         DATASOURCE_BACKEND, DATASOURCE_BLOCK_SIZE, DATASOURCE_NUM_BLOCKS, DATASOURCE_READ_AHEAD);
+  printf("%-18s %22s %22s\n", "", "seek+read per request", "data source");
+  printf("%-18s %10s %11s %10s %11s\n", "pattern", "calls/req", "MB/s", "calls/req", "MB/s");
+  for (i = 0; i < NumPatterns; i++) {
+    NumErrors += _Run(&aPattern[i], NULL, &MBsOld, &CallsOld);
+    NumErrors += _Run(&aPattern[i], pSrc, &MBsNew, &CallsNew);
+    printf("%-18s %10.3f %11.1f %10.3f %11.1f\n", aPattern[i].sName, CallsOld, MBsOld, CallsNew, MBsNew);
+  }
+  DATASOURCE_Close(pSrc);
+  close(_hFile);
+  remove(sFileName);
+  free(_pRef);
+  printf("%s, %d errors\n", NumErrors ? "FAIL" : "PASS", NumErrors);
+  return NumErrors ? 1 : 0;
+}
+
+/*************************** End of file ****************************/
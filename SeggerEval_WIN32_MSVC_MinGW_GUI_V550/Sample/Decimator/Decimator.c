@@ -0,0 +1,199 @@
+/*********************************************************************
+File        : Decimator.c
+Purpose     : Streaming min/max decimator for real time graphs.
+
+              The input samples are combined into a multi-level
+              envelope: Each level keeps a ring of min/max spans, a
+              span of level n covers two spans of level n - 1. A graph
+              picks the level with one span per pixel column and draws
+              a vertical line per column, so the drawing effort only
+              depends on the width of the graph and not on the sample
+              rate. Other than subsampling, single sample peaks are
+              always visible.
+
+              Adding a sample costs two span updates on average.
+
+              To use it with a sample, add this file to the project
+              and Sample\Decimator to the include path.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#include <string.h>
+
+#include "Decimator.h"
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+#define SPAN_MASK  (DECIMATOR_NUM_SPANS - 1)
+#define VALUE_MIN  (-32767 - 1)
+#define VALUE_MAX  32767
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       DECIMATOR_Init
+*/
+void DECIMATOR_Init(DECIMATOR * pDec) {
+  unsigned Level;
+
+  GUI_MEMSET((U8 *)pDec, 0, sizeof(DECIMATOR));
+  for (Level = 0; Level < DECIMATOR_NUM_LEVELS; Level++) {
+    pDec->aAcc[Level].Min = VALUE_MAX;
+    pDec->aAcc[Level].Max = VALUE_MIN;
+  }
+}
+
+/*********************************************************************
+*
+*       DECIMATOR_AddValues
+*
+* Function description
+*   Adds the given samples. Each sample is a span of level 0, which is
+*   merged into the span of level 1. Whenever a span is complete it is
+*   stored into the ring of its level and merged into the next level.
+*/
+void DECIMATOR_AddValues(DECIMATOR * pDec, const I16 * pData, U32 NumItems) {
+  DECIMATOR_SPAN   Span;
+  DECIMATOR_SPAN * pAcc;
+  unsigned         Level;
+  U32              n;
+
+  if (NumItems == 0) {
+    return;
+  }
+  n = pDec->NumItems;
+  while (NumItems--) {
+    Span.Min = Span.Max = *pData++;
+    pDec->aaSpan[0][n & SPAN_MASK] = Span;
+    n++;
+    for (Level = 1; Level < DECIMATOR_NUM_LEVELS; Level++) {
+      pAcc = &pDec->aAcc[Level];
+      if (Span.Min < pAcc->Min) {
+        pAcc->Min = Span.Min;
+      }
+      if (Span.Max > pAcc->Max) {
+        pAcc->Max = Span.Max;
+      }
+      if (n & ((1UL << Level) - 1)) {
+        break;  // Span of this level not complete yet
+      }
+      Span = *pAcc;
+      pDec->aaSpan[Level][((n >> Level) - 1) & SPAN_MASK] = Span;
+      pAcc->Min = VALUE_MAX;
+      pAcc->Max = VALUE_MIN;
+    }
+  }
+  pDec->NumItems = n;
+  pDec->Last     = pData[-1];
+}
+
+/*********************************************************************
+*
+*       DECIMATOR_GetLevel
+*
+* Function description
+*   Returns the level to be used for the given number of samples per
+*   pixel column.
+*/
+unsigned DECIMATOR_GetLevel(U32 NumItemsPerPixel) {
+  unsigned Level;
+
+  for (Level = 0; (Level < DECIMATOR_NUM_LEVELS - 1) && ((1UL << Level) < NumItemsPerPixel); Level++);
+  return Level;
+}
+
+/*********************************************************************
+*
+*       DECIMATOR_GetNumSpans
+*
+* Function description
+*   Returns the number of completed spans of the given level since
+*   initialization. The difference between two calls is the number of
+*   pixel columns the graph has to be scrolled.
+*/
+U32 DECIMATOR_GetNumSpans(const DECIMATOR * pDec, unsigned Level) {
+  return pDec->NumItems >> Level;
+}
+
+/*********************************************************************
+*
+*       DECIMATOR_GetSpans
+*
+* Function description
+*   Copies the most recent completed spans of the given level, oldest
+*   first.
+*
+* Return value
+*   Number of spans copied, less than NumSpans if not enough data is
+*   available.
+*/
+int DECIMATOR_GetSpans(const DECIMATOR * pDec, unsigned Level, DECIMATOR_SPAN * pSpan, int NumSpans) {
+  U32 NumAvail;
+  U32 i;
+  int r;
+
+  NumAvail = pDec->NumItems >> Level;
+  if (NumAvail > DECIMATOR_NUM_SPANS) {
+    NumAvail = DECIMATOR_NUM_SPANS;
+  }
+  if ((U32)NumSpans > NumAvail) {
+    NumSpans = NumAvail;
+  }
+  i = (pDec->NumItems >> Level) - NumSpans;
+  for (r = 0; r < NumSpans; r++) {
+    *pSpan++ = pDec->aaSpan[Level][i++ & SPAN_MASK];
+  }
+  return NumSpans;
+}
+
+/*********************************************************************
+*
+*       DECIMATOR_DrawGraph
+*
+* Function description
+*   Draws the most recent spans of the given level with one vertical
+*   line per pixel column, right aligned to x0 + NumSpans - 1. Like
+*   GUI_DrawGraph() the y-position of a value is y0 + value. Each line
+*   is extended to touch its left neighbour, so the graph has no gaps.
+*/
+void DECIMATOR_DrawGraph(const DECIMATOR * pDec, unsigned Level, int NumSpans, int x0, int y0) {
+  DECIMATOR_SPAN Span;
+  DECIMATOR_SPAN Prev;
+  U32            NumAvail;
+  U32            i;
+  int            x;
+  int            y0Line;
+  int            y1Line;
+
+  NumAvail = pDec->NumItems >> Level;
+  if (NumAvail > DECIMATOR_NUM_SPANS) {
+    NumAvail = DECIMATOR_NUM_SPANS;
+  }
+  if ((U32)NumSpans > NumAvail) {
+    x0      += NumSpans - NumAvail;
+    NumSpans = NumAvail;
+  }
+  if (NumSpans == 0) {
+    return;
+  }
+  i    = (pDec->NumItems >> Level) - NumSpans;
+  Prev = pDec->aaSpan[Level][i & SPAN_MASK];
+  for (x = x0; x < x0 + NumSpans; x++) {
+    Span   = pDec->aaSpan[Level][i++ & SPAN_MASK];
+    y0Line = (Span.Min > Prev.Max) ? Prev.Max : Span.Min;
+    y1Line = (Span.Max < Prev.Min) ? Prev.Min : Span.Max;
+    GUI_DrawVLine(x, y0 + y0Line, y0 + y1Line);
+    Prev = Span;
+  }
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,67 @@
+/*********************************************************************
+File        : Decimator.h
+Purpose     : Streaming min/max decimator for real time graphs.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include "GUI.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+//
+// Number of levels of the envelope. A span of level n covers 2^n
+// input samples.
+//
+#ifndef   DECIMATOR_NUM_LEVELS
+  #define DECIMATOR_NUM_LEVELS  20
+#endif
+
+//
+// Number of spans kept per level, has to be a power of 2 and should
+// not be less than the width of the graph in pixels.
+//
+#ifndef   DECIMATOR_NUM_SPANS
+  #define DECIMATOR_NUM_SPANS   512
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  I16 Min;
+  I16 Max;
+} DECIMATOR_SPAN;
+
+typedef struct {
+  DECIMATOR_SPAN aaSpan[DECIMATOR_NUM_LEVELS][DECIMATOR_NUM_SPANS];  // Ring of completed spans per level
+  DECIMATOR_SPAN aAcc[DECIMATOR_NUM_LEVELS];                          // Span currently filled per level
+  U32            NumItems;                                            // Number of samples added
+  I16            Last;                                                // Most recent sample
+} DECIMATOR;
+
+/*********************************************************************
+*
+*       Public functions
+*
+**********************************************************************
+*/
+void     DECIMATOR_Init       (DECIMATOR * pDec);
+void     DECIMATOR_AddValues  (DECIMATOR * pDec, const I16 * pData, U32 NumItems);
+unsigned DECIMATOR_GetLevel   (U32 NumItemsPerPixel);
+U32      DECIMATOR_GetNumSpans(const DECIMATOR * pDec, unsigned Level);
+int      DECIMATOR_GetSpans   (const DECIMATOR * pDec, unsigned Level, DECIMATOR_SPAN * pSpan, int NumSpans);
+void     DECIMATOR_DrawGraph  (const DECIMATOR * pDec, unsigned Level, int NumSpans, int x0, int y0);
+
+#endif // DECIMATOR_H
+
+/*************************** End of file ****************************/
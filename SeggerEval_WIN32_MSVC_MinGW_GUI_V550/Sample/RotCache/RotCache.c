@@ -0,0 +1,318 @@
+/*********************************************************************
+File        : RotCache.c
+Purpose     : Cache of rotated copies of a memory device.
+
+              Rotating a device with GUI_MEMDEV_RotateHQ() costs a
+              bilinear interpolation per destination pixel on each
+              frame. The cache quantizes the angle range of a source
+              device into a number of angles and keeps a rotated copy
+              per angle, rendered on first use into a 32bpp device
+              just large enough for the rotated source. Drawing then
+              is a plain alpha blended GUI_MEMDEV_WriteAt(). Angles
+              between two cached angles use the nearest one, or with
+              ROTCACHE_CF_BLEND the nearer one on top of the farther
+              one drawn with an alpha value depending on the distance.
+
+              The number of angles is reduced at initialization if the
+              estimated size of all rotated devices exceeds the memory
+              budget. Devices which do not fit into the remaining
+              budget are not cached, so the budget is never exceeded.
+              Angles outside the cached range are rotated directly.
+
+              Positions are rounded to full pixels, so high resolution
+              positions lose their sub pixel part when drawn from the
+              cache.
+
+              To use it with a sample, add this file to the project
+              and Sample\RotCache to the include path.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#include <string.h>
+
+#include "RotCache.h"
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+#define NUM_SAMPLES  64      // Number of angles used to estimate the memory of all angles
+#define FULL_TURN    360000
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       _GetAngle
+*/
+static I32 _GetAngle(ROTCACHE * pCache, int Index) {
+  return pCache->a0 + ((pCache->a1 - pCache->a0) * Index) / (pCache->NumAngles - 1);
+}
+
+/*********************************************************************
+*
+*       _GetRotatedSize
+*
+* Function description
+*   Calculates the size of the bounding box of the source device
+*   rotated by the given angle, including one pixel for rounding and
+*   the interpolated border.
+*/
+static void _GetRotatedSize(ROTCACHE * pCache, I32 a, int * pxSize, int * pySize) {
+  I32 c;
+  I32 s;
+
+  c = GUI__CosHQ(a);
+  s = GUI__SinHQ(a);
+  c = (c < 0) ? -c : c;
+  s = (s < 0) ? -s : s;
+  *pxSize = ((c * pCache->xSizeSrc + s * pCache->ySizeSrc) >> 16) + 3;
+  *pySize = ((s * pCache->xSizeSrc + c * pCache->ySizeSrc) >> 16) + 3;
+}
+
+/*********************************************************************
+*
+*       _RotateDirect
+*/
+static void _RotateDirect(ROTCACHE * pCache, GUI_MEMDEV_Handle hDst, I32 dxHR, I32 dyHR, I32 a) {
+  if (pCache->Flags & ROTCACHE_CF_HQ) {
+    if ((dxHR | dyHR) & 7) {
+      GUI_MEMDEV_RotateHQHR(pCache->hSrc, hDst, dxHR, dyHR, a, 1000);
+    } else {
+      GUI_MEMDEV_RotateHQ(pCache->hSrc, hDst, dxHR >> 3, dyHR >> 3, a, 1000);
+    }
+  } else {
+    if ((dxHR | dyHR) & 7) {
+      GUI_MEMDEV_RotateHR(pCache->hSrc, hDst, dxHR, dyHR, a, 1000);
+    } else {
+      GUI_MEMDEV_Rotate(pCache->hSrc, hDst, dxHR >> 3, dyHR >> 3, a, 1000);
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       _GetItem
+*
+* Function description
+*   Returns the rotated device of the given angle, renders it if
+*   required.
+*
+* Return value
+*   Pointer to the item or NULL if the device does not fit into the
+*   memory budget.
+*/
+static ROTCACHE_ITEM * _GetItem(ROTCACHE * pCache, int Index) {
+  ROTCACHE_ITEM   * pItem;
+  GUI_MEMDEV_Handle hMemOld;
+  GUI_COLOR         BkColorOld;
+  U32               NumBytes;
+  I32               a;
+  int               xSize;
+  int               ySize;
+
+  pItem = &pCache->aItem[Index];
+  if (pItem->hMem) {
+    pCache->Stat.NumHits++;
+    return pItem;
+  }
+  a = _GetAngle(pCache, Index);
+  _GetRotatedSize(pCache, a, &xSize, &ySize);
+  NumBytes = (U32)xSize * ySize * 4;
+  if (pCache->Stat.NumBytes + NumBytes > pCache->NumBytesMax) {
+    return NULL;
+  }
+  pItem->hMem = GUI_MEMDEV_CreateFixed32(0, 0, xSize, ySize);
+  if (pItem->hMem == 0) {
+    return NULL;
+  }
+  pItem->xOff = (I16)((xSize - pCache->xSizeSrc) / 2);
+  pItem->yOff = (I16)((ySize - pCache->ySizeSrc) / 2);
+  hMemOld    = GUI_MEMDEV_Select(pItem->hMem);
+  BkColorOld = GUI_GetBkColor();
+  GUI_SetBkColor(GUI_TRANSPARENT);
+  GUI_Clear();
+  GUI_SetBkColor(BkColorOld);
+  GUI_MEMDEV_Select(hMemOld);
+  _RotateDirect(pCache, pItem->hMem, pItem->xOff * 8, pItem->yOff * 8, a);
+  pCache->Stat.NumMisses++;
+  pCache->Stat.NumBytes += NumBytes;
+  pCache->Stat.NumItems++;
+  return pItem;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       ROTCACHE_Init
+*
+* Function description
+*   Initializes a cache for the angles a0 to a1 (1/1000 degree) of the
+*   given source device. A range of 360 degrees or more is treated as
+*   full turn, other angles are then mapped into the range.
+*
+* Return value
+*   0 if angles are cached, 1 if the budget is too small. The cache
+*   can be used anyhow, all angles are rotated directly then.
+*/
+int ROTCACHE_Init(ROTCACHE * pCache, GUI_MEMDEV_Handle hSrc, I32 a0, I32 a1, int NumAngles, U32 NumBytesMax, int Flags) {
+  U32 NumBytes;
+  I32 a;
+  int xSize;
+  int ySize;
+  int i;
+
+  GUI_MEMSET((U8 *)pCache, 0, sizeof(ROTCACHE));
+  pCache->hSrc        = hSrc;
+  pCache->xSizeSrc    = GUI_MEMDEV_GetXSize(hSrc);
+  pCache->ySizeSrc    = GUI_MEMDEV_GetYSize(hSrc);
+  pCache->a0          = a0;
+  pCache->a1          = a1;
+  pCache->NumBytesMax = NumBytesMax;
+  pCache->Flags       = Flags;
+  if ((a1 <= a0) || (NumAngles < 2)) {
+    return 1;
+  }
+  if (NumAngles > ROTCACHE_MAX_ANGLES) {
+    NumAngles = ROTCACHE_MAX_ANGLES;
+  }
+  //
+  // Estimate the average size of a rotated device and reduce the
+  // number of angles to stay within the budget
+  //
+  NumBytes = 0;
+  for (i = 0; i < NUM_SAMPLES; i++) {
+    a = a0 + ((a1 - a0) / (NUM_SAMPLES - 1)) * i;
+    _GetRotatedSize(pCache, a, &xSize, &ySize);
+    NumBytes += (U32)xSize * ySize * 4;
+  }
+  NumBytes /= NUM_SAMPLES;
+  if ((U32)NumAngles * NumBytes > NumBytesMax) {
+    NumAngles = NumBytesMax / NumBytes;
+  }
+  pCache->NumAngles = (NumAngles >= 2) ? NumAngles : 0;
+  return pCache->NumAngles ? 0 : 1;
+}
+
+/*********************************************************************
+*
+*       ROTCACHE_Exit
+*
+* Function description
+*   Deletes all rotated devices. The source device is not deleted.
+*/
+void ROTCACHE_Exit(ROTCACHE * pCache) {
+  int i;
+
+  for (i = 0; i < pCache->NumAngles; i++) {
+    if (pCache->aItem[i].hMem) {
+      GUI_MEMDEV_Delete(pCache->aItem[i].hMem);
+      pCache->aItem[i].hMem = 0;
+    }
+  }
+  pCache->Stat.NumBytes = 0;
+  pCache->Stat.NumItems = 0;
+}
+
+/*********************************************************************
+*
+*       ROTCACHE_DrawHR
+*
+* Function description
+*   Draws the source device rotated by the given angle into hDst.
+*   Parameters are the same as for GUI_MEMDEV_RotateHQHR() with a
+*   magnification of 1000: dxHR and dyHR are the position of the
+*   unrotated source device relative to hDst in 1/8 pixels, the
+*   device is rotated around its center.
+*/
+void ROTCACHE_DrawHR(ROTCACHE * pCache, GUI_MEMDEV_Handle hDst, I32 dxHR, I32 dyHR, I32 a) {
+  ROTCACHE_ITEM   * pNear;
+  ROTCACHE_ITEM   * pFar;
+  GUI_MEMDEV_Handle hMemOld;
+  I32               Range;
+  I32               Pos;
+  int               Index;
+  int               w;
+  int               Alpha;
+  int               x;
+  int               y;
+
+  Range = pCache->a1 - pCache->a0;
+  if (Range >= FULL_TURN) {
+    a = (a - pCache->a0) % FULL_TURN;
+    a = pCache->a0 + ((a < 0) ? a + FULL_TURN : a);
+  }
+  if ((pCache->NumAngles == 0) || (a < pCache->a0) || (a > pCache->a1)) {
+    pCache->Stat.NumDirect++;
+    _RotateDirect(pCache, hDst, dxHR, dyHR, a);
+    return;
+  }
+  //
+  // Get the cached angle below a and the weight (0...255) of the next one
+  //
+  Pos   = (a - pCache->a0) * (pCache->NumAngles - 1);
+  Index = Pos / Range;
+  w     = ((Pos % Range) * 256) / Range;
+  if (Index >= pCache->NumAngles - 1) {
+    Index = pCache->NumAngles - 1;
+    w     = 0;
+  }
+  if ((pCache->Flags & ROTCACHE_CF_BLEND) == 0) {
+    Index += (w >= 128) ? 1 : 0;
+    w      = 0;
+  }
+  pFar  = NULL;
+  Alpha = 0;
+  if (w < 128) {
+    pNear = _GetItem(pCache, Index);
+    if (w) {
+      pFar  = _GetItem(pCache, Index + 1);
+      Alpha = w * 2;
+    }
+  } else {
+    pNear = _GetItem(pCache, Index + 1);
+    pFar  = _GetItem(pCache, Index);
+    Alpha = (256 - w) * 2;
+  }
+  if ((pNear == NULL) || (w && (pFar == NULL))) {
+    pCache->Stat.NumDirect++;
+    _RotateDirect(pCache, hDst, dxHR, dyHR, a);
+    return;
+  }
+  //
+  // Draw the farther angle transparent, the nearer one on top of it
+  //
+  x = GUI_MEMDEV_GetXPos(hDst) + ((dxHR + 4) >> 3);
+  y = GUI_MEMDEV_GetYPos(hDst) + ((dyHR + 4) >> 3);
+  hMemOld = GUI_MEMDEV_Select(hDst);
+  if (pFar) {
+    GUI_MEMDEV_WriteAlphaAt(pFar->hMem, (Alpha > 255) ? 255 : Alpha, x - pFar->xOff, y - pFar->yOff);
+  }
+  GUI_MEMDEV_WriteAt(pNear->hMem, x - pNear->xOff, y - pNear->yOff);
+  GUI_MEMDEV_Select(hMemOld);
+}
+
+/*********************************************************************
+*
+*       ROTCACHE_Draw
+*
+* Function description
+*   Same as ROTCACHE_DrawHR() with full pixel positions, corresponds to
+*   GUI_MEMDEV_Rotate() with a magnification of 1000.
+*/
+void ROTCACHE_Draw(ROTCACHE * pCache, GUI_MEMDEV_Handle hDst, int dx, int dy, I32 a) {
+  ROTCACHE_DrawHR(pCache, hDst, (I32)dx * 8, (I32)dy * 8, a);
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,84 @@
+/*********************************************************************
+File        : RotCache.h
+Purpose     : Cache of rotated copies of a memory device for the
+              rotation samples.
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#ifndef ROTCACHE_H
+#define ROTCACHE_H
+
+#include "GUI.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+//
+// Maximum number of quantized angles per cache
+//
+#ifndef   ROTCACHE_MAX_ANGLES
+  #define ROTCACHE_MAX_ANGLES  720
+#endif
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+//
+// Create flags
+//
+#define ROTCACHE_CF_HQ     (1 << 0)  // Render with GUI_MEMDEV_RotateHQ() instead of GUI_MEMDEV_Rotate()
+#define ROTCACHE_CF_BLEND  (1 << 1)  // Blend the two neighbouring angles instead of using the nearest one
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  GUI_MEMDEV_Handle hMem;  // Rotated device, 0 if not rendered yet
+  I16               xOff;  // Position of the rotated device relative to the source device
+  I16               yOff;
+} ROTCACHE_ITEM;
+
+typedef struct {
+  U32 NumHits;     // Number of angles drawn from the cache
+  U32 NumMisses;   // Number of angles rendered into the cache
+  U32 NumDirect;   // Number of rotations done without cache (angle out of range or out of memory)
+  U32 NumBytes;    // Number of bytes used by the rendered devices
+  int NumItems;    // Number of rendered devices
+} ROTCACHE_STAT;
+
+typedef struct {
+  ROTCACHE_ITEM     aItem[ROTCACHE_MAX_ANGLES];
+  ROTCACHE_STAT     Stat;
+  GUI_MEMDEV_Handle hSrc;
+  int               xSizeSrc;
+  int               ySizeSrc;
+  I32               a0;           // First cached angle in 1/1000 degree
+  I32               a1;           // Last cached angle in 1/1000 degree
+  int               NumAngles;    // Number of cached angles, may be less than requested because of the memory budget
+  U32               NumBytesMax;  // Memory budget
+  int               Flags;
+} ROTCACHE;
+
+/*********************************************************************
+*
+*       Public functions
+*
+**********************************************************************
+*/
+int  ROTCACHE_Init  (ROTCACHE * pCache, GUI_MEMDEV_Handle hSrc, I32 a0, I32 a1, int NumAngles, U32 NumBytesMax, int Flags);
+void ROTCACHE_Exit  (ROTCACHE * pCache);
+void ROTCACHE_Draw  (ROTCACHE * pCache, GUI_MEMDEV_Handle hDst, int dx, int dy, I32 a);
+void ROTCACHE_DrawHR(ROTCACHE * pCache, GUI_MEMDEV_Handle hDst, I32 dx, I32 dy, I32 a);
+
+#endif // ROTCACHE_H
+
+/*************************** End of file ****************************/
@@ -33,6 +33,7 @@ Requirements: WindowManager - ( )
 #include <windows.h>
 #include <stdio.h>
 #include "GUI.h"
+#include "DataSource.h"
 
 /*********************************************************************
 *
@@ -45,70 +46,12 @@ Requirements: WindowManager - ( )
 //
 #define RECOMMENDED_MEMORY (1024L * 5)
 
-/*********************************************************************
-*
-*       Static data
-*
-**********************************************************************
-*/
-static char _acBuffer[0x1000];
-
 /*******************************************************************
 *
 *       Static functions
 *
 ********************************************************************
 */
-/*********************************************************************
-*
-*       _GetData
-*
-* Function description
-*   This routine is called by the functions GUI_BMP_GetXSizeEx(),
-*   GUI_BMP_GetYSizeEx() and GUI_BMP_DrawEx(). The routine is responsible
-*   for setting the data pointer to a valid data location with at least
-*   one valid byte.
-*
-* Parameters
-*   p           - Pointer to application defined data.
-*   NumBytesReq - Number of bytes requested.
-*   ppData      - Pointer to data pointer. This pointer should be set to
-*                 a valid location.
-*   StartOfFile - If this flag is 1, the data pointer should be set to the
-*                 beginning of the data stream.
-*
-* Return value
-*   Number of data bytes available.
-*/
-static int _GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off) {
-  DWORD    NumBytesRead;
-  HANDLE * phFile;
-
-  phFile = (HANDLE *)p;
-  //
-  // Check buffer size
-  //
-  if (NumBytesReq > sizeof(_acBuffer)) {
-    NumBytesReq = sizeof(_acBuffer);
-  }
-  //
-  // Set file pointer to the required position
-  //
-  SetFilePointer(*phFile, Off, 0, FILE_BEGIN);
-  //
-  // Read data into buffer
-  //
-  ReadFile(*phFile, _acBuffer, NumBytesReq, &NumBytesRead, NULL);
-  //
-  // Set data pointer to the beginning of the buffer
-  //
-  *ppData = _acBuffer;
-  //
-  // Return number of available bytes
-  //
-  return NumBytesRead;
-}
-
 /*******************************************************************
 *
 *       _ShowBMP
@@ -117,22 +60,25 @@ static int _GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off)
 *   Shows the contents of a bitmap file
 */
 static void _ShowBMP(const char * sFilename) {
-  HANDLE hFile;
-  int    XSize;
-  int    YSize;
-  int    XPos;
-  int    YPos;
-
-  hFile = CreateFile(sFilename, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+  DATASOURCE * pSrc;
+  int          XSize;
+  int          YSize;
+  int          XPos;
+  int          YPos;
+
+  pSrc = DATASOURCE_Open(sFilename);
+  if (pSrc == NULL) {
+    return;
+  }
   GUI_ClearRect(0, 60, 319, 239);
-  XSize = GUI_BMP_GetXSizeEx(_GetData, &hFile);
-  YSize = GUI_BMP_GetYSizeEx(_GetData, &hFile);
+  XSize = GUI_BMP_GetXSizeEx(DATASOURCE_GetData, pSrc);
+  YSize = GUI_BMP_GetYSizeEx(DATASOURCE_GetData, pSrc);
   XPos  = (XSize > 320) ?  0 : 160 - (XSize / 2);
   YPos  = (YSize > 180) ? 60 : 150 - (YSize / 2);
-  if (!GUI_BMP_DrawEx(_GetData, &hFile, XPos, YPos)) {
+  if (!GUI_BMP_DrawEx(DATASOURCE_GetData, pSrc, XPos, YPos)) {
     GUI_Delay(2000);
   }
-  CloseHandle(hFile);
+  DATASOURCE_Close(pSrc);
 }
 
 /*******************************************************************
@@ -32,8 +32,10 @@ Requirements: WindowManager - ( )
 
 #include <windows.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "GUI.h"
+#include "DataSource.h"
 
 /*********************************************************************
 *
@@ -51,13 +53,46 @@ Requirements: WindowManager - ( )
 //
 #define RECOMMENDED_MEMORY (1024L * 200)
 
+//
+// Thumbnail cache. Each image is decoded once at the power of 2 scale
+// which still covers the 'fit' size. Smaller levels are built from it
+// by 2x2 box filtering. Drawing uses the smallest level which is not
+// smaller than the requested size.
+//
+#ifndef   GUI_NUMBYTES
+  #define GUI_NUMBYTES       0x280000           // Has to match the value in GUIConf.c
+#endif
+#define THUMB_CACHE_BYTES    (GUI_NUMBYTES / 2) // Memory used for all cached thumbnails
+#define THUMB_MAX_ENTRIES    8                  // Number of images kept in the cache
+#define THUMB_MAX_LEVELS     4                  // Number of levels of each image
+#define THUMB_MAX_SHIFT      3                  // Maximum down scaling by the decoder (1/8)
+#define THUMB_MIN_SIZE       32                 // Levels are not made smaller than this
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  char              acFileName[_MAX_PATH];
+  GUI_MEMDEV_Handle ahMem[THUMB_MAX_LEVELS];
+  int               axSize[THUMB_MAX_LEVELS];
+  int               aySize[THUMB_MAX_LEVELS];
+  int               NumLevels;
+  U32               NumBytes;
+  U32               Age;
+} THUMB;
+
 /*********************************************************************
 *
 *       Static data
 *
 **********************************************************************
 */
-static U8 _acBuffer[0x200];
+static THUMB _aThumb[THUMB_MAX_ENTRIES];
+static U32   _NumBytesThumb;
+static U32   _AgeThumb;
 
 /*********************************************************************
 *
@@ -67,51 +102,237 @@ static U8 _acBuffer[0x200];
 */
 /*********************************************************************
 *
-*       _GetData
+*       _FreeThumb
+*/
+static void _FreeThumb(THUMB * pThumb) {
+  int i;
+
+  for (i = 0; i < pThumb->NumLevels; i++) {
+    GUI_MEMDEV_Delete(pThumb->ahMem[i]);
+  }
+  _NumBytesThumb -= pThumb->NumBytes;
+  pThumb->NumLevels     = 0;
+  pThumb->NumBytes      = 0;
+  pThumb->acFileName[0] = 0;
+}
+
+/*********************************************************************
+*
+*       _ShrinkLevel
 *
 * Function description
-*   This routine is called by GUI_JPEG_DrawEx(). The routine is responsible
-*   for setting the data pointer to a valid data location with at least
-*   one valid byte.
+*   Builds the next smaller level by averaging 2x2 pixels of the given
+*   32bpp level.
+*/
+static void _ShrinkLevel(GUI_MEMDEV_Handle hSrc, int xSizeSrc, GUI_MEMDEV_Handle hDst, int xSizeDst, int ySizeDst) {
+  const U32 * pSrc0;
+  const U32 * pSrc1;
+  U32       * pDst;
+  U32         c0, c1, c2, c3;
+  U32         Mask;
+  int         x, y;
+
+  Mask = 0x00FF00FF;
+  for (y = 0; y < ySizeDst; y++) {
+    pSrc0 = (const U32 *)GUI_MEMDEV_GetDataPtr(hSrc) + (y * 2) * xSizeSrc;
+    pSrc1 = pSrc0 + xSizeSrc;
+    pDst  = (U32 *)GUI_MEMDEV_GetDataPtr(hDst) + y * xSizeDst;
+    for (x = 0; x < xSizeDst; x++) {
+      c0 = pSrc0[x * 2];
+      c1 = pSrc0[x * 2 + 1];
+      c2 = pSrc1[x * 2];
+      c3 = pSrc1[x * 2 + 1];
+      //
+      // Average two channels at once: (A, G) and (R, B)
+      //
+      *pDst++ = (((((c0 >> 8) & Mask) + ((c1 >> 8) & Mask) + ((c2 >> 8) & Mask) + ((c3 >> 8) & Mask) + 0x00020002) << 6) & ~Mask)
+              | (((( c0       & Mask) + ( c1       & Mask) + ( c2       & Mask) + ( c3       & Mask) + 0x00020002) >> 2) &  Mask);
+    }
+  }
+}
+
+/*********************************************************************
 *
-* Parameters:
-*   p           - Pointer to application defined data.
-*   NumBytesReq - Number of bytes requested.
-*   ppData      - Pointer to data pointer. This pointer should be set to
-*                 a valid location.
-*   StartOfFile - If this flag is 1, the data pointer should be set to the
-*                 beginning of the data stream.
+*       _GetThumb
 *
-* Return value:
-*   Number of data bytes available.
+* Function description
+*   Returns the cached thumbnail of the given file. On a miss the image
+*   is decoded and the least recently used thumbnails are discarded
+*   until it fits into THUMB_CACHE_BYTES. Returns NULL if the image
+*   can not be cached.
 */
-static int _GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off) {
-  HANDLE * phFile;
-  DWORD    NumBytesRead;
+static THUMB * _GetThumb(const char * sFileName, DATASOURCE * pSrc, GUI_JPEG_INFO * pInfo, int xSizeNeed, int ySizeNeed) {
+  GUI_MEMDEV_Handle hMemOld;
+  THUMB           * pThumb;
+  U32               NumBytes;
+  int               xSize, ySize;
+  int               Shift;
+  int               i;
 
-  phFile = (HANDLE *)p;
   //
-  // Check buffer size
+  // Search cache
   //
-  if (NumBytesReq > sizeof(_acBuffer)) {
-    NumBytesReq = sizeof(_acBuffer);
+  pThumb = NULL;
+  for (i = 0; i < THUMB_MAX_ENTRIES; i++) {
+    if (_aThumb[i].NumLevels && (strcmp(_aThumb[i].acFileName, sFileName) == 0)) {
+      pThumb = &_aThumb[i];
+      break;
+    }
+  }
+  if (pThumb) {
+    if ((pThumb->axSize[0] >= xSizeNeed) && (pThumb->aySize[0] >= ySizeNeed)) {
+      pThumb->Age = ++_AgeThumb;
+      return pThumb;
+    }
+    _FreeThumb(pThumb);
+  }
+  if (strlen(sFileName) >= _MAX_PATH) {
+    return NULL;
   }
   //
-  // Set file pointer to the required position
-  //
-  SetFilePointer(*phFile, Off, 0, FILE_BEGIN);
-  //
-  // Read data into buffer
+  // Use the smallest decoder scale which still covers the needed size
   //
-  ReadFile(*phFile, _acBuffer, NumBytesReq, &NumBytesRead, NULL);
+  Shift = 0;
+  while ((Shift < THUMB_MAX_SHIFT) && ((pInfo->XSize >> (Shift + 1)) >= xSizeNeed) && ((pInfo->YSize >> (Shift + 1)) >= ySizeNeed)) {
+    Shift++;
+  }
+  xSize    = pInfo->XSize >> Shift;
+  ySize    = pInfo->YSize >> Shift;
+  NumBytes = 0;
+  for (i = 0; (i < THUMB_MAX_LEVELS) && (xSize >= THUMB_MIN_SIZE) && (ySize >= THUMB_MIN_SIZE); i++) {
+    NumBytes += (U32)xSize * ySize * 4;
+    xSize /= 2;
+    ySize /= 2;
+  }
+  if ((i == 0) || (NumBytes > THUMB_CACHE_BYTES)) {
+    return NULL;
+  }
   //
-  // Set data pointer to the beginning of the buffer
+  // Discard least recently used thumbnails until the new one fits
   //
-  *ppData = _acBuffer;
+  while (1) {
+    pThumb = NULL;
+    for (i = 0; i < THUMB_MAX_ENTRIES; i++) {
+      if (_aThumb[i].NumLevels == 0) {
+        pThumb = &_aThumb[i];
+        break;
+      }
+      if ((pThumb == NULL) || (_aThumb[i].Age < pThumb->Age)) {
+        pThumb = &_aThumb[i];
+      }
+    }
+    if (pThumb->NumLevels) {
+      _FreeThumb(pThumb);
+      continue;
+    }
+    if ((_NumBytesThumb + NumBytes <= THUMB_CACHE_BYTES) && ((U32)GUI_ALLOC_GetNumFreeBytes() > NumBytes + RECOMMENDED_MEMORY)) {
+      break;
+    }
+    //
+    // Free slot found but not enough memory, discard the oldest used one
+    //
+    pThumb = NULL;
+    for (i = 0; i < THUMB_MAX_ENTRIES; i++) {
+      if (_aThumb[i].NumLevels && ((pThumb == NULL) || (_aThumb[i].Age < pThumb->Age))) {
+        pThumb = &_aThumb[i];
+      }
+    }
+    if (pThumb == NULL) {
+      return NULL;
+    }
+    _FreeThumb(pThumb);
+  }
   //
-  // Return number of available bytes
+  // Decode level 0 and build the smaller levels
   //
-  return NumBytesRead;
+  xSize = pInfo->XSize >> Shift;
+  ySize = pInfo->YSize >> Shift;
+  pThumb->ahMem[0] = GUI_MEMDEV_CreateFixed32(0, 0, xSize, ySize);
+  if (pThumb->ahMem[0] == 0) {
+    return NULL;
+  }
+  hMemOld = GUI_MEMDEV_Select(pThumb->ahMem[0]);
+  GUI_JPEG_DrawScaledEx(DATASOURCE_GetData, pSrc, 0, 0, 1, 1 << Shift);
+  GUI_MEMDEV_Select(hMemOld);
+  pThumb->axSize[0] = xSize;
+  pThumb->aySize[0] = ySize;
+  pThumb->NumLevels = 1;
+  pThumb->NumBytes  = (U32)xSize * ySize * 4;
+  for (i = 1; i < THUMB_MAX_LEVELS; i++) {
+    xSize /= 2;
+    ySize /= 2;
+    if ((xSize < THUMB_MIN_SIZE) || (ySize < THUMB_MIN_SIZE)) {
+      break;
+    }
+    pThumb->ahMem[i] = GUI_MEMDEV_CreateFixed32(0, 0, xSize, ySize);
+    if (pThumb->ahMem[i] == 0) {
+      break;
+    }
+    _ShrinkLevel(pThumb->ahMem[i - 1], pThumb->axSize[i - 1], pThumb->ahMem[i], xSize, ySize);
+    pThumb->axSize[i] = xSize;
+    pThumb->aySize[i] = ySize;
+    pThumb->NumLevels++;
+    pThumb->NumBytes += (U32)xSize * ySize * 4;
+  }
+  strcpy(pThumb->acFileName, sFileName);
+  pThumb->Age     = ++_AgeThumb;
+  _NumBytesThumb += pThumb->NumBytes;
+  return pThumb;
+}
+
+/*********************************************************************
+*
+*       _DrawThumb
+*
+* Function description
+*   Draws the thumbnail with the given size. The smallest level which
+*   is not smaller than the requested size is resampled bilinear, so
+*   the scale factor is always between 1/2 and 1.
+*
+*   GUI_MEMDEV_RotateHQ() scales both axes by the same factor. The
+*   levels keep the aspect ratio of the image, only the rounding of
+*   the sizes makes the x and y factors differ. The smaller factor is
+*   used, so the result never exceeds the requested size, and the
+*   image is centered in it. A remaining line at the border shows the
+*   background color.
+*
+* Return value
+*   0 on success, 1 if the size is not covered by the thumbnail.
+*/
+static int _DrawThumb(THUMB * pThumb, int xPos, int yPos, int xSize, int ySize) {
+  GUI_MEMDEV_Handle hMem;
+  GUI_MEMDEV_Handle hMemOld;
+  int               Level;
+  int               Mag;
+  int               yMag;
+
+  if ((xSize > pThumb->axSize[0]) || (ySize > pThumb->aySize[0]) || (xSize <= 0) || (ySize <= 0)) {
+    return 1;
+  }
+  Level = 0;
+  while ((Level + 1 < pThumb->NumLevels) && (pThumb->axSize[Level + 1] >= xSize) && (pThumb->aySize[Level + 1] >= ySize)) {
+    Level++;
+  }
+  if ((pThumb->axSize[Level] == xSize) && (pThumb->aySize[Level] == ySize)) {
+    GUI_MEMDEV_WriteAt(pThumb->ahMem[Level], xPos, yPos);
+    return 0;
+  }
+  hMem = GUI_MEMDEV_CreateFixed32(xPos, yPos, xSize, ySize);
+  if (hMem == 0) {
+    return 1;
+  }
+  hMemOld = GUI_MEMDEV_Select(hMem);
+  GUI_Clear();
+  GUI_MEMDEV_Select(hMemOld);
+  Mag  = xSize * 1000 / pThumb->axSize[Level];
+  yMag = ySize * 1000 / pThumb->aySize[Level];
+  if (yMag < Mag) {
+    Mag = yMag;
+  }
+  GUI_MEMDEV_RotateHQ(pThumb->ahMem[Level], hMem, (xSize - pThumb->axSize[Level]) / 2, (ySize - pThumb->aySize[Level]) / 2, 0, Mag);
+  GUI_MEMDEV_WriteAt(hMem, xPos, yPos);
+  GUI_MEMDEV_Delete(hMem);
+  return 0;
 }
 
 /*********************************************************************
@@ -122,18 +343,25 @@ static int _GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off)
 *   Draws the given JPEG image.
 */
 static void _DrawJPEGs(const char * sFileName) {
-  const char    acError[] = "There is possibly not enough memory to display this JPEG image.\n\nPlease assign more memory to emWin in GUIConf.c.";
-  GUI_JPEG_INFO Info;
-  GUI_RECT      Rect;
-  HANDLE        hFile;
-  int           xSizeScreen, ySizeScreen;
-  int           xSizeScale,  ySizeScale;
-  int           xSize,       ySize;
-  int           xPos,        yPos;
-  int           xNum,        yNum;
-  int           Num;
-  int           i;
-  int           r;
+  const char     acError[] = "There is possibly not enough memory to display this JPEG image.\n\nPlease assign more memory to emWin in GUIConf.c.";
+  GUI_JPEG_INFO  Info;
+  GUI_RECT       Rect;
+  GUI_TIMER_TIME Time;
+  GUI_TIMER_TIME TimeFill;
+  GUI_TIMER_TIME TimeDecoder;
+  GUI_TIMER_TIME TimeThumb;
+  DATASOURCE   * pSrc;
+  THUMB        * pThumb;
+  char           acTime[64];
+  int            xSizeScreen, ySizeScreen;
+  int            xSizeScale,  ySizeScale;
+  int            xSize,       ySize;
+  int            xPos,        yPos;
+  int            xNum,        yNum;
+  int            Num;
+  int            i;
+  int            r;
+  int            rThumb;
 
   xSizeScreen = LCD_GetXSize();
   ySizeScreen = LCD_GetYSize();
@@ -152,8 +380,21 @@ static void _DrawJPEGs(const char * sFileName) {
   //
   // Display each image scaled to 3 different sizes.
   //
-  hFile = CreateFile(sFileName, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-  GUI_JPEG_GetInfoEx(_GetData, &hFile, &Info);
+  pSrc = DATASOURCE_Open(sFileName);
+  if (pSrc == NULL) {
+    return;
+  }
+  GUI_JPEG_GetInfoEx(DATASOURCE_GetData, pSrc, &Info);
+  //
+  // Get the thumbnail which covers the 'fit' size. Only larger sizes
+  // are drawn by the decoder.
+  //
+  xNum = (xSizeScreen - BORDER_SIZE * 2)          * 1000 / Info.XSize;
+  yNum = (ySizeScreen - BORDER_SIZE + YPOS_IMAGE) * 1000 / Info.YSize;
+  Num  = (xNum < yNum) ? xNum : yNum;
+  TimeFill = GUI_GetTime();
+  pThumb   = _GetThumb(sFileName, pSrc, &Info, Info.XSize * Num / 1000, Info.YSize * Num / 1000);
+  TimeFill = GUI_GetTime() - TimeFill;
   for (i = 0; i < 3; i++) {
     //
     // Clear the area in which the JPEG files are displayed and set clipping rectangle.
@@ -195,8 +436,21 @@ static void _DrawJPEGs(const char * sFileName) {
     ySize = Info.YSize * Num / 1000;
     xPos  = BORDER_SIZE + (xSizeScreen - BORDER_SIZE * 2 - xSize) / 2;
     yPos  = YPOS_IMAGE  + (ySizeScreen - YPOS_IMAGE      - ySize) / 2;
-    r = GUI_JPEG_DrawScaledEx(_GetData, &hFile, xPos, yPos, Num, 1000);
-    if (r) {
+    //
+    // Draw with the decoder as without the cache, then over it from the
+    // thumbnail, to compare both ways at the same size.
+    //
+    Time        = GUI_GetTime();
+    r           = GUI_JPEG_DrawScaledEx(DATASOURCE_GetData, pSrc, xPos, yPos, Num, 1000);
+    TimeDecoder = GUI_GetTime() - Time;
+    rThumb      = 1;
+    TimeThumb   = 0;
+    if (pThumb) {
+      Time      = GUI_GetTime();
+      rThumb    = _DrawThumb(pThumb, xPos, yPos, xSize, ySize);
+      TimeThumb = GUI_GetTime() - Time;
+    }
+    if (r && rThumb) {
       //
       // The image could not be displayed successfully. Show an error message.
       //
@@ -220,11 +474,24 @@ static void _DrawJPEGs(const char * sFileName) {
       GUI_DispStringInRectWrap("Scaled to 4 times the display area.", &Rect, GUI_TA_BOTTOM | GUI_TA_LEFT, GUI_WRAPMODE_WORD);
       break;
     }
+    //
+    // Show the time used for drawing by the decoder and from the
+    // thumbnail. Filling the cache is shown with the first size, it is
+    // close to 0 if the thumbnail was already cached.
+    //
+    if (rThumb) {
+      sprintf(acTime, "decoder %d ms", (int)TimeDecoder);
+    } else if (i == 0) {
+      sprintf(acTime, "decoder %d ms, cache %d ms (fill %d ms)", (int)TimeDecoder, (int)TimeThumb, (int)TimeFill);
+    } else {
+      sprintf(acTime, "decoder %d ms, cache %d ms", (int)TimeDecoder, (int)TimeThumb);
+    }
+    GUI_DispStringInRect(acTime, &Rect, GUI_TA_BOTTOM | GUI_TA_RIGHT);
     GUI_Delay(2000);
   }
   GUI_SetTextMode(GUI_TM_NORMAL);
   GUI_SetFont(&GUI_Font8x16);
-  CloseHandle(hFile);
+  DATASOURCE_Close(pSrc);
 }
 
 /*********************************************************************
@@ -32,6 +32,7 @@ Requirements: WindowManager - ( )
 
 #include <windows.h>
 #include "GUI.h"
+#include "DataSource.h"
 
 /*********************************************************************
 *
@@ -434,31 +435,6 @@ static void _DrawStripes(void) {
   }
 }
 
-/*********************************************************************
-*
-*       _GetData
-*/
-static int _GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off) {
-  HANDLE * phFile;
-  DWORD    NumBytesRead;
-  U8     * pData;
-
-  pData  = (U8 *)*ppData;
-  phFile = (HANDLE *)p;
-  //
-  // Set file pointer to the required position
-  //
-  SetFilePointer(*phFile, Off, 0, FILE_BEGIN);
-  //
-  // Read data into buffer
-  //
-  ReadFile(*phFile, pData, NumBytesReq, &NumBytesRead, NULL);
-  //
-  // Return number of available bytes
-  //
-  return NumBytesRead;
-}
-
 /*********************************************************************
 *
 *       _DrawPNG_file
@@ -467,23 +443,26 @@ static int _GetData(void * p, const U8 ** ppData, unsigned NumBytesReq, U32 Off)
 *   Draws a PNG file from a file system
 */
 static void _DrawPNG_file(const char * sFilename) {
-  HANDLE hFile;
-  int    xSize;
-  int    ySize;
-  int    w;
-  int    h;
-  int    xPos;
-  int    yPos;
+  DATASOURCE * pSrc;
+  int          xSize;
+  int          ySize;
+  int          w;
+  int          h;
+  int          xPos;
+  int          yPos;
 
-  hFile = CreateFile(sFilename, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-  w     = GUI_PNG_GetXSizeEx(_GetData, &hFile);
-  h     = GUI_PNG_GetYSizeEx(_GetData, &hFile);
+  pSrc = DATASOURCE_Open(sFilename);
+  if (pSrc == NULL) {
+    return;
+  }
+  w     = GUI_PNG_GetXSizeEx(DATASOURCE_GetDataCopy, pSrc);
+  h     = GUI_PNG_GetYSizeEx(DATASOURCE_GetDataCopy, pSrc);
   xSize = LCD_GetXSize();
   ySize = LCD_GetYSize();
   xPos  = (xSize - w) / 2 + 10;
   yPos  = (ySize - h) / 2 + 10;
-  GUI_PNG_DrawEx(_GetData, &hFile, xPos, yPos);
-  CloseHandle(hFile);
+  GUI_PNG_DrawEx(DATASOURCE_GetDataCopy, pSrc, xPos, yPos);
+  DATASOURCE_Close(pSrc);
 }
 
 /*********************************************************************
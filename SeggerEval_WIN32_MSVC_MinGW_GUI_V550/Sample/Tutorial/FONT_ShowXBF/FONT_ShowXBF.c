@@ -31,14 +31,89 @@ Requirements: WindowManager - (x)
 #ifndef SKIP_TEST
 
 #include <windows.h>
+#include <string.h>
 
 #include "GUI.h"
 #include "EDIT.h"
+#include "DataSource.h"
 
 //
 // Recommended memory to run the sample with adequate performance
 //
-#define RECOMMENDED_MEMORY (1024L * 5)
+#define RECOMMENDED_MEMORY (1024L * 5 + CACHE_NUM_BYTES)
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+//
+// Glyph cache
+//
+#define CACHE_NUM_BYTES    (1024L * 8)  // Budget for cached glyph data
+#define CACHE_NUM_GLYPHS   256          // Maximum number of cached glyphs
+#define CACHE_HASH_SIZE    64           // Number of hash buckets, has to be a power of 2
+#define CACHE_MAX_PREFETCH 64           // Maximum number of glyphs loaded by one prefetch
+
+//
+// Layout of the XBF file: Header followed by a table with one entry
+// (U32 offset and U16 size of the glyph data) per character
+//
+#define XBF_OFF_FIRST      14
+#define XBF_OFF_TABLE      18
+#define XBF_SIZEOF_ENTRY   6
+
+//
+// Number of times the sample text is drawn for measuring
+//
+#define NUM_REPEAT         100
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  DATASOURCE * pSrc;
+  U16          First;  // First character of the font
+  U16          Last;   // Last character of the font
+} XBF_FILE;
+
+typedef struct GLYPH GLYPH;
+
+struct GLYPH {
+  const XBF_FILE * pFile;                   // Font the glyph belongs to
+  U16              c;                       // Code point
+  U8               aEntry[XBF_SIZEOF_ENTRY]; // Table entry as stored in the file
+  U32              Off;                     // Location of the glyph data in the file
+  U16              NumBytes;
+  GUI_HMEM         hData;                   // Glyph data, 0 if NumBytes is 0
+  GLYPH          * pNextHash;               // Next glyph in hash bucket or free list
+  GLYPH          * pPrev;                   // LRU list, most recently used first
+  GLYPH          * pNext;
+};
+
+typedef struct {
+  GLYPH   aGlyph[CACHE_NUM_GLYPHS];
+  GLYPH * apHash[CACHE_HASH_SIZE];
+  GLYPH * pFree;
+  GLYPH * pFirst;    // Most recently used glyph
+  GLYPH * pLast;     // Least recently used glyph
+  GLYPH * pCur;      // Glyph of the table entry requested last
+  U32     NumBytes;  // Number of bytes of glyph data in the cache
+  U32     NumHits;
+  U32     NumMisses;
+} CACHE;
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static CACHE _Cache;
 
 /*********************************************************************
 *
@@ -46,6 +121,274 @@ Requirements: WindowManager - (x)
 *
 **********************************************************************
 */
+/*********************************************************************
+*
+*       _Hash
+*/
+static unsigned _Hash(const XBF_FILE * pFile, U16 c) {
+  return (c ^ ((unsigned)(size_t)pFile >> 4)) & (CACHE_HASH_SIZE - 1);
+}
+
+/*********************************************************************
+*
+*       _Unlink
+*
+* Function description
+*   Removes the glyph from the LRU list.
+*/
+static void _Unlink(GLYPH * pGlyph) {
+  if (pGlyph->pPrev) {
+    pGlyph->pPrev->pNext = pGlyph->pNext;
+  } else {
+    _Cache.pFirst = pGlyph->pNext;
+  }
+  if (pGlyph->pNext) {
+    pGlyph->pNext->pPrev = pGlyph->pPrev;
+  } else {
+    _Cache.pLast = pGlyph->pPrev;
+  }
+}
+
+/*********************************************************************
+*
+*       _Touch
+*
+* Function description
+*   Moves the glyph to the front of the LRU list.
+*/
+static void _Touch(GLYPH * pGlyph) {
+  if (_Cache.pFirst != pGlyph) {
+    _Unlink(pGlyph);
+    pGlyph->pPrev = NULL;
+    pGlyph->pNext = _Cache.pFirst;
+    if (_Cache.pFirst) {
+      _Cache.pFirst->pPrev = pGlyph;
+    } else {
+      _Cache.pLast = pGlyph;
+    }
+    _Cache.pFirst = pGlyph;
+  }
+}
+
+/*********************************************************************
+*
+*       _Evict
+*
+* Function description
+*   Removes the least recently used glyph from the cache.
+*/
+static int _Evict(void) {
+  GLYPH  * pGlyph;
+  GLYPH ** ppLink;
+
+  pGlyph = _Cache.pLast;
+  if (pGlyph == NULL) {
+    return 1;
+  }
+  _Unlink(pGlyph);
+  ppLink = &_Cache.apHash[_Hash(pGlyph->pFile, pGlyph->c)];
+  while (*ppLink != pGlyph) {
+    ppLink = &(*ppLink)->pNextHash;
+  }
+  *ppLink = pGlyph->pNextHash;
+  if (pGlyph->hData) {
+    GUI_ALLOC_Free(pGlyph->hData);
+  }
+  if (_Cache.pCur == pGlyph) {
+    _Cache.pCur = NULL;
+  }
+  _Cache.NumBytes  -= pGlyph->NumBytes;
+  pGlyph->pNextHash = _Cache.pFree;
+  _Cache.pFree      = pGlyph;
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _InitCache
+*/
+static void _InitCache(void) {
+  int i;
+
+  while (_Evict() == 0);
+  GUI_ZEROFILL(&_Cache, sizeof(_Cache));
+  for (i = 0; i < CACHE_NUM_GLYPHS; i++) {
+    _Cache.aGlyph[i].pNextHash = _Cache.pFree;
+    _Cache.pFree               = &_Cache.aGlyph[i];
+  }
+}
+
+/*********************************************************************
+*
+*       _FindGlyph
+*/
+static GLYPH * _FindGlyph(const XBF_FILE * pFile, U16 c) {
+  GLYPH * pGlyph;
+
+  for (pGlyph = _Cache.apHash[_Hash(pFile, c)]; pGlyph; pGlyph = pGlyph->pNextHash) {
+    if ((pGlyph->c == c) && (pGlyph->pFile == pFile)) {
+      break;
+    }
+  }
+  return pGlyph;
+}
+
+/*********************************************************************
+*
+*       _LoadGlyph
+*
+* Function description
+*   Reads table entry and data of the given character from the file
+*   and adds it to the cache. Least recently used glyphs are evicted
+*   until the byte budget allows storing the new one.
+*/
+static GLYPH * _LoadGlyph(const XBF_FILE * pFile, U16 c) {
+  GLYPH  * pGlyph;
+  U8       aEntry[XBF_SIZEOF_ENTRY];
+  U32      Off;
+  U16      NumBytes;
+  GUI_HMEM hData;
+  unsigned i;
+
+  if (DATASOURCE_Read(pFile->pSrc, aEntry, XBF_OFF_TABLE + (U32)(c - pFile->First) * XBF_SIZEOF_ENTRY, XBF_SIZEOF_ENTRY) != XBF_SIZEOF_ENTRY) {
+    return NULL;
+  }
+  Off      = aEntry[0] | ((U32)aEntry[1] << 8) | ((U32)aEntry[2] << 16) | ((U32)aEntry[3] << 24);
+  NumBytes = aEntry[4] | (aEntry[5] << 8);
+  if (NumBytes > CACHE_NUM_BYTES) {
+    return NULL;
+  }
+  while ((_Cache.pFree == NULL) || (_Cache.NumBytes + NumBytes > CACHE_NUM_BYTES)) {
+    _Evict();
+  }
+  hData = 0;
+  if (NumBytes) {
+    hData = GUI_ALLOC_AllocNoInit(NumBytes);
+    if (hData == 0) {
+      return NULL;
+    }
+    if (DATASOURCE_Read(pFile->pSrc, GUI_ALLOC_h2p(hData), Off, NumBytes) != NumBytes) {
+      GUI_ALLOC_Free(hData);
+      return NULL;
+    }
+  }
+  pGlyph           = _Cache.pFree;
+  _Cache.pFree     = pGlyph->pNextHash;
+  pGlyph->pFile    = pFile;
+  pGlyph->c        = c;
+  pGlyph->Off      = Off;
+  pGlyph->NumBytes = NumBytes;
+  pGlyph->hData    = hData;
+  for (i = 0; i < XBF_SIZEOF_ENTRY; i++) {
+    pGlyph->aEntry[i] = aEntry[i];
+  }
+  i                  = _Hash(pFile, c);
+  pGlyph->pNextHash  = _Cache.apHash[i];
+  _Cache.apHash[i]   = pGlyph;
+  pGlyph->pPrev      = NULL;
+  pGlyph->pNext      = _Cache.pFirst;
+  if (_Cache.pFirst) {
+    _Cache.pFirst->pPrev = pGlyph;
+  } else {
+    _Cache.pLast = pGlyph;
+  }
+  _Cache.pFirst    = pGlyph;
+  _Cache.NumBytes += NumBytes;
+  return pGlyph;
+}
+
+/*********************************************************************
+*
+*       _cbGetData
+*
+* Function description
+*   GetData function of the XBF font. Requests for the table entry of a
+*   character are served from the cache, a miss loads entry and data of
+*   the glyph. The following request for the glyph data is then served
+*   from the cache too. Everything else is passed to the data source.
+*/
+static int _cbGetData(U32 Off, U16 NumBytes, void * pVoid, void * pBuffer) {
+  XBF_FILE * pFile;
+  GLYPH    * pGlyph;
+  U32        Index;
+  unsigned   Pos;
+
+  pFile = (XBF_FILE *)pVoid;
+  if (Off >= XBF_OFF_TABLE) {
+    Index = (Off - XBF_OFF_TABLE) / XBF_SIZEOF_ENTRY;
+    Pos   = (Off - XBF_OFF_TABLE) % XBF_SIZEOF_ENTRY;
+    if ((Index <= (U32)(pFile->Last - pFile->First)) && (Pos + NumBytes <= XBF_SIZEOF_ENTRY)) {
+      pGlyph = _FindGlyph(pFile, (U16)(pFile->First + Index));
+      if (pGlyph) {
+        _Cache.NumHits++;
+        _Touch(pGlyph);
+      } else {
+        _Cache.NumMisses++;
+        pGlyph = _LoadGlyph(pFile, (U16)(pFile->First + Index));
+      }
+      _Cache.pCur = pGlyph;
+      if (pGlyph) {
+        memcpy(pBuffer, pGlyph->aEntry + Pos, NumBytes);
+        return 0;
+      }
+    }
+  }
+  pGlyph = _Cache.pCur;
+  if (pGlyph && (pGlyph->pFile == pFile) && (Off >= pGlyph->Off) && (Off + NumBytes <= pGlyph->Off + pGlyph->NumBytes)) {
+    memcpy(pBuffer, (U8 *)GUI_ALLOC_h2p(pGlyph->hData) + (Off - pGlyph->Off), NumBytes);
+    return 0;
+  }
+  return DATASOURCE_GetDataXBF(Off, NumBytes, pFile->pSrc, pBuffer);
+}
+
+/*********************************************************************
+*
+*       _Prefetch
+*
+* Function description
+*   Loads all glyphs of the given UTF-8 string which are not already
+*   cached. The missing characters are sorted before loading, so the
+*   table entries and glyph data are read in file order.
+*/
+static void _Prefetch(const XBF_FILE * pFile, const char * s) {
+  U16      ac[CACHE_MAX_PREFETCH];
+  GLYPH  * pGlyph;
+  unsigned NumChars;
+  unsigned i;
+  unsigned j;
+  U16      c;
+
+  NumChars = 0;
+  while (*s && (NumChars < GUI_COUNTOF(ac))) {
+    c  = GUI_UC_GetCharCode(s);
+    s += GUI_UC_GetCharSize(s);
+    if ((c < pFile->First) || (c > pFile->Last)) {
+      continue;
+    }
+    pGlyph = _FindGlyph(pFile, c);
+    if (pGlyph) {
+      _Touch(pGlyph);
+      continue;
+    }
+    //
+    // Insert sorted, skip duplicates
+    //
+    for (i = 0; (i < NumChars) && (ac[i] < c); i++);
+    if ((i < NumChars) && (ac[i] == c)) {
+      continue;
+    }
+    for (j = NumChars; j > i; j--) {
+      ac[j] = ac[j - 1];
+    }
+    ac[i] = c;
+    NumChars++;
+  }
+  for (i = 0; i < NumChars; i++) {
+    _Cache.NumMisses++;
+    _LoadGlyph(pFile, ac[i]);
+  }
+}
+
 /*********************************************************************
 *
 *       _GetFileName
@@ -94,67 +437,70 @@ static void _GetFileName(char * pPath, unsigned MaxSize) {
 
 /*********************************************************************
 *
-*       _cbGetData
+*       _ShowXBF
 *
 * Function description
-*   Callback function for getting font data
-*
-* Parameters:
-*   Off      - Position of XBF file to be read
-*   NumBytes - Number of requested bytes
-*   pVoid    - Application defined pointer
-*   pBuffer  - Pointer to buffer to be filled by the function
-*
-* Return value:
-*   0 on success, 1 on error
+*   Small sub routine which creates (and selects) a XBF font,
+*   shows 'Hello world!' and waits for a keypress. The text is drawn
+*   NUM_REPEAT times to show the effect of the glyph cache.
 */
-static int _cbGetData(U32 Off, U16 NumBytes, void * pVoid, void * pBuffer) {
-  HANDLE hFile;
-  DWORD  NumBytesRead;
+static void _ShowXBF(DATASOURCE * pSrc) {
+  static const char   acText[] = "Hello world!";
+  GUI_XBF_DATA        XBF_Data;
+  GUI_FONT            Font;
+  XBF_FILE            File;
+  U8                  aFirst[4];
+  DATASOURCE_STAT     Stat;
+  U32                 NumSysCalls;
+  U32                 NumHits;
+  U32                 NumMisses;
+  GUI_TIMER_TIME      t;
+  int                 i;
 
-  hFile = *(HANDLE *)pVoid;
   //
-  // Set file pointer to the requested position
+  // Get the character range of the font for the glyph cache
   //
-  if (SetFilePointer(hFile, Off, 0, FILE_BEGIN) == 0xFFFFFFFF) {
-    return 1; // Error
-  }
-  //
-  // Read font data
-  //
-  if (!ReadFile(hFile, pBuffer, NumBytes, &NumBytesRead, 0)) {
-    return 1; // Error
-  }
-  if (NumBytesRead != NumBytes) {
-    return 1; // Error
+  if (DATASOURCE_Read(pSrc, aFirst, XBF_OFF_FIRST, sizeof(aFirst)) != sizeof(aFirst)) {
+    return;
   }
-  return 0;   // Ok
-}
-
-/*********************************************************************
-*
-*       _ShowXBF
-*
-* Function description
-*   Small sub routine which creates (and selects) a XBF font,
-*   shows 'Hello world!' and waits for a keypress
-*/
-static void _ShowXBF(void * pVoid) {
-  GUI_XBF_DATA XBF_Data;
-  GUI_FONT     Font;
-
+  File.pSrc  = pSrc;
+  File.First = aFirst[0] | (aFirst[1] << 8);
+  File.Last  = aFirst[2] | (aFirst[3] << 8);
   //
   // Create XBF font
   //
-  GUI_XBF_CreateFont(&Font,             // Pointer to GUI_FONT structure in RAM
-                     &XBF_Data,         // Pointer to GUI_XBF_DATA structure in RAM
-                     GUI_XBF_TYPE_PROP, // Font type to be created
-                     _cbGetData,        // Pointer to callback function
-                     pVoid);            // Pointer to be passed to GetData function
+  GUI_XBF_CreateFont(&Font,                 // Pointer to GUI_FONT structure in RAM
+                     &XBF_Data,             // Pointer to GUI_XBF_DATA structure in RAM
+                     GUI_XBF_TYPE_PROP,     // Font type to be created
+                     _cbGetData,            // Pointer to callback function
+                     &File);                // Pointer to be passed to GetData function
   //
   // Show 'Hello world!'
   //
-  GUI_DispStringHCenterAt("Hello world!", 160, 80);
+  DATASOURCE_GetStat(pSrc, &Stat);
+  NumSysCalls = Stat.NumSysCalls;
+  NumHits     = _Cache.NumHits;
+  NumMisses   = _Cache.NumMisses;
+  t           = GUI_GetTime();
+  for (i = 0; i < NUM_REPEAT; i++) {
+    _Prefetch(&File, acText);
+    GUI_DispStringHCenterAt(acText, 160, 80);
+  }
+  t = GUI_GetTime() - t;
+  DATASOURCE_GetStat(pSrc, &Stat);
+  //
+  // Show glyphs per second, file reads per frame and cache counters
+  //
+  GUI_SetFont(&GUI_Font10_ASCII);
+  GUI_GotoXY(10, 160);
+  GUI_DispDecMin((NUM_REPEAT * (sizeof(acText) - 1) * 1000) / (t ? t : 1));
+  GUI_DispString(" glyphs/s, ");
+  GUI_DispDecMin((Stat.NumSysCalls - NumSysCalls) / NUM_REPEAT);
+  GUI_DispString(" file reads/frame, ");
+  GUI_DispDecMin(_Cache.NumHits - NumHits);
+  GUI_DispString(" hits, ");
+  GUI_DispDecMin(_Cache.NumMisses - NumMisses);
+  GUI_DispString(" misses");
   //
   // Display hint
   //
@@ -171,6 +517,7 @@ static void _ShowXBF(void * pVoid) {
   // Delete XBF font and clear display
   //
   GUI_XBF_DeleteFont(&Font);
+  _InitCache();
   GUI_ClearRect(0, 40, 319, 239);
 }
 
@@ -185,8 +532,8 @@ static void _ShowXBF(void * pVoid) {
 *       MainTask
 */
 void MainTask(void) {
-  HANDLE hFile;
-  char   acPath[_MAX_PATH] = {0};
+  DATASOURCE * pSrc;
+  char         acPath[_MAX_PATH] = {0};
 
   //
   // Initialize emWin
@@ -199,6 +546,7 @@ void MainTask(void) {
     GUI_ErrorOut("Not enough memory available."); 
     return;
   }
+  _InitCache();
   GUI_SetFont(&GUI_Font24_ASCII);
   GUI_DispStringHCenterAt("External binary font sample", 160, 5);
   while (1) {
@@ -209,13 +557,13 @@ void MainTask(void) {
     //
     // ...and open the file
     //
-    hFile = CreateFile(acPath, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-    if (hFile != INVALID_HANDLE_VALUE) {
+    pSrc = DATASOURCE_Open(acPath);
+    if (pSrc) {
       //
       // On success call demo routine
       //
-      _ShowXBF(&hFile);
-      CloseHandle(hFile);
+      _ShowXBF(pSrc);
+      DATASOURCE_Close(pSrc);
     } else {
       //
       // On error show message box
@@ -28,6 +28,7 @@ Requirements: WindowManager - ( )
 #include <stdlib.h>
 
 #include "GUI.h"
+#include "RotCache.h"
 
 /*********************************************************************
 *
@@ -52,10 +53,26 @@ Requirements: WindowManager - ( )
   #define COLOR_CONV GUICC_8888
 #endif
 
+//
+// Rotation caches. The needle is cached for NEEDLE_NUM_ANGLES angles
+// of the 240 degrees of the scale, the scale for SCALE_NUM_ANGLES
+// angles of a full turn. The number of angles is reduced if the
+// rotated devices would exceed the memory budget, a budget of 0
+// disables the cache.
+//
+#define NEEDLE_NUM_ANGLES    241
+#define NEEDLE_CACHE_BYTES   (1024L * 768)
+#define SCALE_NUM_ANGLES     72
+#define SCALE_CACHE_BYTES    0
+#define NEEDLE_A0            (-30000)  // Angle of the needle at 240 km/h
+#define NEEDLE_A1            210000    // Angle of the needle at 0 km/h
+
+#define T_STAT               1000
+
 //
 // Recommended memory to run the sample with adequate performance
 //
-#define RECOMMENDED_MEMORY (1024L * 1300)
+#define RECOMMENDED_MEMORY (1024L * 1300 + NEEDLE_CACHE_BYTES + SCALE_CACHE_BYTES)
 
 /*********************************************************************
 *
@@ -7751,6 +7768,8 @@ typedef struct {
   GUI_MEMDEV_Handle hScale;
   GUI_MEMDEV_Handle hScaleRot;
   GUI_MEMDEV_Handle hMemBk;
+  ROTCACHE        * pNeedleCache;
+  ROTCACHE        * pScaleCache;
   float             Angle;
   float             Speed;
   int               xSize;
@@ -7758,6 +7777,14 @@ typedef struct {
   U32               FontColor;
 } PARAM;
 
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static ROTCACHE _NeedleCache;
+static ROTCACHE _ScaleCache;
 
 /*********************************************************************
 *
@@ -7817,10 +7844,49 @@ static void _DrawNeedle(PARAM * pParam, GUI_MEMDEV_Handle hDst) {
   ySizeDst = (GUI_MEMDEV_GetYSize(hDst) + 1) & ~1;
   SinHQ = GUI__SinHQ((I32)((pParam->Angle) * (-1000)) + 30000);
   CosHQ = GUI__CosHQ((I32)((pParam->Angle) * (-1000)) + 30000);
-  GUI_MEMDEV_RotateHQHR(pParam->hNeedle, hDst, 
-                        ((xSizeDst - xSizeNeedle) * 4) - (((xSizeNeedle) * CosHQ) >> 14),
-                        ((ySizeDst - ySizeNeedle) * 4) + (((xSizeNeedle) * SinHQ) >> 14),
-                        (int)((pParam->Angle) * (-1000) + 210000), 1000);
+  ROTCACHE_DrawHR(pParam->pNeedleCache, hDst, 
+                  ((xSizeDst - xSizeNeedle) * 4) - (((xSizeNeedle) * CosHQ) >> 14),
+                  ((ySizeDst - ySizeNeedle) * 4) + (((xSizeNeedle) * SinHQ) >> 14),
+                  (int)((pParam->Angle) * (-1000) + 210000));
+}
+
+/*********************************************************************
+*
+*       _DrawStat
+*
+*  Purpose: Shows frames per second and the state of the needle cache
+*           at the left border.
+*/
+static void _DrawStat(PARAM * pParam, int Fps) {
+  ROTCACHE_STAT * pStat;
+  GUI_RECT        Rect;
+  U32             NumReq;
+
+  pStat  = &pParam->pNeedleCache->Stat;
+  NumReq = pStat->NumHits + pStat->NumMisses + pStat->NumDirect;
+  Rect.x0 = 0;
+  Rect.y0 = 50;
+  Rect.x1 = 100;
+  Rect.y1 = Rect.y0 + 50;
+  GUI_SetClipRect(&Rect);
+  GUI_MEMDEV_CopyToLCD(pParam->hMemBk);
+  GUI_SetClipRect(NULL);
+  GUI_SetFont(&GUI_Font8_ASCII);
+  GUI_SetColor(GUI_WHITE);
+  GUI_SetTextAlign(GUI_TA_LEFT);
+  GUI_SetTextMode(GUI_TM_TRANS);
+  GUI_DispStringAt("fps:    ", 4, Rect.y0);
+  GUI_DispDecMin(Fps);
+  GUI_DispStringAt("angles: ", 4, Rect.y0 + 10);
+  GUI_DispDecMin(pStat->NumItems);
+  GUI_DispString("/");
+  GUI_DispDecMin(pParam->pNeedleCache->NumAngles);
+  GUI_DispStringAt("cache:  ", 4, Rect.y0 + 20);
+  GUI_DispDecMin(pStat->NumBytes >> 10);
+  GUI_DispString(" KB");
+  GUI_DispStringAt("hits:   ", 4, Rect.y0 + 30);
+  GUI_DispDecMin(NumReq ? (int)((pStat->NumHits * 100) / NumReq) : 0);
+  GUI_DispString("%");
 }
 /*********************************************************************
 *
@@ -7918,7 +7984,7 @@ static void _Roll(PARAM * pParam, int tMax, void (* pfCalcX)(int, int, int, int
       GUI_MEMDEV_Select(pParam->hDst);
       GUI_MEMDEV_Write(pParam->hMemBk);
       pfCalcX(tDiff, tMax, Size_DevRotate, &ix, &iSpin);
-      GUI_MEMDEV_Rotate(pParam->hScaleRot, pParam->hDst, ix , (pParam->ySize - Size_DevRotate) >> 1, iSpin, 1000);
+      ROTCACHE_Draw(pParam->pScaleCache, pParam->hDst, ix , (pParam->ySize - Size_DevRotate) >> 1, iSpin);
       GUI_MEMDEV_Select(0);
       GUI_MEMDEV_CopyToLCD(pParam->hDst);
     }
@@ -7999,6 +8065,8 @@ void MainTask(void) {
   int               tStart;
   int               tDiff;
   int               tUsed;
+  int               tStat;
+  int               NumFrames;
   GUI_RECT          RectQ1, RectQ2, RectQ3, RectQ4, RectClip, RectSpeed;
   
   Param.Speed = 0;
@@ -8052,6 +8120,8 @@ void MainTask(void) {
   hClearAlpha     = GUI_MEMDEV_CreateFixed(0, 0, _bmSpeedometerScale.XSize, _bmSpeedometerScale.YSize, GUI_MEMDEV_NOTRANS, GUI_MEMDEV_APILIST_1, GUI_COLOR_CONV_1);
   _CreateNeedle(&Param);
   _DrawScale(&Param);
+  Param.pNeedleCache = &_NeedleCache;
+  ROTCACHE_Init(Param.pNeedleCache, Param.hNeedle, NEEDLE_A0, NEEDLE_A1, NEEDLE_NUM_ANGLES, NEEDLE_CACHE_BYTES, ROTCACHE_CF_HQ | ROTCACHE_CF_BLEND);
   //
   // Initialize high resolution anti aliasing
   //
@@ -8078,6 +8148,8 @@ void MainTask(void) {
   // Clear unneeded alpha values
   //
   GUI_MEMDEV_ClearAlpha(Param.hScaleRot, hClearAlpha);
+  Param.pScaleCache = &_ScaleCache;
+  ROTCACHE_Init(Param.pScaleCache, Param.hScaleRot, 0, 360000, SCALE_NUM_ANGLES, SCALE_CACHE_BYTES, 0);
   //
   // Create background device
   //
@@ -8125,10 +8197,21 @@ void MainTask(void) {
     //
     // Accelerate and brake
     //
-    t0 = GUI_GetTime();
+    t0        = GUI_GetTime();
+    tStat     = t0;
+    NumFrames = 0;
     for (; (tDiff = GUI_GetTime() - t0) < T_MAX;) {
       tStart = GUI_GetTime();
       //
+      // Show statistics once per second
+      //
+      if (tStart - tStat >= T_STAT) {
+        _DrawStat(&Param, (NumFrames * 1000) / (tStart - tStat));
+        tStat     = tStart;
+        NumFrames = 0;
+      }
+      NumFrames++;
+      //
       // Calculate speed dependent on time
       //
       if (tDiff < (T_MAX >> 1)) {
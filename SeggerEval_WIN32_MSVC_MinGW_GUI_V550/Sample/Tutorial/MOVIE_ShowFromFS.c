@@ -31,10 +31,9 @@ Requirements: WindowManager - ( )
 #ifndef SKIP_TEST
 
 #include "GUI.h"
+#include "DataSource.h"
 
-#ifdef WIN32
-  #include <windows.h>
-#else
+#if (DATASOURCE_BACKEND == DATASOURCE_BACKEND_EMFILE)
   #include "FS.h"
 #endif
 
@@ -76,31 +75,6 @@ void _cbNotify(GUI_HMEM hMem, int Notification, U32 CurrentFrame) {
   }
 }
 
-/*********************************************************************
-*
-*       _GetData
-*
-* Function description
-*   Reading data directly from file system
-*/
-int _GetData(void * p, const U8 ** ppData, unsigned NumBytes, U32 Off) {
-  U32 NumBytesRead;
-#ifdef WIN32
-  HANDLE hFile;
-
-  hFile = *(HANDLE *)p;
-  SetFilePointer(hFile, Off, 0, FILE_BEGIN);
-  ReadFile(hFile, (U8 *)*ppData, NumBytes, &NumBytesRead, NULL);
-#else
-  FS_FILE * pFile;
-
-  pFile = (FS_FILE *)p;
-  FS_SetFilePos(pFile, Off, FS_FILE_BEGIN);
-  NumBytesRead = FS_Read(pFile, (U8 *)*ppData, NumBytes);
-#endif
-  return NumBytesRead;
-}
-
 /*********************************************************************
 *
 *       Public code
@@ -136,14 +110,11 @@ void MainTask(void) {
   int              xSize, ySize;
   GUI_RECT         Rect;
   int              FontDistY;
+  DATASOURCE     * pSrc;
 #ifdef WIN32
-  HANDLE           hFile;
   const char       acFileName[] = "C:/Work/emWin/Sample/Tutorial/MOVIE_ShowFromFS.emf";
-  #define PARAM    &hFile
 #else
-  FS_FILE        * pFile;
   const char       acFileName[] = "\\MOVIE_ShowFromFS.emf";
-  #define PARAM    pFile
 #endif
 
   GUI_Init();
@@ -160,18 +131,16 @@ void MainTask(void) {
   xSize = LCD_GetXSize();
   ySize = LCD_GetYSize();
   //
-  // Create file handle
+  // Open data source
   //
-#ifdef WIN32
-  hFile = CreateFile(acFileName, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-#else
+#if (DATASOURCE_BACKEND == DATASOURCE_BACKEND_EMFILE)
   FS_Init();
-  pFile = FS_FOpen(acFileName, "r");
 #endif
+  pSrc = DATASOURCE_Open(acFileName);
   //
   // Get physical size of movie
   //
-  if (GUI_MOVIE_GetInfoEx(_GetData, PARAM, &Info) == 0) {
+  if (pSrc && (GUI_MOVIE_GetInfoEx(DATASOURCE_GetDataCopy, pSrc, &Info) == 0)) {
     //
     // Check if display size fits
     //
@@ -179,7 +148,7 @@ void MainTask(void) {
       //
       // Create and play movie
       //
-      hMovie = GUI_MOVIE_CreateEx(_GetData, PARAM, _cbNotify);
+      hMovie = GUI_MOVIE_CreateEx(DATASOURCE_GetDataCopy, pSrc, _cbNotify);
       if (hMovie) {
         GUI_MOVIE_Show(hMovie, (xSize - Info.xSize) / 2, (ySize - Info.ySize) / 2, 1);
       }
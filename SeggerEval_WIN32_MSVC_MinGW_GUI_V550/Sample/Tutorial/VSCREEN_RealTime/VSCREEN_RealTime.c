@@ -43,9 +43,11 @@ Requirements: WindowManager - (x)
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 #include "DIALOG.h"
 #include "PROGBAR.h"
 #include "LCDConf.h"
+#include "Decimator.h"
 
 /*********************************************************************
 *
@@ -55,6 +57,15 @@ Requirements: WindowManager - (x)
 */
 #define ID_TEMPERATURE (GUI_ID_USER + 0)
 
+//
+// Simulated sensors: 1 MS/s per channel, fed every 100 ms. The graph
+// shows one min/max span of 2^GRAPH_LEVEL samples per pixel column.
+//
+#define SAMPLE_RATE      1000000
+#define NUM_SAMPLES_TICK (SAMPLE_RATE / 10)
+#define GRAPH_XSIZE      277
+#define GRAPH_LEVEL      16
+
 //
 // Recommended memory to run the sample with adequate performance
 //
@@ -269,9 +280,29 @@ GUI_COLOR _ColorTemp2      = GUI_BLUE;
 static int _ColorIndex;
 
 //
-// Arrays of temperature values
+// Envelopes of the temperature channels and buffer for the samples
+// of one period
+//
+static DECIMATOR _aDec[2];
+static I16       _aBuffer[NUM_SAMPLES_TICK];
+static I16       _aBase[2];
+
+//
+// Each period contains one single sample peak per channel. A peak is
+// checked to be visible in the envelope when its span is complete.
+// A span (2^GRAPH_LEVEL samples) is shorter than a period, so a peak
+// is checked at the latest one period after it has been added.
+//
+static U32 _aaPeak[2][2];
+static int _aNumPeaksPending[2];
+static U32 _NumPeaks;
+static U32 _NumPeaksKept;
+static U32 _Seed = 1;
+
+//
+// Time used for drawing the graph
 //
-static I16 _aTemp1[277], _aTemp2[277];
+static int _tDraw;
 
 /*********************************************************************
 *
@@ -303,19 +334,72 @@ static I16 _GetRandomValue(I16 Old) {
 
 /*********************************************************************
 *
-*       _InitRandomData
+*       _AddSamples
+*
+* Function description
+*   Creates the samples of one period for the given channel: A slowly
+*   changing base value with some noise and one single sample peak at
+*   a random position. The samples are added to the envelope.
 */
-static void _InitRandomData(I16 * paY, int n) {
-  int i;
+static void _AddSamples(int Channel) {
+  U32 Pos;
+  U32 i;
   int MaxValue;
+  int v;
 
   MaxValue = _TempMax - _TempMin;
-  for (i = 0; i < n; i++) {
-    if (!i) {
-      paY[i] = rand() % MaxValue;
-    } else {
-      paY[i] = _GetRandomValue(paY[i-1]);
+  _aBase[Channel] = _GetRandomValue(_aBase[Channel]);
+  for (i = 0; i < NUM_SAMPLES_TICK; i++) {
+    _Seed = _Seed * 1103515245 + 12345;
+    v = _aBase[Channel] + (int)((_Seed >> 16) % 5) - 2;
+    if (v < 1) {
+      v = 1;
+    } else if (v > MaxValue) {
+      v = MaxValue;
     }
+    _aBuffer[i] = (I16)v;
+  }
+  Pos = rand() % NUM_SAMPLES_TICK;
+  _aBuffer[Pos] = 0;
+  if (_aNumPeaksPending[Channel] < (int)GUI_COUNTOF(_aaPeak[0])) {
+    _aaPeak[Channel][_aNumPeaksPending[Channel]++] = _aDec[Channel].NumItems + Pos;
+  }
+  DECIMATOR_AddValues(&_aDec[Channel], _aBuffer, NUM_SAMPLES_TICK);
+}
+
+/*********************************************************************
+*
+*       _CheckPeaks
+*
+* Function description
+*   Checks if the pending peaks are contained in the envelope. Called
+*   before adding the samples of the next period. A span of the graph
+*   has 2^GRAPH_LEVEL (65536) samples and a period NUM_SAMPLES_TICK
+*   (100000), so the span of the last peak may still be incomplete.
+*   Such a peak is not counted and stays pending for the next check.
+*/
+static void _CheckPeaks(void) {
+  DECIMATOR_SPAN * pSpan;
+  U32              Span;
+  int              i;
+  int              j;
+  int              n;
+
+  for (i = 0; i < 2; i++) {
+    n = 0;
+    for (j = 0; j < _aNumPeaksPending[i]; j++) {
+      Span = _aaPeak[i][j] >> GRAPH_LEVEL;
+      if (Span >= DECIMATOR_GetNumSpans(&_aDec[i], GRAPH_LEVEL)) {
+        _aaPeak[i][n++] = _aaPeak[i][j];
+        continue;
+      }
+      pSpan = &_aDec[i].aaSpan[GRAPH_LEVEL][Span & (DECIMATOR_NUM_SPANS - 1)];
+      _NumPeaks++;
+      if (pSpan->Min == 0) {
+        _NumPeaksKept++;
+      }
+    }
+    _aNumPeaksPending[i] = n;
   }
 }
 
@@ -354,11 +438,12 @@ static void _UpdateTextColors(WM_HWIN hDlg) {
 *       _DrawGraph
 */
 static void _DrawGraph(void) {
-  GUI_RECT Rect;
-  int      xSize;
-  int      ySize;
-  int      x;
-  int      y;
+  GUI_RECT       Rect;
+  GUI_TIMER_TIME t;
+  int            xSize;
+  int            ySize;
+  int            x;
+  int            y;
 
   WM_GetClientRect(&Rect);
   xSize = Rect.x1;
@@ -374,10 +459,12 @@ static void _DrawGraph(void) {
     int xPos = x + 25;
     GUI_DrawVLine(xPos, 1, ySize - 21);
   }
+  t = GUI_GetTime();
   GUI_SetColor(_ColorTemp1);
-  GUI_DrawGraph(_aTemp1, GUI_COUNTOF(_aTemp1), 26, ySize - 121);
+  DECIMATOR_DrawGraph(&_aDec[0], GRAPH_LEVEL, GRAPH_XSIZE, 26, ySize - 121);
   GUI_SetColor(_ColorTemp2);
-  GUI_DrawGraph(_aTemp2, GUI_COUNTOF(_aTemp2), 26, ySize - 121);
+  DECIMATOR_DrawGraph(&_aDec[1], GRAPH_LEVEL, GRAPH_XSIZE, 26, ySize - 121);
+  _tDraw = GUI_GetTime() - t;
 }
 
 /*********************************************************************
@@ -655,10 +742,10 @@ static void _cbDialogMain(WM_MESSAGE * pMsg) {
     //
     hItem = WM_GetDialogItem(hDlg, GUI_ID_PROGBAR0);
     WIDGET_SetEffect(hItem, &WIDGET_Effect_3D);
-    _SetProgbarValue(GUI_ID_PROGBAR0, _aTemp1[GUI_COUNTOF(_aTemp1) - 1]);
+    _SetProgbarValue(GUI_ID_PROGBAR0, _aDec[0].Last);
     hItem = WM_GetDialogItem(hDlg, GUI_ID_PROGBAR1);
     WIDGET_SetEffect(hItem, &WIDGET_Effect_3D);
-    _SetProgbarValue(GUI_ID_PROGBAR1, _aTemp2[GUI_COUNTOF(_aTemp2) - 1]);
+    _SetProgbarValue(GUI_ID_PROGBAR1, _aDec[1].Last);
     //
     // Init edit widgets
     //
@@ -702,7 +789,10 @@ static void _cbDialogMain(WM_MESSAGE * pMsg) {
 *          MainTask
 */
 void MainTask(void) {
-  int Index;
+  GUI_TIMER_TIME t;
+  char           acText[80];
+  int            tAdd;
+  int            i;
 
   GUI_Init();
   //
@@ -717,10 +807,13 @@ void MainTask(void) {
   #endif
   WM_SetDesktopColor(GUI_BLACK);
   //
-  // Initialize the temperature arrays
+  // Initialize the temperature envelopes
   //
-  _InitRandomData(_aTemp1, GUI_COUNTOF(_aTemp1));
-  _InitRandomData(_aTemp2, GUI_COUNTOF(_aTemp2));
+  for (i = 0; i < 2; i++) {
+    DECIMATOR_Init(&_aDec[i]);
+    _aBase[i] = rand() % (_TempMax - _TempMin);
+    _aDec[i].Last = _aBase[i];
+  }
   //
   // Execute the intro dialog
   //
@@ -733,27 +826,30 @@ void MainTask(void) {
   //
   // Add new temperatures...
   //
-  Index = GUI_COUNTOF(_aTemp1) - 1;
   while (1) {
     WM_HWIN hItem;
     GUI_Delay(100); // Wait a while
     //
-    // Shift the color arrays
+    // Add new values
     //
-    memmove(_aTemp1, _aTemp1 + 1, sizeof(_aTemp1) - 2);
-    memmove(_aTemp2, _aTemp2 + 1, sizeof(_aTemp2) - 2);
+    _CheckPeaks();
+    t = GUI_GetTime();
+    _AddSamples(0);
+    _AddSamples(1);
+    tAdd = GUI_GetTime() - t;
     //
-    // Add new values
+    // Show the time required for adding and drawing and the number
+    // of peaks visible in the graph
     //
-    _aTemp1[Index] = _GetRandomValue(_aTemp1[Index - 1]);
-    _aTemp2[Index] = _GetRandomValue(_aTemp2[Index - 1]);
+    hItem = WM_GetDialogItem(_hDialogMain, ID_TEMPERATURE);
+    sprintf(acText, "Temp. 2 x 1 MS/s: add %d ms, draw %d ms, peaks %lu/%lu", tAdd, _tDraw, (unsigned long)_NumPeaksKept, (unsigned long)_NumPeaks);
+    FRAMEWIN_SetText(hItem, acText);
     //
     // Update windows
     //
-    hItem = WM_GetClientWindow(WM_GetDialogItem(_hDialogMain, ID_TEMPERATURE));
-    WM_InvalidateWindow(hItem);
-    _SetProgbarValue(GUI_ID_PROGBAR0, _aTemp1[Index]);
-    _SetProgbarValue(GUI_ID_PROGBAR1, _aTemp2[Index]);
+    WM_InvalidateWindow(WM_GetClientWindow(hItem));
+    _SetProgbarValue(GUI_ID_PROGBAR0, _aDec[0].Last);
+    _SetProgbarValue(GUI_ID_PROGBAR1, _aDec[1].Last);
   }
 }
 
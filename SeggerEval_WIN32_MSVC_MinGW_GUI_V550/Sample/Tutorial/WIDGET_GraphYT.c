@@ -30,6 +30,7 @@ Requirements: WindowManager - (x)
 
 #include "DIALOG.h"
 #include "GRAPH.h"
+#include "Decimator.h"
 
 /*********************************************************************
 *
@@ -39,6 +40,13 @@ Requirements: WindowManager - (x)
 */
 #define MAX_VALUE 180
 
+//
+// Simulated input of 1 MS/s per channel. The graph shows the min/max
+// envelope with 2^GRAPH_LEVEL samples per pixel column.
+//
+#define NUM_SAMPLES_TICK 10000  // Samples per channel and loop (10 ms)
+#define GRAPH_LEVEL      14
+
 //
 // Recommended memory to run the sample with adequate performance
 //
@@ -50,13 +58,18 @@ Requirements: WindowManager - (x)
 *
 **********************************************************************
 */
-static GRAPH_DATA_Handle  _ahData[3]; // Array of handles for the GRAPH_DATA objects
+static GRAPH_DATA_Handle  _ahData[6]; // Array of handles for the GRAPH_DATA objects, min and max per channel
 static GRAPH_SCALE_Handle _hScaleV;   // Handle of vertical scale
 static GRAPH_SCALE_Handle _hScaleH;   // Handle of horizontal scale
 
 static I16 _aValue[3];
 static int _Stop = 0;
 
+static DECIMATOR _aDec[3];                    // Envelope per channel
+static U32       _aNumSpans[3];               // Number of spans already added to the graph
+static I16       _aBuffer[NUM_SAMPLES_TICK];  // Samples of one loop
+static U32       _Seed = 1;
+
 static GUI_COLOR _aColor[] = {GUI_RED, GUI_GREEN, GUI_LIGHTBLUE}; // Array of colors for the GRAPH_DATA objects
 
 //
@@ -95,11 +108,17 @@ static const GUI_WIDGET_CREATE_INFO _aDialogCreate[] = {
 *       _AddValues
 *
 * Function description
-*   This routine calculates new random values in dependence of the previous added values
-*   and adds them to the GRAPH_DATA objects
+*   This routine calculates new random values in dependence of the previous added values.
+*   Each loop creates NUM_SAMPLES_TICK noisy samples and some single sample peaks per
+*   channel. The samples are combined by the decimator, the GRAPH_DATA objects receive
+*   minimum and maximum of each completed pixel column.
 */
 static void _AddValues(void) {
-  unsigned i;
+  DECIMATOR_SPAN aSpan[8];
+  unsigned       i;
+  int            NumSpans;
+  int            j;
+  int            v;
 
   for (i = 0; i < GUI_COUNTOF(_aColor); i++) {
     int Add = ((unsigned)rand()) % (2 + i * i);
@@ -110,7 +129,28 @@ static void _AddValues(void) {
     } else if (_aValue[i] < 0) {
       _aValue[i] = 0;
     }
-    GRAPH_DATA_YT_AddValue(_ahData[i], _aValue[i]);
+    for (j = 0; j < NUM_SAMPLES_TICK; j++) {
+      _Seed = _Seed * 1103515245 + 12345;
+      v = _aValue[i] + (int)((_Seed >> 16) % 7) - 3;
+      _aBuffer[j] = (I16)((v < 0) ? 0 : (v > MAX_VALUE) ? MAX_VALUE : v);
+    }
+    if ((rand() % 20) == 0) {
+      _aBuffer[rand() % NUM_SAMPLES_TICK] = MAX_VALUE;
+    }
+    DECIMATOR_AddValues(&_aDec[i], _aBuffer, NUM_SAMPLES_TICK);
+    //
+    // Add the spans completed since the last call, oldest first
+    //
+    NumSpans = DECIMATOR_GetNumSpans(&_aDec[i], GRAPH_LEVEL) - _aNumSpans[i];
+    _aNumSpans[i] += NumSpans;
+    if (NumSpans > (int)GUI_COUNTOF(aSpan)) {
+      NumSpans = GUI_COUNTOF(aSpan);
+    }
+    NumSpans = DECIMATOR_GetSpans(&_aDec[i], GRAPH_LEVEL, aSpan, NumSpans);
+    for (j = 0; j < NumSpans; j++) {
+      GRAPH_DATA_YT_AddValue(_ahData[i * 2],     aSpan[j].Min);
+      GRAPH_DATA_YT_AddValue(_ahData[i * 2 + 1], aSpan[j].Max);
+    }
   }
 }
 
@@ -236,8 +276,12 @@ static void _cbCallback(WM_MESSAGE * pMsg) {
     //
     for (i = 0; i < GUI_COUNTOF(_aColor); i++) {
       _aValue[i] = rand() % 180;
-      _ahData[i] = GRAPH_DATA_YT_Create(_aColor[i], 500, 0, 0);
-      GRAPH_AttachData(hItem, _ahData[i]);
+      DECIMATOR_Init(&_aDec[i]);
+      _aNumSpans[i]      = 0;
+      _ahData[i * 2]     = GRAPH_DATA_YT_Create(_aColor[i], 500, 0, 0);
+      _ahData[i * 2 + 1] = GRAPH_DATA_YT_Create(_aColor[i], 500, 0, 0);
+      GRAPH_AttachData(hItem, _ahData[i * 2]);
+      GRAPH_AttachData(hItem, _ahData[i * 2 + 1]);
     }
     //
     // Set graph attributes
@@ -407,7 +451,7 @@ static void _cbCallback(WM_MESSAGE * pMsg) {
         // Toggle alignment
         //
         WM_GetDialogItem(hDlg, GUI_ID_GRAPH0);
-        for (i = 0; i < GUI_COUNTOF(_aColor); i++) {
+        for (i = 0; i < GUI_COUNTOF(_ahData); i++) {
           if (CHECKBOX_IsChecked(WM_GetDialogItem(hDlg, GUI_ID_CHECK8))) {
             GRAPH_DATA_YT_SetAlign(_ahData[i], GRAPH_ALIGN_LEFT);
             GRAPH_DATA_YT_MirrorX (_ahData[i], 1);
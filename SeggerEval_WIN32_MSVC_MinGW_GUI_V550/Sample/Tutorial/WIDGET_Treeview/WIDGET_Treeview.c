@@ -16,7 +16,10 @@ only  be used  in accordance  with  a license  and should  not be  re-
 distributed in any way. We appreciate your understanding and fairness.
 ----------------------------------------------------------------------
 File        : WIDGET_Treeview.c
-Purpose     : Demonstrates using the TREEVIEW widget
+Purpose     : Demonstrates using the TREEVIEW widget. With LAZY_TREEVIEW
+              enabled the items of a large hierarchy are created when
+              their parent node is expanded and deleted again when it
+              is collapsed.
 Requirements: WindowManager - (x)
               MemoryDevices - (x)
               AntiAliasing  - ( )
@@ -38,6 +41,22 @@ Requirements: WindowManager - (x)
 #define NUM_CHILD_ITEMS 6
 #define TREEVIEW_DEPTH  7
 
+//
+// Lazy creation of items. The synthetic hierarchy numbers its items
+// like a heap, the children of item n are the items n * LAZY_NUM_CHILDREN + 1
+// up to n * LAZY_NUM_CHILDREN + LAZY_NUM_CHILDREN. The user data of an item
+// contains its number and a flag which is set when the children are attached.
+//
+#define LAZY_TREEVIEW     1              // 1: Create items on expand, 0: Create all items up front
+#define LAZY_NUM_ITEMS    1000000UL      // Total number of items of the hierarchy
+#define LAZY_NUM_CHILDREN 10             // Number of children per node
+#define LAZY_FLAG_FILLED  (1UL << 31)    // Children of the item are attached
+
+//
+// Length of the labels of the result texts
+//
+#define LABEL_LEN 8
+
 //
 // Recommended memory to run the sample with adequate performance
 //
@@ -51,6 +70,7 @@ Requirements: WindowManager - (x)
 */
 static int _NumNodes;
 static int _NumLeaves;
+static int _NumItems;   // Number of items currently attached to the TREEVIEW
 
 /*********************************************************************
 *
@@ -58,39 +78,45 @@ static int _NumLeaves;
 *
 **********************************************************************
 */
+/*********************************************************************
+*
+*       _GetLen
+*/
+static int _GetLen(char * p) {
+  int Len;
+  
+  for (Len = 0; *p++; Len++);
+  return Len;
+}
+
 /*********************************************************************
 *
 *       _MakeNumberString
+*
+* Return value:
+*   Pointer to the terminating zero
 */
-static void _MakeNumberString(char * p, U32 Number) {
-  int v;
+static char * _MakeNumberString(char * p, U32 Number) {
+  U32 v;
   int NumDecs;
   
-  NumDecs = 0;
-  *p      = '0';
+  NumDecs = 1;
   v       = Number;
-  while (v) {
+  while (v >= 10) {
     NumDecs++;
     v /= 10;
   }
-  p += NumDecs - 1;
+  p += NumDecs;
+  *p = 0;
   while (NumDecs--) {
+    p--;
     *p = '0' + Number % 10;
     Number /= 10;
-    p--;
   }
+  return p + _GetLen(p);
 }
 
-/*********************************************************************
-*
-*       _GetLen
-*/
-static int _GetLen(char * p) {
-  int Len;
-  
-  for (Len = 0; *p++; Len++);
-  return Len;
-}
+#if (LAZY_TREEVIEW == 0)
 
 /*********************************************************************
 *
@@ -160,6 +186,184 @@ static int _FillNode(WM_HWIN hTree, TREEVIEW_ITEM_Handle hNode, int NumNodes, in
   return 0;
 }
 
+#endif
+
+#if LAZY_TREEVIEW
+
+/*********************************************************************
+*
+*       _GetNumChildren
+*
+* Function description
+*   Returns the number of children of the given item of the synthetic
+*   hierarchy. This is the hint which decides if an item is created as
+*   node, so the expand button is shown before any child exists.
+*/
+static U32 _GetNumChildren(U32 Id) {
+  U32 IdFirst;
+
+  IdFirst = Id * LAZY_NUM_CHILDREN + 1;
+  if (IdFirst >= LAZY_NUM_ITEMS) {
+    return 0;
+  }
+  if (LAZY_NUM_ITEMS - IdFirst < LAZY_NUM_CHILDREN) {
+    return LAZY_NUM_ITEMS - IdFirst;
+  }
+  return LAZY_NUM_CHILDREN;
+}
+
+/*********************************************************************
+*
+*       _MakeItemText
+*
+* Function description
+*   Creates the text of an item like '3.10.2 (10)', the path of the item
+*   followed by the number of children.
+*/
+static void _MakeItemText(char * p, U32 Id) {
+  U8  aIndex[16];
+  int NumLevels;
+
+  NumLevels = 0;
+  while (Id) {
+    aIndex[NumLevels++] = (U8)((Id - 1) % LAZY_NUM_CHILDREN + 1);
+    Id = (Id - 1) / LAZY_NUM_CHILDREN;
+  }
+  while (NumLevels--) {
+    p = _MakeNumberString(p, aIndex[NumLevels]);
+    if (NumLevels) {
+      *p++ = '.';
+    }
+  }
+  *p = 0;
+}
+
+/*********************************************************************
+*
+*       _CreateChildren
+*
+* Function description
+*   Creates and attaches the children of the given node.
+*
+* Return value:
+*  0 on success, 1 on error
+*/
+static int _CreateChildren(WM_HWIN hTree, TREEVIEW_ITEM_Handle hNode) {
+  TREEVIEW_ITEM_Handle hItem;
+  U32                  UserData;
+  U32                  IdFirst;
+  U32                  NumChildren;
+  U32                  NumGrandChildren;
+  U32                  i;
+  int                  Position;
+  char                 acBuffer[48];
+  char               * p;
+
+  UserData    = TREEVIEW_ITEM_GetUserData(hNode);
+  NumChildren = _GetNumChildren(UserData);
+  IdFirst     = UserData * LAZY_NUM_CHILDREN + 1;
+  TREEVIEW_ITEM_SetUserData(hNode, UserData | LAZY_FLAG_FILLED);
+  Position    = TREEVIEW_INSERT_FIRST_CHILD;
+  for (i = 0; i < NumChildren; i++) {
+    NumGrandChildren = _GetNumChildren(IdFirst + i);
+    _MakeItemText(acBuffer, IdFirst + i);
+    if (NumGrandChildren) {
+      p = acBuffer + _GetLen(acBuffer);
+      *p++ = ' ';
+      *p++ = '(';
+      p = _MakeNumberString(p, NumGrandChildren);
+      *p++ = ')';
+      *p   = 0;
+    }
+    hItem = TREEVIEW_ITEM_Create(NumGrandChildren ? 1 : 0, acBuffer, IdFirst + i);
+    if (hItem == 0) {
+      return 1; // Error
+    }
+    TREEVIEW_AttachItem(hTree, hItem, hNode, Position);
+    _NumItems++;
+    Position = TREEVIEW_INSERT_BELOW;
+    hNode    = hItem;
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _DeleteChildren
+*
+* Function description
+*   Deletes the children of the given node, depth first, so only items
+*   without children are deleted.
+*/
+static void _DeleteChildren(WM_HWIN hTree, TREEVIEW_ITEM_Handle hNode) {
+  TREEVIEW_ITEM_Handle hItem;
+
+  while ((hItem = TREEVIEW_GetItem(hTree, hNode, TREEVIEW_GET_FIRST_CHILD)) != 0) {
+    if (TREEVIEW_ITEM_GetUserData(hItem) & LAZY_FLAG_FILLED) {
+      _DeleteChildren(hTree, hItem);
+    }
+    TREEVIEW_ITEM_Delete(hItem);
+    _NumItems--;
+  }
+  TREEVIEW_ITEM_SetUserData(hNode, TREEVIEW_ITEM_GetUserData(hNode) & ~LAZY_FLAG_FILLED);
+}
+
+/*********************************************************************
+*
+*       _SyncNode
+*
+* Function description
+*   Compares the expansion state of the given node and its attached
+*   descendants with the attached children. Expanded nodes without
+*   children get their children, collapsed nodes lose them. Only
+*   attached items are visited, so the effort does not depend on the
+*   size of the hierarchy.
+*/
+static void _SyncNode(WM_HWIN hTree, TREEVIEW_ITEM_Handle hNode) {
+  TREEVIEW_ITEM_INFO   Info;
+  TREEVIEW_ITEM_Handle hItem;
+
+  TREEVIEW_ITEM_GetInfo(hNode, &Info);
+  if (Info.IsNode == 0) {
+    return;
+  }
+  if (TREEVIEW_ITEM_GetUserData(hNode) & LAZY_FLAG_FILLED) {
+    if (Info.IsExpanded) {
+      hItem = TREEVIEW_GetItem(hTree, hNode, TREEVIEW_GET_FIRST_CHILD);
+      while (hItem) {
+        _SyncNode(hTree, hItem);
+        hItem = TREEVIEW_GetItem(hTree, hItem, TREEVIEW_GET_NEXT_SIBLING);
+      }
+    } else {
+      _DeleteChildren(hTree, hNode);
+    }
+  } else if (Info.IsExpanded) {
+    _CreateChildren(hTree, hNode);
+  }
+}
+
+/*********************************************************************
+*
+*       _cbTree
+*
+* Function description
+*   The TREEVIEW does not notify its parent about expanding or collapsing
+*   a node. So the state of the attached items is synchronized after each
+*   input message processed by the original callback.
+*/
+static void _cbTree(WM_MESSAGE * pMsg) {
+  TREEVIEW_Callback(pMsg);
+  switch (pMsg->MsgId) {
+  case WM_KEY:
+  case WM_TOUCH:
+  case WM_PID_STATE_CHANGED:
+    _SyncNode(pMsg->hWin, TREEVIEW_GetItem(pMsg->hWin, 0, TREEVIEW_GET_FIRST));
+    break;
+  }
+}
+
+#endif
+
 /*********************************************************************
 *
 *       _MakeNumberText
@@ -167,14 +371,22 @@ static int _FillNode(WM_HWIN hTree, TREEVIEW_ITEM_Handle hNode, int NumNodes, in
 * Purpose:
 *   Create text widgets for showing the result
 */
-static void _MakeNumberText(WM_HWIN hParent, int xPos, int * pyPos, int xSize, int ySize, char * pText, U32 Value) {
+static WM_HWIN _MakeNumberText(WM_HWIN hParent, int xPos, int * pyPos, int xSize, int ySize, char * pText, U32 Value) {
   WM_HWIN hText;
-  int     Len;
 
-  Len = _GetLen(pText);
-  _MakeNumberString(pText + Len, Value);
+  _MakeNumberString(pText + LABEL_LEN, Value);
   hText = TEXT_CreateEx(xPos, *pyPos, xSize, ySize, hParent, WM_CF_SHOW, 0, GUI_ID_TEXT0, pText);
   *pyPos += WM_GetWindowSizeY(hText);
+  return hText;
+}
+
+/*********************************************************************
+*
+*       _UpdateNumberText
+*/
+static void _UpdateNumberText(WM_HWIN hText, char * pText, U32 Value) {
+  _MakeNumberString(pText + LABEL_LEN, Value);
+  TEXT_SetText(hText, pText);
 }
 
 /*********************************************************************
@@ -199,12 +411,21 @@ void MainTask(void) {
   int                  ySizeText;
   U32                  BytesFree;
   U32                  BytesUsed;
+  U32                  BytesUsedStart;
+  U32                  BytesPeak;
+  WM_HWIN              hTextItems;
+  WM_HWIN              hTextPeak;
+  int                  NumItemsShown;
+#if (LAZY_TREEVIEW == 0)
   char                 acBuffer[(TREEVIEW_DEPTH << 1) + 1];
+#endif
   char                 acNumNodes[30]  = "Nodes:  ";
   char                 acNumLeaves[30] = "Leaves: ";
   char                 acNumTotal[30]  = "Total:  ";
+  char                 acNumItems[30]  = "Items:  ";
   char                 acTimeUsed[30]  = "Time:   ";
   char                 acBytesUsed[30] = "Memory: ";
+  char                 acBytesPeak[30] = "Peak:   ";
 
   //
   // Initialize emWin
@@ -245,11 +466,37 @@ void MainTask(void) {
   // Fill TREEVIEW
   //
   hNode = TREEVIEW_InsertItem(hTree, TREEVIEW_ITEM_TYPE_NODE, 0, 0, "Tree");
-  BytesFree = GUI_ALLOC_GetNumFreeBytes();
-  TimeStart = GUI_GetTime();
+  BytesFree      = GUI_ALLOC_GetNumFreeBytes();
+  BytesUsedStart = GUI_ALLOC_GetNumUsedBytes();
+  TimeStart      = GUI_GetTime();
+#if LAZY_TREEVIEW
+  //
+  // Only the children of the root node are created, all other items
+  // are created when their parent gets expanded
+  //
+  WM_SetCallback(hTree, _cbTree);
+  _NumNodes  = (LAZY_NUM_ITEMS + LAZY_NUM_CHILDREN - 2) / LAZY_NUM_CHILDREN;
+  _NumLeaves = LAZY_NUM_ITEMS - _NumNodes;
+  _NumItems  = 1;
+  TREEVIEW_ITEM_SetUserData(hNode, 0);
+  TREEVIEW_ITEM_Expand(hNode);
+  r = _CreateChildren(hTree, hNode);
+#else
   r = _FillNode(hTree, hNode, NUM_CHILD_NODES, NUM_CHILD_ITEMS, TREEVIEW_DEPTH, TREEVIEW_DEPTH, acBuffer, acBuffer);
-  TimeUsed = GUI_GetTime() - TimeStart;
+  _NumItems = _NumNodes + _NumLeaves + 1;
+#endif
+  //
+  // Measure the time until the TREEVIEW has been drawn the first time
+  //
+  if (r == 0) {
+    GUI_Exec();
+  }
+  TimeUsed  = GUI_GetTime() - TimeStart;
   BytesUsed = BytesFree - GUI_ALLOC_GetNumFreeBytes();
+  BytesPeak = GUI_ALLOC_GetMaxUsedBytes() - BytesUsedStart;
+  hTextItems    = 0;
+  hTextPeak     = 0;
+  NumItemsShown = _NumItems;
   if (r) {
     //
     // Error message
@@ -265,12 +512,23 @@ void MainTask(void) {
     _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acNumNodes, _NumNodes);
     _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acNumLeaves, _NumLeaves);
     _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acNumTotal, _NumNodes + _NumLeaves);
+    hTextItems = _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acNumItems, _NumItems);
     _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acTimeUsed, TimeUsed);
     _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acBytesUsed, BytesUsed);
+    hTextPeak  = _MakeNumberText(hTree, xSize >> 1, &yPos, xSize >> 1, ySizeText, acBytesPeak, BytesPeak);
     WM_SetFocus(hTree);
   }
   while (1) {
     GUI_Delay(100);
+    //
+    // Show the number of attached items and the peak memory usage
+    // while nodes are expanded and collapsed
+    //
+    if (hTextItems && (NumItemsShown != _NumItems)) {
+      NumItemsShown = _NumItems;
+      _UpdateNumberText(hTextItems, acNumItems, _NumItems);
+      _UpdateNumberText(hTextPeak,  acBytesPeak, GUI_ALLOC_GetMaxUsedBytes() - BytesUsedStart);
+    }
   }
 }
 
@@ -0,0 +1,680 @@
+/*********************************************************************
+File        : WIDGET_VirtualListview.c
+Purpose     : Sorted table with a virtual data model. The rows are kept
+              in column oriented arrays of the application, a custom
+              window draws only the visible cells.
+Requirements: WindowManager - (x)
+              MemoryDevices - ( )
+              AntiAliasing  - ( )
+              VNC-Server    - ( )
+              PNG-Library   - ( )
+              TrueTypeFonts - ( )
+---------------------------END-OF-HEADER------------------------------
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "DIALOG.h"
+
+/*********************************************************************
+*
+*       Defines
+*
+**********************************************************************
+*/
+#define NUM_ROWS_MAX   100000  // Capacity of the data model
+#define NUM_ROWS_INIT  6       // Number of rows created at startup
+#define NUM_COLS       3
+#define LEN_CODE       5
+#define NUM_SCROLL     50      // Number of pages scrolled when measuring
+
+#define COL_NAME       0
+#define COL_CODE       1
+#define COL_BALANCE    2
+
+#define BORDER         5       // Left and right border of a cell
+#define SEL_NONE       0xFFFFFFFF
+
+#define ID_LIST        (GUI_ID_USER + 0)
+#define ID_HEADER      (GUI_ID_USER + 1)
+
+//
+// Recommended memory to run the sample with adequate performance
+//
+#define RECOMMENDED_MEMORY (1024L * 20)
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       Column properties
+*/
+typedef struct {
+  char * pText;
+  int    Width;
+  int    Align;
+} COL_PROP;
+
+/*********************************************************************
+*
+*       Static Data
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       Data model
+*
+* The name of a row is derived from its index, code and balance are
+* stored in one array per column. For each column a permutation of the
+* row indices is kept in sorted order, so changing the sort column or
+* direction does not compare anything.
+*/
+static U8       _aacCode[NUM_ROWS_MAX][LEN_CODE];
+static I16      _aBalance[NUM_ROWS_MAX];
+static U32      _aaPerm[NUM_COLS][NUM_ROWS_MAX];
+static U32      _NumRows;
+static unsigned _SortCol;      // Column the rows are shown sorted by
+static int      _Reverse;      // Sort direction of _SortCol
+static unsigned _CompareCol;   // Column used by _cbSort()
+static U32      _SelRow = SEL_NONE;
+
+//
+// Measurement results
+//
+static int      _tSort;        // Time required for building the permutations
+
+/*********************************************************************
+*
+*       Dialog ressource
+*/
+static const GUI_WIDGET_CREATE_INFO _aDialogCreate[] = {
+  { FRAMEWIN_CreateIndirect, "Virtual listview sample", 0,      5,  50, 305, 180 },
+  { BUTTON_CreateIndirect,   "Add row",    GUI_ID_BUTTON0,   220,   5,  65,  20 },
+  { BUTTON_CreateIndirect,   "Fill",       GUI_ID_BUTTON1,   220,  30,  65,  20 },
+  { BUTTON_CreateIndirect,   "OK",         GUI_ID_OK,        220,  55,  65,  20 },
+  { TEXT_CreateIndirect,     "",           GUI_ID_TEXT0,     220,  85,  75,  60 },
+};
+
+/*********************************************************************
+*
+*       Array of column propperties
+*/
+static const COL_PROP _aColProps[] = {
+  { "Name",    70, GUI_TA_LEFT    },
+  { "Code",    50, GUI_TA_HCENTER },
+  { "Balance", 60, GUI_TA_RIGHT   }
+};
+
+/*********************************************************************
+*
+*       Static routines
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       _Compare
+*
+* Function description
+*   Compares two rows by the given column. Equal cells are ordered by
+*   the row index, so each row has a unique position in every
+*   permutation.
+*/
+static int _Compare(unsigned Col, U32 Row0, U32 Row1) {
+  int r;
+
+  switch (Col) {
+  case COL_CODE:
+    r = memcmp(_aacCode[Row0], _aacCode[Row1], LEN_CODE);
+    break;
+  case COL_BALANCE:
+    r = _aBalance[Row0] - _aBalance[Row1];
+    break;
+  default:
+    r = 0;
+    break;
+  }
+  if (r == 0) {
+    r = (Row0 > Row1) - (Row0 < Row1);
+  }
+  return r;
+}
+
+/*********************************************************************
+*
+*       _cbSort
+*/
+static int _cbSort(const void * p0, const void * p1) {
+  return _Compare(_CompareCol, *(const U32 *)p0, *(const U32 *)p1);
+}
+
+/*********************************************************************
+*
+*       _FindPos
+*
+* Function description
+*   Binary search for the position of the given row within the
+*   permutation of the given column. Also used for rows not yet
+*   contained, then the insert position is returned.
+*/
+static U32 _FindPos(unsigned Col, U32 NumRows, U32 Row) {
+  U32 * pPerm;
+  U32   Lo;
+  U32   Hi;
+  U32   i;
+
+  pPerm = _aaPerm[Col];
+  Lo    = 0;
+  Hi    = NumRows;
+  while (Lo < Hi) {
+    i = (Lo + Hi) / 2;
+    if (_Compare(Col, pPerm[i], Row) < 0) {
+      Lo = i + 1;
+    } else {
+      Hi = i;
+    }
+  }
+  return Lo;
+}
+
+/*********************************************************************
+*
+*       _CreateRowData
+*
+* Function description
+*   Fills the cells of the given row with random data.
+*/
+static void _CreateRowData(U32 Row) {
+  int i;
+
+  for (i = 0; i < LEN_CODE; i++) {
+    _aacCode[Row][i] = rand() % 26 + 'A';
+  }
+  _aBalance[Row] = (I16)((rand() % 10000) - 5000);
+}
+
+/*********************************************************************
+*
+*       _AddRow
+*
+* Function description
+*   Adds a single row. The row is inserted into the permutation of
+*   each column at the position found by binary search.
+*/
+static int _AddRow(void) {
+  U32      Row;
+  U32      Pos;
+  unsigned Col;
+
+  if (_NumRows >= NUM_ROWS_MAX) {
+    return 1;
+  }
+  Row = _NumRows;
+  _CreateRowData(Row);
+  for (Col = 0; Col < NUM_COLS; Col++) {
+    Pos = _FindPos(Col, Row, Row);
+    memmove(&_aaPerm[Col][Pos + 1], &_aaPerm[Col][Pos], (Row - Pos) * sizeof(U32));
+    _aaPerm[Col][Pos] = Row;
+  }
+  _NumRows++;
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _FillRows
+*
+* Function description
+*   Fills the data model up to its capacity. For a large number of new
+*   rows sorting all permutations once is cheaper than inserting each
+*   row separately.
+*/
+static void _FillRows(void) {
+  GUI_TIMER_TIME t;
+  unsigned       Col;
+  U32            Row;
+
+  for (Row = _NumRows; Row < NUM_ROWS_MAX; Row++) {
+    _CreateRowData(Row);
+  }
+  _NumRows = NUM_ROWS_MAX;
+  t = GUI_GetTime();
+  for (Col = 0; Col < NUM_COLS; Col++) {
+    for (Row = 0; Row < _NumRows; Row++) {
+      _aaPerm[Col][Row] = Row;
+    }
+    if (Col != COL_NAME) {
+      _CompareCol = Col;
+      qsort(_aaPerm[Col], _NumRows, sizeof(U32), _cbSort);
+    }
+  }
+  _tSort = GUI_GetTime() - t;
+}
+
+/*********************************************************************
+*
+*       _GetRow
+*
+* Function description
+*   Returns the row shown at the given position.
+*/
+static U32 _GetRow(U32 Pos) {
+  if (_Reverse) {
+    Pos = _NumRows - 1 - Pos;
+  }
+  return _aaPerm[_SortCol][Pos];
+}
+
+/*********************************************************************
+*
+*       _GetSelPos
+*
+* Function description
+*   Returns the position of the selected row in the current order.
+*/
+static U32 _GetSelPos(void) {
+  U32 Pos;
+
+  Pos = _FindPos(_SortCol, _NumRows, _SelRow);
+  return _Reverse ? _NumRows - 1 - Pos : Pos;
+}
+
+/*********************************************************************
+*
+*       _FormatCell
+*/
+static void _FormatCell(unsigned Col, U32 Row, char * pBuffer) {
+  switch (Col) {
+  case COL_NAME:
+    sprintf(pBuffer, "Name %5lu", (unsigned long)Row);
+    break;
+  case COL_CODE:
+    memcpy(pBuffer, _aacCode[Row], LEN_CODE);
+    pBuffer[LEN_CODE] = 0;
+    break;
+  default:
+    sprintf(pBuffer, "%d", _aBalance[Row]);
+    break;
+  }
+}
+
+/*********************************************************************
+*
+*       _GetNumRowsVisible
+*/
+static int _GetNumRowsVisible(WM_HWIN hWin) {
+  GUI_RECT Rect;
+  WM_HWIN  hHeader;
+
+  hHeader = WM_GetDialogItem(hWin, ID_HEADER);
+  WM_GetInsideRectExScrollbar(hWin, &Rect);
+  GUI_SetFont(GUI_FONT_13_ASCII);
+  return (Rect.y1 - Rect.y0 + 1 - HEADER_GetHeight(hHeader)) / GUI_GetFontDistY();
+}
+
+/*********************************************************************
+*
+*       _UpdateScrollbar
+*
+* Function description
+*   Adapts the scrollbar to the number of rows and moves it if required
+*   to make the selected row visible.
+*/
+static void _UpdateScrollbar(WM_HWIN hWin) {
+  WM_HWIN hScroll;
+  int     NumVisible;
+  int     Pos;
+  int     SelPos;
+
+  hScroll    = WM_GetScrollbarV(hWin);
+  NumVisible = _GetNumRowsVisible(hWin);
+  SCROLLBAR_SetNumItems(hScroll, _NumRows);
+  SCROLLBAR_SetPageSize(hScroll, NumVisible);
+  if (_SelRow != SEL_NONE) {
+    Pos    = SCROLLBAR_GetValue(hScroll);
+    SelPos = _GetSelPos();
+    if (SelPos < Pos) {
+      SCROLLBAR_SetValue(hScroll, SelPos);
+    } else if (SelPos >= Pos + NumVisible) {
+      SCROLLBAR_SetValue(hScroll, SelPos - NumVisible + 1);
+    }
+  }
+  WM_InvalidateWindow(hWin);
+}
+
+/*********************************************************************
+*
+*       _MoveSel
+*/
+static void _MoveSel(WM_HWIN hWin, int Delta) {
+  int SelPos;
+
+  if (_NumRows == 0) {
+    return;
+  }
+  SelPos = (_SelRow == SEL_NONE) ? 0 : (int)_GetSelPos() + Delta;
+  if (SelPos < 0) {
+    SelPos = 0;
+  }
+  if (SelPos >= (int)_NumRows) {
+    SelPos = _NumRows - 1;
+  }
+  _SelRow = _GetRow(SelPos);
+  _UpdateScrollbar(hWin);
+}
+
+/*********************************************************************
+*
+*       _cbList
+*
+* Function description
+*   Callback of the list window. Only the cells of the visible rows are
+*   formatted and drawn.
+*/
+static void _cbList(WM_MESSAGE * pMsg) {
+  GUI_PID_STATE * pState;
+  WM_KEY_INFO   * pKeyInfo;
+  GUI_RECT        Rect;
+  GUI_RECT        RectCell;
+  WM_HWIN         hWin;
+  WM_HWIN         hHeader;
+  char            acBuffer[16];
+  unsigned        Col;
+  U32             Pos;
+  U32             Row;
+  int             yDist;
+  int             Width;
+  int             Sel;
+  int             i;
+
+  hWin = pMsg->hWin;
+  switch (pMsg->MsgId) {
+  case WM_CREATE:
+    SCROLLBAR_CreateAttached(hWin, SCROLLBAR_CF_VERTICAL);
+    WM_GetInsideRectExScrollbar(hWin, &Rect);
+    hHeader = HEADER_CreateEx(Rect.x0, Rect.y0, Rect.x1 - Rect.x0 + 1, 0, hWin, WM_CF_SHOW, 0, ID_HEADER);
+    HEADER_SetDragLimit(hHeader, 1);
+    for (i = 0; i < NUM_COLS; i++) {
+      HEADER_AddItem(hHeader, _aColProps[i].Width, _aColProps[i].pText, _aColProps[i].Align);
+    }
+    HEADER_SetDirIndicator(hHeader, _SortCol, _Reverse);
+    break;
+  case WM_PAINT:
+    hHeader = WM_GetDialogItem(hWin, ID_HEADER);
+    WM_GetInsideRectExScrollbar(hWin, &Rect);
+    GUI_SetBkColor(GUI_WHITE);
+    GUI_Clear();
+    GUI_SetFont(GUI_FONT_13_ASCII);
+    GUI_SetTextMode(GUI_TM_TRANS);
+    yDist       = GUI_GetFontDistY();
+    RectCell.y0 = Rect.y0 + HEADER_GetHeight(hHeader);
+    for (Pos = SCROLLBAR_GetValue(WM_GetScrollbarV(hWin)); (Pos < _NumRows) && (RectCell.y0 <= Rect.y1); Pos++) {
+      Row         = _GetRow(Pos);
+      RectCell.y1 = RectCell.y0 + yDist - 1;
+      if (Row == _SelRow) {
+        GUI_SetColor(GUI_BLUE);
+        GUI_FillRect(Rect.x0, RectCell.y0, Rect.x1, RectCell.y1);
+        GUI_SetColor(GUI_WHITE);
+      } else {
+        GUI_SetColor(GUI_BLACK);
+      }
+      RectCell.x0 = Rect.x0;
+      for (Col = 0; Col < NUM_COLS; Col++) {
+        Width       = HEADER_GetItemWidth(hHeader, Col);
+        RectCell.x1 = RectCell.x0 + Width - 1;
+        _FormatCell(Col, Row, acBuffer);
+        RectCell.x0 += BORDER;
+        RectCell.x1 -= BORDER;
+        GUI_DispStringInRect(acBuffer, &RectCell, _aColProps[Col].Align | GUI_TA_VCENTER);
+        RectCell.x0 += Width - BORDER;
+      }
+      RectCell.y0 += yDist;
+    }
+    break;
+  case WM_NOTIFY_PARENT:
+    hHeader = WM_GetDialogItem(hWin, ID_HEADER);
+    if (pMsg->hWinSrc == hHeader) {
+      if (pMsg->Data.v == WM_NOTIFICATION_RELEASED) {
+        Sel = HEADER_GetSel(hHeader);
+        if (Sel >= 0) {
+          //
+          // The permutation of each column is always up to date,
+          // changing the order requires no sorting
+          //
+          if ((unsigned)Sel == _SortCol) {
+            _Reverse ^= 1;
+          } else {
+            _SortCol = Sel;
+            _Reverse = 0;
+          }
+          HEADER_SetDirIndicator(hHeader, _SortCol, _Reverse);
+          _UpdateScrollbar(hWin);
+        }
+      }
+      WM_InvalidateWindow(hWin);
+    } else if (pMsg->Data.v == WM_NOTIFICATION_VALUE_CHANGED) {
+      WM_InvalidateWindow(hWin);
+    }
+    break;
+  case WM_TOUCH:
+    pState = (GUI_PID_STATE *)pMsg->Data.p;
+    if (pState && pState->Pressed) {
+      hHeader = WM_GetDialogItem(hWin, ID_HEADER);
+      WM_GetInsideRectExScrollbar(hWin, &Rect);
+      GUI_SetFont(GUI_FONT_13_ASCII);
+      i = pState->y - Rect.y0 - HEADER_GetHeight(hHeader);
+      if (i >= 0) {
+        Pos = SCROLLBAR_GetValue(WM_GetScrollbarV(hWin)) + i / GUI_GetFontDistY();
+        if (Pos < _NumRows) {
+          _SelRow = _GetRow(Pos);
+          WM_InvalidateWindow(hWin);
+        }
+      }
+      WM_SetFocus(hWin);
+    }
+    break;
+  case WM_KEY:
+    pKeyInfo = (WM_KEY_INFO *)pMsg->Data.p;
+    if (pKeyInfo->PressedCnt > 0) {
+      switch (pKeyInfo->Key) {
+      case GUI_KEY_UP:
+        _MoveSel(hWin, -1);
+        break;
+      case GUI_KEY_DOWN:
+        _MoveSel(hWin, 1);
+        break;
+      case GUI_KEY_PGUP:
+        _MoveSel(hWin, -_GetNumRowsVisible(hWin));
+        break;
+      case GUI_KEY_PGDOWN:
+        _MoveSel(hWin, _GetNumRowsVisible(hWin));
+        break;
+      default:
+        WM_DefaultProc(pMsg);
+      }
+    }
+    break;
+  case WM_SET_FOCUS:
+    pMsg->Data.v = 0;
+    break;
+  default:
+    WM_DefaultProc(pMsg);
+  }
+}
+
+/*********************************************************************
+*
+*       _ShowStat
+*
+* Function description
+*   Shows number of rows, memory used by the data model and the
+*   measured times.
+*/
+static void _ShowStat(WM_HWIN hText, int tFrame10) {
+  char acText[80];
+  U32  NumBytes;
+
+  NumBytes = _NumRows * (LEN_CODE + sizeof(I16) + NUM_COLS * sizeof(U32));
+  sprintf(acText, "Rows: %lu\nMemory: %lu KB\nSort: %d ms\nFrame: %d.%d ms",
+          (unsigned long)_NumRows, (unsigned long)(NumBytes >> 10), _tSort, tFrame10 / 10, tFrame10 % 10);
+  TEXT_SetText(hText, acText);
+}
+
+/*********************************************************************
+*
+*       _MeasureScroll
+*
+* Function description
+*   Scrolls page by page through the list and returns the average
+*   time per frame in 1/10 ms.
+*/
+static int _MeasureScroll(WM_HWIN hList) {
+  GUI_TIMER_TIME t;
+  WM_HWIN        hScroll;
+  int            NumVisible;
+  int            i;
+
+  hScroll    = WM_GetScrollbarV(hList);
+  NumVisible = _GetNumRowsVisible(hList);
+  t          = GUI_GetTime();
+  for (i = 0; i < NUM_SCROLL; i++) {
+    SCROLLBAR_SetValue(hScroll, (i * NumVisible) % _NumRows);
+    WM_InvalidateWindow(hList);
+    WM_Exec();
+  }
+  t = GUI_GetTime() - t;
+  return (t * 10) / NUM_SCROLL;
+}
+
+/*********************************************************************
+*
+*       _cbDialog
+*
+* Function description
+*   Callback routine of dialog
+*/
+static void _cbDialog(WM_MESSAGE * pMsg) {
+  WM_HWIN hDlg;
+  WM_HWIN hList;
+  WM_HWIN hItem;
+  int     NCode;
+  int     Id;
+  int     i;
+
+  hDlg = pMsg->hWin;
+  switch (pMsg->MsgId) {
+  case WM_INIT_DIALOG:
+    for (i = 0; i < NUM_ROWS_INIT; i++) {
+      _AddRow();
+    }
+    hList = WM_CreateWindowAsChild(10, 5, 200, 140, WM_GetClientWindow(hDlg), WM_CF_SHOW, _cbList, 0);
+    WM_SetId(hList, ID_LIST);
+    _UpdateScrollbar(hList);
+    hItem = WM_GetDialogItem(hDlg, GUI_ID_TEXT0);
+    TEXT_SetFont(hItem, GUI_FONT_10_ASCII);
+    _ShowStat(hItem, 0);
+    break;
+  case WM_NOTIFY_PARENT:
+    Id    = WM_GetId(pMsg->hWinSrc);
+    NCode = pMsg->Data.v;
+    switch (NCode) {
+    case WM_NOTIFICATION_RELEASED:
+      hList = WM_GetDialogItem(hDlg, ID_LIST);
+      switch (Id) {
+      case GUI_ID_BUTTON0:
+        //
+        // Add new row and select it
+        //
+        if (_AddRow() == 0) {
+          _SelRow = _NumRows - 1;
+        }
+        _UpdateScrollbar(hList);
+        _ShowStat(WM_GetDialogItem(hDlg, GUI_ID_TEXT0), 0);
+        break;
+      case GUI_ID_BUTTON1:
+        //
+        // Fill up the data model and measure sorting and scrolling
+        //
+        _FillRows();
+        _UpdateScrollbar(hList);
+        _ShowStat(WM_GetDialogItem(hDlg, GUI_ID_TEXT0), _MeasureScroll(hList));
+        break;
+      case GUI_ID_OK:
+        //
+        // End dialog
+        //
+        GUI_EndDialog(hDlg, 0);
+        break;
+      }
+      break;
+    }
+    break;
+  default:
+    WM_DefaultProc(pMsg);
+  }
+}
+
+/*********************************************************************
+*
+*       _cbBkWin
+*
+* Function description
+*   Callback routine of desktop window
+*/
+static void _cbBkWin(WM_MESSAGE * pMsg) {
+  switch (pMsg->MsgId) {
+  case WM_PAINT:
+    GUI_Clear();
+    GUI_SetFont(&GUI_Font24_ASCII);
+    GUI_DispStringHCenterAt("WIDGET_VirtualListview - Sample", 160, 5);
+    GUI_SetFont(&GUI_Font10_ASCII);
+    GUI_DispStringHCenterAt("Please touch the header of the list for sorting...", 160, 35);
+    break;
+  default:
+    WM_DefaultProc(pMsg);
+  }
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+/*********************************************************************
+*
+*       MainTask
+*/
+void MainTask(void) {
+  GUI_Init();
+  //
+  // Check if recommended memory for the sample is available
+  //
+  if (GUI_ALLOC_GetNumFreeBytes() < RECOMMENDED_MEMORY) {
+    GUI_ErrorOut("Not enough memory available.");
+    return;
+  }
+  #if GUI_SUPPORT_MEMDEV
+    WM_SetCreateFlags(WM_CF_MEMDEV);
+  #endif
+  FRAMEWIN_SetDefaultSkin(FRAMEWIN_SKIN_FLEX);
+  BUTTON_SetDefaultSkin(BUTTON_SKIN_FLEX);
+  HEADER_SetDefaultSkin(HEADER_SKIN_FLEX);
+  SCROLLBAR_SetDefaultSkin(SCROLLBAR_SKIN_FLEX);
+  GUI_CURSOR_Show();
+  WM_SetCallback(WM_HBKWIN, _cbBkWin);
+  while (1) {
+    _NumRows = 0;
+    _SelRow  = SEL_NONE;
+    GUI_ExecDialogBox(_aDialogCreate, GUI_COUNTOF(_aDialogCreate), _cbDialog, 0, 0, 0);
+    GUI_Delay(1000);
+  }
+}
+
+/*************************** End of file ****************************/